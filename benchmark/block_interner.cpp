@@ -0,0 +1,67 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <veriblock/block_interner.hpp>
+#include <veriblock/mock_miner.hpp>
+#include <veriblock/stateless_validation.hpp>
+
+using namespace altintegration;
+
+//! 100 contiguous BTC headers, which are BTC context of many VTBs
+static const std::vector<BtcBlock>& getContext() {
+  static std::vector<BtcBlock> context;
+  if (context.empty()) {
+    MockMiner miner;
+    auto* tip = miner.mineBtcBlocks(100);
+    for (auto* index = tip; index->pprev != nullptr; index = index->pprev) {
+      context.insert(context.begin(), index->getHeader());
+    }
+  }
+  return context;
+}
+
+// range(0) is 0 if headers are checked directly, 1 if they are interned
+static void CheckSharedBtcContext(benchmark::State& state) {
+  const auto& context = getContext();
+  BtcChainParamsRegTest params;
+  BtcBlockInterner interner(params);
+  ValidationState vstate;
+
+  for (auto _ : state) {
+    // context of 1000 VTBs
+    for (size_t i = 0; i < 1000; i++) {
+      bool ok = state.range(0) != 0
+                    ? checkBtcBlocks(context, vstate, interner)
+                    : checkBtcBlocks(context, vstate, params);
+      VBK_ASSERT(ok);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * 1000 * context.size());
+}
+BENCHMARK(CheckSharedBtcContext)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// range(0) is 0 if header is checked directly, 1 if it is interned
+static void CheckVbkBlock(benchmark::State& state) {
+  MockMiner miner;
+  auto block = miner.mineVbkBlocks(1)->getHeader();
+  VbkChainParamsRegTest params;
+  VbkBlockInterner interner(params);
+  ValidationState vstate;
+
+  for (auto _ : state) {
+    bool ok = state.range(0) != 0 ? checkBlock(block, vstate, interner)
+                                  : checkBlock(block, vstate, params);
+    VBK_ASSERT(ok);
+  }
+}
+BENCHMARK(CheckVbkBlock)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <veriblock/mock_miner.hpp>
+#include <veriblock/storage/tree_snapshot.hpp>
+#include <veriblock/storage/util.hpp>
+
+using namespace altintegration;
+
+struct SerializedVbkTree {
+  VbkBlock::hash_t tip;
+  std::vector<std::vector<uint8_t>> blocks;
+  std::vector<uint8_t> snapshot;
+};
+
+//! mines VBK chain of `size` blocks once per size, serializes all its blocks
+static const SerializedVbkTree& getSerializedVbkTree(size_t size) {
+  static std::map<size_t, SerializedVbkTree> cache;
+  auto it = cache.find(size);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  MockMiner miner;
+  miner.mineVbkBlocks(size);
+  auto& ret = cache[size];
+  ret.tip = miner.vbk().getBestChain().tip()->getHash();
+  ret.blocks.reserve(miner.vbk().getBlocks().size());
+  for (auto& p : miner.vbk().getBlocks()) {
+    ret.blocks.push_back(p.second->toRaw());
+  }
+  WriteStream snapshot;
+  SaveTreeSnapshot(miner.vbk(), snapshot);
+  ret.snapshot = snapshot.data();
+  return ret;
+}
+
+// range(0) is a number of blocks, range(1) is a number of threads
+static void LoadVbkTree(benchmark::State& state) {
+  auto& serialized = getSerializedVbkTree((size_t)state.range(0));
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  ValidationState vstate;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<PayloadsIndex> index(new PayloadsIndex());
+    std::unique_ptr<VbkBlockTree> tree(
+        new VbkBlockTree(vbkparam, btcparam, provider, *index));
+    VBK_ASSERT(tree->btc().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->bootstrapWithGenesis(vstate));
+    VectorBlockCursor cursor(serialized.blocks);
+    state.ResumeTiming();
+
+    VBK_ASSERT_MSG(LoadTree(*tree,
+                            cursor,
+                            serialized.tip,
+                            vstate,
+                            (size_t)state.range(1)),
+                   vstate.toString());
+
+    state.PauseTiming();
+    tree.reset();
+    index.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          (int64_t)serialized.blocks.size());
+}
+BENCHMARK(LoadVbkTree)
+    ->Args({1000000, 1})
+    ->Args({1000000, (int64_t)default_thread_count()})
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// range(0) is a number of blocks
+static void RestoreVbkTreeSnapshot(benchmark::State& state) {
+  auto& serialized = getSerializedVbkTree((size_t)state.range(0));
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  ValidationState vstate;
+  const std::vector<uint8_t> key(32, 1);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<PayloadsIndex> index(new PayloadsIndex());
+    std::unique_ptr<VbkBlockTree> tree(
+        new VbkBlockTree(vbkparam, btcparam, provider, *index));
+    VBK_ASSERT(tree->btc().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->bootstrapWithGenesis(vstate));
+    state.ResumeTiming();
+
+    // HMAC is verified by AltBlockTree::restoreSnapshot
+    benchmark::DoNotOptimize(hmacSha256(key, serialized.snapshot));
+    ReadStream stream(serialized.snapshot);
+    VBK_ASSERT_MSG(RestoreTreeSnapshot(*tree, stream, vstate),
+                   vstate.toString());
+
+    state.PauseTiming();
+    tree.reset();
+    index.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          (int64_t)serialized.blocks.size());
+}
+BENCHMARK(RestoreVbkTreeSnapshot)
+    ->Arg(1000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
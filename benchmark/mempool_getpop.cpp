@@ -0,0 +1,94 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <veriblock/mempool.hpp>
+#include <veriblock/mock_miner.hpp>
+
+using namespace altintegration;
+
+struct BenchAltChainParams : public AltChainParams {
+  AltBlock getBootstrapBlock() const noexcept override {
+    AltBlock b;
+    b.hash = {1, 2, 3};
+    b.height = 0;
+    b.timestamp = 0;
+    return b;
+  }
+
+  int64_t getIdentifier() const noexcept override { return 0x7ec7; }
+
+  std::vector<uint8_t> getHash(
+      const std::vector<uint8_t>& bytes) const noexcept override {
+    ReadStream stream(bytes);
+    return AltBlock::fromVbkEncoding(stream).getHash();
+  }
+};
+
+struct GetPopFixture {
+  BenchAltChainParams altparam;
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  AltBlockTree tree{altparam, vbkparam, btcparam, provider};
+  MemPool mempool{tree};
+
+  //! `size` ATVs endorsing ALT bootstrap block, 100 ATVs per VBK block
+  explicit GetPopFixture(size_t size) {
+    ValidationState state;
+    VBK_ASSERT(tree.btc().bootstrapWithGenesis(state));
+    VBK_ASSERT(tree.vbk().bootstrapWithGenesis(state));
+    VBK_ASSERT(tree.bootstrap(state));
+    // AltBlockTree reads payloads of PopData it validates from provider
+    mempool.onAccepted<VbkBlock>([&](const VbkBlock& b) { provider.write(b); });
+    mempool.onAccepted<ATV>([&](const ATV& atv) { provider.write(atv); });
+
+    MockMiner miner;
+    PublicationData pub;
+    pub.identifier = altparam.getIdentifier();
+    pub.header = altparam.getBootstrapBlock().toVbkEncoding();
+    size_t submitted = 0;
+    while (submitted < size) {
+      std::vector<VbkTx> txs;
+      for (size_t i = 0; i < 100 && submitted + i < size; i++) {
+        pub.contextInfo = {(uint8_t)i, (uint8_t)(submitted >> 8)};
+        txs.push_back(miner.createVbkTxEndorsingAltBlock(pub));
+      }
+      for (const auto& atv : miner.applyATVs(txs, state)) {
+        VBK_ASSERT_MSG(mempool.submit(atv, state), state.toString());
+      }
+      submitted += txs.size();
+    }
+  }
+};
+
+// range(0) is a number of ATVs, range(1) is 1 if template stays valid
+// between calls
+static void GetPop(benchmark::State& state) {
+  GetPopFixture fixture((size_t)state.range(0));
+  const bool stable = state.range(1) != 0;
+  auto selector = std::make_shared<HeightOrderSelector>();
+  auto pop = fixture.mempool.getPop();
+  VBK_ASSERT(!pop.atvs.empty());
+
+  for (auto _ : state) {
+    if (!stable) {
+      // forces template to be built from scratch
+      fixture.mempool.setSelector(selector);
+    }
+    pop = fixture.mempool.getPop();
+    benchmark::DoNotOptimize(pop);
+  }
+
+  state.SetItemsProcessed(state.iterations() * pop.atvs.size());
+}
+BENCHMARK(GetPop)
+    ->Args({500, 0})
+    ->Args({500, 1})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
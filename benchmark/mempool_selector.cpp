@@ -0,0 +1,106 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <veriblock/mempool_selector.hpp>
+#include <veriblock/storage/inmem_payloads_provider.hpp>
+
+using namespace altintegration;
+
+struct BenchAltChainParams : public AltChainParams {
+  AltBlock getBootstrapBlock() const noexcept override {
+    AltBlock b;
+    b.hash = {1, 2, 3};
+    b.height = 0;
+    b.timestamp = 0;
+    return b;
+  }
+
+  int64_t getIdentifier() const noexcept override { return 0x7ec7; }
+
+  std::vector<uint8_t> getHash(
+      const std::vector<uint8_t>& bytes) const noexcept override {
+    ReadStream stream(bytes);
+    return AltBlock::fromVbkEncoding(stream).getHash();
+  }
+};
+
+struct SelectorFixture {
+  BenchAltChainParams altparam;
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  AltBlockTree tree{altparam, vbkparam, btcparam, provider};
+
+  std::vector<std::unique_ptr<VbkPayloadsRelations>> relations;
+  MemPoolSelector::relations_index_t index;
+
+  //! `entries` payloads, 2 VTBs and 3 ATVs per VBK block. Half of ATVs
+  //! endorse bootstrap block, others endorse unknown blocks. VTBs publish
+  //! previous VBK block.
+  explicit SelectorFixture(size_t entries) {
+    ValidationState state;
+    VBK_ASSERT(tree.btc().bootstrapWithGenesis(state));
+    VBK_ASSERT(tree.vbk().bootstrapWithGenesis(state));
+    VBK_ASSERT(tree.bootstrap(state));
+
+    AltBlock unknown = altparam.getBootstrapBlock();
+    unknown.hash = {3, 2, 1};
+    auto known = altparam.getBootstrapBlock().toVbkEncoding();
+    auto other = unknown.toVbkEncoding();
+
+    srand(0);
+    VbkBlock previous;
+    for (size_t i = 0; i * 5 < entries; i++) {
+      VbkBlock block;
+      block.height = (int32_t)i + 1;
+      block.nonce = (uint64_t)rand();
+      std::unique_ptr<VbkPayloadsRelations> rel(
+          new VbkPayloadsRelations(block));
+      for (int j = 0; j < 2; j++) {
+        auto vtb = std::make_shared<VTB>();
+        vtb->containingBlock = block;
+        vtb->transaction.publishedBlock = previous;
+        vtb->transaction.bitcoinTransaction.tx.resize(200 + rand() % 800);
+        rel->addVTB(vtb);
+      }
+      for (int j = 0; j < 3; j++) {
+        auto atv = std::make_shared<ATV>();
+        atv->blockOfProof = block;
+        auto& pub = atv->transaction.publicationData;
+        pub.header = rand() % 2 == 0 ? known : other;
+        pub.contextInfo.resize(100 + rand() % 1000);
+        rel->addATV(atv);
+      }
+      rel->arrival = i;
+      index[{block.height, rel->arrival}] = rel.get();
+      relations.push_back(std::move(rel));
+      previous = block;
+    }
+  }
+};
+
+template <typename Selector>
+static void SelectPopData(benchmark::State& state) {
+  SelectorFixture fixture((size_t)state.range(0));
+  Selector selector;
+
+  for (auto _ : state) {
+    auto pop = selector.select(fixture.index, fixture.tree);
+    benchmark::DoNotOptimize(pop);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(SelectPopData, HeightOrderSelector)
+    ->Arg(50000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(SelectPopData, ValueDensitySelector)
+    ->Arg(50000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,200 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <veriblock/algorithm.hpp>
+#include <veriblock/mempool.hpp>
+#include <veriblock/mock_miner.hpp>
+
+using namespace altintegration;
+
+struct BenchAltChainParams : public AltChainParams {
+  AltBlock getBootstrapBlock() const noexcept override {
+    AltBlock b;
+    b.hash = {1, 2, 3};
+    b.height = 0;
+    b.timestamp = 0;
+    return b;
+  }
+
+  int64_t getIdentifier() const noexcept override { return 0x7ec7; }
+
+  std::vector<uint8_t> getHash(
+      const std::vector<uint8_t>& bytes) const noexcept override {
+    ReadStream stream(bytes);
+    return AltBlock::fromVbkEncoding(stream).getHash();
+  }
+};
+
+//! `size` ATVs endorsing ALT bootstrap block, 100 ATVs per VBK block, with
+//! VBK context. Mined once per size.
+static const PopData& getPopData(size_t size) {
+  static std::map<size_t, PopData> cache;
+  auto it = cache.find(size);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  BenchAltChainParams altparam;
+  MockMiner miner;
+  ValidationState state;
+  auto& pop = cache[size];
+  PublicationData pub;
+  pub.identifier = altparam.getIdentifier();
+  pub.header = altparam.getBootstrapBlock().toVbkEncoding();
+  while (pop.atvs.size() < size) {
+    std::vector<VbkTx> txs;
+    for (size_t i = 0; i < 100 && pop.atvs.size() + i < size; i++) {
+      pub.contextInfo = {(uint8_t)i, (uint8_t)(pop.atvs.size() >> 8)};
+      txs.push_back(miner.createVbkTxEndorsingAltBlock(pub));
+    }
+    auto atvs = miner.applyATVs(txs, state);
+    pop.context.push_back(atvs.at(0).blockOfProof);
+    pop.atvs.insert(pop.atvs.end(), atvs.begin(), atvs.end());
+  }
+  return pop;
+}
+
+// range(0) is a number of ATVs, range(1) is a number of threads
+static void SubmitAll(benchmark::State& state) {
+  const auto& pop = getPopData((size_t)state.range(0));
+  BenchAltChainParams altparam;
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  ValidationState vstate;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<AltBlockTree> tree(
+        new AltBlockTree(altparam, vbkparam, btcparam, provider));
+    VBK_ASSERT(tree->btc().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->vbk().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->bootstrap(vstate));
+    std::unique_ptr<MemPool> mempool(new MemPool(*tree));
+    // every iteration does full stateless validation
+    PopData copy = pop;
+    for (auto& atv : copy.atvs) {
+      atv.checked = false;
+    }
+    state.ResumeTiming();
+
+    auto result = mempool->submitAll(copy, (size_t)state.range(1));
+    for (auto& p : result.atvs) {
+      VBK_ASSERT_MSG(p.second.IsValid(), p.second.toString());
+    }
+
+    state.PauseTiming();
+    mempool.reset();
+    tree.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(SubmitAll)
+    ->Args({2000, 1})
+    ->Args({2000, (int64_t)default_thread_count()})
+    ->Unit(benchmark::kMillisecond);
+
+// range(0) is a number of ATVs
+static void RestoreSnapshot(benchmark::State& state) {
+  const auto& pop = getPopData((size_t)state.range(0));
+  BenchAltChainParams altparam;
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  ValidationState vstate;
+
+  WriteStream snapshot;
+  {
+    AltBlockTree tree(altparam, vbkparam, btcparam, provider);
+    VBK_ASSERT(tree.btc().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree.vbk().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree.bootstrap(vstate));
+    MemPool mempool(tree);
+    mempool.submitAll(pop);
+    mempool.saveSnapshot(snapshot);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<AltBlockTree> tree(
+        new AltBlockTree(altparam, vbkparam, btcparam, provider));
+    VBK_ASSERT(tree->btc().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->vbk().bootstrapWithGenesis(vstate));
+    VBK_ASSERT(tree->bootstrap(vstate));
+    std::unique_ptr<MemPool> mempool(new MemPool(*tree));
+    state.ResumeTiming();
+
+    VBK_ASSERT_MSG(mempool->restoreSnapshot(snapshot.data(), vstate),
+                   vstate.toString());
+    VBK_ASSERT(mempool->getMap<ATV>().size() == pop.atvs.size());
+
+    state.PauseTiming();
+    mempool.reset();
+    tree.reset();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(RestoreSnapshot)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+//! `size` statelessly checked VTBs in the same containing block, each with
+//! 100 BTC context blocks and a 1KB BTC transaction
+static std::vector<VTB> getLargeVTBs(size_t size) {
+  std::vector<VTB> vtbs(size);
+  for (size_t i = 0; i < size; i++) {
+    auto& vtb = vtbs[i];
+    vtb.transaction.bitcoinTransaction.tx.resize(1024, (uint8_t)i);
+    vtb.transaction.bitcoinTransaction.tx[0] = (uint8_t)(i >> 8);
+    vtb.transaction.blockOfProofContext.resize(100);
+    vtb.transaction.merklePath.layers.resize(10, uint256());
+    vtb.checked = true;
+  }
+  return vtbs;
+}
+
+// range(0) is 0 if VTBs are copied into mempool, 1 if they are moved
+static void SubmitLargeVTBs(benchmark::State& state) {
+  const bool move = state.range(0) != 0;
+  const size_t size = 1000;
+  BenchAltChainParams altparam;
+  VbkChainParamsRegTest vbkparam;
+  BtcChainParamsRegTest btcparam;
+  InmemPayloadsProvider provider;
+  ValidationState vstate;
+  AltBlockTree tree(altparam, vbkparam, btcparam, provider);
+  VBK_ASSERT(tree.btc().bootstrapWithGenesis(vstate));
+  VBK_ASSERT(tree.vbk().bootstrapWithGenesis(vstate));
+  VBK_ASSERT(tree.bootstrap(vstate));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<MemPool> mempool(new MemPool(tree));
+    auto vtbs = getLargeVTBs(size);
+    state.ResumeTiming();
+
+    for (auto& vtb : vtbs) {
+      bool ok = move ? mempool->submit(std::move(vtb), vstate, false)
+                     : mempool->submit(vtb, vstate, false);
+      VBK_ASSERT_MSG(ok, vstate.toString());
+    }
+
+    state.PauseTiming();
+    VBK_ASSERT(mempool->getMap<VTB>().size() == size);
+    mempool.reset();
+    vtbs.clear();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(SubmitLargeVTBs)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <random>
+#include <veriblock/storage/file_block_storage.hpp>
+#include <veriblock/storage/mmap_payloads_provider.hpp>
+#include <veriblock/strutil.hpp>
+
+using namespace altintegration;
+
+static const std::string payloadsPath = "benchmark_mmap_payloads.log";
+static const std::string blocksPath = "benchmark_mmap_blocks.log";
+
+static const auto defaultAtvEncoded = ParseHex(
+    "0000000101580101166772f51ab208d32771ab1506970eeb664462730b838e0203e80001"
+    "0701370100010c6865616465722062797465730112636f6e7465787420696e666f206279"
+    "74657301117061796f757420696e666f2062797465734630440220398b74708dc8f8aee6"
+    "8fce0c47b8959e6fce6354665da3ed87a83f708e62aa6b02202e6c00c00487763c55e92c"
+    "7b8e1dd538b7375d8df2b2117e75acbb9db7deb3c7583056301006072a8648ce3d020106"
+    "052b8104000a03420004de4ee8300c3cd99e913536cf53c4add179f048f8fe90e5adf3ed"
+    "19668dd1dbf6c2d8e692b1d36eac7187950620a28838da60a8c9dd60190c14c59b82cb90"
+    "319e04000000010400000000201fec8aa4983d69395010e4d18cd8b943749d5b4f575e88"
+    "a375debdc5ed22531c040000000220000000000000000000000000000000000000000000"
+    "000000000000000000000020000000000000000000000000000000000000000000000000"
+    "000000000000000040000013880002449c60619294546ad825af03b0935637860679ddd5"
+    "5ee4fd21082e18686e26bbfda7d5e4462ef24ae02d67e47d785c9b90f301010000000000"
+    "01");
+
+//! generates ATVs with unique ids
+static std::vector<ATV> generateATVs(size_t n, int64_t& counter) {
+  ATV atv = ATV::fromVbkEncoding(defaultAtvEncoded);
+  std::vector<ATV> ret;
+  ret.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    atv.transaction.signatureIndex = counter++;
+    ret.push_back(atv);
+  }
+  return ret;
+}
+
+static void MmapPayloadsWriteFlush(benchmark::State& state) {
+  std::remove(payloadsPath.c_str());
+  ValidationState vstate;
+  MmapPayloadsProvider provider(payloadsPath);
+  VBK_ASSERT(provider.open(vstate));
+
+  int64_t counter = 0;
+  const auto n = (size_t)state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto atvs = generateATVs(n, counter);
+    state.ResumeTiming();
+
+    provider.write(atvs);
+    VBK_ASSERT(provider.flush(vstate));
+  }
+
+  state.SetItemsProcessed(state.iterations() * (int64_t)n);
+  state.SetBytesProcessed((int64_t)provider.size());
+  std::remove(payloadsPath.c_str());
+}
+BENCHMARK(MmapPayloadsWriteFlush)->Arg(1)->Arg(100)->Arg(1000);
+
+static void MmapPayloadsGetATVViews(benchmark::State& state) {
+  std::remove(payloadsPath.c_str());
+  ValidationState vstate;
+  MmapPayloadsProvider provider(payloadsPath);
+  VBK_ASSERT(provider.open(vstate));
+
+  int64_t counter = 0;
+  auto atvs = generateATVs(10000, counter);
+  provider.write(atvs);
+  VBK_ASSERT(provider.flush(vstate));
+
+  std::mt19937 rng(0);
+  std::vector<ATVView> views;
+  for (auto _ : state) {
+    auto& atv = atvs[rng() % atvs.size()];
+    VBK_ASSERT(provider.getATVViews({atv.getId()}, views, vstate));
+    benchmark::DoNotOptimize(views[0].getId());
+  }
+  std::remove(payloadsPath.c_str());
+}
+BENCHMARK(MmapPayloadsGetATVViews);
+
+static void FileBlockBatchCommit(benchmark::State& state) {
+  std::remove(blocksPath.c_str());
+  ValidationState vstate;
+  FileBlockStorage storage(blocksPath);
+  VBK_ASSERT(storage.open(vstate));
+
+  // range(0) is a batch size, 1 means commit every block
+  FileBlockBatch batch(storage, (size_t)state.range(0));
+  BlockIndex<BtcBlock> index;
+  BtcBlock block;
+  uint32_t nonce = 0;
+  const size_t blocks = 1000;
+  for (auto _ : state) {
+    for (size_t i = 0; i < blocks; i++) {
+      block.nonce = nonce++;
+      index.setHeader(block);
+      VBK_ASSERT(batch.writeBlock(index));
+    }
+    VBK_ASSERT(batch.writeTip(index));
+    VBK_ASSERT(batch.commit(vstate));
+  }
+
+  state.SetItemsProcessed(state.iterations() * (int64_t)blocks);
+  std::remove(blocksPath.c_str());
+}
+BENCHMARK(FileBlockBatchCommit)
+    ->Arg(1)
+    ->Arg(FileBlockBatch::kDefaultMaxBatchSize)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+#include <veriblock/entities/merkle_tree.hpp>
+#include <veriblock/hashutil.hpp>
+
+using namespace altintegration;
+
+// range(0) is sha256_backend, range(1) is input size
+static void Sha256(benchmark::State& state) {
+  auto backend = (sha256_backend)state.range(0);
+  auto previous = sha256_get_backend();
+  if (!sha256_set_backend(backend)) {
+    state.SkipWithError("backend is not supported");
+    return;
+  }
+  state.SetLabel(sha256_backend_name(backend));
+
+  std::vector<uint8_t> data((size_t)state.range(1), 0xAB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sha256(data));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+  sha256_set_backend(previous);
+}
+
+// BTC header hash, range(0) is sha256_backend
+static void Sha256TwiceBtcHeader(benchmark::State& state) {
+  auto backend = (sha256_backend)state.range(0);
+  auto previous = sha256_get_backend();
+  if (!sha256_set_backend(backend)) {
+    state.SkipWithError("backend is not supported");
+    return;
+  }
+  state.SetLabel(sha256_backend_name(backend));
+
+  std::vector<uint8_t> header(80, 0xAB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sha256twice(header));
+  }
+
+  sha256_set_backend(previous);
+}
+
+// range(0) is sha256_backend, range(1) is sha256_batch_backend
+static bool setBackends(benchmark::State& state) {
+  auto backend = (sha256_backend)state.range(0);
+  auto batch = (sha256_batch_backend)state.range(1);
+  if (!sha256_set_backend(backend) || !sha256_set_batch_backend(batch)) {
+    state.SkipWithError("backend is not supported");
+    return false;
+  }
+  state.SetLabel(std::string(sha256_backend_name(backend)) + "/" +
+                 sha256_batch_backend_name(batch));
+  return true;
+}
+
+// hashes of 2000 BTC headers
+static void Sha256TwiceBatchBtcHeaders(benchmark::State& state) {
+  auto previous = sha256_get_backend();
+  auto previousBatch = sha256_get_batch_backend();
+  if (!setBackends(state)) {
+    return;
+  }
+
+  const size_t n = 2000;
+  std::vector<uint8_t> headers(n * 80, 0xAB);
+  std::vector<Slice<const uint8_t>> inputs;
+  for (size_t i = 0; i < n; i++) {
+    headers[i * 80] = (uint8_t)i;
+    inputs.emplace_back(headers.data() + i * 80, 80);
+  }
+  std::vector<uint256> hashes(n);
+  for (auto _ : state) {
+    sha256twiceBatch(inputs, hashes);
+    benchmark::DoNotOptimize(hashes.data());
+  }
+
+  sha256_set_backend(previous);
+  sha256_set_batch_backend(previousBatch);
+}
+
+// BTC merkle tree of 4096 transactions
+static void BtcMerkleTreeBuild(benchmark::State& state) {
+  auto previous = sha256_get_backend();
+  auto previousBatch = sha256_get_batch_backend();
+  if (!setBackends(state)) {
+    return;
+  }
+
+  std::vector<uint256> txes;
+  for (uint64_t i = 0; i < 4096; i++) {
+    txes.push_back(ArithUint256(i));
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BtcMerkleTree(txes).getMerkleRoot());
+  }
+
+  sha256_set_backend(previous);
+  sha256_set_batch_backend(previousBatch);
+}
+
+// clang-format off
+BENCHMARK(Sha256)
+    ->Args({SHA256_BACKEND_PORTABLE, 64})
+    ->Args({SHA256_BACKEND_SHANI, 64})
+    ->Args({SHA256_BACKEND_ARMV8, 64})
+    ->Args({SHA256_BACKEND_PORTABLE, 4096})
+    ->Args({SHA256_BACKEND_SHANI, 4096})
+    ->Args({SHA256_BACKEND_ARMV8, 4096});
+BENCHMARK(Sha256TwiceBtcHeader)
+    ->Arg(SHA256_BACKEND_PORTABLE)
+    ->Arg(SHA256_BACKEND_SHANI)
+    ->Arg(SHA256_BACKEND_ARMV8);
+BENCHMARK(Sha256TwiceBatchBtcHeaders)
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_SINGLE})
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_SSE2})
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_AVX2})
+    ->Args({SHA256_BACKEND_SHANI, SHA256_BATCH_SINGLE})
+    ->Args({SHA256_BACKEND_SHANI, SHA256_BATCH_AVX2})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BtcMerkleTreeBuild)
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_SINGLE})
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_SSE2})
+    ->Args({SHA256_BACKEND_PORTABLE, SHA256_BATCH_AVX2})
+    ->Args({SHA256_BACKEND_SHANI, SHA256_BATCH_SINGLE})
+    ->Args({SHA256_BACKEND_SHANI, SHA256_BATCH_AVX2})
+    ->Unit(benchmark::kMicrosecond);
+// clang-format on
+
+BENCHMARK_MAIN();
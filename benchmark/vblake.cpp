@@ -0,0 +1,69 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+#include <veriblock/hashutil.hpp>
+#include <veriblock/entities/vbkblock.hpp>
+
+using namespace altintegration;
+
+// VBK header hash
+static void VBlake(benchmark::State& state) {
+  std::vector<uint8_t> header(VBK_HEADER_SIZE, 0xAB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(vblake(header));
+  }
+}
+
+// hashes of 2000 VBK headers, range(0) is vblake_batch_backend
+static void VBlakeBatch(benchmark::State& state) {
+  auto backend = (vblake_batch_backend)state.range(0);
+  auto previous = vblake_get_batch_backend();
+  if (!vblake_set_batch_backend(backend)) {
+    state.SkipWithError("backend is not supported");
+    return;
+  }
+  state.SetLabel(vblake_batch_backend_name(backend));
+
+  const size_t n = 2000;
+  std::vector<uint8_t> headers(n * VBK_HEADER_SIZE, 0xAB);
+  std::vector<Slice<const uint8_t>> inputs;
+  for (size_t i = 0; i < n; i++) {
+    headers[i * VBK_HEADER_SIZE] = (uint8_t)i;
+    inputs.emplace_back(headers.data() + i * VBK_HEADER_SIZE, VBK_HEADER_SIZE);
+  }
+  std::vector<uint192> hashes(n);
+  for (auto _ : state) {
+    vblakeBatch(inputs, hashes);
+    benchmark::DoNotOptimize(hashes.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * (int64_t)n);
+  vblake_set_batch_backend(previous);
+}
+
+// VBK header serialization and hash
+static void VbkBlockGetHash(benchmark::State& state) {
+  VbkBlock block;
+  block.height = 100;
+  block.timestamp = 1600000000;
+  block.difficulty = 0x01010000;
+  for (auto _ : state) {
+    block.nonce++;
+    benchmark::DoNotOptimize(block.getHash());
+  }
+}
+
+BENCHMARK(VBlake);
+BENCHMARK(VBlakeBatch)
+    ->Arg(VBLAKE_BATCH_SINGLE)
+    ->Arg(VBLAKE_BATCH_AVX2)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(VbkBlockGetHash);
+
+BENCHMARK_MAIN();
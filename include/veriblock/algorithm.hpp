@@ -10,9 +10,11 @@
 #include <functional>
 #include <iterator>
 #include <set>
+#include <thread>
 #include <vector>
 #include <veriblock/assert.hpp>
 #include <veriblock/blob.hpp>
+#include <veriblock/thread_pool.hpp>
 
 namespace altintegration {
 
@@ -80,6 +82,62 @@ bool erase_last_item_if(std::vector<T*>& v,
   return true;
 }
 
+//! number of worker threads to use, when caller did not specify it
+inline size_t default_thread_count() {
+  auto n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+/**
+ * Calls `f(i)` for every `i` in [0, size) on caller thread and up to
+ * `threads - 1` workers of `pool`. Every thread processes contiguous range of
+ * indices, and stops at first `i` for which `f` returned false. No worker is
+ * used for less than `minItemsPerThread` items.
+ * @return smallest `i` for which `f` returned false, or `size`
+ */
+template <typename F>
+size_t parallel_for(ThreadPool& pool,
+                    size_t size,
+                    size_t threads,
+                    F f,
+                    size_t minItemsPerThread = 256) {
+  threads = std::max<size_t>(
+      1,
+      std::min({threads,
+                pool.size() + 1,
+                (size + minItemsPerThread - 1) / minItemsPerThread}));
+
+  const size_t chunk = (size + threads - 1) / threads;
+  std::vector<size_t> failed(threads, size);
+  pool.run(threads, [&](size_t t) {
+    auto begin = std::min(size, t * chunk);
+    auto end = std::min(size, begin + chunk);
+    for (size_t i = begin; i < end; i++) {
+      if (!f(i)) {
+        failed[t] = i;
+        return;
+      }
+    }
+  });
+
+  return *std::min_element(failed.begin(), failed.end());
+}
+
+/**
+ * Same as parallel_for over a pool, but starts up to `threads - 1` workers for
+ * this call only. Callers, which run it repeatedly, should own a ThreadPool.
+ */
+template <typename F>
+size_t parallel_for(size_t size,
+                    size_t threads,
+                    F f,
+                    size_t minItemsPerThread = 256) {
+  threads = std::max<size_t>(
+      1, std::min(threads, (size + minItemsPerThread - 1) / minItemsPerThread));
+  ThreadPool pool(threads - 1);
+  return parallel_for(pool, size, threads, f, minItemsPerThread);
+}
+
 }  // namespace altintegration
 
 #endif  // VERIBLOCK_POP_CPP_ALGORITHM_HPP
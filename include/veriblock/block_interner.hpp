@@ -0,0 +1,117 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_VERIBLOCK_BLOCK_INTERNER_HPP
+#define ALT_INTEGRATION_VERIBLOCK_BLOCK_INTERNER_HPP
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "veriblock/hashers.hpp"
+#include "veriblock/stateless_validation.hpp"
+
+namespace altintegration {
+
+/**
+ * @struct InternedBlock
+ *
+ * Immutable block header with its hash and proof of work check result, which
+ * are computed once when header is interned.
+ */
+template <typename Block>
+struct InternedBlock {
+  using hash_t = typename Block::hash_t;
+
+  template <typename ChainParams>
+  InternedBlock(const Block& b, const ChainParams& params)
+      : header(b), hash(b.getHash()), validPow(checkProofOfWork(b, params)) {}
+
+  const Block header;
+  const hash_t hash;
+  const bool validPow;
+};
+
+/**
+ * @struct BlockInterner
+ *
+ * Deduplicates block headers by their raw encoding into shared immutable
+ * InternedBlock instances, so that hash and proof of work of a header, which
+ * occurs in many payloads (e.g. BTC context of VTBs endorsing the same VBK
+ * blocks), are computed once.
+ *
+ * Instances are refcounted. When interner is full, instances, which are not
+ * referenced outside of interner, are dropped.
+ *
+ * Thread-safe.
+ */
+template <typename Block, typename ChainParams>
+struct BlockInterner {
+  using entry_t = InternedBlock<Block>;
+
+  //! default max number of interned headers
+  static const size_t kDefaultCapacity = 20000;
+
+  explicit BlockInterner(const ChainParams& params,
+                         size_t capacity = kDefaultCapacity)
+      : params_(params), capacity_(capacity) {}
+
+  //! @return interned instance equal to `block`
+  std::shared_ptr<const entry_t> intern(const Block& block) {
+    auto raw = block.toRaw();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = blocks_.find(raw);
+      if (it != blocks_.end()) {
+        return it->second;
+      }
+    }
+
+    // hash is computed without holding the lock
+    auto entry = std::make_shared<const entry_t>(block, params_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blocks_.size() >= capacity_) {
+      collect();
+    }
+    if (blocks_.size() >= capacity_) {
+      // every instance is in use, do not grow
+      return entry;
+    }
+    // other thread may have interned the same header
+    return blocks_.emplace(std::move(raw), entry).first->second;
+  }
+
+  //! number of interned headers
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+  }
+
+  const ChainParams& getParams() const { return params_; }
+
+ private:
+  const ChainParams& params_;
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::vector<uint8_t>, std::shared_ptr<const entry_t>>
+      blocks_;
+
+  // drops instances, which are referenced only by interner
+  void collect() {
+    for (auto it = blocks_.begin(); it != blocks_.end();) {
+      if (it->second.use_count() == 1) {
+        it = blocks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+};
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_VERIBLOCK_BLOCK_INTERNER_HPP
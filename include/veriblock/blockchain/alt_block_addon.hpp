@@ -26,7 +26,7 @@ struct AltBlockAddon : public PopState<AltEndorsement> {
 
   void setNullInmemFields() {
     chainWork = 0;
-    endorsedBy.clear();
+    setNullEndorsedBy();
   }
 
   template <typename I>
@@ -86,6 +86,15 @@ struct AltBlockAddon : public PopState<AltEndorsement> {
     writeArrayOf<uint96>(w, _vbkblockids, writeSingleByteLenValue);
   }
 
+  //! compact encoding, see BlockIndex::toRaw
+  template <typename GetHash>
+  void toRawV2(WriteStream& w, const GetHash& getHash) const {
+    writeCompactArrayOf<uint256>(w, _atvids);
+    writeCompactArrayOf<uint256>(w, _vtbids);
+    writeCompactArrayOf<uint96>(w, _vbkblockids);
+    PopState<AltEndorsement>::toRawV2(w, _atvids, getHash);
+  }
+
  protected:
   //! list of changes introduced in this block
   // ATV::id_t
@@ -113,6 +122,14 @@ struct AltBlockAddon : public PopState<AltEndorsement> {
         r, [](ReadStream& s) -> uint96 { return readSingleByteLenValue(s); });
   }
 
+  template <typename GetHash>
+  void initAddonFromRawV2(ReadStream& r, const GetHash& getHash) {
+    _atvids = readCompactArrayOf<uint256>(r);
+    _vtbids = readCompactArrayOf<uint256>(r);
+    _vbkblockids = readCompactArrayOf<uint96>(r);
+    PopState<AltEndorsement>::initAddonFromRawV2(r, _atvids, getHash);
+  }
+
   template <typename pop_t>
   std::vector<typename pop_t::id_t>& getPayloadIdsInner();
 };
@@ -135,14 +135,16 @@ struct AltBlockTree : public BaseBlockTree<AltBlock> {
                    const PopData& popData,
                    ValidationState& state);
   //! @overload
-  bool addPayloads(index_t& index, PopData& payloads, ValidationState& state);
+  bool addPayloads(index_t& index,
+                   const PopData& payloads,
+                   ValidationState& state);
 
   /**
    * Efficiently connect block loaded from disk.
    *
-   * It recovers all pointers (pprev, pnext, endorsedBy,
-   * blockOfProofEndorsements), validates block and endorsements, recovers
-   * validity index, recovers tips array.
+   * It recovers all pointers (pprev, pnext, blockOfProofEndorsements),
+   * validates block and endorsements, recovers validity index, recovers tips
+   * array. `endorsedBy` is resolved on first access.
    * @param[in] index block
    * @param[out] state validation state
    * @return true if block is valid
@@ -152,6 +154,13 @@ struct AltBlockTree : public BaseBlockTree<AltBlock> {
    */
   bool loadBlock(const index_t& index, ValidationState& state) override;
 
+  //! same as loadBlock. When `trusted` is true, block has been validated
+  //! before it was saved: duplicates and endorsements are not checked.
+  //! @invariant NOT atomic.
+  bool loadCheckedBlock(const index_t& index,
+                        ValidationState& state,
+                        bool trusted);
+
   /**
    * After all blocks loaded, efficiently set current tip.
    * @param[in] hash tip hash
@@ -161,6 +170,37 @@ struct AltBlockTree : public BaseBlockTree<AltBlock> {
    */
   bool loadTip(const hash_t& hash, ValidationState& state) override;
 
+  /**
+   * Serialize BTC, VBK and ALT trees into a binary snapshot, which can be
+   * restored with restoreSnapshot.
+   * @param[out] stream snapshot is appended to this stream
+   * @param[in] key node-local secret, which authenticates the snapshot. Must be
+   * kept outside of the snapshot file, see SaveTreeCommitment.
+   * @ingroup api
+   */
+  void saveSnapshot(WriteStream& stream, Slice<const uint8_t> key) const;
+
+  /**
+   * Restore BTC, VBK and ALT trees from a snapshot written by saveSnapshot.
+   *
+   * Snapshot is position-independent, so it may point to a memory-mapped
+   * file. Its HMAC is verified with `key`, then blocks are loaded without
+   * re-validation, and tips are set.
+   * @param[in] snapshot snapshot bytes
+   * @param[in] key the same key, which was passed to saveSnapshot. Empty key
+   * is rejected.
+   * @param[out] state validation state
+   * @return true on success, false otherwise
+   * @warning PoW and endorsements of restored blocks are not checked, so
+   * snapshot must come from a trusted source, e.g. be written by this node
+   * @invariant NOT atomic. Trees must be bootstrapped, and should not contain
+   * other blocks.
+   * @ingroup api
+   */
+  bool restoreSnapshot(Slice<const uint8_t> snapshot,
+                       Slice<const uint8_t> key,
+                       ValidationState& state);
+
   /**
    * Efficiently compares current tip (A) and any other block (B).
    *
@@ -312,7 +352,7 @@ JsonValue ToJSON(const BlockIndex<AltBlock>& i) {
   json::putArrayKV(obj, "containingEndorsements", endorsements);
 
   std::vector<uint256> endorsedBy;
-  for (const auto* e : i.endorsedBy) {
+  for (const auto* e : i.getEndorsedBy()) {
     endorsedBy.push_back(e->id);
   }
   json::putArrayKV(obj, "endorsedBy", endorsedBy);
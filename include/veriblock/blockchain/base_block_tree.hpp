@@ -38,6 +38,26 @@ struct BaseBlockTree {
   const std::unordered_set<index_t*>& getTips() const { return tips_; }
   const block_index_t& getBlocks() const { return blocks_; }
 
+  //! blocks, which were modified since they were saved last time
+  const std::unordered_set<index_t*>& getDirtyBlocks() const {
+    return dirtyBlocks_;
+  }
+
+  //! hashes of blocks, which were removed since last save
+  const std::unordered_set<hash_t>& getRemovedBlocks() const {
+    return removedBlocks_;
+  }
+
+  //! marks all dirty blocks as saved and forgets removed blocks
+  void markSaved() {
+    std::unordered_set<index_t*> dirty;
+    dirty.swap(dirtyBlocks_);
+    for (auto* index : dirty) {
+      index->unsetDirty();
+    }
+    removedBlocks_.clear();
+  }
+
   virtual ~BaseBlockTree() = default;
 
   BaseBlockTree() = default;
@@ -413,10 +433,12 @@ struct BaseBlockTree {
     if (itr != removed_.end()) {
       newIndex = itr->second;
       removed_.erase(itr);
+      removedBlocks_.erase(hash);
     } else {
       newIndex = std::make_shared<index_t>();
     }
 
+    newIndex->setDirtySet(&dirtyBlocks_);
     newIndex->setNull();
     it = blocks_.insert({shortHash, std::move(newIndex)}).first;
     return it->second.get();
@@ -629,11 +651,16 @@ struct BaseBlockTree {
       block.pprev->pnext.erase(&block);
     }
 
-    auto shortHash = makePrevHash(block.getHash());
+    auto hash = block.getHash();
+    auto shortHash = makePrevHash(hash);
     auto it = blocks_.at(shortHash);
     // TODO: it is a hack because we do not erase blocks and just move them to
     // the remove_ container
     it->setNull();
+    // removed blocks are never written, they are reported by hash instead
+    it->setDirtySet(nullptr);
+    it->unsetDirty();
+    removedBlocks_.insert(hash);
     removed_[shortHash] = it;
     blocks_.erase(shortHash);
   }
@@ -654,6 +681,10 @@ struct BaseBlockTree {
   //! stores all removed blocks, to ensure pointers to blocks remain stable
   // TODO(bogdan): remove for future releases
   block_index_t removed_;
+  //! (memory only) stores blocks, which should be written on disk
+  std::unordered_set<index_t*> dirtyBlocks_;
+  //! (memory only) stores hashes of blocks, which should be deleted from disk
+  std::unordered_set<hash_t> removedBlocks_;
   //! stores ONLY VALID tips, including currently active tip
   std::unordered_set<index_t*> tips_;
   //! currently applied chain
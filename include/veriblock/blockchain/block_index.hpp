@@ -7,7 +7,9 @@
 #define ALT_INTEGRATION_INCLUDE_VERIBLOCK_BLOCKCHAIN_BLOCK_INDEX_HPP_
 
 #include <memory>
+#include <mutex>
 #include <set>
+#include <unordered_set>
 #include <vector>
 #include <veriblock/arith_uint256.hpp>
 #include <veriblock/blockchain/block_status.hpp>
@@ -88,10 +90,32 @@ struct BlockIndex : public Block::addon_t {
     return false;
   }
 
-  void setDirty() { this->dirty = true; }
-  void unsetDirty() { this->dirty = false; }
+  void setDirty() {
+    if (!this->dirty && this->dirtySet.ptr != nullptr) {
+      this->dirtySet.ptr->insert(this);
+    }
+    this->dirty = true;
+  }
+  void unsetDirty() {
+    if (this->dirtySet.ptr != nullptr) {
+      this->dirtySet.ptr->erase(this);
+    }
+    this->dirty = false;
+  }
   bool isDirty() const { return this->dirty; }
 
+  //! (memory only) while this block is dirty, it is kept in `set`.
+  //! Used by block tree to find modified blocks without a full scan.
+  void setDirtySet(std::unordered_set<BlockIndex*>* set) {
+    if (this->dirtySet.ptr != nullptr) {
+      this->dirtySet.ptr->erase(this);
+    }
+    this->dirtySet.ptr = set;
+    if (set != nullptr && this->dirty) {
+      set->insert(this);
+    }
+  }
+
   void setFlag(enum BlockStatus s) {
     this->status |= s;
     setDirty();
@@ -186,6 +210,27 @@ struct BlockIndex : public Block::addon_t {
     return nullptr;
   }
 
+  /**
+   * List of endorsements pointing to this block.
+   *
+   * Loaded blocks do not have it materialized: on first access it is
+   * collected from containing endorsements of descendants within endorsement
+   * settlement interval. Order of endorsements is not specified.
+   *
+   * May be called concurrently with other const methods, e.g. during parallel
+   * validation: collection is done under a lock.
+   */
+  template <typename A = addon_t>
+  const std::vector<typename A::endorsement_t*>& getEndorsedBy() const {
+    if (!this->isEndorsedByResolved()) {
+      std::lock_guard<std::mutex> lock(getResolutionMutex());
+      if (!this->isEndorsedByResolved()) {
+        resolveEndorsedBy<A>();
+      }
+    }
+    return this->endorsedBy;
+  }
+
   std::string toPrettyString(size_t level = 0) const {
     return fmt::sprintf("%s%sBlockIndex(height=%d, hash=%s, status=%d, %s)",
                         std::string(level, ' '),
@@ -200,18 +245,46 @@ struct BlockIndex : public Block::addon_t {
     return fmt::sprintf("%s:%d:%s", Block::name(), height, HexStr(getHash()));
   }
 
+  /**
+   * Compact (v2) encoding:
+   * `kRawV2Marker(1) | varint height | header | varint status | addon`.
+   *
+   * Addon stores reference counters as varints and payload ids as fixed-size
+   * values. Endorsement ids are stored as indices in block's payload ids, and
+   * containing hash is omitted as it is a hash of this block. Memory-only
+   * fields, like chainWork, are not stored and are restored on load.
+   */
   void toRaw(WriteStream& stream) const {
+    stream.writeBE<uint8_t>(kRawV2Marker);
+    writeVarInt(stream, (uint32_t)height);
+    header->toRaw(stream);
+    writeVarInt(stream, status);
+    addon_t::toRawV2(stream, [this]() { return getHash(); });
+  }
+
+  //! legacy (v1) encoding: `height(4) | header | status(4) | addon`
+  void toRawV1(WriteStream& stream) const {
     stream.writeBE<uint32_t>(height);
     header->toRaw(stream);
     stream.writeBE<uint32_t>(status);
     addon_t::toRaw(stream);
   }
 
+  //! reads both v1 and v2 encodings
   void initFromRaw(ReadStream& stream) {
-    height = stream.readBE<uint32_t>();
-    header = std::make_shared<Block>(Block::fromRaw(stream));
-    status = stream.readBE<uint32_t>();
-    addon_t::initAddonFromRaw(stream);
+    if (stream.remaining() > 0 &&
+        stream.data()[stream.position()] == kRawV2Marker) {
+      stream.readBE<uint8_t>();
+      height = (height_t)(uint32_t)readVarInt(stream);
+      header = std::make_shared<Block>(Block::fromRaw(stream));
+      status = (uint32_t)readVarInt(stream);
+      addon_t::initAddonFromRawV2(stream, [this]() { return getHash(); });
+    } else {
+      height = stream.readBE<uint32_t>();
+      header = std::make_shared<Block>(Block::fromRaw(stream));
+      status = stream.readBE<uint32_t>();
+      addon_t::initAddonFromRaw(stream);
+    }
     setDirty();
   }
 
@@ -233,6 +306,40 @@ struct BlockIndex : public Block::addon_t {
   }
 
  protected:
+  //! one of mutexes, which serialize resolution of `endorsedBy`
+  std::mutex& getResolutionMutex() const {
+    static std::mutex mutexes[64];
+    return mutexes[(reinterpret_cast<uintptr_t>(this) / sizeof(BlockIndex)) %
+                   64];
+  }
+
+  template <typename A>
+  void resolveEndorsedBy() const {
+    const auto hash = getHash();
+    const auto maxHeight =
+        height + this->_endorsedByWindow.value.load(std::memory_order_relaxed);
+    std::vector<const BlockIndex*> stack(pnext.begin(), pnext.end());
+    while (!stack.empty()) {
+      const auto* index = stack.back();
+      stack.pop_back();
+      if (index->height > maxHeight) {
+        continue;
+      }
+
+      for (const auto& p : index->getContainingEndorsements()) {
+        if (p.second->endorsedHash == hash) {
+          this->endorsedBy.push_back(p.second.get());
+        }
+      }
+      stack.insert(stack.end(), index->pnext.begin(), index->pnext.end());
+    }
+    this->_endorsedByWindow.value.store(0, std::memory_order_release);
+  }
+
+  //! first byte of v2 encoding. v1 encoding starts with big-endian height,
+  //! which never has the highest byte set to 0xff.
+  static const uint8_t kRawV2Marker = 0xff;
+
   //! height of the entry in the chain
   height_t height = 0;
 
@@ -244,6 +351,20 @@ struct BlockIndex : public Block::addon_t {
 
   //! (memory only) if true, this block should be written on disk
   bool dirty = false;
+
+ private:
+  //! pointer, which is neither copied nor assigned together with its
+  //! BlockIndex, so only the block owned by a tree is tracked
+  struct DirtySetPtr {
+    DirtySetPtr() = default;
+    DirtySetPtr(const DirtySetPtr&) {}
+    DirtySetPtr& operator=(const DirtySetPtr&) { return *this; }
+
+    std::unordered_set<BlockIndex*>* ptr = nullptr;
+  };
+
+  //! (memory only) dirty blocks of the tree, which owns this block
+  DirtySetPtr dirtySet{};
 };
 
 template <typename Block>
@@ -43,11 +43,15 @@ void removePayloadsFromIndex(Storage& storage,
                              BlockIndex<Block>& index,
                              const CommandGroup& cg);
 
+//! recovers `blockOfProofEndorsements` and resolved `endorsedBy` from
+//! containing endorsements of `toRecover`. When `chain` is null, endorsements
+//! are trusted and only resolved, not checked.
 template <typename ProtectedBlockTree>
-bool recoverEndorsements(ProtectedBlockTree& ed_,
-                         Chain<typename ProtectedBlockTree::index_t>& chain,
-                         typename ProtectedBlockTree::index_t& toRecover,
-                         ValidationState& state) {
+bool recoverEndorsements(
+    ProtectedBlockTree& ed_,
+    const Chain<typename ProtectedBlockTree::index_t>* chain,
+    typename ProtectedBlockTree::index_t& toRecover,
+    ValidationState& state) {
   std::vector<std::function<void()>> actions;
   auto& containingEndorsements = toRecover.getContainingEndorsements();
   actions.reserve(containingEndorsements.size());
@@ -57,7 +61,7 @@ bool recoverEndorsements(ProtectedBlockTree& ed_,
     auto& id = p.first;
     auto& e = *p.second;
 
-    if (id != e.id) {
+    if (chain && id != e.id) {
       return state.Invalid(
           "bad-id", fmt::format("Key={}, Id={}", HexStr(id), HexStr(e.id)));
     }
@@ -69,15 +73,16 @@ bool recoverEndorsements(ProtectedBlockTree& ed_,
           fmt::format("Can not find endorsed block in {}", e.toPrettyString()));
     }
 
-    if (chain[endorsed->getHeight()] == nullptr ||
-        chain[endorsed->getHeight()]->getHash() != e.endorsedHash ||
-        endorsed->getHash() != e.endorsedHash) {
+    if (chain &&
+        ((*chain)[endorsed->getHeight()] == nullptr ||
+         (*chain)[endorsed->getHeight()]->getHash() != e.endorsedHash ||
+         endorsed->getHash() != e.endorsedHash)) {
       return state.Invalid(
           "bad-endorsed",
           fmt::format("Endorsed block does not match {}", e.toPrettyString()));
     }
 
-    if (e.containingHash != toRecover.getHash()) {
+    if (chain && e.containingHash != toRecover.getHash()) {
       return state.Invalid("bad-containing",
                            fmt::format("Containing block does not match {}",
                                        e.toPrettyString()));
@@ -97,10 +102,14 @@ bool recoverEndorsements(ProtectedBlockTree& ed_,
     // delay execution. this ensures atomic changes - if any of endorsemens fail
     // validation, no 'action' is actually executed.
     actions.push_back([endorsed, blockOfProof, endorsement] {
-      auto& by = endorsed->endorsedBy;
-      VBK_ASSERT_MSG(std::find(by.begin(), by.end(), endorsement) == by.end(),
-                     "same endorsement is added to endorsedBy second time");
-      by.push_back(endorsement);
+      // no-op for loaded blocks, their `endorsedBy` is resolved lazily
+      if (endorsed->isEndorsedByResolved()) {
+        auto& by = endorsed->getEndorsedBy();
+        VBK_ASSERT_MSG(
+            std::find(by.begin(), by.end(), endorsement) == by.end(),
+            "same endorsement is added to endorsedBy second time");
+      }
+      endorsed->addEndorsedBy(endorsement);
 
       auto& bop = blockOfProof->blockOfProofEndorsements;
       VBK_ASSERT_MSG(
@@ -128,10 +128,29 @@ struct BlockTree : public BaseBlockTree<Block> {
 
   //! @invariant NOT atomic.
   bool loadBlock(const index_t& index, ValidationState& state) override {
+    if (!checkLoadedHeader(index, state)) {
+      return false;
+    }
+
+    return loadCheckedBlock(index, state, false);
+  }
+
+  //! stateless check of a block loaded from disk. Does not access the tree,
+  //! so may be called concurrently for different blocks.
+  bool checkLoadedHeader(const index_t& index, ValidationState& state) const {
     if (!checkBlock(index.getHeader(), state, *param_)) {
       return state.Invalid("bad-header");
     }
+    return true;
+  }
 
+  //! same as loadBlock, but header has already been checked with
+  //! checkLoadedHeader. When `trusted` is true, block has been validated
+  //! before it was saved, and is not checked contextually.
+  //! @invariant NOT atomic.
+  virtual bool loadCheckedBlock(const index_t& index,
+                                ValidationState& state,
+                                bool trusted) {
     if (!base::loadBlock(index, state)) {
       return false;
     }
@@ -142,7 +161,7 @@ struct BlockTree : public BaseBlockTree<Block> {
     auto* prev = current->pprev;
     // we only check blocks contextually if they are not bootstrap blocks, and
     // previous block exists
-    if (prev && !current->hasFlags(BLOCK_BOOTSTRAP) &&
+    if (!trusted && prev && !current->hasFlags(BLOCK_BOOTSTRAP) &&
         !contextuallyCheckBlock(*prev, current->getHeader(), state, *param_)) {
       return state.Invalid("bad-block-contextually");
     }
@@ -75,6 +75,29 @@ struct BtcBlockAddon {
         r, [](ReadStream& stream) { return stream.readBE<ref_height_t>(); });
   }
 
+  //! compact encoding, see BlockIndex::toRaw
+  template <typename GetHash>
+  void toRawV2(WriteStream& w, const GetHash&) const {
+    writeVarInt(w, refs.size());
+    for (auto ref : refs) {
+      writeVarInt(w, (uint32_t)ref);
+    }
+  }
+
+  template <typename GetHash>
+  void initAddonFromRawV2(ReadStream& r, const GetHash&) {
+    const auto count = readVarInt(r);
+    // every ref takes at least one byte
+    if (count > r.remaining()) {
+      throw std::out_of_range("BtcBlockAddon: bad refs count");
+    }
+    refs.clear();
+    refs.reserve((size_t)count);
+    for (uint64_t i = 0; i < count; i++) {
+      refs.push_back((ref_height_t)(uint32_t)readVarInt(r));
+    }
+  }
+
   std::string toPrettyString() const {
     return fmt::format("chainwork={}", chainWork.toHex());
   }
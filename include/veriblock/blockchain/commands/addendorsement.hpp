@@ -79,7 +79,7 @@ struct AddEndorsement : public Command {
     }
 
     containing->insertContainingEndorsement(e_);
-    endorsed->endorsedBy.push_back(e_.get());
+    endorsed->addEndorsedBy(e_.get());
     blockOfProof->blockOfProofEndorsements.push_back(e_.get());
 
     return true;
@@ -119,7 +119,7 @@ struct AddEndorsement : public Command {
     };
 
     // erase endorsedBy
-    bool p1 = erase_last_item_if<endorsement_t>(endorsed->endorsedBy, rm);
+    bool p1 = endorsed->removeEndorsedBy((Eit->second).get());
     VBK_ASSERT_MSG(p1,
                    "Failed to remove endorsement %s from endorsedBy in "
                    "AddEndorsement::Unexecute",
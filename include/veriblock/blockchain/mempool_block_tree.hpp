@@ -6,6 +6,7 @@
 #ifndef ALTINTEGRATION_MEMPOOL_BLOCK_TREE_HPP
 #define ALTINTEGRATION_MEMPOOL_BLOCK_TREE_HPP
 
+#include <set>
 #include <unordered_map>
 
 #include "veriblock/blockchain/alt_block_tree.hpp"
@@ -18,32 +19,187 @@ struct VbkPayloadsRelations {
   using height_t = typename VbkBlock::height_t;
 
   VbkPayloadsRelations(const VbkBlock& b)
-      : header(std::make_shared<VbkBlock>(b)) {}
+      : VbkPayloadsRelations(std::make_shared<VbkBlock>(b)) {}
 
   VbkPayloadsRelations(const std::shared_ptr<VbkBlock>& ptr_b)
-      : header(ptr_b) {}
+      : header(ptr_b),
+        id(ptr_b->getId()),
+        headerSize(ptr_b->serializedSize()),
+        usage_(headerUsage()) {}
 
   std::shared_ptr<VbkBlock> header;
+  //! id of `header`
+  id_t id;
+  //! VTBs contained in `header`
   std::vector<std::shared_ptr<VTB>> vtbs;
   std::vector<std::shared_ptr<ATV>> atvs;
 
+  //! VBK encoding sizes of header and payloads, cached when added
+  size_t headerSize = 0;
+  std::vector<size_t> vtbSizes;
+  std::vector<size_t> atvSizes;
+
+  //! keys of payloads, cached when added, so that MemPoolSelector does not
+  //! read payloads: id of VBK block published by VTB and sha256 of ALT block
+  //! header endorsed by ATV
+  std::vector<id_t> vtbPublished;
+  std::vector<uint256> atvEndorsed;
+
+  //! position in MemPool relations index, which is ordered by VBK height and
+  //! arrival
+  uint64_t arrival = 0;
+
+  //! eviction class and memory usage of this relation, last accounted by
+  //! MemPool
+  int evictionClass = -1;
+  size_t accountedUsage = 0;
+
+  //! true if `header` does not connect to VBK tree or to other relations in
+  //! MemPool, `orphanTime` is a time when relation became orphan
+  bool orphan = false;
+  uint32_t orphanTime = 0;
+
   PopData toPopData() const;
 
+  /**
+   * Same as toPopData().estimateSize() for PopData with first `vtbsCount`
+   * VTBs and `atvsCount` ATVs of this relation, but without serialization.
+   */
+  size_t estimateSize(size_t vtbsCount, size_t atvsCount) const;
+
+  size_t estimateSize() const {
+    return estimateSize(vtbs.size(), atvs.size());
+  }
+
   bool empty() const { return atvs.empty() && vtbs.empty(); }
 
+  /**
+   * Estimated memory used by relation and its payloads: objects, their heap
+   * data, shared pointers and entries in MemPool maps and indices.
+   */
+  size_t memoryUsage() const { return usage_; }
+
+  //! estimated memory used by payload with given VBK encoding size
+  template <typename Pop>
+  static size_t payloadUsage(size_t serializedSize) {
+    // object and its heap data, which is roughly the same as its encoding,
+    // control block of shared_ptr, node of MemPool map with id and pointer,
+    // pointer, cached size and key (at most 32 bytes) in relation
+    return sizeof(Pop) + serializedSize + 2 * sizeof(void*) +
+           (sizeof(void*) + sizeof(typename Pop::id_t) +
+            sizeof(std::shared_ptr<Pop>)) +
+           (sizeof(std::shared_ptr<Pop>) + sizeof(size_t) + sizeof(uint256));
+  }
+
+  void addVTB(std::shared_ptr<VTB> vtb);
+  void addATV(std::shared_ptr<ATV> atv);
+
   void removeVTB(const VTB::id_t& vtb_id);
   void removeATV(const ATV::id_t& atv_id);
+
+  //! removes VTBs for which `pred` returns true
+  template <typename Pred>
+  void removeVTBsIf(const Pred& pred) {
+    removeIf(vtbs, vtbSizes, vtbPublished, pred);
+  }
+
+  //! removes ATVs for which `pred` returns true
+  template <typename Pred>
+  void removeATVsIf(const Pred& pred) {
+    removeIf(atvs, atvSizes, atvEndorsed, pred);
+  }
+
+ private:
+  size_t usage_ = 0;
+
+  //! estimated memory used by header, relation and its index entries
+  size_t headerUsage() const {
+    // relation and header objects with their shared_ptrs, nodes of MemPool
+    // maps and indices
+    return sizeof(VbkPayloadsRelations) + payloadUsage<VbkBlock>(headerSize) +
+           3 * (sizeof(void*) * 4 + sizeof(VbkBlock::id_t));
+  }
+
+  template <typename T, typename Key, typename Pred>
+  void removeIf(std::vector<std::shared_ptr<T>>& payloads,
+                std::vector<size_t>& sizes,
+                std::vector<Key>& keys,
+                const Pred& pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+      if (pred(*payloads[i])) {
+        usage_ -= payloadUsage<T>(sizes[i]);
+        continue;
+      }
+      payloads[kept] = std::move(payloads[i]);
+      sizes[kept] = sizes[i];
+      keys[kept] = keys[i];
+      ++kept;
+    }
+    payloads.resize(kept);
+    sizes.resize(kept);
+    keys.resize(kept);
+  }
 };
 
+/**
+ * @struct MemPoolBlockTree
+ *
+ * Speculative view of AltBlockTree, used to validate candidate PopData for the
+ * next ALT block.
+ *
+ * VBK and BTC blocks from payloads are added to copy-on-write overlays
+ * (TempBlockTree) on top of the stable VBK and BTC trees, and endorsements are
+ * checked against the overlays, so the overlays can be discarded without
+ * touching AltBlockTree.
+ *
+ * Checks mirror what happens when payloads are connected to the next block on
+ * top of current ALT tip: duplicates, header validity, BTC context of VTBs and
+ * endorsement windows. Effects of VBK fork resolution are not modelled, so
+ * this is a cheap pre-filter: payloads it accepts still have to pass
+ * AltBlockTree::filterInvalidPayloads.
+ */
 struct MemPoolBlockTree {
   using BtcBlockTree = typename VbkBlockTree::BtcTree;
 
   MemPoolBlockTree(const AltBlockTree& tree)
-      : temp_vbk_tree_(tree.vbk()), temp_btc_tree_(tree.btc()), tree_(tree) {
-    (void)tree_;
-    (void)temp_vbk_tree_;
-    (void)temp_btc_tree_;
-  }
+      : temp_vbk_tree_(tree.vbk()), temp_btc_tree_(tree.btc()), tree_(tree) {}
+
+  /**
+   * Speculatively add VBK block from PopData context.
+   * @return true if block can be added, false otherwise
+   */
+  bool acceptVbkBlock(const VbkBlock& blk, ValidationState& state);
+
+  /**
+   * Discard VBK block accepted by acceptVbkBlock. Blocks and payloads accepted
+   * on top of it must be discarded before.
+   */
+  void removeVbkBlock(const VbkBlock& blk);
+
+  /**
+   * Speculatively add VTB. Its containing block must be accepted before.
+   * @return true if VTB can be added, false otherwise
+   */
+  bool acceptVTB(const VTB& vtb, ValidationState& state);
+
+  /**
+   * Speculatively add ATV to the next block on top of current ALT tip.
+   * @return true if ATV can be added, false otherwise
+   */
+  bool acceptATV(const ATV& atv, ValidationState& state);
+
+  /**
+   * Remove payloads, which can not be added to the next block on top of
+   * current ALT tip, from `pop`. Discards previously accepted payloads.
+   */
+  void filterInvalidPayloads(PopData& pop);
+
+  //! discard all speculatively accepted blocks and payloads
+  void clear();
+
+  const TempBlockTree<VbkBlockTree>& vbk() const { return temp_vbk_tree_; }
+  const TempBlockTree<BtcBlockTree>& btc() const { return temp_btc_tree_; }
 
   /**
    * Compares ATVs for the strongly equivalence
@@ -87,9 +243,23 @@ struct MemPoolBlockTree {
   int weaklyCompare(const VTB& vtb1, const VTB& vtb2);
 
  private:
+  //! true if payload is already added to ALT active chain
+  bool isOnActiveChain(const std::vector<uint8_t>& id) const;
+
+  //! true if BTC context of VTB connects to BTC blocks known at containing
+  //! height, see VbkBlockTree::validateBTCContext
+  bool validateBTCContext(const VTB& vtb, ValidationState& state) const;
+
   TempBlockTree<VbkBlockTree> temp_vbk_tree_;
   TempBlockTree<BtcBlockTree> temp_btc_tree_;
   const AltBlockTree& tree_;
+
+  // ids of accepted payloads
+  std::set<VbkBlock::id_t> vbkblocks_;
+  std::set<VTB::id_t> vtbs_;
+  std::set<ATV::id_t> atvs_;
+  // min VBK height at which accepted BTC blocks are referenced
+  std::unordered_map<BtcBlock::hash_t, int32_t> btcRefs_;
 };
 
 }  // namespace altintegration
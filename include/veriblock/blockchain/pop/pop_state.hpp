@@ -6,10 +6,15 @@
 #ifndef VERIBLOCK_POP_CPP_POP_STATE_HPP
 #define VERIBLOCK_POP_CPP_POP_STATE_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
+#include <veriblock/algorithm.hpp>
+#include <veriblock/hashers.hpp>
 #include <veriblock/serde.hpp>
 #include <veriblock/uint.hpp>
 
@@ -24,15 +29,44 @@ struct PopState {
       std::multimap<eid_t, std::shared_ptr<endorsement_t>>;
 
   //! (memory-only) list of endorsements pointing to this block.
+  //! Not materialized for loaded blocks, read it with
+  //! BlockIndex::getEndorsedBy.
   // must be a vector, because we can have duplicates here
-  std::vector<endorsement_t*> endorsedBy;
+  mutable std::vector<endorsement_t*> endorsedBy;
 
   const containing_endorsement_store_t& getContainingEndorsements() const {
     return _containingEndorsements;
   }
 
-  const std::vector<endorsement_t*>& getEndorsedBy() const {
-    return endorsedBy;
+  //! false if `endorsedBy` is not materialized yet, see
+  //! BlockIndex::getEndorsedBy
+  bool isEndorsedByResolved() const {
+    return _endorsedByWindow.value.load(std::memory_order_acquire) == 0;
+  }
+
+  //! drops `endorsedBy`. It will be collected from containing endorsements of
+  //! descendants, which are at most `window` blocks higher, on first access.
+  void setEndorsedByUnresolved(int32_t window) {
+    VBK_ASSERT(window > 0);
+    endorsedBy.clear();
+    _endorsedByWindow.value.store(window, std::memory_order_release);
+  }
+
+  //! does nothing if `endorsedBy` is not resolved yet - `e` will be found in
+  //! its containing block during resolution
+  void addEndorsedBy(endorsement_t* e) {
+    if (isEndorsedByResolved()) {
+      endorsedBy.push_back(e);
+    }
+  }
+
+  //! @return false if `endorsedBy` is resolved and does not contain `e`
+  bool removeEndorsedBy(const endorsement_t* e) {
+    if (!isEndorsedByResolved()) {
+      return true;
+    }
+    return erase_last_item_if<endorsement_t>(
+        endorsedBy, [e](const endorsement_t* it) { return it == e; });
   }
 
   void insertContainingEndorsement(std::shared_ptr<endorsement_t> e) {
@@ -62,16 +96,126 @@ struct PopState {
         });
   }
 
+  /**
+   * Compact encoding of containing endorsements.
+   *
+   * Endorsement id, which is also an id of a payload in `payloadIds`, is
+   * written as an index in `payloadIds`. Containing hash is omitted, if it is
+   * a hash of this block. Hashes and payout info, which repeat when several
+   * payloads of this block endorse the same block, are written once and then
+   * referenced by number. `getHash` is called only when there are
+   * endorsements.
+   */
+  template <typename GetHash>
+  void toRawV2(WriteStream& w,
+               const std::vector<eid_t>& payloadIds,
+               const GetHash& getHash) const {
+    writeVarInt(w, _containingEndorsements.size());
+    if (_containingEndorsements.empty()) {
+      return;
+    }
+
+    std::unordered_map<eid_t, size_t> payloadPosition;
+    payloadPosition.reserve(payloadIds.size());
+    for (size_t i = 0; i < payloadIds.size(); i++) {
+      payloadPosition.insert({payloadIds[i], i});
+    }
+
+    const auto containingHash = getHash();
+    written_values_t written;
+    for (const auto& p : _containingEndorsements) {
+      const auto& e = *p.second;
+      auto it = payloadPosition.find(e.id);
+      uint8_t flags = 0;
+      if (it != payloadPosition.end()) {
+        flags |= kEndorsementIdIsPayloadId;
+      }
+      if (e.containingHash == containingHash) {
+        flags |= kEndorsementIsContained;
+      }
+
+      w.writeBE<uint8_t>(flags);
+      if ((flags & kEndorsementIdIsPayloadId) != 0) {
+        writeVarInt(w, (uint64_t)it->second);
+      } else {
+        writeSingleByteLenValue(w, e.id);
+      }
+      writeDeduplicated(w, written, e.endorsedHash);
+      if ((flags & kEndorsementIsContained) == 0) {
+        writeDeduplicated(w, written, e.containingHash);
+      }
+      writeDeduplicated(w, written, e.blockOfProof);
+      writeDeduplicated(w, written, e.payoutInfo);
+    }
+  }
+
   // hide setters from public usage
  protected:
+  static const uint8_t kEndorsementIdIsPayloadId = 1 << 0;
+  static const uint8_t kEndorsementIsContained = 1 << 1;
+
+  //! values written by toRawV2, mapped to their numbers
+  using written_values_t = std::unordered_map<std::vector<uint8_t>, uint64_t>;
+
+  //! writes 0 followed by `value`, or number of equal value written before
+  //! plus 1
+  static void writeDeduplicated(WriteStream& w,
+                                written_values_t& written,
+                                Slice<const uint8_t> value) {
+    auto pair = written.insert({value.asVector(), (uint64_t)written.size()});
+    if (!pair.second) {
+      writeVarInt(w, pair.first->second + 1);
+      return;
+    }
+    writeVarInt(w, 0);
+    writeSingleByteLenValue(w, value);
+  }
+
+  //! reads value written by writeDeduplicated
+  static Slice<const uint8_t> readDeduplicated(
+      ReadStream& r, std::vector<Slice<const uint8_t>>& read) {
+    auto number = readVarInt(r);
+    if (number == 0) {
+      read.push_back(readSingleByteLenValue(r));
+      return read.back();
+    }
+    return read.at((size_t)number - 1);
+  }
+
   //! (stored as vector) list of containing endorsements in this block
   containing_endorsement_store_t _containingEndorsements{};
 
+  //! atomic, which is copied and assigned by value, so that PopState stays
+  //! copyable
+  struct EndorsedByWindow {
+    EndorsedByWindow() = default;
+    EndorsedByWindow(const EndorsedByWindow& other)
+        : value(other.value.load(std::memory_order_relaxed)) {}
+    EndorsedByWindow& operator=(const EndorsedByWindow& other) {
+      value.store(other.value.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+      return *this;
+    }
+
+    std::atomic<int32_t> value{0};
+  };
+
+  //! (memory-only) 0 if `endorsedBy` is resolved. Otherwise, max height
+  //! difference between this block and blocks containing its endorsements.
+  //! Set to 0 with release order after `endorsedBy` is collected, so readers
+  //! which see 0 also see collected `endorsedBy`.
+  mutable EndorsedByWindow _endorsedByWindow{};
+
   void setDirty();
 
   void setNull() {
     _containingEndorsements.clear();
+    setNullEndorsedBy();
+  }
+
+  void setNullEndorsedBy() {
     endorsedBy.clear();
+    _endorsedByWindow.value.store(0, std::memory_order_relaxed);
   }
 
   void initAddonFromRaw(ReadStream& r) {
@@ -87,9 +231,43 @@ struct PopState {
     // do not restore 'endorsedBy', it will be done later
   }
 
+  //! reads compact encoding written by toRawV2
+  template <typename GetHash>
+  void initAddonFromRawV2(ReadStream& r,
+                          const std::vector<eid_t>& payloadIds,
+                          const GetHash& getHash) {
+    const auto count = readVarInt(r);
+    if (count == 0) {
+      return;
+    }
+
+    const auto containingHash = getHash();
+    std::vector<Slice<const uint8_t>> read;
+    for (uint64_t i = 0; i < count; i++) {
+      auto e = std::make_shared<endorsement_t>();
+      auto flags = r.readBE<uint8_t>();
+      if ((flags & kEndorsementIdIsPayloadId) != 0) {
+        e->id = payloadIds.at((size_t)readVarInt(r));
+      } else {
+        e->id = readSingleByteLenValue(r);
+      }
+      e->endorsedHash = readDeduplicated(r, read).asVector();
+      if ((flags & kEndorsementIsContained) != 0) {
+        e->containingHash = containingHash;
+      } else {
+        e->containingHash = readDeduplicated(r, read).asVector();
+      }
+      e->blockOfProof = readDeduplicated(r, read).asVector();
+      e->payoutInfo = readDeduplicated(r, read).asVector();
+      _containingEndorsements.insert({e->id, std::move(e)});
+    }
+    // do not restore 'endorsedBy', it will be done later
+  }
+
   void initAddonFromOther(const PopState& other) {
     _containingEndorsements = other._containingEndorsements;
     endorsedBy = other.endorsedBy;
+    _endorsedByWindow = other._endorsedByWindow;
   }
 };
 
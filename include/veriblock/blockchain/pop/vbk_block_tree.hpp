@@ -53,12 +53,15 @@ struct VbkBlockTree : public BlockTree<VbkBlock, VbkChainParams> {
                PayloadsIndex& payloadsIndex);
 
   //! efficiently connect `index` to current tree, loaded from disk
-  //! - recovers all pointers (pprev, pnext, endorsedBy)
+  //! - recovers all pointers (pprev, pnext), `endorsedBy` is resolved on
+  //!   first access
   //! - recalculates chainWork
-  //! - does validation of endorsements
+  //! - does validation of endorsements, unless block is `trusted`
   //! - recovers tips array
   //! @invariant NOT atomic.
-  bool loadBlock(const index_t& index, ValidationState& state) override;
+  bool loadCheckedBlock(const index_t& index,
+                        ValidationState& state,
+                        bool trusted) override;
 
   BtcTree& btc() { return cmp_.getProtectingBlockTree(); }
   const BtcTree& btc() const { return cmp_.getProtectingBlockTree(); }
@@ -157,7 +160,7 @@ JsonValue ToJSON(const BlockIndex<VbkBlock>& i) {
   json::putArrayKV(obj, "containingEndorsements", endorsements);
 
   std::vector<uint256> endorsedBy;
-  for (const auto* e : i.endorsedBy) {
+  for (const auto* e : i.getEndorsedBy()) {
     endorsedBy.push_back(e->id);
   }
   json::putArrayKV(obj, "endorsedBy", endorsedBy);
@@ -8,10 +8,24 @@
 
 #include <memory>
 
+#include "veriblock/blockchain/blockchain_util.hpp"
+#include "veriblock/stateless_validation.hpp"
 #include "veriblock/validation_state.hpp"
 
 namespace altintegration {
 
+/**
+ * @struct TempBlockTree
+ *
+ * Copy-on-write overlay on top of a stable block tree.
+ *
+ * Blocks accepted to TempBlockTree are stored in the overlay only, and their
+ * `pprev` may point into the stable tree. Lookups check the overlay first,
+ * then fall back to the stable tree. Stable tree is never modified, so blocks
+ * can be validated speculatively and discarded with `clear`.
+ *
+ * @invariant stable tree must not remove blocks while overlay refers to them.
+ */
 template <typename StableBlockTree>
 struct TempBlockTree {
   using block_tree_t = StableBlockTree;
@@ -19,7 +33,7 @@ struct TempBlockTree {
   using index_t = typename block_tree_t::index_t;
   using block_index_t = typename block_tree_t::base::block_index_t;
 
-  TempBlockTree(const block_tree_t& tree) : tree_(tree) { (void)tree_; }
+  TempBlockTree(const block_tree_t& tree) : tree_(tree) {}
 
   template <typename T,
             typename = typename std::enable_if<
@@ -32,57 +46,81 @@ struct TempBlockTree {
                                     : it->second.get();
   }
 
-  bool accpetBlock(const block_t& header, ValidationState& state) {
+  bool acceptBlock(const block_t& header, ValidationState& state) {
     return acceptBlock(std::make_shared<block_t>(header), state);
   }
 
+  /**
+   * Validate block against overlay and add it to the overlay.
+   *
+   * Performs same checks as BlockTree::acceptBlock: stateless checks,
+   * previous block must be known and valid, contextual checks.
+   * @return true if block is valid, false otherwise
+   */
   bool acceptBlock(const std::shared_ptr<block_t>& header,
                    ValidationState& state) {
-    auto* prev = getBlockIndex(header->previousBlock);
+    auto* current = getBlockIndex(header->getHash());
+    if (current != nullptr) {
+      // it is a duplicate
+      return current->isValid()
+                 ? true
+                 : state.Invalid(block_t::name() + "-bad-chain",
+                                 "Block is invalid");
+    }
+
+    if (!checkBlock(*header, state, tree_.getParams())) {
+      return state.Invalid(block_t::name() + "-check-block");
+    }
 
+    auto* prev = getBlockIndex(header->previousBlock);
     if (prev == nullptr) {
       return state.Invalid(
           block_t::name() + "-bad-prev-block",
           "can not find previous block: " + HexStr(header->previousBlock));
     }
 
-    auto index = insertBlockHeader(header);
+    if (!prev->isValid()) {
+      return state.Invalid(
+          block_t::name() + "-bad-chain",
+          fmt::sprintf("Previous block is invalid=%s", prev->toPrettyString()));
+    }
+
+    if (!contextuallyCheckBlock(*prev, *header, state, tree_.getParams())) {
+      return state.Invalid(block_t::name() + "-contextually-check-block");
+    }
+
+    auto index = doInsertBlockHeader(header, prev);
     VBK_ASSERT(index != nullptr &&
-               "insertBlockHeader should have never returned nullptr");
+               "doInsertBlockHeader should have never returned nullptr");
 
     return true;
   }
 
-  const block_tree_t& getStableTree() const { return tree_; }
-
- private:
-  index_t* insertBlockHeader(const std::shared_ptr<block_t>& header) {
-    auto hash = header->getHash();
-    index_t* current = getBlockIndex(hash);
-    if (current != nullptr) {
-      // it is a duplicate
-      return current;
-    }
+  //! number of blocks in the overlay
+  size_t size() const { return temp_blocks_.size(); }
 
-    current = doInsertBlockHeader(header);
-    VBK_ASSERT(current != nullptr);
+  //! discards all blocks in the overlay
+  void clear() { temp_blocks_.clear(); }
 
-    return current;
+  //! discards block from the overlay. Blocks accepted on top of it must be
+  //! discarded before.
+  void removeBlock(const typename block_t::hash_t& hash) {
+    temp_blocks_.erase(tree_.makePrevHash(hash));
   }
 
-  index_t* doInsertBlockHeader(const std::shared_ptr<block_t>& header) {
+  const block_tree_t& getStableTree() const { return tree_; }
+
+ private:
+  index_t* doInsertBlockHeader(const std::shared_ptr<block_t>& header,
+                               index_t* prev) {
     VBK_ASSERT(header != nullptr);
 
     index_t* current = touchBlockIndex(header->getHash());
-    current->setHeader(std::move(header));
-    current->pprev = getBlockIndex(header->previousBlock);
-
-    if (current->pprev != nullptr) {
-      // prev block found
-      current->setHeight(current->pprev->getHeight() + 1);
-    } else {
-      current->setHeight(0);
-    }
+    current->setHeader(header);
+    current->pprev = prev;
+    current->setHeight(prev->getHeight() + 1);
+    // overlay blocks are never applied
+    current->setFlag(BLOCK_VALID_TREE);
 
     return current;
   }
@@ -107,4 +145,4 @@ struct TempBlockTree {
 
 }  // namespace altintegration
 
-#endif
\ No newline at end of file
+#endif
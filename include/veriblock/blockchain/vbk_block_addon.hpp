@@ -32,7 +32,7 @@ struct VbkBlockAddon : public PopState<VbkEndorsement> {
   void setNullInmemFields() {
     chainWork = 0;
     blockOfProofEndorsements.clear();
-    endorsedBy.clear();
+    setNullEndorsedBy();
   }
 
   template <typename I>
@@ -99,6 +99,14 @@ struct VbkBlockAddon : public PopState<VbkEndorsement> {
     writeArrayOf<uint256>(w, _vtbids, writeSingleByteLenValue);
   }
 
+  //! compact encoding, see BlockIndex::toRaw
+  template <typename GetHash>
+  void toRawV2(WriteStream& w, const GetHash& getHash) const {
+    writeVarInt(w, _refCount);
+    writeCompactArrayOf<uint256>(w, _vtbids);
+    PopState<VbkEndorsement>::toRawV2(w, _vtbids, getHash);
+  }
+
  protected:
   //! reference counter for fork resolution
   uint32_t _refCount = 0;
@@ -121,6 +129,13 @@ struct VbkBlockAddon : public PopState<VbkEndorsement> {
     _vtbids = readArrayOf<uint256>(
         r, [](ReadStream& s) -> uint256 { return readSingleByteLenValue(s); });
   }
+
+  template <typename GetHash>
+  void initAddonFromRawV2(ReadStream& r, const GetHash& getHash) {
+    _refCount = (uint32_t)readVarInt(r);
+    _vtbids = readCompactArrayOf<uint256>(r);
+    PopState<VbkEndorsement>::initAddonFromRawV2(r, _vtbids, getHash);
+  }
 };
 
 }  // namespace altintegration
@@ -92,12 +92,25 @@ struct Address {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes
+  size_t serializedSize() const;
+
  private:
   Address(AddressType type, std::string addr)
       : m_Type(type), m_Address(std::move(addr)) {}
 
+  //! validates `input`, which decodes to `decodedSize` bytes
+  Address(const std::string& input, size_t decodedSize);
+
+  friend bool Deserialize(ReadStream& stream,
+                          Address& out,
+                          ValidationState& state);
+
   AddressType m_Type{};
   std::string m_Address{};
+  //! size of decoded address bytes, known after VBK decoding, otherwise
+  //! computed on first serializedSize() call. 0 if unknown.
+  mutable size_t m_DecodedSize = 0;
 };
 
 //! @overload
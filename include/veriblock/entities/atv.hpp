@@ -59,6 +59,9 @@ struct ATV {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Convert ATV to raw bytes data using Vbk byte format
    * @return bytes data
@@ -83,6 +83,9 @@ struct BtcBlock {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   uint32_t getDifficulty() const;
 
   uint32_t getBlockTime() const;
@@ -52,6 +52,9 @@ struct BtcTx {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Calculate the hash of the btc transaction
    * @return hash transaction hash
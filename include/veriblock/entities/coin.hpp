@@ -36,6 +36,9 @@ struct Coin {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Compare two Coins for equality
    * @param other Coin
@@ -0,0 +1,143 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_INCLUDE_VERIBLOCK_ENTITIES_COMPACT_POPDATA_HPP_
+#define ALT_INTEGRATION_INCLUDE_VERIBLOCK_ENTITIES_COMPACT_POPDATA_HPP_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "veriblock/blob.hpp"
+#include "veriblock/entities/popdata.hpp"
+#include "veriblock/serde.hpp"
+#include "veriblock/slice.hpp"
+
+namespace altintegration {
+
+/**
+ * @struct CompactPopData
+ *
+ * Compact encoding of PopData for ALT block relay. Payloads, which receiver
+ * most likely has in its MemPool, are replaced by 6-byte salted short ids.
+ * Payloads, which sender predicts to be missing, are sent in full
+ * ("prefilled") together with their position in PopData.
+ *
+ * Receiver rebuilds PopData with MemPool::reconstruct, requests payloads,
+ * which it could not find, and calls MemPool::reconstruct again with them.
+ *
+ * @note short id collisions are possible, so reconstructed PopData must be
+ * validated the same way as PopData received in full.
+ *
+ * @version 1
+ */
+struct CompactPopData {
+  using short_id_t = Blob<6>;
+
+  //! payloads of a single type in PopData order
+  template <typename Pop>
+  struct Payloads {
+    //! short ids of payloads, which are not prefilled, in PopData order
+    std::vector<short_id_t> shortIds;
+    //! prefilled payloads with their indexes in PopData, sorted by index
+    std::vector<std::pair<uint32_t, Pop>> prefilled;
+
+    //! number of payloads in PopData
+    size_t size() const { return shortIds.size() + prefilled.size(); }
+  };
+
+  //! indexes of payloads, which could not be found during reconstruction
+  struct Missing {
+    std::vector<uint32_t> context;
+    std::vector<uint32_t> vtbs;
+    std::vector<uint32_t> atvs;
+
+    size_t size() const { return context.size() + vtbs.size() + atvs.size(); }
+    bool empty() const { return size() == 0; }
+  };
+
+  uint32_t version = 1;
+  //! salt of short ids, chosen by sender
+  uint64_t salt = 0;
+  Payloads<VbkBlock> context;
+  Payloads<VTB> vtbs;
+  Payloads<ATV> atvs;
+
+  //! short id of payload with given id: first 6 bytes of sha256(salt || id)
+  static short_id_t shortId(uint64_t salt, Slice<const uint8_t> id);
+
+  template <typename Id>
+  short_id_t shortId(const Id& id) const {
+    return shortId(salt, Slice<const uint8_t>(id.data(), id.size()));
+  }
+
+  /**
+   * Build compact encoding of `pop`.
+   * @param[in] pop PopData to encode
+   * @param[in] salt salt of short ids
+   * @param[in] prefill functor, which is called with every payload and returns
+   * true if payload should be sent in full
+   */
+  template <typename Prefill>
+  static CompactPopData fromPopData(const PopData& pop,
+                                    uint64_t salt,
+                                    const Prefill& prefill) {
+    CompactPopData c;
+    c.version = pop.version;
+    c.salt = salt;
+    c.add(pop.context, prefill, c.context);
+    c.add(pop.vtbs, prefill, c.vtbs);
+    c.add(pop.atvs, prefill, c.atvs);
+    return c;
+  }
+
+  /**
+   * Read VBK data from the stream and convert it to CompactPopData
+   * @param stream data stream to read from
+   * @throws std::out_of_range, std::domain_error on invalid data
+   * @return CompactPopData
+   */
+  static CompactPopData fromVbkEncoding(ReadStream& stream);
+
+  /**
+   * Convert CompactPopData to data stream using Vbk byte format
+   * @param stream data stream to write into
+   */
+  void toVbkEncoding(WriteStream& stream) const;
+
+  /**
+   * Convert CompactPopData to raw bytes data using Vbk byte format
+   * @return bytes data
+   */
+  std::vector<uint8_t> toVbkEncoding() const;
+
+  friend bool operator==(const CompactPopData& a, const CompactPopData& b) {
+    return a.toVbkEncoding() == b.toVbkEncoding();
+  }
+
+ private:
+  template <typename Pop, typename Prefill>
+  void add(const std::vector<Pop>& payloads,
+           const Prefill& prefill,
+           Payloads<Pop>& out) const {
+    for (size_t i = 0; i < payloads.size(); i++) {
+      const auto& p = payloads[i];
+      if (prefill(p)) {
+        out.prefilled.emplace_back((uint32_t)i, p);
+      } else {
+        out.shortIds.push_back(shortId(p.getId()));
+      }
+    }
+  }
+};
+
+bool Deserialize(ReadStream& stream,
+                 CompactPopData& out,
+                 ValidationState& state);
+
+}  // namespace altintegration
+
+#endif
@@ -47,12 +47,18 @@ struct MerklePath {
    */
   void toRaw(WriteStream& stream) const;
 
+  //! size of raw encoding in bytes, computed without serialization
+  size_t rawSize() const;
+
   /**
    * Convert MerklePath to data stream using MerklePath VBK byte format
    * @param stream data stream to write into
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Calculate the hash of the merkle root
    * @return hash merkle root hash
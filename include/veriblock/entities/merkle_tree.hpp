@@ -69,15 +69,26 @@ struct MerkleTree {
     layers.push_back(layer);
 
     layer.resize(n % 2 == 0 ? n : n + 1);
+    // concatenated pairs of nodes, all nodes of a layer are hashed in a batch
+    std::vector<uint8_t> concat;
+    std::vector<Slice<const uint8_t>> pairs;
     while (n > 1) {
       if (n % 2) {
         layer[n] = layer[n - 1];
         ++n;
       }
       n /= 2;
+      concat.resize(2 * n * txhash_t::size());
+      pairs.clear();
       for (size_t i = 0; i < n; i++) {
-        layer[i] = instance.hash(layer[2 * i], layer[2 * i + 1]);
+        uint8_t* pair = concat.data() + 2 * i * txhash_t::size();
+        std::copy(layer[2 * i].begin(), layer[2 * i].end(), pair);
+        std::copy(layer[2 * i + 1].begin(),
+                  layer[2 * i + 1].end(),
+                  pair + txhash_t::size());
+        pairs.emplace_back(pair, 2 * txhash_t::size());
       }
+      instance.hashBatch(pairs, Slice<txhash_t>(layer.data(), n));
       layers.push_back({layer.begin(), layer.begin() + n});
     }
   }
@@ -96,6 +107,11 @@ struct VbkMerkleTree : public MerkleTree<VbkMerkleTree> {
 
   txhash_t hash(const txhash_t& a, const txhash_t& b) { return sha256(a, b); }
 
+  void hashBatch(Slice<const Slice<const uint8_t>> pairs,
+                 Slice<txhash_t> out) {
+    sha256Batch(pairs, out);
+  }
+
   std::vector<txhash_t> finalizePath(std::vector<txhash_t> path) {
     // opposite tree merkle root (we don't have the opposite tree)
     path.emplace_back();
@@ -143,6 +159,11 @@ struct BtcMerkleTree : public MerkleTree<BtcMerkleTree> {
     return sha256twice(a, b);
   }
 
+  void hashBatch(Slice<const Slice<const uint8_t>> pairs,
+                 Slice<txhash_t> out) {
+    sha256twiceBatch(pairs, out);
+  }
+
   std::vector<txhash_t> finalizePath(const std::vector<txhash_t>& path) {
     return path;
   }
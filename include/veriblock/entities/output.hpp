@@ -46,6 +46,9 @@ struct Output {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   std::string toPrettyString() const;
 };
 
@@ -0,0 +1,175 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_INCLUDE_VERIBLOCK_ENTITIES_PAYLOADS_VIEW_HPP_
+#define ALT_INTEGRATION_INCLUDE_VERIBLOCK_ENTITIES_PAYLOADS_VIEW_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "veriblock/entities/atv.hpp"
+#include "veriblock/entities/btcblock.hpp"
+#include "veriblock/entities/publication_data.hpp"
+#include "veriblock/entities/vbkblock.hpp"
+#include "veriblock/entities/vbkpoptx.hpp"
+#include "veriblock/entities/vtb.hpp"
+#include "veriblock/serde.hpp"
+#include "veriblock/slice.hpp"
+
+/**
+ * @file payloads_view.hpp
+ *
+ * Non-owning views over VBK-encoded payloads.
+ *
+ * Deserialization of a view only records boundaries of every field, and
+ * validates lengths and counts. Fields are decoded on demand, ids are
+ * calculated directly over viewed bytes. Views are valid as long as
+ * underlying buffer (provider buffer, mmaped file) is alive.
+ */
+
+namespace altintegration {
+
+/**
+ * @struct VbkPopTxView
+ *
+ * View over VBK-encoded VbkPopTx.
+ *
+ * @ingroup entities
+ */
+struct VbkPopTxView {
+  using hash_t = VbkPopTx::hash_t;
+
+  //! raw tx bytes, without signature and public key
+  Slice<const uint8_t> raw{};
+  Slice<const uint8_t> signature{};
+  Slice<const uint8_t> publicKey{};
+  //! raw VBK header of endorsed block
+  Slice<const uint8_t> publishedBlock{};
+  //! raw BTC tx
+  Slice<const uint8_t> bitcoinTransaction{};
+  //! raw MerklePath of `bitcoinTransaction`
+  Slice<const uint8_t> merklePath{};
+  //! raw BTC header of block of proof
+  Slice<const uint8_t> blockOfProof{};
+  //! VBK-encoded BTC headers of context, without leading count
+  Slice<const uint8_t> blockOfProofContext{};
+  size_t blockOfProofContextSize = 0;
+
+  //! same as VbkPopTx::getHash
+  hash_t getHash() const;
+
+  BtcBlock::hash_t getBtcTxHash() const;
+
+  BtcBlock::hash_t getBlockOfProofHash() const;
+
+  VbkBlock::hash_t getPublishedBlockHash() const;
+
+  //! raw BTC header of i-th context block
+  Slice<const uint8_t> getBlockOfProofContextRaw(size_t i) const;
+
+  bool getPublishedBlock(VbkBlock& out, ValidationState& state) const;
+
+  bool getBlockOfProof(BtcBlock& out, ValidationState& state) const;
+
+  bool getBlockOfProofContext(std::vector<BtcBlock>& out,
+                              ValidationState& state) const;
+
+  //! fully decode viewed tx
+  bool materialize(VbkPopTx& out, ValidationState& state) const;
+};
+
+/**
+ * @struct ATVView
+ *
+ * View over VBK-encoded ATV.
+ *
+ * @ingroup entities
+ */
+struct ATVView {
+  using id_t = ATV::id_t;
+
+  uint32_t version = 1;
+  //! raw VbkTx bytes, without signature and public key
+  Slice<const uint8_t> transaction{};
+  Slice<const uint8_t> signature{};
+  Slice<const uint8_t> publicKey{};
+  //! raw PublicationData, subrange of `transaction`
+  Slice<const uint8_t> publicationData{};
+  //! VBK-encoded VbkMerklePath
+  Slice<const uint8_t> merklePath{};
+  //! raw VBK header of block of proof
+  Slice<const uint8_t> blockOfProof{};
+
+  //! same as ATV::getId
+  id_t getId() const;
+
+  VbkBlock::hash_t getBlockOfProofHash() const;
+
+  bool getBlockOfProof(VbkBlock& out, ValidationState& state) const;
+
+  bool getPublicationData(PublicationData& out, ValidationState& state) const;
+
+  //! fully decode viewed ATV
+  bool materialize(ATV& out, ValidationState& state) const;
+
+  static const std::string& name() { return ATV::name(); }
+};
+
+/**
+ * @struct VTBView
+ *
+ * View over VBK-encoded VTB.
+ *
+ * @ingroup entities
+ */
+struct VTBView {
+  using id_t = VTB::id_t;
+
+  uint32_t version = 1;
+  VbkPopTxView transaction{};
+  //! VBK-encoded VbkMerklePath
+  Slice<const uint8_t> merklePath{};
+  //! raw VBK header of containing block
+  Slice<const uint8_t> containingBlock{};
+
+  //! same as VTB::getId
+  id_t getId() const;
+
+  VbkBlock::hash_t getContainingBlockHash() const;
+
+  bool getContainingBlock(VbkBlock& out, ValidationState& state) const;
+
+  //! fully decode viewed VTB
+  bool materialize(VTB& out, ValidationState& state) const;
+
+  static const std::string& name() { return VTB::name(); }
+};
+
+/**
+ * Read boundaries of VBK-encoded VbkPopTx.
+ *
+ * Address and merkle path are validated during VbkPopTxView::materialize.
+ */
+bool Deserialize(ReadStream& stream, VbkPopTxView& out, ValidationState& state);
+
+/**
+ * Read boundaries of VBK-encoded ATV.
+ *
+ * Addresses, outputs and merkle path are validated during
+ * ATVView::materialize.
+ */
+bool Deserialize(ReadStream& stream, ATVView& out, ValidationState& state);
+
+/**
+ * Read boundaries of VBK-encoded VTB.
+ *
+ * Addresses and merkle paths are validated during VTBView::materialize.
+ */
+bool Deserialize(ReadStream& stream, VTBView& out, ValidationState& state);
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_INCLUDE_VERIBLOCK_ENTITIES_PAYLOADS_VIEW_HPP_
@@ -38,7 +38,7 @@ struct PopData {
     atvs.insert(atvs.end(), p.atvs.begin(), p.atvs.end());
   }
 
-  size_t estimateSize() const { return toVbkEncoding().size(); }
+  size_t estimateSize() const { return serializedSize(); }
 
   /**
    * Read VBK data from the stream and convert it to PopData
@@ -60,6 +60,9 @@ struct PopData {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Convert PopData to raw bytes data using Vbk byte format
    * @return bytes data
@@ -63,6 +63,9 @@ struct PublicationData {
    * @param stream data stream to write into
    */
   void toRaw(WriteStream& stream) const;
+
+  //! size of raw encoding in bytes, computed without serialization
+  size_t rawSize() const;
 };
 
 //! @private
@@ -44,6 +44,9 @@ struct VbkMerklePath {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Calculate the hash of the vb merkle root
    * @return hash merkle root hash
@@ -103,6 +103,9 @@ struct VbkBlock {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /*
    * Getter for difficulty
    * @return block difficulty
@@ -67,12 +67,18 @@ struct VbkPopTx {
    */
   void toRaw(WriteStream& stream) const;
 
+  //! size of raw encoding in bytes, computed without serialization
+  size_t rawSize() const;
+
   /**
    * Convert VbkPopTx to data stream using VbkPopTx VBK byte format
    * @param stream data stream to write into
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Calculate the hash of the vbk pop transaction
    * @return hash vbk pop transaction hash
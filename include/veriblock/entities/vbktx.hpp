@@ -66,12 +66,18 @@ struct VbkTx {
    */
   void toRaw(WriteStream& stream) const;
 
+  //! size of raw encoding in bytes, computed without serialization
+  size_t rawSize() const;
+
   /**
    * Convert VbkTx to data stream using VbkTx VBK byte format
    * @param stream data stream to write into
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   /**
    * Calculate the hash of the vbk transaction
    * @return hash vbk transaction hash
@@ -68,6 +68,9 @@ struct VTB {
    */
   void toVbkEncoding(WriteStream& stream) const;
 
+  //! size of VBK encoding in bytes, computed without serialization
+  size_t serializedSize() const;
+
   static VTB fromHex(const std::string& hex);
 
   /**
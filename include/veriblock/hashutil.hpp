@@ -31,6 +31,29 @@ uint256 sha256(Slice<const uint8_t> a, Slice<const uint8_t> b);
 uint256 sha256twice(Slice<const uint8_t> data);
 uint256 sha256twice(Slice<const uint8_t> a, Slice<const uint8_t> b);
 
+/**
+ * Calculates HMAC-SHA256 (RFC 2104) of the message
+ * @param key secret key of any size
+ * @param message read data from this array
+ * @return message authentication code
+ */
+uint256 hmacSha256(Slice<const uint8_t> key, Slice<const uint8_t> message);
+
+/**
+ * Calculates SHA256 of many inputs of the same size at once, using SIMD lanes
+ * when CPU has no SHA extensions
+ * @param inputs read data from these arrays, all of the same size
+ * @param outputs write hashes here, size must be equal to size of inputs
+ */
+void sha256Batch(Slice<const Slice<const uint8_t>> inputs,
+                 Slice<uint256> outputs);
+
+/**
+ * Calculates SHA256 twice of many inputs of the same size at once
+ * @see sha256Batch
+ */
+void sha256twiceBatch(Slice<const Slice<const uint8_t>> inputs,
+                      Slice<uint256> outputs);
 
 /**
  * Calculates VBlake of the input data
@@ -39,6 +62,15 @@ uint256 sha256twice(Slice<const uint8_t> a, Slice<const uint8_t> b);
  */
 uint192 vblake(Slice<const uint8_t> data);
 
+/**
+ * Calculates VBlake of many inputs of the same size at once, using SIMD lanes
+ * when CPU supports them
+ * @param inputs read data from these arrays, all of the same size
+ * @param outputs write hashes here, size must be equal to size of inputs
+ */
+void vblakeBatch(Slice<const Slice<const uint8_t>> inputs,
+                 Slice<uint192> outputs);
+
 }  // namespace altintegration
 
 #endif  //__SHAUTIL__HPP__
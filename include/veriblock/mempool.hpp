@@ -8,14 +8,20 @@
 
 #include <map>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "veriblock/block_interner.hpp"
 #include "veriblock/blockchain/alt_block_tree.hpp"
 #include "veriblock/blockchain/mempool_block_tree.hpp"
+#include "veriblock/entities/compact_popdata.hpp"
 #include "veriblock/entities/popdata.hpp"
+#include "veriblock/mempool_notifications.hpp"
 #include "veriblock/mempool_result.hpp"
+#include "veriblock/mempool_selector.hpp"
 #include "veriblock/signals.hpp"
+#include "veriblock/thread_pool.hpp"
 
 namespace altintegration {
 
@@ -32,6 +38,12 @@ namespace altintegration {
  * current VBK chain, so this VTB remains in MemPool until we explicitly remove
  * it, or connect containing VBK block with this VTB.
  *
+ * Payloads, which VBK block does not connect to VBK tree or to VBK blocks
+ * stored in MemPool, are kept in orphan pool, indexed by missing previous VBK
+ * block. Orphans are not selected by getPop and not re-checked by vacuum. When
+ * missing block arrives to MemPool or VBK tree, only its dependents are
+ * validated and promoted.
+ *
  * @ingroup api
  */
 struct MemPool {
@@ -45,10 +57,26 @@ struct MemPool {
   using atv_map_t = payload_map<ATV>;
   using vtb_map_t = payload_map<VTB>;
   using relations_map_t = payload_map<VbkPayloadsRelations>;
+  using relations_index_t = MemPoolSelector::relations_index_t;
+  //! relations ordered by eviction class, VBK block height and arrival
+  using eviction_index_t =
+      std::map<std::tuple<int, VbkBlock::height_t, uint64_t>,
+               VbkPayloadsRelations*>;
+
+  //! default limit of memory used by stored payloads, in bytes
+  static const size_t kDefaultMaxMemoryUsage = 300 * 1024 * 1024;
+  //! default max number of orphan VBK blocks
+  static const size_t kDefaultMaxOrphans = 1000;
+  //! default time in seconds after which orphans are removed
+  static const uint32_t kDefaultOrphanExpiry = 20 * 60;
   //! @}
 
   ~MemPool() = default;
-  MemPool(AltBlockTree& tree) : tree_(&tree) {}
+  MemPool(AltBlockTree& tree)
+      : tree_(&tree),
+        selector_(std::make_shared<HeightOrderSelector>()),
+        btcInterner_(tree.btc().getParams()),
+        vbkInterner_(tree.vbk().getParams()) {}
 
   //! getter for payloads stored in mempool
   //! @ingroup api
@@ -97,14 +125,63 @@ struct MemPool {
     return true;
   }
 
+  //! @overload
+  //! Takes ownership of payload, which is stored without copying.
+  bool submit(std::shared_ptr<ATV> atv,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true);
+  //! @overload
+  bool submit(std::shared_ptr<VTB> vtb,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true);
+  //! @overload
+  bool submit(std::shared_ptr<VbkBlock> block,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true);
+
+  //! @overload
+  //! Payload is moved into mempool without copying.
+  bool submit(ATV&& atv,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true) {
+    return submit(
+        std::make_shared<ATV>(std::move(atv)), state, shouldDoContextualCheck);
+  }
+  //! @overload
+  bool submit(VTB&& vtb,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true) {
+    return submit(
+        std::make_shared<VTB>(std::move(vtb)), state, shouldDoContextualCheck);
+  }
+  //! @overload
+  bool submit(VbkBlock&& block,
+              ValidationState& state,
+              bool shouldDoContextualCheck = true) {
+    return submit(std::make_shared<VbkBlock>(std::move(block)),
+                  state,
+                  shouldDoContextualCheck);
+  }
+
   /**
    * Shortcut to submit PopData as whole thing.
    *
+   * Stateless validation of payloads does not depend on MemPool or
+   * AltBlockTree state, so it runs on up to `threads` threads. Contextual
+   * validation and insertion are done sequentially on caller thread, in the
+   * same order as with `threads=1`. Worker threads are started by the first
+   * call, which needs them, and are reused until MemPool is destroyed.
+   *
    * @param pop PopData
+   * @param threads max number of threads used for stateless validation
    * @return MempoolResult - an entity that can be serialized ToJSON.
    * @ingroup api
    */
-  MempoolResult submitAll(const PopData& pop);
+  MempoolResult submitAll(const PopData& pop, size_t threads = 1);
+
+  //! @overload
+  //! Payloads are moved into mempool without copying.
+  MempoolResult submitAll(PopData&& pop, size_t threads = 1);
 
   //! @private
   template <typename T>
@@ -121,16 +198,39 @@ struct MemPool {
    * this method returns PopData which contains fully valid and connected
    * payloads. This should be inserted into AltBlock as is.
    *
+   * Result is kept as a template for the next call. While trees are not
+   * changed and no payloads are removed from mempool, template is returned as
+   * is, and if selector is incremental, payloads submitted since then are
+   * validated on top of the template and appended to it while they fit.
+   * Extended template is checked by AltBlockTree again, and if any payload is
+   * rejected, or selector is not incremental, template is built from scratch.
+   *
    * @ingroup api
    * @return statefully valid PopData that can be connected to current tip.
    */
   PopData getPop();
 
+  /**
+   * Set strategy, which picks payloads in getPop.
+   *
+   * By default payloads are taken in VBK height order, see
+   * HeightOrderSelector. ValueDensitySelector prefers payloads with higher
+   * value per byte.
+   * @ingroup api
+   */
+  void setSelector(std::shared_ptr<MemPoolSelector> selector) {
+    VBK_ASSERT(selector != nullptr);
+    selector_ = std::move(selector);
+    invalidateTemplate();
+  }
+
   /**
    * Remove payloads from mempool by their IDs.
    *
    * Use it when new block arrives and it contains PopData. Doing this, mempool
    * will not contain duplicates (payloads that are already in blockchain).
+   * If block is relayed to peers, build its compact encoding before calling
+   * this, see compact.
    * @ingroup api
    * @param popData
    */
@@ -141,6 +241,117 @@ struct MemPool {
    */
   void clear();
 
+  /**
+   * Serialize stored VBK blocks and payloads into a binary snapshot, which can
+   * be restored with restoreSnapshot, e.g. after restart.
+   *
+   * Snapshot is `magic(4) | version(4) | sha256 of body(32) | body`. Body is
+   * `count(4)` relations in order of arrival, each is VBK block followed by
+   * `count(4)` VTBs and `count(4)` ATVs in VBK encoding.
+   *
+   * @param[out] stream snapshot is appended to this stream
+   * @ingroup api
+   */
+  void saveSnapshot(WriteStream& stream) const;
+
+  /**
+   * Add VBK blocks and payloads from a snapshot written by saveSnapshot.
+   *
+   * Stored payloads are statelessly valid, so when snapshot checksum matches,
+   * stateless checks are skipped. Payloads are inserted without contextual
+   * checks, then all of them are checked against current tree in a single
+   * vacuum pass, and those which are no longer valid are removed. "Accepted"
+   * signals fire for restored payloads.
+   *
+   * @param[in] snapshot snapshot bytes
+   * @param[out] state validation state
+   * @return true on success, false otherwise
+   * @warning snapshot must come from a trusted source, e.g. be written by this
+   * node
+   * @invariant NOT atomic
+   * @ingroup api
+   */
+  bool restoreSnapshot(Slice<const uint8_t> snapshot, ValidationState& state);
+
+  /**
+   * Build compact encoding of `pop` for relay to peers.
+   *
+   * Payloads, which are not stored in this mempool, are likely missing on
+   * peers as well, so they are prefilled. Other payloads are sent as short
+   * ids.
+   *
+   * @warning must be called before `removeAll(pop)`, which removes payloads
+   * of `pop` from mempool, otherwise every payload is prefilled.
+   *
+   * @param[in] pop PopData of ALT block
+   * @param[in] salt random salt of short ids, should be different for every
+   * block
+   * @return compact PopData
+   * @ingroup api
+   */
+  CompactPopData compact(const PopData& pop, uint64_t salt) const;
+
+  /**
+   * Rebuild PopData from its compact encoding using payloads stored in this
+   * mempool and `extra` payloads.
+   *
+   * When some short ids can not be resolved, their indexes are written to
+   * `missing`. Payloads at these indexes should be requested from peer, and
+   * reconstruct should be called again with them in `extra`. Ambiguous short
+   * ids, which match more than one payload, are reported as missing.
+   *
+   * Short ids of stored payloads are computed once per salt, so repeated
+   * calls for the same compact PopData do not hash whole mempool again.
+   *
+   * @param[in] compact compact PopData received from peer
+   * @param[out] out reconstructed PopData, set only on success
+   * @param[out] missing indexes of payloads, which could not be found
+   * @param[out] state validation state
+   * @param[in] extra payloads received in addition to `compact`
+   * @return true if every payload is found, false otherwise
+   * @note reconstructed PopData must be validated as usual, because short
+   * ids may collide
+   * @ingroup api
+   */
+  bool reconstruct(const CompactPopData& compact,
+                   PopData& out,
+                   CompactPopData::Missing& missing,
+                   ValidationState& state,
+                   const PopData& extra = PopData{}) const;
+
+  /**
+   * Set limit of memory used by stored payloads, evicting payloads if it is
+   * exceeded.
+   *
+   * When the limit is exceeded, VBK blocks are evicted with their payloads,
+   * first orphans, then those on VBK forks, then those no payloads refer to,
+   * then the rest. Within each group blocks with the lowest VBK height are
+   * evicted first.
+   *
+   * @param[in] bytes max estimated memory usage
+   * @ingroup api
+   */
+  void setMaxMemoryUsage(size_t bytes);
+
+  //! estimated memory used by stored payloads, in bytes
+  size_t getMemoryUsage() const { return usage_; }
+
+  /**
+   * Set limits of orphan pool.
+   *
+   * When there are more than `maxOrphans` orphan VBK blocks, oldest ones are
+   * evicted with their payloads. Orphans older than `expiry` seconds are
+   * removed on vacuum.
+   *
+   * @param[in] maxOrphans max number of orphan VBK blocks
+   * @param[in] expiry orphan lifetime in seconds
+   * @ingroup api
+   */
+  void setOrphanLimits(size_t maxOrphans, uint32_t expiry);
+
+  //! number of VBK blocks in orphan pool
+  size_t getOrphansCount() const { return orphans_.size(); }
+
   /**
    * Subscribe on "accepted" event - fires whenever new payload is added into
    * mempool.
@@ -154,6 +365,19 @@ struct MemPool {
     return sig.connect(f);
   }
 
+  /**
+   * Set queue, to which ids of accepted payloads are pushed, in addition to
+   * "accepted" signals. Every submit, submitAll and restoreSnapshot call
+   * pushes a single batch.
+   *
+   * When queue is full, submit blocks until it is drained.
+   * @param[in] queue notification queue, nullptr disables notifications
+   * @ingroup api
+   */
+  void setNotificationQueue(std::shared_ptr<MemPoolNotificationQueue> queue) {
+    notifications_ = std::move(queue);
+  }
+
   //! fires when new valid ATV is accepted to mempool
   signals::Signal<void(const ATV& atv)> on_atv_accepted;
   //! fires when new valid VTB is accepted to mempool
@@ -163,14 +387,136 @@ struct MemPool {
 
  private:
   AltBlockTree* tree_;
+  std::shared_ptr<MemPoolSelector> selector_;
+  // headers shared by many payloads are hashed and checked once
+  mutable BtcBlockInterner btcInterner_;
+  mutable VbkBlockInterner vbkInterner_;
+  std::shared_ptr<MemPoolNotificationQueue> notifications_;
+  // ids accepted by current submit call
+  MemPoolNotificationQueue::Batch accepted_;
+
+  //! short ids of stored payloads for a single salt, see reconstruct
+  struct ShortIds {
+    template <typename Pop>
+    using map_t = std::unordered_multimap<CompactPopData::short_id_t,
+                                          typename Pop::id_t>;
+
+    bool built = false;
+    uint64_t salt = 0;
+    map_t<VbkBlock> context;
+    map_t<VTB> vtbs;
+    map_t<ATV> atvs;
+
+    size_t size() const { return context.size() + vtbs.size() + atvs.size(); }
+
+    //! adds payload stored after map has been built
+    template <typename Pop>
+    void add(map_t<Pop>& map, const typename Pop::id_t& id) {
+      if (built) {
+        map.emplace(CompactPopData::shortId(
+                        salt, Slice<const uint8_t>(id.data(), id.size())),
+                    id);
+      }
+    }
+  };
+  // built by reconstruct with a new salt, payloads stored later are added to
+  // it, removed ones are skipped when matched
+  mutable ShortIds shortIds_;
+  // workers of submitAll stateless validation
+  ThreadPool workers_;
+
+  //! identifies state of ALT, VBK and BTC trees
+  struct TreeState {
+    AltBlock::hash_t alt;
+    VbkBlock::hash_t vbk;
+    BtcBlock::hash_t btc;
+    size_t blocks = 0;
+
+    bool operator==(const TreeState& o) const {
+      return alt == o.alt && vbk == o.vbk && btc == o.btc &&
+             blocks == o.blocks;
+    }
+  };
+
+  // PopData returned by last getPop, its size and speculative view of trees
+  // with this PopData applied. Valid for trees in `templateState_`. View is
+  // null if canonical check has dropped payloads accepted by the view, then
+  // template is rebuilt instead of extended.
+  PopData template_;
+  size_t templateSize_ = 0;
+  std::unique_ptr<MemPoolBlockTree> templateTree_;
+  TreeState templateState_;
+  bool hasTemplate_ = false;
+  // VBK blocks and payloads added to non-orphan relations since template has
+  // been built
+  std::vector<std::shared_ptr<VbkBlock>> addedBlocks_;
+  std::vector<std::shared_ptr<VTB>> addedVtbs_;
+  std::vector<std::shared_ptr<ATV>> addedAtvs_;
   // relations between VBK block and payloads
   relations_map_t relations_;
+  // same relations, in order in which they are evicted
+  eviction_index_t evictionIndex_;
+  size_t usage_ = 0;
+  size_t maxUsage_ = kDefaultMaxMemoryUsage;
+  // orphan relations by arrival, and by missing previous VBK block
+  std::map<uint64_t, VbkPayloadsRelations*> orphans_;
+  std::multimap<vbk_hash_t, VbkPayloadsRelations*> orphansByPrev_;
+  size_t maxOrphans_ = kDefaultMaxOrphans;
+  uint32_t orphanExpiry_ = kDefaultOrphanExpiry;
+  // same relations, maintained in order in which they are added to PopData
+  relations_index_t relationsIndex_;
+  uint64_t arrivals_ = 0;
   vbkblock_map_t vbkblocks_;
   atv_map_t stored_atvs_;
   vtb_map_t stored_vtbs_;
 
-  VbkPayloadsRelations& touchVbkBlock(const VbkBlock& block,
-                                      VbkBlock::id_t id = VbkBlock::id_t());
+  // expiry wheel: ALT tip height at which ATVs expire -> ATV ids.
+  // may contain ids of already removed ATVs.
+  std::multimap<AltBlock::height_t, ATV::id_t> atvExpiry_;
+  // ATVs which endorse ALT blocks not yet known to ALT tree
+  std::set<ATV::id_t> unresolvedAtvs_;
+  // ALT and VBK tips at the moment of last vacuum
+  AltBlock::hash_t lastAltTip_;
+  VbkBlock::hash_t lastVbkTip_;
+  // if true, next vacuum re-checks every stored payload
+  bool fullVacuum_ = true;
+
+  //! finds or creates relation of `block`. New relation stores `stored`, or
+  //! a copy of `block` if it is nullptr.
+  VbkPayloadsRelations& touchVbkBlock(
+      const VbkBlock& block,
+      VbkBlock::id_t id = VbkBlock::id_t(),
+      std::shared_ptr<VbkBlock> stored = nullptr);
+
+  //! pushes ids accepted by current submit call to notification queue
+  void notifyAccepted();
+
+  TreeState getTreeState() const;
+
+  //! template is built from scratch on next getPop
+  void invalidateTemplate();
+
+  //! selects payloads and validates them into new template
+  void rebuildTemplate();
+
+  //! validates payloads added since template has been built on top of
+  //! template, and appends valid ones while they fit
+  void extendTemplate();
+
+  //! appends `block` with its ancestors stored in mempool to template context
+  //! @return true if `block` is in template or VBK tree
+  bool extendTemplateContext(const VbkBlock& block);
+
+  //! size by which template grows, when payload of `size` bytes is appended
+  //! to vector of `count` payloads
+  static size_t templateGrowth(size_t count, size_t size);
+
+  //! puts ATV into expiry wheel bucket
+  void scheduleExpiry(const ATV& atv);
+
+  //! true if only connected tip block changed ALT and VBK chains since last
+  //! vacuum
+  bool canVacuumIncrementally() const;
 
   template <typename Pop>
   signals::Signal<void(const Pop&)>& getSignal() {
@@ -178,9 +524,59 @@ struct MemPool {
   }
 
   void vacuum(const PopData& pop);
+  void vacuumFull(const PopData& pop);
+  void vacuumIncremental(const PopData& pop);
+
+  //! removes relation with all its payloads
+  relations_map_t::iterator removeRelation(relations_map_t::iterator it);
+
+  //! updates memory usage and eviction index after relation is changed
+  void reindexRelation(VbkPayloadsRelations& rel);
+
+  //! evicts relations until memory usage and number of orphans fit the
+  //! limits
+  void trimToSize();
+
+  //! true if block connects to VBK tree or to non-orphan relation
+  bool isConnected(const VbkBlock& block) const;
+
+  //! validates and promotes orphans, which depend on `arrived` VBK blocks,
+  //! and then their dependents
+  void connectOrphans(std::vector<vbk_hash_t> arrived);
+
+  //! removes orphans older than orphan expiry
+  void expireOrphans();
+
+  //! removes VTBs, which VBK tree already has, from relation
+  //! @return true if relation has nothing left to add and can be removed
+  bool cleanupRelation(VbkPayloadsRelations& rel,
+                       const PopData& pop,
+                       const std::set<VbkBlock::id_t>& vbkblockids);
 
   template <typename Pop>
   bool checkContextually(const Pop& payload, ValidationState& state);
+
+  //! stateless part of submit, safe to call concurrently
+  template <typename Pop>
+  bool checkStateless(const Pop& payload, ValidationState& state) const;
+
+  //! contextual validation and insertion of statelessly valid payload.
+  //! `stored` is kept in mempool, if it is nullptr, `payload` is copied.
+  template <typename Pop>
+  bool submitChecked(const Pop& payload,
+                     std::shared_ptr<Pop> stored,
+                     ValidationState& state,
+                     bool shouldDoContextualCheck);
+
+  //! submits `size` payloads, `get(i)` returns i-th payload and `take(i)`
+  //! releases ownership of it, as in submitChecked
+  template <typename Pop, typename Get, typename Take>
+  void submitMany(
+      size_t size,
+      const Get& get,
+      const Take& take,
+      std::vector<std::pair<typename Pop::id_t, ValidationState>>& results,
+      size_t threads);
 };
 
 // clang-format off
@@ -198,6 +594,18 @@ template <> bool MemPool::checkContextually<ATV>(const ATV& id, ValidationState&
 //! @overload
 template <> bool MemPool::checkContextually<VbkBlock>(const VbkBlock& id, ValidationState& state);
 //! @overload
+template <> bool MemPool::checkStateless(const ATV& atv, ValidationState& state) const;
+//! @overload
+template <> bool MemPool::checkStateless(const VTB& vtb, ValidationState& state) const;
+//! @overload
+template <> bool MemPool::checkStateless(const VbkBlock& block, ValidationState& state) const;
+//! @overload
+template <> bool MemPool::submitChecked(const ATV& atv, std::shared_ptr<ATV> stored, ValidationState& state, bool shouldDoContextualCheck);
+//! @overload
+template <> bool MemPool::submitChecked(const VTB& vtb, std::shared_ptr<VTB> stored, ValidationState& state, bool shouldDoContextualCheck);
+//! @overload
+template <> bool MemPool::submitChecked(const VbkBlock& block, std::shared_ptr<VbkBlock> stored, ValidationState& state, bool shouldDoContextualCheck);
+//! @overload
 template <> const MemPool::payload_map<VbkBlock>& MemPool::getMap() const;
 //! @overload
 template <> const MemPool::payload_map<ATV>& MemPool::getMap() const;
@@ -0,0 +1,98 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_VERIBLOCK_MEMPOOL_NOTIFICATIONS_HPP
+#define ALT_INTEGRATION_VERIBLOCK_MEMPOOL_NOTIFICATIONS_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "veriblock/entities/atv.hpp"
+#include "veriblock/entities/vbkblock.hpp"
+#include "veriblock/entities/vtb.hpp"
+
+namespace altintegration {
+
+/**
+ * @struct MemPoolNotificationQueue
+ *
+ * Bounded queue of "accepted" notifications, which MemPool pushes to and
+ * users drain on a thread of their choice, so that handlers do not run inside
+ * MemPool::submit.
+ *
+ * Every MemPool::submit, MemPool::submitAll and MemPool::restoreSnapshot call
+ * adds a single batch with ids of all payloads it has accepted, if there are
+ * any.
+ *
+ * Queue is bounded by number of ids. When it is full, `push` blocks until
+ * consumer drains enough batches, so a slow consumer slows down submission
+ * instead of growing the queue. Batch larger than capacity is accepted when
+ * queue is empty.
+ *
+ * @see MemPool::setNotificationQueue
+ * @ingroup api
+ */
+struct MemPoolNotificationQueue {
+  //! ids of payloads accepted by a single submit or submitAll call
+  struct Batch {
+    std::vector<VbkBlock::id_t> vbkblocks;
+    std::vector<VTB::id_t> vtbs;
+    std::vector<ATV::id_t> atvs;
+
+    size_t size() const { return vbkblocks.size() + vtbs.size() + atvs.size(); }
+    bool empty() const { return size() == 0; }
+  };
+
+  using callback_t = std::function<void(const Batch&)>;
+
+  //! default max number of queued ids
+  static const size_t kDefaultCapacity = 100000;
+
+  explicit MemPoolNotificationQueue(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity) {}
+
+  /**
+   * Add batch to the queue. Blocks while queue is full.
+   * @warning if queue is drained on the same thread, capacity must be large
+   * enough for all batches pushed between drains.
+   */
+  void push(Batch batch);
+
+  /**
+   * Call `f` for every queued batch, in order, on caller thread. Space taken
+   * by a batch is released after `f` returns or throws. If `f` throws, the
+   * exception is propagated and remaining batches stay in the queue.
+   * @return number of batches
+   */
+  size_t drain(const callback_t& f);
+
+  /**
+   * Wait until queue is not empty, at most `timeout`, then drain it.
+   * @return number of batches
+   */
+  size_t waitAndDrain(const callback_t& f, std::chrono::milliseconds timeout);
+
+  //! number of queued ids
+  size_t size() const;
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+  std::deque<Batch> batches_;
+  // queued ids, including batches which are being processed by `drain`
+  size_t size_ = 0;
+};
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_VERIBLOCK_MEMPOOL_NOTIFICATIONS_HPP
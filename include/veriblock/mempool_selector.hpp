@@ -0,0 +1,137 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_VERIBLOCK_MEMPOOL_SELECTOR_HPP
+#define ALT_INTEGRATION_VERIBLOCK_MEMPOOL_SELECTOR_HPP
+
+#include <map>
+#include <utility>
+
+#include "veriblock/blockchain/alt_block_tree.hpp"
+#include "veriblock/blockchain/mempool_block_tree.hpp"
+#include "veriblock/entities/popdata.hpp"
+
+namespace altintegration {
+
+/**
+ * @struct MemPoolSelector
+ *
+ * Strategy, which picks payloads stored in MemPool for the next ALT block.
+ *
+ * Relations are given in order in which their VBK blocks have to be added to
+ * PopData context: payloads of a relation can be selected only together with
+ * VBK blocks of this and all preceding relations.
+ *
+ * Selected PopData is filtered for stateful validity afterwards, so selector
+ * only has to respect size limit.
+ *
+ * @see MemPool::setSelector
+ * @ingroup interfaces
+ */
+struct MemPoolSelector {
+  //! relations ordered by VBK block height and arrival
+  using relations_index_t =
+      std::map<std::pair<VbkBlock::height_t, uint64_t>, VbkPayloadsRelations*>;
+
+  virtual ~MemPoolSelector() = default;
+
+  /**
+   * Select payloads for the next block on top of current ALT tip.
+   * @param[in] relations candidate payloads
+   * @param[in] tree current ALT tree
+   * @return PopData which size does not exceed
+   * AltChainParams::getMaxPopDataSize
+   */
+  virtual PopData select(const relations_index_t& relations,
+                         const AltBlockTree& tree) const = 0;
+
+  /**
+   * If true, MemPool may append payloads, which arrive after `select`, to
+   * previously selected PopData while they fit, instead of running `select`
+   * again.
+   */
+  virtual bool isIncremental() const { return false; }
+};
+
+/**
+ * @struct HeightOrderSelector
+ *
+ * Default selector. Takes relations in VBK height order until size limit is
+ * reached, VTBs are cut before ATVs.
+ */
+struct HeightOrderSelector : public MemPoolSelector {
+  PopData select(const relations_index_t& relations,
+                 const AltBlockTree& tree) const override;
+
+  //! new payloads are taken while they fit
+  bool isIncremental() const override { return true; }
+};
+
+/**
+ * @struct ValueDensitySelector
+ *
+ * Greedy knapsack over payloads, ordered by value per serialized byte.
+ *
+ * Payload can be added only together with VBK blocks of its own and all
+ * preceding relations, so its density is computed over its size plus size of
+ * these VBK blocks, and payloads in deep relations pay for the context they
+ * require. Payloads which do not fit are skipped, and smaller ones are tried.
+ * When selection is done, remaining space is filled with VBK blocks.
+ *
+ * Payload values are given by `getValue` and can be overridden. By default
+ * ATV is worth POP score it adds to endorsed block, and VTB is worth ATVs it
+ * unlocks, see getValue.
+ */
+struct ValueDensitySelector : public MemPoolSelector {
+  //! ALT block endorsed by ATVs, resolved once per `select` call
+  struct Endorsed {
+    //! nullptr if block is unknown
+    const BlockIndex<AltBlock>* index = nullptr;
+    //! lowest height of VBK blocks on active VBK chain, which contain
+    //! endorsements of this block, -1 if there are none
+    int32_t bestPublication = -1;
+    //! block is on active chain and within settlement window of the next
+    //! block, so ATVs endorsing it can be added
+    bool endorsable = false;
+  };
+
+  PopData select(const relations_index_t& relations,
+                 const AltBlockTree& tree) const override;
+
+  /**
+   * Value of ATV. By default it is POP score, which ATV adds to endorsed
+   * block, see PopRewards::scoreFromEndorsements: relative score of
+   * `h - best`, where h is height of `blockOfProof` and best is
+   * `endorsed.bestPublication`, or h if block is not endorsed yet. ATVs
+   * endorsing blocks, which are not `endorsed.endorsable`, are worth 0.
+   * Payloads with no value are not selected.
+   * @param[in] atv ATV, default implementation does not read it
+   * @param[in] blockOfProof VBK block containing ATV, same as
+   * `atv.blockOfProof`
+   * @param[in] endorsed block endorsed by ATV
+   * @param[in] tree current ALT tree
+   */
+  virtual double getValue(const ATV& atv,
+                          const VbkBlock& blockOfProof,
+                          const Endorsed& endorsed,
+                          const AltBlockTree& tree) const;
+
+  /**
+   * Value of VTB. VTB publishes VBK block to BTC, so it is worth as much as
+   * ATVs contained in published block: the ones which are stored in mempool,
+   * and the ones which are added to active ALT chain within settlement
+   * window. By default it is `unlocked`, the sum of their values.
+   * @param[in] vtb VTB, default implementation does not read it
+   * @param[in] unlocked total value of ATVs in published block
+   * @param[in] tree current ALT tree
+   */
+  virtual double getValue(const VTB& vtb,
+                          double unlocked,
+                          const AltBlockTree& tree) const;
+};
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_VERIBLOCK_MEMPOOL_SELECTOR_HPP
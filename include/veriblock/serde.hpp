@@ -255,6 +255,48 @@ bool readNetworkByte(ReadStream& stream,
  */
 void writeNetworkByte(WriteStream& stream, NetworkBytePair networkOrType);
 
+/**
+ * Number of bytes written by writeSingleBEValue, computed without encoding.
+ * @param value value to be written
+ * @return size in bytes
+ */
+size_t singleBEValueSize(int64_t value);
+
+/**
+ * Number of bytes written by writeSingleFixedBEValue<T>.
+ * @return size in bytes
+ */
+template <typename T,
+          typename = typename std::enable_if<std::is_integral<T>::value>::type>
+size_t singleFixedBEValueSize() {
+  return 1 + sizeof(T);
+}
+
+/**
+ * Number of bytes written by writeSingleByteLenValue for `size` bytes of data.
+ * @param size size of data
+ * @return size in bytes
+ */
+inline size_t singleByteLenValueSize(size_t size) { return 1 + size; }
+
+/**
+ * Number of bytes written by writeVarLenValue for `size` bytes of data.
+ * @param size size of data
+ * @return size in bytes
+ */
+inline size_t varLenValueSize(size_t size) {
+  return singleBEValueSize((int64_t)size) + size;
+}
+
+/**
+ * Number of bytes written by writeNetworkByte.
+ * @param networkOrType network byte and type
+ * @return size in bytes
+ */
+inline size_t networkByteSize(NetworkBytePair networkOrType) {
+  return networkOrType.hasNetworkByte ? 2 : 1;
+}
+
 /**
  * Reads array of entities of type T.
  * @tparam T type of entity to read
@@ -342,6 +384,55 @@ std::vector<T> readArrayOf(ReadStream& stream,
   return readArrayOf<T>(stream, 0, max, readFunc);
 }
 
+/**
+ * Write unsigned integer as a variable-length quantity: 7 bits per byte,
+ * least significant group first, high bit is set in all bytes but the last.
+ * @param stream write data to this stream
+ * @param value value to write
+ */
+void writeVarInt(WriteStream& stream, uint64_t value);
+
+/**
+ * Read unsigned integer written by writeVarInt.
+ * @param stream read data from this stream
+ * @throws std::out_of_range if stream is out of data or value does not fit
+ * into 64 bits
+ * @return read value
+ */
+uint64_t readVarInt(ReadStream& stream);
+
+/**
+ * Write array of fixed-size values as `varint count | values`.
+ * @tparam T fixed-size type (Blob)
+ */
+template <typename T>
+void writeCompactArrayOf(WriteStream& stream, const std::vector<T>& values) {
+  writeVarInt(stream, values.size());
+  for (const auto& value : values) {
+    stream.write(value);
+  }
+}
+
+/**
+ * Read array of fixed-size values written by writeCompactArrayOf.
+ * @tparam T fixed-size type (Blob)
+ * @throws std::out_of_range if stream is out of data
+ */
+template <typename T>
+std::vector<T> readCompactArrayOf(ReadStream& stream) {
+  const auto count = readVarInt(stream);
+  if (count > stream.remaining() / T::size()) {
+    throw std::out_of_range("readCompactArrayOf(): out of data");
+  }
+
+  std::vector<T> items;
+  items.reserve((size_t)count);
+  for (uint64_t i = 0; i < count; i++) {
+    items.emplace_back(stream.readSlice(T::size()));
+  }
+  return items;
+}
+
 std::string readString(ReadStream& stream);
 
 void writeDouble(WriteStream& stream, const double& val);
@@ -20,6 +20,11 @@
 
 namespace altintegration {
 
+template <typename Block, typename ChainParams>
+struct BlockInterner;
+using BtcBlockInterner = BlockInterner<BtcBlock, BtcChainParams>;
+using VbkBlockInterner = BlockInterner<VbkBlock, VbkChainParams>;
+
 bool containsSplit(const std::vector<uint8_t>& pop_data,
                    const std::vector<uint8_t>& btcTx_data);
 
@@ -51,6 +56,12 @@ bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlocks,
                     ValidationState& state,
                     const BtcChainParams& param);
 
+//! @overload
+//! Hash and proof of work of every header are taken from `interner`.
+bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlocks,
+                    ValidationState& state,
+                    BtcBlockInterner& interner);
+
 bool checkVbkBlocks(const std::vector<VbkBlock>& vbkBlocks,
                     ValidationState& state,
                     const VbkChainParams& param);
@@ -66,6 +77,11 @@ bool checkVbkPopTx(const VbkPopTx& tx,
                    ValidationState& state,
                    const BtcChainParams& param);
 
+//! @overload
+bool checkVbkPopTx(const VbkPopTx& tx,
+                   ValidationState& state,
+                   BtcBlockInterner& interner);
+
 bool checkVbkTx(const VbkTx& tx, ValidationState& state);
 
 bool checkBlock(const BtcBlock& block,
@@ -76,6 +92,11 @@ bool checkBlock(const VbkBlock& block,
                 ValidationState& state,
                 const VbkChainParams& params);
 
+//! @overload
+bool checkBlock(const VbkBlock& block,
+                ValidationState& state,
+                VbkBlockInterner& interner);
+
 bool checkATV(const ATV& atv,
               ValidationState& state,
               const AltChainParams& alt);
@@ -83,6 +104,11 @@ bool checkATV(const ATV& atv,
 bool checkVTB(const VTB& vtb,
               ValidationState& state,
               const BtcChainParams& btc);
+
+//! @overload
+bool checkVTB(const VTB& vtb,
+              ValidationState& state,
+              BtcBlockInterner& interner);
 }  // namespace altintegration
 
 #endif  // ! ALT_INTEGRATION_INCLUDE_VERIBLOCK_STATELESS_VALIDATION_H
@@ -0,0 +1,70 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_APPEND_ONLY_FILE_HPP
+#define VERIBLOCK_POP_CPP_APPEND_ONLY_FILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <veriblock/slice.hpp>
+#include <veriblock/validation_state.hpp>
+
+namespace altintegration {
+
+/**
+ * @struct AppendOnlyFile
+ *
+ * Append-only file, which is read through a read-only memory mapping.
+ *
+ * Mapping is updated by `open`, `append` and `truncate`, so slices returned by
+ * `data()` are invalidated by these calls. If `append` fails, mapping still
+ * covers the file as it was before the call.
+ *
+ * @private
+ */
+struct AppendOnlyFile {
+  explicit AppendOnlyFile(std::string path);
+  ~AppendOnlyFile();
+
+  AppendOnlyFile(const AppendOnlyFile&) = delete;
+  AppendOnlyFile& operator=(const AppendOnlyFile&) = delete;
+
+  //! opens file for appending, creates it if it does not exist
+  bool open(ValidationState& state);
+
+  bool isOpen() const { return fd_ >= 0; }
+
+  //! writes `bytes` at the end of file. Data is not durable until `sync`.
+  bool append(Slice<const uint8_t> bytes, ValidationState& state);
+
+  //! flushes appended data to the disk
+  bool sync(ValidationState& state);
+
+  //! cuts file at `size` bytes. Used to drop partially written records.
+  bool truncate(uint64_t size, ValidationState& state);
+
+  //! mapped file contents
+  Slice<const uint8_t> data() const {
+    return {(const uint8_t*)map_, (size_t)mapSize_};
+  }
+
+  uint64_t size() const { return size_; }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  bool map(ValidationState& state);
+  void unmap();
+
+  std::string path_;
+  int fd_ = -1;
+  uint64_t size_ = 0;
+  void* map_ = nullptr;
+  uint64_t mapSize_ = 0;
+};
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_APPEND_ONLY_FILE_HPP
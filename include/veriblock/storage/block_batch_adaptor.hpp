@@ -13,6 +13,14 @@
 
 namespace altintegration {
 
+//! commitment to the saved active chain of a tree, which ends at `tip`. See
+//! SaveTreeCommitment.
+template <typename Block>
+struct TreeCommitment {
+  typename Block::hash_t tip;
+  uint256 value;
+};
+
 /**
  * @struct BlockBatchAdaptor
  *
@@ -32,6 +40,28 @@ struct BlockBatchAdaptor {
   virtual bool writeTip(const BlockIndex<BtcBlock>& value) = 0;
   virtual bool writeTip(const BlockIndex<VbkBlock>& value) = 0;
   virtual bool writeTip(const BlockIndex<AltBlock>& value) = 0;
+
+  //! block with given hash has been removed from the tree, and should be
+  //! deleted from storage. Default implementation keeps removed blocks.
+  virtual bool removeBlock(const BtcBlock::hash_t& /* hash */) { return true; }
+  virtual bool removeBlock(const VbkBlock::hash_t& /* hash */) { return true; }
+  virtual bool removeBlock(const AltBlock::hash_t& /* hash */) { return true; }
+
+  //! commitment to saved active chain of a tree with given tip, which allows
+  //! trusted reload. Default implementation does not store it, so loaded
+  //! blocks are always fully validated.
+  virtual bool writeCommitment(const BlockIndex<BtcBlock>& /* tip */,
+                               const uint256& /* commitment */) {
+    return true;
+  }
+  virtual bool writeCommitment(const BlockIndex<VbkBlock>& /* tip */,
+                               const uint256& /* commitment */) {
+    return true;
+  }
+  virtual bool writeCommitment(const BlockIndex<AltBlock>& /* tip */,
+                               const uint256& /* commitment */) {
+    return true;
+  }
 };
 
 }  // namespace altintegration
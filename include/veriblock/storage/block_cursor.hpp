@@ -0,0 +1,59 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_BLOCK_CURSOR_HPP
+#define VERIBLOCK_POP_CPP_BLOCK_CURSOR_HPP
+
+#include <cstdint>
+#include <vector>
+#include <veriblock/slice.hpp>
+
+namespace altintegration {
+
+/**
+ * @struct BlockCursor
+ *
+ * Forward-only cursor over serialized blocks (BlockIndex::toRaw) of a single
+ * block tree, in any order.
+ *
+ * Used by LoadTree to decode and check blocks in parallel, without
+ * materializing all of them first.
+ *
+ * @ingroup interfaces
+ */
+struct BlockCursor {
+  virtual ~BlockCursor() = default;
+
+  /**
+   * Read next block.
+   * @param[out] raw serialized BlockIndex. Must stay valid until LoadTree
+   * returns.
+   * @return false if there are no more blocks
+   */
+  virtual bool next(Slice<const uint8_t>& raw) = 0;
+};
+
+//! @private
+struct VectorBlockCursor : public BlockCursor {
+  explicit VectorBlockCursor(const std::vector<std::vector<uint8_t>>& blocks)
+      : blocks_(blocks) {}
+  ~VectorBlockCursor() override = default;
+
+  bool next(Slice<const uint8_t>& raw) override {
+    if (pos_ >= blocks_.size()) {
+      return false;
+    }
+    raw = blocks_[pos_++];
+    return true;
+  }
+
+ private:
+  const std::vector<std::vector<uint8_t>>& blocks_;
+  size_t pos_ = 0;
+};
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_BLOCK_CURSOR_HPP
@@ -0,0 +1,201 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_FILE_BLOCK_STORAGE_HPP
+#define VERIBLOCK_POP_CPP_FILE_BLOCK_STORAGE_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <veriblock/storage/append_only_file.hpp>
+#include <veriblock/storage/block_batch_adaptor.hpp>
+#include <veriblock/storage/block_cursor.hpp>
+
+namespace altintegration {
+
+/**
+ * @struct FileBlockStorage
+ *
+ * Reference on-disk block storage.
+ *
+ * Blocks and tips are stored in a single append-only log. Each record is
+ * `type(1) | hash size(1) | hash | size(4, BE) | BlockIndex::toRaw()`.
+ * When the same block is written multiple times, last record wins. Removed
+ * blocks are recorded with empty payload. Tree commitments are recorded with
+ * tip hash and 32 byte commitment as payload.
+ *
+ * In-memory index maps block hash to its latest record, and is rebuilt on
+ * `open` by scanning record headers only. Partially written records at the
+ * end of the log are discarded.
+ *
+ * Records are appended by FileBlockBatch.
+ */
+struct FileBlockStorage {
+  template <typename T>
+  using index_t = std::unordered_map<typename T::hash_t, uint64_t>;
+
+  explicit FileBlockStorage(std::string path) : file_(std::move(path)) {}
+
+  //! opens block log and rebuilds index
+  bool open(ValidationState& state);
+
+  //! appends group of records written by FileBlockBatch and syncs the log
+  bool commit(Slice<const uint8_t> records, ValidationState& state);
+
+  //! latest stored version of every block
+  template <typename T>
+  std::vector<BlockIndex<T>> load();
+
+  //! latest stored tip
+  template <typename T>
+  typename T::hash_t getTip() const;
+
+  //! latest stored tree commitment, see SaveTreeCommitment
+  template <typename T>
+  TreeCommitment<T> getCommitment() const;
+
+  template <typename T>
+  const index_t<T>& getIndex() const;
+
+  //! cursor over latest stored version of every block. Invalidated by
+  //! `commit`.
+  template <typename T>
+  std::unique_ptr<BlockCursor> getCursor() {
+    return std::unique_ptr<BlockCursor>(new Cursor<T>(*this));
+  }
+
+  uint64_t size() const { return file_.size(); }
+
+ private:
+  template <typename T>
+  struct Cursor : public BlockCursor {
+    explicit Cursor(FileBlockStorage& storage)
+        : storage_(storage),
+          it_(storage.getIndex<T>().begin()),
+          end_(storage.getIndex<T>().end()) {}
+    ~Cursor() override = default;
+
+    bool next(Slice<const uint8_t>& raw) override {
+      if (it_ == end_) {
+        return false;
+      }
+      raw = storage_.getRecord(it_->second);
+      ++it_;
+      return true;
+    }
+
+   private:
+    FileBlockStorage& storage_;
+    typename index_t<T>::const_iterator it_;
+    typename index_t<T>::const_iterator end_;
+  };
+
+  //! indexes records in [from, file end), returns end of last full record
+  uint64_t scan(uint64_t from);
+
+  //! BlockIndex::toRaw() of a record which starts at `offset`
+  Slice<const uint8_t> getRecord(uint64_t offset);
+
+  AppendOnlyFile file_;
+  //! size of the log, which ends with a complete committed record
+  uint64_t committed_ = 0;
+
+  index_t<BtcBlock> btc_;
+  index_t<VbkBlock> vbk_;
+  index_t<AltBlock> alt_;
+
+  BtcBlock::hash_t btcTip_;
+  VbkBlock::hash_t vbkTip_;
+  AltBlock::hash_t altTip_;
+
+  TreeCommitment<BtcBlock> btcCommitment_;
+  TreeCommitment<VbkBlock> vbkCommitment_;
+  TreeCommitment<AltBlock> altCommitment_;
+};
+
+// clang-format off
+template <> inline const FileBlockStorage::index_t<BtcBlock>& FileBlockStorage::getIndex<BtcBlock>() const { return btc_; }
+template <> inline const FileBlockStorage::index_t<VbkBlock>& FileBlockStorage::getIndex<VbkBlock>() const { return vbk_; }
+template <> inline const FileBlockStorage::index_t<AltBlock>& FileBlockStorage::getIndex<AltBlock>() const { return alt_; }
+template <> inline BtcBlock::hash_t FileBlockStorage::getTip<BtcBlock>() const { return btcTip_; }
+template <> inline VbkBlock::hash_t FileBlockStorage::getTip<VbkBlock>() const { return vbkTip_; }
+template <> inline AltBlock::hash_t FileBlockStorage::getTip<AltBlock>() const { return altTip_; }
+template <> inline TreeCommitment<BtcBlock> FileBlockStorage::getCommitment<BtcBlock>() const { return btcCommitment_; }
+template <> inline TreeCommitment<VbkBlock> FileBlockStorage::getCommitment<VbkBlock>() const { return vbkCommitment_; }
+template <> inline TreeCommitment<AltBlock> FileBlockStorage::getCommitment<AltBlock>() const { return altCommitment_; }
+// clang-format on
+
+template <typename T>
+std::vector<BlockIndex<T>> FileBlockStorage::load() {
+  std::vector<BlockIndex<T>> ret;
+  auto& index = getIndex<T>();
+  ret.reserve(index.size());
+  for (auto& p : index) {
+    ret.push_back(BlockIndex<T>::fromRaw(getRecord(p.second)));
+  }
+  return ret;
+}
+
+/**
+ * @struct FileBlockBatch
+ *
+ * BlockBatchAdaptor, which writes blocks to FileBlockStorage in
+ * group-committed batches.
+ *
+ * Records are accumulated in memory, and appended to the log with a single
+ * write and sync when `commit` is called, or when more than `maxBatchSize`
+ * bytes are accumulated. Several SaveAllTrees calls may share one commit.
+ */
+struct FileBlockBatch : public BlockBatchAdaptor {
+  static const size_t kDefaultMaxBatchSize = 4 * 1024 * 1024;
+
+  FileBlockBatch(FileBlockStorage& storage,
+                 size_t maxBatchSize = kDefaultMaxBatchSize)
+      : storage_(storage), maxBatchSize_(maxBatchSize) {}
+  ~FileBlockBatch() override = default;
+
+  bool writeBlock(const BlockIndex<BtcBlock>& value) override;
+  bool writeBlock(const BlockIndex<VbkBlock>& value) override;
+  bool writeBlock(const BlockIndex<AltBlock>& value) override;
+
+  bool writeTip(const BlockIndex<BtcBlock>& value) override;
+  bool writeTip(const BlockIndex<VbkBlock>& value) override;
+  bool writeTip(const BlockIndex<AltBlock>& value) override;
+
+  bool removeBlock(const BtcBlock::hash_t& hash) override;
+  bool removeBlock(const VbkBlock::hash_t& hash) override;
+  bool removeBlock(const AltBlock::hash_t& hash) override;
+
+  bool writeCommitment(const BlockIndex<BtcBlock>& tip,
+                       const uint256& commitment) override;
+  bool writeCommitment(const BlockIndex<VbkBlock>& tip,
+                       const uint256& commitment) override;
+  bool writeCommitment(const BlockIndex<AltBlock>& tip,
+                       const uint256& commitment) override;
+
+  //! appends accumulated records to storage
+  bool commit(ValidationState& state);
+
+  //! number of accumulated, not yet committed bytes
+  size_t pendingSize() const { return pending_.size(); }
+
+  //! state of the last failed implicit commit
+  const ValidationState& getState() const { return state_; }
+
+ private:
+  bool append(uint8_t type,
+              Slice<const uint8_t> hash,
+              const std::vector<uint8_t>& raw);
+
+  FileBlockStorage& storage_;
+  size_t maxBatchSize_;
+  std::vector<uint8_t> pending_;
+  ValidationState state_;
+};
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_FILE_BLOCK_STORAGE_HPP
@@ -52,6 +52,10 @@ struct InmemBlockStorage {
   BtcBlock::hash_t btcTip;
   VbkBlock::hash_t vbkTip;
   AltBlock::hash_t altTip;
+
+  TreeCommitment<BtcBlock> btcCommitment;
+  TreeCommitment<VbkBlock> vbkCommitment;
+  TreeCommitment<AltBlock> altCommitment;
 };
 
 // clang-format off
@@ -101,6 +105,42 @@ struct InmemBlockBatch : public BlockBatchAdaptor {
     return true;
   }
 
+  bool removeBlock(const BtcBlock::hash_t& hash) override {
+    storage_.btc.erase(hash);
+    return true;
+  }
+
+  bool removeBlock(const VbkBlock::hash_t& hash) override {
+    storage_.vbk.erase(hash);
+    return true;
+  }
+
+  bool removeBlock(const AltBlock::hash_t& hash) override {
+    storage_.alt.erase(hash);
+    return true;
+  }
+
+  bool writeCommitment(const BlockIndex<BtcBlock>& tip,
+                       const uint256& commitment) override {
+    storage_.btcCommitment.tip = tip.getHash();
+    storage_.btcCommitment.value = commitment;
+    return true;
+  }
+
+  bool writeCommitment(const BlockIndex<VbkBlock>& tip,
+                       const uint256& commitment) override {
+    storage_.vbkCommitment.tip = tip.getHash();
+    storage_.vbkCommitment.value = commitment;
+    return true;
+  }
+
+  bool writeCommitment(const BlockIndex<AltBlock>& tip,
+                       const uint256& commitment) override {
+    storage_.altCommitment.tip = tip.getHash();
+    storage_.altCommitment.value = commitment;
+    return true;
+  }
+
  private:
   InmemBlockStorage& storage_;
 };
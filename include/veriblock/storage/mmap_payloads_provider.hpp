@@ -0,0 +1,116 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_MMAP_PAYLOADS_PROVIDER_HPP
+#define VERIBLOCK_POP_CPP_MMAP_PAYLOADS_PROVIDER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <veriblock/storage/append_only_file.hpp>
+#include <veriblock/storage/payloads_view_provider.hpp>
+
+namespace altintegration {
+
+/**
+ * @struct MmapPayloadsProvider
+ *
+ * Reference on-disk PayloadsProvider.
+ *
+ * Payloads are stored in a single append-only log. Each record is
+ * `type(1) | id | size(4, BE) | VBK-encoded payload`. Log is read through a
+ * memory mapping, ATVs and VTBs are served as views over mapped bytes.
+ *
+ * In-memory index maps payload id to record offset, and is rebuilt on `open`
+ * by scanning record headers only. Partially written records at the end of
+ * the log are discarded.
+ *
+ * `write` buffers records in memory, where they are already visible to
+ * readers, `flush` makes them durable with a single write and sync. If `flush`
+ * fails, partially written bytes are cut off and records stay buffered.
+ *
+ * Views over buffered records are invalidated by `write` and `flush`, views
+ * over flushed records are invalidated by `flush`.
+ *
+ * @ingroup interfaces
+ */
+struct MmapPayloadsProvider : public PayloadsViewProvider {
+  explicit MmapPayloadsProvider(std::string path) : file_(std::move(path)) {}
+  ~MmapPayloadsProvider() override = default;
+
+  //! opens payload log and rebuilds index
+  bool open(ValidationState& state);
+
+  void write(const PopData& data) {
+    write(data.context);
+    write(data.vtbs);
+    write(data.atvs);
+  }
+
+  template <typename T>
+  void write(const std::vector<T>& vs) {
+    for (auto& v : vs) {
+      write(v);
+    }
+  }
+
+  //! writes ATV and its block of proof
+  void write(const ATV& atv);
+  //! writes VTB and its containing block
+  void write(const VTB& vtb);
+  void write(const VbkBlock& block);
+
+  //! appends all buffered records to the log and syncs it
+  bool flush(ValidationState& state);
+
+  //! number of bytes written, but not flushed yet
+  size_t pendingSize() const { return pending_.size(); }
+
+  //! log size, including pending records
+  uint64_t size() const { return committed_ + pending_.size(); }
+
+  bool getATVViews(const std::vector<ATV::id_t>& ids,
+                   std::vector<ATVView>& out,
+                   ValidationState& state) override;
+
+  bool getVTBViews(const std::vector<VTB::id_t>& ids,
+                   std::vector<VTBView>& out,
+                   ValidationState& state) override;
+
+  bool getVBKs(const std::vector<VbkBlock::id_t>& ids,
+               std::vector<VbkBlock>& out,
+               ValidationState& state) override;
+
+ private:
+  template <typename T>
+  using index_t = std::unordered_map<typename T::id_t, uint64_t>;
+
+  template <typename T>
+  void append(const T& payload);
+
+  template <typename T, typename View>
+  bool getViews(const std::vector<typename T::id_t>& ids,
+                std::vector<View>& out,
+                ValidationState& state);
+
+  //! VBK-encoded payload of a record, which starts at `offset`
+  Slice<const uint8_t> getRecord(uint64_t offset, size_t idSize);
+
+  template <typename T>
+  index_t<T>& getIndex();
+
+  AppendOnlyFile file_;
+  //! size of the log, which ends with a complete record
+  uint64_t committed_ = 0;
+  std::vector<uint8_t> pending_;
+
+  index_t<ATV> atvs_;
+  index_t<VTB> vtbs_;
+  index_t<VbkBlock> vbkblocks_;
+};
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_MMAP_PAYLOADS_PROVIDER_HPP
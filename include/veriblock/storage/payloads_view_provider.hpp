@@ -0,0 +1,63 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_PAYLOADS_VIEW_PROVIDER_HPP
+#define VERIBLOCK_POP_CPP_PAYLOADS_VIEW_PROVIDER_HPP
+
+#include <veriblock/entities/payloads_view.hpp>
+#include <veriblock/storage/payloads_provider.hpp>
+
+namespace altintegration {
+
+/**
+ * @struct PayloadsViewProvider
+ *
+ * PayloadsProvider, which is able to serve ATVs and VTBs as views over its
+ * own buffers (page cache, mmaped file, etc).
+ *
+ * Commands are built directly from views, so only fields which are needed
+ * for state changes are decoded. Views must stay valid until the next call
+ * to this provider.
+ *
+ * @ingroup interfaces
+ */
+struct PayloadsViewProvider : public PayloadsProvider {
+  ~PayloadsViewProvider() override = default;
+
+  //! should write views over ALL ATVs identified by `id` into `out`, or
+  //! return false
+  virtual bool getATVViews(const std::vector<ATV::id_t>& ids,
+                           std::vector<ATVView>& out,
+                           ValidationState& state) = 0;
+  //! should write views over ALL VTBs identified by `id` into `out`, or
+  //! return false
+  virtual bool getVTBViews(const std::vector<VTB::id_t>& ids,
+                           std::vector<VTBView>& out,
+                           ValidationState& state) = 0;
+
+  //! materializes views returned by getATVViews
+  bool getATVs(const std::vector<ATV::id_t>& ids,
+               std::vector<ATV>& out,
+               ValidationState& state) override;
+
+  //! materializes views returned by getVTBViews
+  bool getVTBs(const std::vector<VTB::id_t>& ids,
+               std::vector<VTB>& out,
+               ValidationState& state) override;
+
+  bool getCommands(AltBlockTree& tree,
+                   const BlockIndex<AltBlock>& block,
+                   std::vector<CommandGroup>& out,
+                   ValidationState& state) override;
+
+  bool getCommands(VbkBlockTree& tree,
+                   const BlockIndex<VbkBlock>& block,
+                   std::vector<CommandGroup>& out,
+                   ValidationState& state) override;
+};
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_PAYLOADS_VIEW_PROVIDER_HPP
@@ -0,0 +1,167 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VERIBLOCK_POP_CPP_TREE_SNAPSHOT_HPP
+#define VERIBLOCK_POP_CPP_TREE_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <veriblock/blockchain/block_index.hpp>
+#include <veriblock/read_stream.hpp>
+#include <veriblock/validation_state.hpp>
+#include <veriblock/write_stream.hpp>
+
+namespace altintegration {
+
+/**
+ * Binary snapshot of block trees.
+ *
+ * Snapshot is position-independent: all references are record numbers or
+ * offsets relative to the section, so it may be restored directly from a
+ * memory-mapped file.
+ *
+ * Snapshot is `magic(4) | version(4) | hmac(32) | body`, where hmac is
+ * HMAC-SHA256 of body with node-local key. Body is a
+ * sequence of tree sections, one per tree:
+ * - `count(4)` number of blocks
+ * - `tip(4)` record number of the tip
+ * - `count` fixed-size records `parent(4) | offset(4) | size(4)`, ordered by
+ *   height, so parent record always precedes its children. Parent is
+ *   kSnapshotNoParent for the first bootstrap block, and must match previous
+ *   block hash in the header of every other block.
+ * - `data size(4) | data`, where record's BlockIndex::toRaw() is at `offset`
+ *
+ * All integers are big-endian.
+ *
+ * Version 2: BlockIndex records use compact toRaw() encoding.
+ * Version 3: checksum is keyed HMAC instead of sha256.
+ */
+static const uint32_t kSnapshotMagic = 0x56425453;  // "VBTS"
+static const uint32_t kSnapshotVersion = 3;
+static const uint32_t kSnapshotNoParent = 0xffffffff;
+//! magic, version and hmac
+static const size_t kSnapshotHeaderSize = 4 + 4 + 32;
+
+//! appends snapshot section of `tree` to `stream`
+template <typename BlockTreeT>
+void SaveTreeSnapshot(const BlockTreeT& tree, WriteStream& stream) {
+  using index_t = typename BlockTreeT::index_t;
+
+  std::vector<const index_t*> sorted;
+  sorted.reserve(tree.getBlocks().size());
+  for (const auto& p : tree.getBlocks()) {
+    sorted.push_back(p.second.get());
+  }
+  std::sort(
+      sorted.begin(), sorted.end(), [](const index_t* a, const index_t* b) {
+        return a->getHeight() < b->getHeight();
+      });
+
+  std::unordered_map<const index_t*, uint32_t> recordOf;
+  recordOf.reserve(sorted.size());
+  WriteStream data;
+  WriteStream records;
+  for (uint32_t i = 0; i < (uint32_t)sorted.size(); i++) {
+    const auto* index = sorted[i];
+    recordOf[index] = i;
+    auto it = recordOf.find(index->pprev);
+    uint32_t offset = (uint32_t)data.data().size();
+    index->toRaw(data);
+    records.writeBE<uint32_t>(it == recordOf.end() ? kSnapshotNoParent
+                                                   : it->second);
+    records.writeBE<uint32_t>(offset);
+    records.writeBE<uint32_t>((uint32_t)data.data().size() - offset);
+  }
+
+  auto* tip = tree.getBestChain().tip();
+  VBK_ASSERT(tip != nullptr && "tree must be bootstrapped");
+  stream.writeBE<uint32_t>((uint32_t)sorted.size());
+  stream.writeBE<uint32_t>(recordOf.at(tip));
+  stream.write(records.data());
+  stream.writeBE<uint32_t>((uint32_t)data.data().size());
+  stream.write(data.data());
+}
+
+/**
+ * Restores blocks from snapshot section at current position of `stream`.
+ *
+ * Blocks are decoded directly from the section and connected in stored order,
+ * without sorting. Blocks are trusted and not re-validated, so caller must
+ * authenticate the snapshot first, see AltBlockTree::restoreSnapshot.
+ * @invariant NOT atomic
+ */
+template <typename BlockTreeT>
+bool RestoreTreeSnapshot(BlockTreeT& tree,
+                         ReadStream& stream,
+                         ValidationState& state) {
+  using index_t = typename BlockTreeT::index_t;
+  using block_t = typename BlockTreeT::block_t;
+  using prev_hash_t = typename BlockTreeT::prev_block_hash_t;
+  const size_t recordSize = 3 * sizeof(uint32_t);
+
+  uint32_t count = 0;
+  uint32_t tip = 0;
+  Slice<const uint8_t> records;
+  uint32_t dataSize = 0;
+  Slice<const uint8_t> data;
+  if (!stream.readBE<uint32_t>(count, state) ||
+      !stream.readBE<uint32_t>(tip, state) ||
+      !stream.readSlice(count * recordSize, records, state) ||
+      !stream.readBE<uint32_t>(dataSize, state) ||
+      !stream.readSlice(dataSize, data, state)) {
+    return state.Invalid(block_t::name() + "-bad-snapshot-section");
+  }
+  if (tip >= count) {
+    return state.Invalid(block_t::name() + "-bad-snapshot-tip");
+  }
+
+  VBK_LOG_WARN("Restoring %d %s blocks from snapshot", count, block_t::name());
+  VBK_ASSERT(tree.isBootstrapped() && "tree must be bootstrapped");
+
+  ReadStream table(records);
+  typename BlockTreeT::hash_t tiphash;
+  // hashes of restored records, to check parent references
+  std::vector<prev_hash_t> hashes;
+  hashes.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    auto parent = table.readBE<uint32_t>();
+    auto offset = table.readBE<uint32_t>();
+    auto size = table.readBE<uint32_t>();
+    bool isRoot = parent == kSnapshotNoParent;
+    if ((isRoot ? i != 0 : parent >= i) ||
+        (uint64_t)offset + size > data.size()) {
+      return state.Invalid(block_t::name() + "-bad-snapshot-record",
+                           fmt::format("record {}", i));
+    }
+
+    index_t index;
+    try {
+      ReadStream block(data.data() + offset, size);
+      index.initFromRaw(block);
+    } catch (const std::exception& e) {
+      return state.Invalid(block_t::name() + "-bad-snapshot-block", e.what());
+    }
+
+    hashes.push_back(tree.makePrevHash(index.getHash()));
+    if (!isRoot &&
+        hashes[parent] != tree.makePrevHash(index.getHeader().previousBlock)) {
+      return state.Invalid(block_t::name() + "-bad-snapshot-parent",
+                           fmt::format("record {}", i));
+    }
+    if (!tree.loadCheckedBlock(index, state, true)) {
+      return state.Invalid(block_t::name() + "-bad-snapshot-block");
+    }
+    if (i == tip) {
+      tiphash = index.getHash();
+    }
+  }
+
+  return tree.loadTip(tiphash, state);
+}
+
+}  // namespace altintegration
+
+#endif  // VERIBLOCK_POP_CPP_TREE_SNAPSHOT_HPP
@@ -6,23 +6,224 @@
 #ifndef VERIBLOCK_POP_CPP_STORAGE_UTIL_HPP
 #define VERIBLOCK_POP_CPP_STORAGE_UTIL_HPP
 
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
+#include <veriblock/algorithm.hpp>
+#include <veriblock/arith_uint256.hpp>
 #include <veriblock/blockchain/alt_block_tree.hpp>
+#include <veriblock/hashutil.hpp>
 #include <veriblock/logger.hpp>
 #include <veriblock/storage/block_batch_adaptor.hpp>
+#include <veriblock/storage/block_cursor.hpp>
 #include <veriblock/validation_state.hpp>
 
 namespace altintegration {
 
-//! efficiently loads `blocks` into tree (they must be sorted by height) and
-//! does validation of these blocks. Sets tip after loading.
+namespace detail {
+
+template <typename Block, typename ChainParams>
+bool checkLoadedBlock(const BlockTree<Block, ChainParams>& tree,
+                      const BlockIndex<Block>& index,
+                      ValidationState& state) {
+  return tree.checkLoadedHeader(index, state);
+}
+
+//! ALT blocks have no PoW, there is nothing to check statelessly
+inline bool checkLoadedBlock(const AltBlockTree& /* tree */,
+                             const BlockIndex<AltBlock>& /* index */,
+                             ValidationState& /* state */) {
+  return true;
+}
+
+inline std::vector<Slice<const uint8_t>> readAll(BlockCursor& cursor) {
+  std::vector<Slice<const uint8_t>> raw;
+  Slice<const uint8_t> next;
+  while (cursor.next(next)) {
+    raw.push_back(next);
+  }
+  return raw;
+}
+
+//! HMAC of the chain of blocks, which ends at the tip: sum of digests of
+//! serialized blocks, their count, and the tip hash.
+template <typename Hash>
+uint256 makeTreeCommitment(Slice<const uint8_t> key,
+                           const ArithUint256& digestSum,
+                           uint64_t count,
+                           const Hash& tiphash) {
+  WriteStream stream;
+  stream.write(digestSum);
+  stream.writeBE<uint64_t>(count);
+  stream.write(tiphash);
+  return hmacSha256(key, stream.data());
+}
+
+//! marks `blocks` of the chain, which ends at the committed tip, if the chain
+//! matches `commitment`. Other blocks have been saved after the commitment,
+//! or modified.
+template <typename BlockTreeT>
+std::vector<bool> findTrustedBlocks(
+    const BlockTreeT& tree,
+    const std::vector<typename BlockTreeT::index_t>& blocks,
+    const std::vector<uint256>& digests,
+    const TreeCommitment<typename BlockTreeT::block_t>& commitment,
+    Slice<const uint8_t> key) {
+  std::vector<bool> trusted(blocks.size(), false);
+  if (key.size() == 0) {
+    return trusted;
+  }
+
+  using prev_hash_t = typename BlockTreeT::prev_block_hash_t;
+  std::unordered_map<prev_hash_t, size_t> byHash;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    byHash[tree.makePrevHash(blocks[i].getHash())] = i;
+  }
+
+  std::vector<size_t> chain;
+  ArithUint256 sum;
+  auto it = byHash.find(tree.makePrevHash(commitment.tip));
+  while (it != byHash.end() && chain.size() < blocks.size()) {
+    chain.push_back(it->second);
+    sum += ArithUint256(digests[it->second]);
+    const auto& header = blocks[it->second].getHeader();
+    it = byHash.find(tree.makePrevHash(header.previousBlock));
+  }
+
+  if (chain.empty() ||
+      makeTreeCommitment(key, sum, chain.size(), commitment.tip) !=
+          commitment.value) {
+    return trusted;
+  }
+
+  for (auto i : chain) {
+    trusted[i] = true;
+  }
+  return trusted;
+}
+
+template <typename BlockTreeT>
+bool decodeLoadedBlock(const BlockTreeT& tree,
+                       Slice<const uint8_t> raw,
+                       typename BlockTreeT::index_t& out,
+                       ValidationState& state,
+                       bool check = true) {
+  try {
+    ReadStream stream(raw);
+    out.initFromRaw(stream);
+  } catch (const std::exception& e) {
+    return state.Invalid("bad-block-encoding", e.what());
+  }
+  return !check || checkLoadedBlock(tree, out, state);
+}
+
+}  // namespace detail
+
+//! checks `blocks` in parallel, except for blocks marked in `trusted`. Does
+//! not modify the tree.
+template <typename BlockTreeT>
+bool CheckLoadedBlocks(const BlockTreeT& tree,
+                       const std::vector<typename BlockTreeT::index_t>& blocks,
+                       ValidationState& state,
+                       size_t threads = default_thread_count(),
+                       const std::vector<bool>& trusted = {}) {
+  auto failed = parallel_for(blocks.size(), threads, [&](size_t i) {
+    ValidationState dummy;
+    return (!trusted.empty() && trusted[i]) ||
+           detail::checkLoadedBlock(tree, blocks[i], dummy);
+  });
+  if (failed != blocks.size()) {
+    // repeat to get the reason
+    detail::checkLoadedBlock(tree, blocks[failed], state);
+    return state.Invalid("load-tree");
+  }
+  return true;
+}
+
+//! reads all blocks from `cursor`, decodes and checks them in parallel. Does
+//! not modify the tree, so may run concurrently with loading of other trees.
+//!
+//! Blocks of the chain, which ends at the committed tip, have been validated
+//! before they were saved, and are not checked again if they match
+//! `commitment` written by SaveTreeCommitment with the same `key`. They are
+//! marked in `trusted`. All other blocks are checked.
+template <typename BlockTreeT>
+bool DecodeLoadedBlocks(
+    const BlockTreeT& tree,
+    BlockCursor& cursor,
+    const TreeCommitment<typename BlockTreeT::block_t>& commitment,
+    Slice<const uint8_t> key,
+    std::vector<typename BlockTreeT::index_t>& out,
+    std::vector<bool>& trusted,
+    ValidationState& state,
+    size_t threads = default_thread_count()) {
+  auto raw = detail::readAll(cursor);
+
+  // decode and hash blocks, but do not check them yet
+  std::vector<typename BlockTreeT::index_t> blocks(raw.size());
+  std::vector<uint256> digests(raw.size());
+  auto failed = parallel_for(raw.size(), threads, [&](size_t i) {
+    ValidationState dummy;
+    digests[i] = sha256(raw[i]);
+    return detail::decodeLoadedBlock(tree, raw[i], blocks[i], dummy, false);
+  });
+  if (failed != raw.size()) {
+    detail::decodeLoadedBlock(tree, raw[failed], blocks[failed], state, false);
+    return state.Invalid("load-tree");
+  }
+
+  auto marked =
+      detail::findTrustedBlocks(tree, blocks, digests, commitment, key);
+  auto untrusted =
+      (size_t)std::count(marked.begin(), marked.end(), false);
+  if (untrusted > 0) {
+    VBK_LOG_WARN("%d of %d %s blocks do not match saved commitment, validating",
+                 untrusted,
+                 blocks.size(),
+                 BlockTreeT::block_t::name());
+    if (!CheckLoadedBlocks(tree, blocks, state, threads, marked)) {
+      return false;
+    }
+  }
+
+  out = std::move(blocks);
+  trusted = std::move(marked);
+  return true;
+}
+
+//! @overload
+//! All blocks are checked.
+template <typename BlockTreeT>
+bool DecodeLoadedBlocks(const BlockTreeT& tree,
+                        BlockCursor& cursor,
+                        std::vector<typename BlockTreeT::index_t>& out,
+                        ValidationState& state,
+                        size_t threads = default_thread_count()) {
+  auto raw = detail::readAll(cursor);
+
+  std::vector<typename BlockTreeT::index_t> blocks(raw.size());
+  auto failed = parallel_for(raw.size(), threads, [&](size_t i) {
+    ValidationState dummy;
+    return detail::decodeLoadedBlock(tree, raw[i], blocks[i], dummy);
+  });
+  if (failed != raw.size()) {
+    detail::decodeLoadedBlock(tree, raw[failed], blocks[failed], state);
+    return state.Invalid("load-tree");
+  }
+
+  out = std::move(blocks);
+  return true;
+}
+
+//! connects checked `blocks` to the tree in height order, and sets tip.
+//! Blocks marked in `trusted` are not validated contextually.
 //! @invariant NOT atomic
 template <typename BlockTreeT>
-bool LoadTree(BlockTreeT& tree,
-              std::vector<typename BlockTreeT::index_t> blocks,
-              const typename BlockTreeT::hash_t& tiphash,
-              ValidationState& state) {
-  using index_t = typename BlockTreeT::index_t;
+bool LinkLoadedBlocks(BlockTreeT& tree,
+                      const std::vector<typename BlockTreeT::index_t>& blocks,
+                      const typename BlockTreeT::hash_t& tiphash,
+                      ValidationState& state,
+                      const std::vector<bool>& trusted = {}) {
   using block_t = typename BlockTreeT::block_t;
   VBK_LOG_WARN("Loading %d %s blocks with tip %s",
                blocks.size(),
@@ -30,15 +231,18 @@ bool LoadTree(BlockTreeT& tree,
                HexStr(tiphash));
   VBK_ASSERT(tree.isBootstrapped() && "tree must be bootstrapped");
 
-  // first, sort them by height
-  std::sort(
-      blocks.begin(), blocks.end(), [](const index_t& a, const index_t& b) {
-        return a.getHeight() < b.getHeight();
-      });
+  // sort positions by height, blocks themselves are not copied
+  std::vector<size_t> sorted(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    sorted[i] = i;
+  }
+  std::sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) {
+    return blocks[a].getHeight() < blocks[b].getHeight();
+  });
 
-  for (auto& block : blocks) {
-    // load blocks one by one
-    if (!tree.loadBlock(block, state)) {
+  for (auto i : sorted) {
+    bool isTrusted = !trusted.empty() && trusted[i];
+    if (!tree.loadCheckedBlock(blocks[i], state, isTrusted)) {
       return state.Invalid("load-tree");
     }
   }
@@ -46,24 +250,144 @@ bool LoadTree(BlockTreeT& tree,
   return tree.loadTip(tiphash, state);
 }
 
-//! Save blocks and tip to batch
+//! efficiently loads `blocks` into tree and does validation of these blocks.
+//! Stateless checks (PoW) are done in parallel on `threads` threads, then
+//! blocks are connected in height order. Sets tip after loading.
+//! @invariant NOT atomic
+template <typename BlockTreeT>
+bool LoadTree(BlockTreeT& tree,
+              const std::vector<typename BlockTreeT::index_t>& blocks,
+              const typename BlockTreeT::hash_t& tiphash,
+              ValidationState& state,
+              size_t threads = default_thread_count()) {
+  return CheckLoadedBlocks(tree, blocks, state, threads) &&
+         LinkLoadedBlocks(tree, blocks, tiphash, state);
+}
+
+//! @overload
+//! Blocks are read from `cursor` and decoded in parallel.
+template <typename BlockTreeT>
+bool LoadTree(BlockTreeT& tree,
+              BlockCursor& cursor,
+              const typename BlockTreeT::hash_t& tiphash,
+              ValidationState& state,
+              size_t threads = default_thread_count()) {
+  std::vector<typename BlockTreeT::index_t> blocks;
+  return DecodeLoadedBlocks(tree, cursor, blocks, state, threads) &&
+         LinkLoadedBlocks(tree, blocks, tiphash, state);
+}
+
+//! @overload
+//! Trusted reload: blocks of the committed chain, which match `commitment`
+//! written by SaveTreeCommitment with the same `key`, are loaded without
+//! re-validation. All other blocks are fully validated.
+template <typename BlockTreeT>
+bool LoadTree(BlockTreeT& tree,
+              BlockCursor& cursor,
+              const typename BlockTreeT::hash_t& tiphash,
+              const TreeCommitment<typename BlockTreeT::block_t>& commitment,
+              Slice<const uint8_t> key,
+              ValidationState& state,
+              size_t threads = default_thread_count()) {
+  std::vector<typename BlockTreeT::index_t> blocks;
+  std::vector<bool> trusted;
+  return DecodeLoadedBlocks(
+             tree, cursor, commitment, key, blocks, trusted, state, threads) &&
+         LinkLoadedBlocks(tree, blocks, tiphash, state, trusted);
+}
+
+//! Save modified blocks and tip to batch, report removed blocks.
+//! Complexity is O(number of changed blocks).
 template <typename BlockTreeT>
 void SaveTree(BlockTreeT& tree, BlockBatchAdaptor& batch) {
-  for (auto& block : tree.getBlocks()) {
-    auto& index = block.second;
-    if (index->isDirty()) {
-      index->unsetDirty();
-      batch.writeBlock(*index);
-    }
+  for (const auto& hash : tree.getRemovedBlocks()) {
+    batch.removeBlock(hash);
   }
 
+  for (auto* index : tree.getDirtyBlocks()) {
+    batch.writeBlock(*index);
+  }
+
+  tree.markSaved();
   batch.writeTip(*tree.getBestChain().tip());
 }
 
+//! commitment to blocks of the active chain, as they are serialized in
+//! storage, authenticated with `key`. Complexity is O(chain length).
+template <typename BlockTreeT>
+uint256 GetTreeCommitment(const BlockTreeT& tree, Slice<const uint8_t> key) {
+  ArithUint256 sum;
+  uint64_t count = 0;
+  auto* tip = tree.getBestChain().tip();
+  for (auto* index = tip; index != nullptr; index = index->pprev) {
+    auto raw = index->toRaw();
+    sum += ArithUint256(sha256(raw));
+    count++;
+  }
+  return detail::makeTreeCommitment(key, sum, count, tip->getHash());
+}
+
+//! Save commitment to the saved active chain of the tree, which allows trusted
+//! reload. Should be called on clean shutdown, after SaveTree.
+//!
+//! `key` is a node-local secret, which must be kept outside of block storage,
+//! so that blocks and commitment can not be modified together.
+template <typename BlockTreeT>
+void SaveTreeCommitment(const BlockTreeT& tree,
+                        BlockBatchAdaptor& batch,
+                        Slice<const uint8_t> key) {
+  batch.writeCommitment(*tree.getBestChain().tip(),
+                        GetTreeCommitment(tree, key));
+}
+
 struct AltBlockTree;
 
 void SaveAllTrees(AltBlockTree& tree, BlockBatchAdaptor& batch);
 
+//! Save commitments of BTC, VBK and ALT trees, see SaveTreeCommitment.
+void SaveAllTreesCommitments(const AltBlockTree& tree,
+                             BlockBatchAdaptor& batch,
+                             Slice<const uint8_t> key);
+
+/**
+ * Load BTC, VBK and ALT trees of `tree`.
+ *
+ * Blocks of the next tree are decoded and checked while blocks of the
+ * previous tree are being connected.
+ * @invariant NOT atomic
+ */
+bool LoadAllTrees(AltBlockTree& tree,
+                  BlockCursor& btc,
+                  BlockCursor& vbk,
+                  BlockCursor& alt,
+                  const BtcBlock::hash_t& btcTip,
+                  const VbkBlock::hash_t& vbkTip,
+                  const AltBlock::hash_t& altTip,
+                  ValidationState& state,
+                  size_t threads = default_thread_count());
+
+/**
+ * Trusted reload of BTC, VBK and ALT trees of `tree`.
+ *
+ * Blocks of the committed chain of every tree, which match its commitment
+ * written by SaveAllTreesCommitments with the same `key`, are loaded without
+ * re-validation. All other blocks are fully validated.
+ * @invariant NOT atomic
+ */
+bool LoadAllTrees(AltBlockTree& tree,
+                  BlockCursor& btc,
+                  BlockCursor& vbk,
+                  BlockCursor& alt,
+                  const BtcBlock::hash_t& btcTip,
+                  const VbkBlock::hash_t& vbkTip,
+                  const AltBlock::hash_t& altTip,
+                  const TreeCommitment<BtcBlock>& btcCommitment,
+                  const TreeCommitment<VbkBlock>& vbkCommitment,
+                  const TreeCommitment<AltBlock>& altCommitment,
+                  Slice<const uint8_t> key,
+                  ValidationState& state,
+                  size_t threads = default_thread_count());
+
 }  // namespace altintegration
 
 #endif  // VERIBLOCK_POP_CPP_STORAGE_UTIL_HPP
@@ -25,6 +25,7 @@
 #ifndef _SHA2_H
 #define _SHA2_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "veriblock/consts.hpp"
@@ -72,6 +73,94 @@ void sha256_finish(sha256_context *ctx, uint8_t out[SHA256_HASH_SIZE]);
  */
 void sha256(uint8_t out[SHA256_HASH_SIZE], const uint8_t *buf, uint32_t nsize);
 
+/**
+ * \brief          SHA-256 block compression backends
+ *
+ * Backend is selected at runtime: by default the fastest one supported by the
+ * build and by CPU is used.
+ */
+typedef enum {
+  SHA256_BACKEND_PORTABLE = 0, /*!< portable C code         */
+  SHA256_BACKEND_SHANI = 1,    /*!< x86-64 SHA extensions   */
+  SHA256_BACKEND_ARMV8 = 2,    /*!< ARMv8 crypto extensions */
+} sha256_backend;
+
+/**
+ * Check if backend is compiled in and supported by CPU
+ * @param backend backend
+ * @return 1 if supported, 0 otherwise
+ */
+int sha256_backend_supported(sha256_backend backend);
+
+/**
+ * Use given backend for all subsequent hashing. Should not be called while
+ * other threads are hashing.
+ * @param backend backend
+ * @return 1 on success, 0 if backend is not supported
+ */
+int sha256_set_backend(sha256_backend backend);
+
+/**
+ * @return backend, which is currently used
+ */
+sha256_backend sha256_get_backend(void);
+
+/**
+ * @return human readable backend name
+ */
+const char *sha256_backend_name(sha256_backend backend);
+
+/**
+ * \brief          Multi-buffer SHA-256 backends, which hash several messages
+ *                 at once, one message per SIMD lane
+ *
+ * By default messages are hashed one by one if CPU has SHA extensions, which
+ * are faster than SIMD lanes, otherwise the widest supported backend is used.
+ */
+typedef enum {
+  SHA256_BATCH_SINGLE = 0, /*!< one message at a time    */
+  SHA256_BATCH_SSE2 = 1,   /*!< 4 messages, x86-64 SSE2  */
+  SHA256_BATCH_AVX2 = 2,   /*!< 8 messages, x86-64 AVX2  */
+} sha256_batch_backend;
+
+/**
+ * Check if batch backend is compiled in and supported by CPU
+ * @param backend batch backend
+ * @return 1 if supported, 0 otherwise
+ */
+int sha256_batch_backend_supported(sha256_batch_backend backend);
+
+/**
+ * Use given batch backend for all subsequent batch hashing. Should not be
+ * called while other threads are hashing.
+ * @param backend batch backend
+ * @return 1 on success, 0 if backend is not supported
+ */
+int sha256_set_batch_backend(sha256_batch_backend backend);
+
+/**
+ * @return batch backend, which is currently used
+ */
+sha256_batch_backend sha256_get_batch_backend(void);
+
+/**
+ * @return human readable batch backend name
+ */
+const char *sha256_batch_backend_name(sha256_batch_backend backend);
+
+/**
+ * \brief          Output = SHA-256( input[i] ) for every input
+ *
+ * \param out      n hashes, 32 bytes each, must not overlap inputs
+ * \param in       n buffers of the same size
+ * \param n        number of buffers
+ * \param nsize    size of every buffer
+ */
+void sha256_batch(uint8_t *out,
+                  const uint8_t *const *in,
+                  size_t n,
+                  uint32_t nsize);
+
 }  // namespace altintegration
 
 #endif /* sha2.h */
@@ -0,0 +1,72 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_VERIBLOCK_THREAD_POOL_HPP
+#define ALT_INTEGRATION_VERIBLOCK_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace altintegration {
+
+/**
+ * @struct ThreadPool
+ *
+ * Fixed set of worker threads, which are started once and reused by every
+ * `run` call, so that repeated parallel work does not pay for thread creation.
+ *
+ * `run` executes tasks on workers and on caller thread, and returns when all
+ * of them are done. Calls to `run` from different threads are serialized.
+ */
+struct ThreadPool {
+  //! starts `workers` threads, with 0 workers tasks run on caller thread
+  explicit ThreadPool(size_t workers = 0);
+
+  //! waits for running tasks and stops workers
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  //! number of worker threads
+  size_t size() const { return workers_.size(); }
+
+  //! starts more workers, until there are at least `workers` of them
+  void reserve(size_t workers);
+
+  /**
+   * Call `task(i)` for every `i` in [0, tasks) on workers and caller thread.
+   * Returns when all tasks are finished. If a task throws, remaining tasks
+   * still run, and the first exception is rethrown on caller thread.
+   */
+  void run(size_t tasks, const std::function<void(size_t)>& task);
+
+ private:
+  std::mutex runMutex_;
+  std::mutex mutex_;
+  std::condition_variable hasTasks_;
+  std::condition_variable finished_;
+  const std::function<void(size_t)>* task_ = nullptr;
+  size_t tasks_ = 0;
+  size_t next_ = 0;
+  // tasks, which are taken, but not finished yet
+  size_t running_ = 0;
+  std::exception_ptr error_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+
+  void work();
+
+  //! runs next task, returns false if there are none
+  bool runNext(std::unique_lock<std::mutex>& lock);
+};
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_VERIBLOCK_THREAD_POOL_HPP
@@ -55,6 +55,54 @@ int vblake(void *out,  // return buffer for digest
            const void *in,
            size_t inlen);  // data to be hashed
 
+/**
+ * Multi-buffer vBlake backends, which hash several messages at once, one
+ * message per SIMD lane. By default the widest one supported by the build and
+ * by CPU is used.
+ */
+typedef enum {
+  VBLAKE_BATCH_SINGLE = 0,  ///< one message at a time
+  VBLAKE_BATCH_AVX2 = 1,    ///< 4 messages, x86-64 AVX2
+} vblake_batch_backend;
+
+/**
+ * Check if batch backend is compiled in and supported by CPU
+ * @param backend batch backend
+ * @return 1 if supported, 0 otherwise
+ */
+int vblake_batch_backend_supported(vblake_batch_backend backend);
+
+/**
+ * Use given batch backend for all subsequent batch hashing. Should not be
+ * called while other threads are hashing.
+ * @param backend batch backend
+ * @return 1 on success, 0 if backend is not supported
+ */
+int vblake_set_batch_backend(vblake_batch_backend backend);
+
+/**
+ * @return batch backend, which is currently used
+ */
+vblake_batch_backend vblake_get_batch_backend(void);
+
+/**
+ * @return human readable batch backend name
+ */
+const char *vblake_batch_backend_name(vblake_batch_backend backend);
+
+/**
+ * Computes vBlake of many inputs of the same size.
+ * @param[out] out n hashes, 24 bytes each, must not overlap inputs
+ * @param[in] in n input buffers
+ * @param[in] n number of input buffers
+ * @param[in] inlen length of every input buffer, not more than 64 bytes
+ * @return 0 if succeeded, -1 if inlen is more than 64 bytes
+ */
+int vblake_batch(void *out,
+                 const uint8_t *const *in,
+                 size_t n,
+                 size_t inlen);
+
 }  // namespace altintegration
 
 #endif  // ALT_INTEGRATION_VBLAKE_HPP
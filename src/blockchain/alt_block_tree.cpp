@@ -8,6 +8,7 @@
 #include <veriblock/blockchain/commands/commands.hpp>
 #include <veriblock/reversed_range.hpp>
 #include <veriblock/storage/block_batch_adaptor.hpp>
+#include <veriblock/storage/tree_snapshot.hpp>
 
 #include "veriblock/algorithm.hpp"
 #include "veriblock/command_group_cache.hpp"
@@ -261,7 +262,7 @@ bool AltBlockTree::connectBlock(index_t& index, ValidationState& state) {
 // in !StrictAddPayloadsOrdering mode, payloads can be added to any block, which
 // may trigger incorrect AltTree behavior in certain cases
 bool AltBlockTree::addPayloads(index_t& index,
-                               PopData& payloads,
+                               const PopData& payloads,
                                ValidationState& state) {
   // atomicity: ensure we can not just add payloads but connect the block
   VBK_ASSERT_MSG(index.pprev->hasFlags(BLOCK_CONNECTED),
@@ -532,10 +533,9 @@ void AltBlockTree::filterInvalidPayloads(PopData& pop) {
 bool AltBlockTree::addPayloads(const hash_t& block,
                                const PopData& popData,
                                ValidationState& state) {
-  auto copy = popData;
   auto* index = getBlockIndex(block);
   VBK_ASSERT_MSG(index, "can't find block %s", HexStr(block));
-  return addPayloads(*index, copy, state);
+  return addPayloads(*index, popData, state);
 }
 
 bool AltBlockTree::setState(index_t& to, ValidationState& state) {
@@ -583,6 +583,12 @@ void AltBlockTree::setTipContinueOnInvalid(AltBlockTree::index_t& to) {
 
 bool AltBlockTree::loadBlock(const AltBlockTree::index_t& index,
                              ValidationState& state) {
+  return loadCheckedBlock(index, state, false);
+}
+
+bool AltBlockTree::loadCheckedBlock(const AltBlockTree::index_t& index,
+                                    ValidationState& state,
+                                    bool trusted) {
   if (!base::loadBlock(index, state)) {
     return false;  // already set
   }
@@ -592,20 +598,32 @@ bool AltBlockTree::loadBlock(const AltBlockTree::index_t& index,
   auto* current = getBlockIndex(containingHash);
   VBK_ASSERT(current);
 
-  auto vbkblocks = current->getPayloadIds<VbkBlock>();
-  auto vtbs = current->getPayloadIds<VTB>();
-  auto atvs = current->getPayloadIds<ATV>();
-  if (hasDuplicates<VbkBlock>(*current, vbkblocks, *this, state) ||
-      hasDuplicates<VTB>(*current, vtbs, *this, state) ||
-      hasDuplicates<ATV>(*current, atvs, *this, state)) {
-    return false;
+  if (!trusted) {
+    auto vbkblocks = current->getPayloadIds<VbkBlock>();
+    auto vtbs = current->getPayloadIds<VTB>();
+    auto atvs = current->getPayloadIds<ATV>();
+    if (hasDuplicates<VbkBlock>(*current, vbkblocks, *this, state) ||
+        hasDuplicates<VTB>(*current, vtbs, *this, state) ||
+        hasDuplicates<ATV>(*current, atvs, *this, state)) {
+      return false;
+    }
   }
 
-  // recover `endorsedBy` and `blockOfProofEndorsements`
-  auto window = std::max(
-      0, index.getHeight() - getParams().getEndorsementSettlementInterval());
-  Chain<index_t> chain(window, current);
-  if (!recoverEndorsements(*this, chain, *current, state)) {
+  // `endorsedBy` of loaded blocks is resolved on first access
+  current->setEndorsedByUnresolved(
+      getParams().getEndorsementSettlementInterval());
+
+  // recover `blockOfProofEndorsements`
+  bool recovered = false;
+  if (trusted) {
+    recovered = recoverEndorsements(*this, nullptr, *current, state);
+  } else {
+    auto window = std::max(
+        0, index.getHeight() - getParams().getEndorsementSettlementInterval());
+    Chain<index_t> chain(window, current);
+    recovered = recoverEndorsements(*this, &chain, *current, state);
+  }
+  if (!recovered) {
     return state.Invalid("bad-endorsements");
   }
 
@@ -614,6 +632,65 @@ bool AltBlockTree::loadBlock(const AltBlockTree::index_t& index,
   return true;
 }
 
+void AltBlockTree::saveSnapshot(WriteStream& stream,
+                                Slice<const uint8_t> key) const {
+  WriteStream body;
+  SaveTreeSnapshot(btc(), body);
+  SaveTreeSnapshot(vbk(), body);
+  SaveTreeSnapshot(*this, body);
+
+  stream.writeBE<uint32_t>(kSnapshotMagic);
+  stream.writeBE<uint32_t>(kSnapshotVersion);
+  auto checksum = hmacSha256(key, body.data());
+  stream.write(checksum);
+  stream.write(body.data());
+}
+
+bool AltBlockTree::restoreSnapshot(Slice<const uint8_t> snapshot,
+                                   Slice<const uint8_t> key,
+                                   ValidationState& state) {
+  auto invalid = [&state](const std::string& reason,
+                          const std::string& debug = "") {
+    state.Invalid(reason, debug);
+    return state.Invalid("restore-snapshot");
+  };
+
+  // blocks are not re-validated, so snapshot must be authenticated
+  if (key.size() == 0) {
+    return invalid("bad-snapshot-key");
+  }
+
+  ReadStream stream(snapshot);
+  ValidationState dummy;
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  Slice<const uint8_t> checksum;
+  if (!stream.readBE<uint32_t>(magic, dummy) ||
+      !stream.readBE<uint32_t>(version, dummy) ||
+      !stream.readSlice(uint256::size(), checksum, dummy)) {
+    return invalid("bad-snapshot-header");
+  }
+  if (magic != kSnapshotMagic) {
+    return invalid("bad-snapshot-magic");
+  }
+  if (version != kSnapshotVersion) {
+    return invalid("bad-snapshot-version", fmt::format("version {}", version));
+  }
+
+  Slice<const uint8_t> body(snapshot.data() + stream.position(),
+                            stream.remaining());
+  if (hmacSha256(key, body) != uint256(checksum)) {
+    return invalid("bad-snapshot-checksum");
+  }
+
+  if (!RestoreTreeSnapshot(btc(), stream, state) ||
+      !RestoreTreeSnapshot(vbk(), stream, state) ||
+      !RestoreTreeSnapshot(*this, stream, state)) {
+    return state.Invalid("restore-snapshot");
+  }
+  return true;
+}
+
 AltBlockTree::AltBlockTree(const AltBlockTree::alt_config_t& alt_config,
                            const AltBlockTree::vbk_config_t& vbk_config,
                            const AltBlockTree::btc_config_t& btc_config,
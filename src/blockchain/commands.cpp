@@ -5,6 +5,7 @@
 
 #include <veriblock/blockchain/alt_block_tree.hpp>
 #include <veriblock/blockchain/commands/commands.hpp>
+#include <veriblock/entities/payloads_view.hpp>
 
 namespace altintegration {
 
@@ -42,6 +43,49 @@ void payloadToCommands(AltBlockTree& tree,
   cmds.push_back(std::move(cmd));
 }
 
+template <>
+void payloadToCommands(AltBlockTree& tree,
+                       const VTBView& pop,
+                       const std::vector<uint8_t>& containingHash,
+                       std::vector<CommandPtr>& cmds) {
+  // AddVTB owns the VTB, so it has to be decoded
+  ValidationState state;
+  VTB vtb;
+  VBK_ASSERT_MSG(pop.materialize(vtb, state),
+                 "stored VTB=%s is corrupted: %s",
+                 HexStr(pop.getId()),
+                 state.toString());
+  payloadToCommands(tree, vtb, containingHash, cmds);
+}
+
+template <>
+void payloadToCommands(AltBlockTree& tree,
+                       const ATVView& pop,
+                       const std::vector<uint8_t>& containingHash,
+                       std::vector<CommandPtr>& cmds) {
+  // decode only fields which are needed for endorsement
+  ValidationState state;
+  VbkBlock blockOfProof;
+  PublicationData publicationData;
+  VBK_ASSERT_MSG(pop.getBlockOfProof(blockOfProof, state) &&
+                     pop.getPublicationData(publicationData, state),
+                 "stored ATV=%s is corrupted: %s",
+                 HexStr(pop.getId()),
+                 state.toString());
+  addBlock(tree.vbk(), blockOfProof, cmds);
+
+  auto e = std::make_shared<AltEndorsement>();
+  e->id = pop.getId();
+  e->blockOfProof = blockOfProof.getHash();
+  e->endorsedHash = tree.getParams().getHash(publicationData.header);
+  e->containingHash = containingHash;
+  e->payoutInfo = std::move(publicationData.payoutInfo);
+
+  auto cmd =
+      std::make_shared<AddAltEndorsement>(tree.vbk(), tree, std::move(e));
+  cmds.push_back(std::move(cmd));
+}
+
 template <>
 std::vector<CommandGroup> payloadsToCommandGroups(
     AltBlockTree& tree,
@@ -79,6 +123,39 @@ void payloadToCommands(VbkBlockTree& tree,
   cmds.push_back(std::move(cmd));
 }
 
+template <>
+void payloadToCommands(VbkBlockTree& tree,
+                       const VTBView& pop,
+                       const std::vector<uint8_t>& /* ignore */,
+                       std::vector<CommandPtr>& cmds) {
+  // decode only BTC blocks and containing block, rest of VTB is not needed
+  ValidationState state;
+  VbkBlock containingBlock;
+  std::vector<BtcBlock> context;
+  BtcBlock blockOfProof;
+  VBK_ASSERT_MSG(pop.getContainingBlock(containingBlock, state) &&
+                     pop.transaction.getBlockOfProofContext(context, state) &&
+                     pop.transaction.getBlockOfProof(blockOfProof, state),
+                 "stored VTB=%s is corrupted: %s",
+                 HexStr(pop.getId()),
+                 state.toString());
+
+  for (const auto& b : context) {
+    addBlock(tree.btc(), b, containingBlock.height, cmds);
+  }
+  addBlock(tree.btc(), blockOfProof, containingBlock.height, cmds);
+
+  auto e = std::make_shared<VbkEndorsement>();
+  e->id = pop.getId();
+  e->blockOfProof = blockOfProof.getHash();
+  e->containingHash = containingBlock.getHash();
+  e->endorsedHash = pop.transaction.getPublishedBlockHash();
+  e->payoutInfo = {};
+  auto cmd =
+      std::make_shared<AddVbkEndorsement>(tree.btc(), tree, std::move(e));
+  cmds.push_back(std::move(cmd));
+}
+
 template <>
 std::vector<CommandGroup> payloadsToCommandGroups(
     VbkBlockTree& tree,
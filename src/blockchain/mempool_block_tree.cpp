@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <numeric>
+
 #include "veriblock/blockchain/blockchain_util.hpp"
 #include "veriblock/blockchain/mempool_block_tree.hpp"
+#include "veriblock/hashutil.hpp"
 #include "veriblock/keystone_util.hpp"
 
 namespace altintegration {
@@ -15,15 +19,35 @@ PopData VbkPayloadsRelations::toPopData() const {
     pop.atvs.push_back(*atv);
   }
 
-  // we sort VTBs in ascending order of their containing VBK blocks to guarantee
-  // that within a single block they all are connected.
-  std::sort(pop.vtbs.begin(), pop.vtbs.end(), [](const VTB& a, const VTB& b) {
-    return a.containingBlock.height < b.containingBlock.height;
-  });
-
   return pop;
 }
 
+size_t VbkPayloadsRelations::estimateSize(size_t vtbsCount,
+                                          size_t atvsCount) const {
+  VBK_ASSERT(vtbsCount <= vtbs.size() && atvsCount <= atvs.size());
+  // version, context, atvs, vtbs. see PopData::toVbkEncoding
+  size_t size = sizeof(uint32_t) + singleBEValueSize(1) + headerSize +
+                singleBEValueSize(atvsCount) + singleBEValueSize(vtbsCount);
+  size = std::accumulate(atvSizes.begin(), atvSizes.begin() + atvsCount, size);
+  size = std::accumulate(vtbSizes.begin(), vtbSizes.begin() + vtbsCount, size);
+  return size;
+}
+
+void VbkPayloadsRelations::addVTB(std::shared_ptr<VTB> vtb) {
+  VBK_ASSERT(vtb->containingBlock.getId() == id);
+  vtbSizes.push_back(vtb->serializedSize());
+  vtbPublished.push_back(vtb->transaction.publishedBlock.getId());
+  vtbs.push_back(std::move(vtb));
+  usage_ += payloadUsage<VTB>(vtbSizes.back());
+}
+
+void VbkPayloadsRelations::addATV(std::shared_ptr<ATV> atv) {
+  atvSizes.push_back(atv->serializedSize());
+  atvEndorsed.push_back(sha256(atv->transaction.publicationData.header));
+  atvs.push_back(std::move(atv));
+  usage_ += payloadUsage<ATV>(atvSizes.back());
+}
+
 void VbkPayloadsRelations::removeVTB(const VTB::id_t& vtb_id) {
   auto it = std::find_if(
       vtbs.begin(), vtbs.end(), [&vtb_id](const std::shared_ptr<VTB>& vtb) {
@@ -31,6 +55,9 @@ void VbkPayloadsRelations::removeVTB(const VTB::id_t& vtb_id) {
       });
 
   if (it != vtbs.end()) {
+    usage_ -= payloadUsage<VTB>(vtbSizes[it - vtbs.begin()]);
+    vtbSizes.erase(vtbSizes.begin() + (it - vtbs.begin()));
+    vtbPublished.erase(vtbPublished.begin() + (it - vtbs.begin()));
     vtbs.erase(it);
   }
 }
@@ -42,10 +69,256 @@ void VbkPayloadsRelations::removeATV(const ATV::id_t& atv_id) {
       });
 
   if (it != atvs.end()) {
+    usage_ -= payloadUsage<ATV>(atvSizes[it - atvs.begin()]);
+    atvSizes.erase(atvSizes.begin() + (it - atvs.begin()));
+    atvEndorsed.erase(atvEndorsed.begin() + (it - atvs.begin()));
     atvs.erase(it);
   }
 }
 
+bool MemPoolBlockTree::isOnActiveChain(const std::vector<uint8_t>& id) const {
+  auto& chain = tree_.getBestChain();
+  for (const auto& hash : tree_.getPayloadsIndex().getContainingAltBlocks(id)) {
+    if (chain.contains(tree_.getBlockIndex(hash))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MemPoolBlockTree::validateBTCContext(const VTB& vtb,
+                                          ValidationState& state) const {
+  auto& tx = vtb.transaction;
+  auto& firstBlock = tx.blockOfProofContext.empty()
+                         ? tx.blockOfProof
+                         : tx.blockOfProofContext[0];
+  auto connectingHash = firstBlock.previousBlock != ArithUint256()
+                            ? firstBlock.previousBlock
+                            : firstBlock.getHash();
+
+  auto* connecting = temp_btc_tree_.getBlockIndex(connectingHash);
+  if (connecting == nullptr) {
+    return state.Invalid("vtb-btc-context-unknown-previous-block",
+                         "Can not find the BTC block referenced by the first "
+                         "block of the VTB context: " +
+                             connectingHash.toHex());
+  }
+
+  auto height = vtb.containingBlock.height;
+  auto& refs = connecting->getRefs();
+  auto it = btcRefs_.find(connecting->getHash());
+  bool isValid = std::any_of(refs.begin(),
+                             refs.end(),
+                             [&](int32_t ref) { return ref <= height; }) ||
+                 (it != btcRefs_.end() && it->second <= height);
+  return isValid
+             ? true
+             : state.Invalid("vtb-btc-context-block-referenced-too-early",
+                             "The BTC block referenced by the first block of "
+                             "the VTB context is added by blocks that follow "
+                             "the containing block: " +
+                                 connectingHash.toHex());
+}
+
+bool MemPoolBlockTree::acceptVbkBlock(const VbkBlock& blk,
+                                      ValidationState& state) {
+  auto id = blk.getId();
+  if (vbkblocks_.count(id) > 0 || isOnActiveChain(id.asVector())) {
+    return state.Invalid("vbkblock-duplicate");
+  }
+
+  if (!temp_vbk_tree_.acceptBlock(blk, state)) {
+    return false;
+  }
+
+  vbkblocks_.insert(id);
+  return true;
+}
+
+void MemPoolBlockTree::removeVbkBlock(const VbkBlock& blk) {
+  temp_vbk_tree_.removeBlock(blk.getHash());
+  vbkblocks_.erase(blk.getId());
+}
+
+bool MemPoolBlockTree::acceptVTB(const VTB& vtb, ValidationState& state) {
+  auto id = vtb.getId();
+  if (vtbs_.count(id) > 0 || isOnActiveChain(id.asVector())) {
+    return state.Invalid("vtb-duplicate");
+  }
+
+  auto* containing = temp_vbk_tree_.getBlockIndex(vtb.containingBlock.getHash());
+  if (containing == nullptr) {
+    return state.Invalid(
+        "VBK-bad-containing",
+        "Can not find VTB containing block: " +
+            vtb.containingBlock.getHash().toHex());
+  }
+  if (containing->pprev == nullptr) {
+    return state.Invalid("VBK-bad-containing-prev",
+                         "It is forbidden to add payloads to bootstrap block");
+  }
+
+  if (!validateBTCContext(vtb, state)) {
+    return state.Invalid("VBK-btc-context-does-not-connect");
+  }
+
+  // see AddEndorsement
+  auto window =
+      tree_.vbk().getParams().getEndorsementSettlementInterval();
+  auto* endorsed = temp_vbk_tree_.getBlockIndex(
+      vtb.transaction.publishedBlock.getHash());
+  if (endorsed == nullptr) {
+    return state.Invalid("VBK-no-endorsed-block",
+                         "Endorsed block not found in the tree");
+  }
+  if (containing->getHeight() - endorsed->getHeight() > window) {
+    return state.Invalid("VBK-expired", "Endorsement expired");
+  }
+  if (containing->getAncestor(endorsed->getHeight()) != endorsed) {
+    return state.Invalid("VBK-block-differs",
+                         "Endorsed block is on a different chain");
+  }
+
+  // endorsement must not be contained in the chain of containing block
+  const auto* block = containing;
+  for (int32_t i = 0; i < window && block != nullptr; i++) {
+    if (block->getContainingEndorsements().count(id) > 0) {
+      return state.Invalid("vtb-duplicate",
+                           "VTB is already added to containing chain in " +
+                               block->toShortPrettyString());
+    }
+    block = block->pprev;
+  }
+
+  // BTC blocks are added before endorsement in payloadToCommands, but
+  // endorsement checks above do not depend on them. If one of BTC blocks is
+  // invalid, canonical tree rolls back the whole VTB, so do the same here.
+  std::vector<BtcBlock::hash_t> added;
+  // previous min reference height, -1 if there was no reference
+  std::vector<std::pair<BtcBlock::hash_t, int32_t>> oldRefs;
+  auto rollback = [&]() {
+    for (auto it = oldRefs.rbegin(); it != oldRefs.rend(); ++it) {
+      if (it->second < 0) {
+        btcRefs_.erase(it->first);
+      } else {
+        btcRefs_[it->first] = it->second;
+      }
+    }
+    for (auto it = added.rbegin(); it != added.rend(); ++it) {
+      temp_btc_tree_.removeBlock(*it);
+    }
+  };
+  auto acceptBtcBlock = [&](const BtcBlock& b) {
+    auto hash = b.getHash();
+    bool known = temp_btc_tree_.getBlockIndex(hash) != nullptr;
+    if (!temp_btc_tree_.acceptBlock(b, state)) {
+      return false;
+    }
+    if (!known) {
+      added.push_back(hash);
+    }
+    auto ref = btcRefs_.find(hash);
+    if (ref == btcRefs_.end()) {
+      oldRefs.emplace_back(hash, -1);
+      btcRefs_.emplace(hash, containing->getHeight());
+    } else {
+      oldRefs.emplace_back(hash, ref->second);
+      ref->second = (std::min)(ref->second, containing->getHeight());
+    }
+    return true;
+  };
+  for (const auto& b : vtb.transaction.blockOfProofContext) {
+    if (!acceptBtcBlock(b)) {
+      rollback();
+      return state.Invalid("vtb-btc-context");
+    }
+  }
+  if (!acceptBtcBlock(vtb.transaction.blockOfProof)) {
+    rollback();
+    return state.Invalid("vtb-btc-block-of-proof");
+  }
+
+  vtbs_.insert(id);
+  return true;
+}
+
+bool MemPoolBlockTree::acceptATV(const ATV& atv, ValidationState& state) {
+  auto id = atv.getId();
+  if (atvs_.count(id) > 0 || isOnActiveChain(id.asVector())) {
+    return state.Invalid("atv-duplicate");
+  }
+
+  // see AddEndorsement. ATV is added to the next block on top of ALT tip
+  auto& chain = tree_.getBestChain();
+  auto containingHeight = chain.tip()->getHeight() + 1;
+  auto window = tree_.getParams().getEndorsementSettlementInterval();
+  auto* endorsed = tree_.getBlockIndex(
+      tree_.getParams().getHash(atv.transaction.publicationData.header));
+  if (endorsed == nullptr) {
+    return state.Invalid("ALT-no-endorsed-block",
+                         "Endorsed block not found in the tree");
+  }
+  if (containingHeight - endorsed->getHeight() > window) {
+    return state.Invalid("ALT-expired", "Endorsement expired");
+  }
+  if (!chain.contains(endorsed)) {
+    return state.Invalid("ALT-block-differs",
+                         "Endorsed block is on a different chain");
+  }
+
+  // block of proof is added before endorsement in payloadToCommands, but
+  // endorsement checks above do not depend on it, and a rejected ATV must not
+  // leave it in the overlay
+  if (temp_vbk_tree_.getBlockIndex(atv.blockOfProof.getHash()) == nullptr &&
+      !temp_vbk_tree_.acceptBlock(atv.blockOfProof, state)) {
+    return state.Invalid("atv-block-of-proof");
+  }
+
+  atvs_.insert(id);
+  return true;
+}
+
+template <typename Pop, typename Accept>
+static void filterPayloads(std::vector<Pop>& payloads, Accept accept) {
+  auto it =
+      std::remove_if(payloads.begin(), payloads.end(), [&](const Pop& p) {
+        ValidationState state;
+        if (accept(p, state)) {
+          return false;
+        }
+        VBK_LOG_DEBUG("Removed %s %s from PopData: %s",
+                      Pop::name(),
+                      p.getId().toHex(),
+                      state.toString());
+        return true;
+      });
+  payloads.erase(it, payloads.end());
+}
+
+void MemPoolBlockTree::filterInvalidPayloads(PopData& pop) {
+  clear();
+
+  // same order in which payloads are applied, see payloadsToCommandGroups
+  filterPayloads(pop.context, [&](const VbkBlock& b, ValidationState& state) {
+    return acceptVbkBlock(b, state);
+  });
+  filterPayloads(pop.vtbs, [&](const VTB& vtb, ValidationState& state) {
+    return acceptVTB(vtb, state);
+  });
+  filterPayloads(pop.atvs, [&](const ATV& atv, ValidationState& state) {
+    return acceptATV(atv, state);
+  });
+}
+
+void MemPoolBlockTree::clear() {
+  temp_vbk_tree_.clear();
+  temp_btc_tree_.clear();
+  vbkblocks_.clear();
+  vtbs_.clear();
+  atvs_.clear();
+  btcRefs_.clear();
+}
+
 bool MemPoolBlockTree::areStronglyEquivalent(const ATV& atv1, const ATV& atv2) {
   return atv1.transaction.getHash() == atv2.transaction.getHash() &&
          atv1.blockOfProof.getHash() == atv2.blockOfProof.getHash();
@@ -375,9 +375,10 @@ std::string VbkBlockTree::toPrettyString(size_t level) const {
       "%s\n%s", VbkTree::toPrettyString(level), cmp_.toPrettyString(level + 2));
 }
 
-bool VbkBlockTree::loadBlock(const VbkBlockTree::index_t& index,
-                             ValidationState& state) {
-  if (!VbkTree::loadBlock(index, state)) {
+bool VbkBlockTree::loadCheckedBlock(const VbkBlockTree::index_t& index,
+                                    ValidationState& state,
+                                    bool trusted) {
+  if (!VbkTree::loadCheckedBlock(index, state, trusted)) {
     return false;  // already set
   }
 
@@ -386,11 +387,20 @@ bool VbkBlockTree::loadBlock(const VbkBlockTree::index_t& index,
 
   // TODO: check for duplicates
 
-  // recover `endorsedBy`
-  auto window = std::max(
-      0, index.getHeight() - param_->getEndorsementSettlementInterval());
-  Chain<index_t> chain(window, current);
-  if (!recoverEndorsements(*this, chain, *current, state)) {
+  // `endorsedBy` of loaded blocks is resolved on first access
+  current->setEndorsedByUnresolved(param_->getEndorsementSettlementInterval());
+
+  // recover `blockOfProofEndorsements`
+  bool recovered = false;
+  if (trusted) {
+    recovered = recoverEndorsements(*this, nullptr, *current, state);
+  } else {
+    auto window = std::max(
+        0, index.getHeight() - param_->getEndorsementSettlementInterval());
+    Chain<index_t> chain(window, current);
+    recovered = recoverEndorsements(*this, &chain, *current, state);
+  }
+  if (!recovered) {
     return state.Invalid("bad-endorsements");
   }
 
@@ -449,10 +459,10 @@ void assertBlockCanBeRemoved(const BlockIndex<VbkBlock>& index) {
                  "lost",
                  index.blockOfProofEndorsements.size());
 
-  VBK_ASSERT_MSG(index.endorsedBy.empty(),
+  VBK_ASSERT_MSG(index.getEndorsedBy().empty(),
                  "endorsedBy has %d pointers to endorsements, they will be "
                  "lost",
-                 index.endorsedBy.size());
+                 index.getEndorsedBy().size());
 }
 
 template <>
@@ -0,0 +1,65 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_SRC_CPU_FEATURES_HPP
+#define ALT_INTEGRATION_SRC_CPU_FEATURES_HPP
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace altintegration {
+
+// runtime checks of CPU features used by hashing backends, which are compiled
+// with their own instruction set flags
+
+//! @return true if CPU supports x86 SHA extensions, SSSE3 and SSE4.1
+inline bool cpuHasShaNi() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  // SSSE3 and SSE4.1
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 ||
+      (ecx & bit_SSSE3) == 0 || (ecx & bit_SSE4_1) == 0) {
+    return false;
+  }
+  // SHA
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (ebx & (1u << 29)) != 0;
+#else
+  return false;
+#endif
+}
+
+//! @return true if CPU supports AVX2 and OS saves YMM registers
+inline bool cpuHasAvx2() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  // AVX, and OS saves YMM registers
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 || (ecx & bit_AVX) == 0 ||
+      (ecx & bit_OSXSAVE) == 0) {
+    return false;
+  }
+  uint32_t xcr0 = 0, xcr0High = 0;
+  __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+  if ((xcr0 & 6) != 6) {
+    return false;
+  }
+  // AVX2
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (ebx & (1u << 5)) != 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_SRC_CPU_FEATURES_HPP
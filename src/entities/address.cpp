@@ -125,27 +125,44 @@ Address Address::fromVbkEncoding(ReadStream& stream) {
           "nor multisig");
   }
 
-  return fromString(address);
+  return Address(address, addressBytes.size());
 }
 
-void Address::toVbkEncoding(WriteStream& stream) const {
-  stream.writeBE<uint8_t>((uint8_t)getType());
-  std::vector<uint8_t> decoded;
-  switch (getType()) {
+static std::vector<uint8_t> decodeAddress(AddressType type,
+                                          const std::string& address) {
+  switch (type) {
     case AddressType::STANDARD:
-      decoded = DecodeBase58(toString());
-      break;
-    case AddressType ::MULTISIG:
-      decoded = DecodeBase59(toString());
-      break;
+      return DecodeBase58(address);
+    case AddressType::MULTISIG:
+      return DecodeBase59(address);
     default:
-      // if we don't know address type, do not encode anything
-      return;
+      return {};
+  }
+}
+
+void Address::toVbkEncoding(WriteStream& stream) const {
+  stream.writeBE<uint8_t>((uint8_t)getType());
+  if (getType() != AddressType::STANDARD &&
+      getType() != AddressType::MULTISIG) {
+    // if we don't know address type, do not encode anything
+    return;
   }
 
+  auto decoded = decodeAddress(getType(), toString());
   writeSingleByteLenValue(stream, decoded);
 }
 
+size_t Address::serializedSize() const {
+  if (getType() != AddressType::STANDARD &&
+      getType() != AddressType::MULTISIG) {
+    return 1;
+  }
+  if (m_DecodedSize == 0) {
+    m_DecodedSize = decodeAddress(getType(), toString()).size();
+  }
+  return 1 + singleByteLenValueSize(m_DecodedSize);
+}
+
 void Address::getPopBytes(WriteStream& stream) const {
   std::vector<uint8_t> bytes = DecodeBase58(m_Address.substr(1));
   stream.write(std::vector<uint8_t>(bytes.begin(), bytes.begin() + 16));
@@ -213,6 +230,11 @@ Address::Address(const std::string& input) {
   m_Address = input;
 }
 
+Address::Address(const std::string& input, size_t decodedSize)
+    : Address(input) {
+  m_DecodedSize = decodedSize;
+}
+
 bool Address::operator==(const Address& other) const noexcept {
 	return m_Address == other.m_Address;
 }
@@ -252,7 +274,7 @@ bool Deserialize(ReadStream& stream,
 
   Address address;
   try {
-    address = Address::fromString(addressText);
+    address = Address(addressText, addressBytes.size());
   } catch (std::invalid_argument&) {
     return state.Invalid("invalid-address");
   }
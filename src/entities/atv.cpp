@@ -43,6 +43,13 @@ void ATV::toVbkEncoding(WriteStream& stream) const {
   }
 }
 
+size_t ATV::serializedSize() const {
+  VBK_ASSERT_MSG(
+      version == 1, "ATV serialization version=%d is not implemented", version);
+  return sizeof(version) + transaction.serializedSize() +
+         merklePath.serializedSize() + blockOfProof.serializedSize();
+}
+
 std::vector<uint8_t> ATV::toVbkEncoding() const {
   WriteStream stream;
   toVbkEncoding(stream);
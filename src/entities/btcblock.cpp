@@ -46,6 +46,10 @@ void BtcBlock::toVbkEncoding(WriteStream& stream) const {
   writeSingleByteLenValue(stream, blockStream.data());
 }
 
+size_t BtcBlock::serializedSize() const {
+  return singleByteLenValueSize(BTC_HEADER_SIZE);
+}
+
 uint32_t BtcBlock::getDifficulty() const { return bits; }
 
 uint32_t BtcBlock::getBlockTime() const { return timestamp; }
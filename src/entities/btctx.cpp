@@ -15,6 +15,8 @@ void BtcTx::toVbkEncoding(WriteStream& stream) const {
   writeVarLenValue(stream, tx);
 }
 
+size_t BtcTx::serializedSize() const { return varLenValueSize(tx.size()); }
+
 uint256 BtcTx::getHash() const { return sha256twice(tx); }
 
 std::string BtcTx::toHex() const {
@@ -0,0 +1,104 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veriblock/entities/compact_popdata.hpp>
+
+#include "veriblock/hashutil.hpp"
+
+namespace altintegration {
+
+namespace {
+
+template <typename Pop>
+void writePayloads(WriteStream& stream,
+                   const CompactPopData::Payloads<Pop>& payloads) {
+  writeCompactArrayOf(stream, payloads.shortIds);
+  writeVarInt(stream, payloads.prefilled.size());
+  for (const auto& p : payloads.prefilled) {
+    writeVarInt(stream, p.first);
+    p.second.toVbkEncoding(stream);
+  }
+}
+
+template <typename Pop>
+void readPayloads(ReadStream& stream,
+                  size_t max,
+                  CompactPopData::Payloads<Pop>& out) {
+  out.shortIds = readCompactArrayOf<CompactPopData::short_id_t>(stream);
+  const auto prefilled = readVarInt(stream);
+  if (out.shortIds.size() > max || prefilled > max - out.shortIds.size()) {
+    throw std::domain_error(
+        fmt::format("CompactPopData: too many {}", Pop::name()));
+  }
+
+  const size_t size = out.shortIds.size() + (size_t)prefilled;
+  out.prefilled.reserve((size_t)prefilled);
+  for (uint64_t i = 0; i < prefilled; i++) {
+    const auto index = readVarInt(stream);
+    // indexes are sorted, so every payload has unique position
+    if (index >= size ||
+        (!out.prefilled.empty() && index <= out.prefilled.back().first)) {
+      throw std::domain_error(fmt::format(
+          "CompactPopData: bad index {} of prefilled {}", index, Pop::name()));
+    }
+    out.prefilled.emplace_back((uint32_t)index, Pop::fromVbkEncoding(stream));
+  }
+}
+
+}  // namespace
+
+CompactPopData::short_id_t CompactPopData::shortId(uint64_t salt,
+                                                   Slice<const uint8_t> id) {
+  WriteStream stream(sizeof(salt));
+  stream.writeBE<uint64_t>(salt);
+  return sha256(stream.data(), id).trim<short_id_t::size()>();
+}
+
+CompactPopData CompactPopData::fromVbkEncoding(ReadStream& stream) {
+  CompactPopData c;
+  c.version = stream.readBE<uint32_t>();
+  if (c.version != 1) {
+    throw std::domain_error(fmt::format(
+        "CompactPopData deserialization version={} is not implemented",
+        c.version));
+  }
+
+  c.salt = stream.readBE<uint64_t>();
+  readPayloads(stream, MAX_CONTEXT_COUNT, c.context);
+  readPayloads(stream, MAX_CONTEXT_COUNT_ALT_PUBLICATION, c.atvs);
+  readPayloads(stream, MAX_CONTEXT_COUNT_VBK_PUBLICATION, c.vtbs);
+  return c;
+}
+
+void CompactPopData::toVbkEncoding(WriteStream& stream) const {
+  VBK_ASSERT_MSG(version == 1,
+                 "CompactPopData serialization version=%d is not implemented",
+                 version);
+  stream.writeBE<uint32_t>(version);
+  stream.writeBE<uint64_t>(salt);
+  // same order as in PopData
+  writePayloads(stream, context);
+  writePayloads(stream, atvs);
+  writePayloads(stream, vtbs);
+}
+
+std::vector<uint8_t> CompactPopData::toVbkEncoding() const {
+  WriteStream stream;
+  toVbkEncoding(stream);
+  return stream.data();
+}
+
+bool Deserialize(ReadStream& stream,
+                 CompactPopData& out,
+                 ValidationState& state) {
+  try {
+    out = CompactPopData::fromVbkEncoding(stream);
+  } catch (const std::exception& e) {
+    return state.Invalid("compact-pop-bad-encoding", e.what());
+  }
+  return true;
+}
+
+}  // namespace altintegration
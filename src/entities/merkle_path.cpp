@@ -60,6 +60,17 @@ void MerklePath::toVbkEncoding(WriteStream& stream) const {
   writeVarLenValue(stream, pathStream.data());
 }
 
+size_t MerklePath::rawSize() const {
+  // index, number of layers, size of subject size, subject size
+  size_t size = 3 * singleFixedBEValueSize<int32_t>() + sizeof(int32_t);
+  for (const auto& layer : layers) {
+    size += singleByteLenValueSize(layer.size());
+  }
+  return size;
+}
+
+size_t MerklePath::serializedSize() const { return varLenValueSize(rawSize()); }
+
 uint256 MerklePath::calculateMerkleRoot() const {
   if (layers.empty()) {
     return subject;
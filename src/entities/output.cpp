@@ -22,6 +22,10 @@ void Output::toVbkEncoding(WriteStream& stream) const {
   coin.toVbkEncoding(stream);
 }
 
+size_t Output::serializedSize() const {
+  return address.serializedSize() + coin.serializedSize();
+}
+
 std::string Output::toPrettyString() const {
   return fmt::sprintf(
       "Output{address=%s, coin=%lld}", address.toString(), coin.units);
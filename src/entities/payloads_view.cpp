@@ -0,0 +1,344 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "veriblock/entities/payloads_view.hpp"
+
+#include "veriblock/hashutil.hpp"
+
+namespace altintegration {
+
+namespace {
+
+bool skipAddress(ReadStream& stream, ValidationState& state) {
+  uint8_t addressType = 0;
+  if (!stream.readLE<uint8_t>(addressType, state)) {
+    return state.Invalid("address-type");
+  }
+  Slice<const uint8_t> addressBytes;
+  if (!readSingleByteLenValue(stream, addressBytes, state, 0, ADDRESS_SIZE)) {
+    return state.Invalid("address-bytes");
+  }
+  return true;
+}
+
+bool skipCoin(ReadStream& stream, ValidationState& state) {
+  int64_t amount = 0;
+  if (!readSingleBEValue<int64_t>(stream, amount, state)) {
+    return state.Invalid("invalid-amount");
+  }
+  return true;
+}
+
+//! reads VBK-encoded VbkMerklePath and returns its bytes in `out`
+bool readVbkMerklePath(ReadStream& stream,
+                       Slice<const uint8_t>& out,
+                       ValidationState& state) {
+  const size_t begin = stream.position();
+  int32_t treeIndex = 0;
+  if (!readSingleBEValue<int32_t>(stream, treeIndex, state)) {
+    return state.Invalid("vbkmerkle-tree-index");
+  }
+  int32_t index = 0;
+  if (!readSingleBEValue<int32_t>(stream, index, state)) {
+    return state.Invalid("vbkmerkle-index");
+  }
+  Slice<const uint8_t> hash;
+  if (!readSingleByteLenValue(
+          stream, hash, state, SHA256_HASH_SIZE, SHA256_HASH_SIZE)) {
+    return state.Invalid("vbkmerkle-subject");
+  }
+  int32_t count = 0;
+  if (!readSingleBEValue<int32_t>(stream, count, state)) {
+    return state.Invalid("vbkmerkle-layers-count");
+  }
+  if (!checkRange(count, 0, MAX_LAYER_COUNT_MERKLE, state)) {
+    return state.Invalid("vbkmerkle-layers-count-range");
+  }
+  for (int32_t i = 0; i < count; i++) {
+    if (!readSingleByteLenValue(
+            stream, hash, state, SHA256_HASH_SIZE, SHA256_HASH_SIZE)) {
+      return state.Invalid("vbkmerkle-layer", i);
+    }
+  }
+  out = Slice<const uint8_t>(stream.data().data() + begin,
+                             stream.position() - begin);
+  return true;
+}
+
+}  // namespace
+
+VbkPopTxView::hash_t VbkPopTxView::getHash() const { return sha256(raw); }
+
+BtcBlock::hash_t VbkPopTxView::getBtcTxHash() const {
+  return sha256twice(bitcoinTransaction);
+}
+
+BtcBlock::hash_t VbkPopTxView::getBlockOfProofHash() const {
+  return sha256twice(blockOfProof).reverse();
+}
+
+VbkBlock::hash_t VbkPopTxView::getPublishedBlockHash() const {
+  return vblake(publishedBlock);
+}
+
+Slice<const uint8_t> VbkPopTxView::getBlockOfProofContextRaw(size_t i) const {
+  VBK_ASSERT(i < blockOfProofContextSize);
+  // every context block is encoded as [1 byte len | BTC_HEADER_SIZE bytes]
+  const size_t offset = i * (BTC_HEADER_SIZE + 1) + 1;
+  return {blockOfProofContext.data() + offset, BTC_HEADER_SIZE};
+}
+
+bool VbkPopTxView::getPublishedBlock(VbkBlock& out,
+                                     ValidationState& state) const {
+  return DeserializeRaw(publishedBlock, out, state);
+}
+
+bool VbkPopTxView::getBlockOfProof(BtcBlock& out,
+                                   ValidationState& state) const {
+  return DeserializeRaw(blockOfProof, out, state);
+}
+
+bool VbkPopTxView::getBlockOfProofContext(std::vector<BtcBlock>& out,
+                                          ValidationState& state) const {
+  std::vector<BtcBlock> ret(blockOfProofContextSize);
+  for (size_t i = 0; i < blockOfProofContextSize; i++) {
+    if (!DeserializeRaw(getBlockOfProofContextRaw(i), ret[i], state)) {
+      return state.Invalid("vbkpoptx-btc-context", i);
+    }
+  }
+  out = std::move(ret);
+  return true;
+}
+
+bool VbkPopTxView::materialize(VbkPopTx& out, ValidationState& state) const {
+  return DeserializeRaw(raw, signature, publicKey, out, state);
+}
+
+ATVView::id_t ATVView::getId() const {
+  auto left = sha256(transaction);
+  auto right = getBlockOfProofHash();
+  return sha256(left, right);
+}
+
+VbkBlock::hash_t ATVView::getBlockOfProofHash() const {
+  return vblake(blockOfProof);
+}
+
+bool ATVView::getBlockOfProof(VbkBlock& out, ValidationState& state) const {
+  return DeserializeRaw(blockOfProof, out, state);
+}
+
+bool ATVView::getPublicationData(PublicationData& out,
+                                 ValidationState& state) const {
+  return Deserialize(publicationData, out, state);
+}
+
+bool ATVView::materialize(ATV& out, ValidationState& state) const {
+  ATV atv{};
+  atv.version = version;
+  if (!DeserializeRaw(
+          transaction, signature, publicKey, atv.transaction, state)) {
+    return state.Invalid("atv-transaction");
+  }
+  if (!Deserialize(merklePath, atv.merklePath, state)) {
+    return state.Invalid("atv-merkle-path");
+  }
+  if (!getBlockOfProof(atv.blockOfProof, state)) {
+    return state.Invalid("atv-containing-block");
+  }
+  out = std::move(atv);
+  return true;
+}
+
+VTBView::id_t VTBView::getId() const {
+  auto btcTx = transaction.getBtcTxHash();
+  auto blockOfProof = transaction.getBlockOfProofHash();
+  auto containingVbkBlock = uint256(getContainingBlockHash());
+  auto temp = sha256(blockOfProof, containingVbkBlock);
+  return sha256(btcTx, temp);
+}
+
+VbkBlock::hash_t VTBView::getContainingBlockHash() const {
+  return vblake(containingBlock);
+}
+
+bool VTBView::getContainingBlock(VbkBlock& out, ValidationState& state) const {
+  return DeserializeRaw(containingBlock, out, state);
+}
+
+bool VTBView::materialize(VTB& out, ValidationState& state) const {
+  VTB vtb{};
+  vtb.version = version;
+  if (!transaction.materialize(vtb.transaction, state)) {
+    return state.Invalid("vtb-transaction");
+  }
+  if (!Deserialize(merklePath, vtb.merklePath, state)) {
+    return state.Invalid("vtb-merkle-path");
+  }
+  if (!getContainingBlock(vtb.containingBlock, state)) {
+    return state.Invalid("vtb-containing-block");
+  }
+  out = std::move(vtb);
+  return true;
+}
+
+bool Deserialize(ReadStream& stream,
+                 VbkPopTxView& out,
+                 ValidationState& state) {
+  VbkPopTxView tx{};
+  if (!readVarLenValue(stream, tx.raw, state, 0, MAX_RAWTX_SIZE_VBKPOPTX)) {
+    return state.Invalid("vbkpoptx-invalid-tx");
+  }
+  if (!readSingleByteLenValue(
+          stream, tx.signature, state, 0, MAX_SIGNATURE_SIZE)) {
+    return state.Invalid("vbkpoptx-invalid-signature");
+  }
+  if (!readSingleByteLenValue(
+          stream, tx.publicKey, state, 0, PUBLIC_KEY_SIZE)) {
+    return state.Invalid("vbkpoptx-invalid-public-key");
+  }
+
+  ReadStream raw(tx.raw);
+  NetworkBytePair networkOrType;
+  if (!readNetworkByte(raw, TxType::VBK_POP_TX, networkOrType, state)) {
+    return state.Invalid("vbkpoptx-network-or-type");
+  }
+  if (!skipAddress(raw, state)) {
+    return state.Invalid("vbkpoptx-address");
+  }
+  if (!readSingleByteLenValue(raw,
+                              tx.publishedBlock,
+                              state,
+                              VBK_HEADER_SIZE,
+                              VBK_HEADER_SIZE)) {
+    return state.Invalid("vbkpoptx-published-block");
+  }
+  if (!readVarLenValue(
+          raw, tx.bitcoinTransaction, state, 0, BTC_TX_MAX_RAW_SIZE)) {
+    return state.Invalid("vbkpoptx-bitcoin-tx");
+  }
+  if (!readVarLenValue(raw, tx.merklePath, state, 0, MAX_MERKLE_BYTES)) {
+    return state.Invalid("vbkpoptx-merkle-path");
+  }
+  if (!readSingleByteLenValue(
+          raw, tx.blockOfProof, state, BTC_HEADER_SIZE, BTC_HEADER_SIZE)) {
+    return state.Invalid("vbkpoptx-block-of-proof");
+  }
+
+  int32_t count = 0;
+  if (!readSingleBEValue<int32_t>(raw, count, state)) {
+    return state.Invalid("vbkpoptx-btc-context-count");
+  }
+  if (!checkRange(count, 0, MAX_CONTEXT_COUNT, state)) {
+    return state.Invalid("vbkpoptx-btc-context-range");
+  }
+  const size_t begin = raw.position();
+  for (int32_t i = 0; i < count; i++) {
+    Slice<const uint8_t> header;
+    if (!readSingleByteLenValue(
+            raw, header, state, BTC_HEADER_SIZE, BTC_HEADER_SIZE)) {
+      return state.Invalid("vbkpoptx-btc-context", i);
+    }
+  }
+  tx.blockOfProofContext =
+      Slice<const uint8_t>(tx.raw.data() + begin, raw.position() - begin);
+  tx.blockOfProofContextSize = (size_t)count;
+
+  out = tx;
+  return true;
+}
+
+bool Deserialize(ReadStream& stream, ATVView& out, ValidationState& state) {
+  ATVView atv{};
+  if (!stream.readBE<uint32_t>(atv.version, state)) {
+    return state.Invalid("atv-version");
+  }
+  if (atv.version != 1) {
+    return state.Invalid("atv-bad-version");
+  }
+
+  if (!readVarLenValue(
+          stream, atv.transaction, state, 0, MAX_RAWTX_SIZE_VBKTX)) {
+    return state.Invalid("vbktx-header");
+  }
+  if (!readSingleByteLenValue(
+          stream, atv.signature, state, 0, MAX_SIGNATURE_SIZE)) {
+    return state.Invalid("vbktx-signature");
+  }
+  if (!readSingleByteLenValue(
+          stream, atv.publicKey, state, 0, PUBLIC_KEY_SIZE)) {
+    return state.Invalid("vbktx-public-key");
+  }
+
+  // walk over raw VbkTx to find publication data
+  ReadStream raw(atv.transaction);
+  NetworkBytePair networkOrType;
+  if (!readNetworkByte(raw, TxType::VBK_TX, networkOrType, state)) {
+    return state.Invalid("vbktx-network-or-type");
+  }
+  if (!skipAddress(raw, state)) {
+    return state.Invalid("vbktx-address");
+  }
+  if (!skipCoin(raw, state)) {
+    return state.Invalid("vbktx-amount");
+  }
+  uint8_t outputSize = 0;
+  if (!raw.readBE<uint8_t>(outputSize, state)) {
+    return state.Invalid("vbktx-outputs-size");
+  }
+  for (size_t i = 0; i < outputSize; i++) {
+    if (!skipAddress(raw, state) || !skipCoin(raw, state)) {
+      return state.Invalid("vbktx-output", i);
+    }
+  }
+  int64_t signatureIndex = 0;
+  if (!readSingleBEValue<int64_t>(raw, signatureIndex, state)) {
+    return state.Invalid("vbktx-signature-index");
+  }
+  if (!readVarLenValue(
+          raw, atv.publicationData, state, 0, MAX_SIZE_PUBLICATION_DATA)) {
+    return state.Invalid("vbktx-publication-bytes");
+  }
+
+  if (!readVbkMerklePath(stream, atv.merklePath, state)) {
+    return state.Invalid("atv-merkle-path");
+  }
+  if (!readSingleByteLenValue(
+          stream, atv.blockOfProof, state, VBK_HEADER_SIZE, VBK_HEADER_SIZE)) {
+    return state.Invalid("atv-containing-block");
+  }
+
+  out = atv;
+  return true;
+}
+
+bool Deserialize(ReadStream& stream, VTBView& out, ValidationState& state) {
+  VTBView vtb{};
+  if (!stream.readBE<uint32_t>(vtb.version, state)) {
+    return state.Invalid("vtb-version");
+  }
+  if (vtb.version != 1) {
+    return state.Invalid("vtb-bad-version");
+  }
+
+  if (!Deserialize(stream, vtb.transaction, state)) {
+    return state.Invalid("vtb-transaction");
+  }
+  if (!readVbkMerklePath(stream, vtb.merklePath, state)) {
+    return state.Invalid("vtb-merkle-path");
+  }
+  if (!readSingleByteLenValue(stream,
+                              vtb.containingBlock,
+                              state,
+                              VBK_HEADER_SIZE,
+                              VBK_HEADER_SIZE)) {
+    return state.Invalid("vtb-containing-block");
+  }
+
+  out = vtb;
+  return true;
+}
+
+}  // namespace altintegration
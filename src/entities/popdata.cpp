@@ -63,6 +63,25 @@ void PopData::toVbkEncoding(WriteStream& stream) const {
   }
 }
 
+size_t PopData::serializedSize() const {
+  VBK_ASSERT_MSG(version == 1,
+                 "PopData serialization version=%d is not implemented",
+                 version);
+  size_t size = sizeof(version) + singleBEValueSize((int64_t)context.size()) +
+                singleBEValueSize((int64_t)atvs.size()) +
+                singleBEValueSize((int64_t)vtbs.size());
+  for (const auto& b : context) {
+    size += b.serializedSize();
+  }
+  for (const auto& atv : atvs) {
+    size += atv.serializedSize();
+  }
+  for (const auto& vtb : vtbs) {
+    size += vtb.serializedSize();
+  }
+  return size;
+}
+
 std::vector<uint8_t> PopData::toVbkEncoding() const {
   WriteStream stream;
   toVbkEncoding(stream);
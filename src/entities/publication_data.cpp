@@ -31,6 +31,12 @@ void PublicationData::toRaw(WriteStream& stream) const {
   writeVarLenValue(stream, payoutInfo);
 }
 
+size_t PublicationData::rawSize() const {
+  return singleBEValueSize(identifier) + varLenValueSize(header.size()) +
+         varLenValueSize(contextInfo.size()) +
+         varLenValueSize(payoutInfo.size());
+}
+
 bool altintegration::Deserialize(ReadStream& stream,
                                  PublicationData& out,
                                  ValidationState& state) {
@@ -35,6 +35,16 @@ void VbkMerklePath::toVbkEncoding(WriteStream& stream) const {
   }
 }
 
+size_t VbkMerklePath::serializedSize() const {
+  // tree index, index, subject, number of layers
+  size_t size = 3 * singleFixedBEValueSize<int32_t>() +
+                singleByteLenValueSize(subject.size());
+  for (const auto& layer : layers) {
+    size += singleByteLenValueSize(layer.size());
+  }
+  return size;
+}
+
 uint128 VbkMerklePath::calculateMerkleRoot() const {
   if (layers.empty()) {
     return subject.trim<VBK_MERKLE_ROOT_HASH_SIZE>();
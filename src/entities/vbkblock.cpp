@@ -47,6 +47,10 @@ void VbkBlock::toVbkEncoding(WriteStream& stream) const {
   writeSingleByteLenValue(stream, blockStream.data());
 }
 
+size_t VbkBlock::serializedSize() const {
+  return singleByteLenValueSize(VBK_HEADER_SIZE);
+}
+
 std::vector<uint8_t> VbkBlock::toVbkEncoding() const {
   WriteStream stream;
   toVbkEncoding(stream);
@@ -58,7 +62,7 @@ uint32_t VbkBlock::getDifficulty() const { return difficulty; }
 uint32_t VbkBlock::getBlockTime() const { return timestamp; }
 
 VbkBlock::hash_t VbkBlock::getHash() const {
-  WriteStream stream;
+  WriteStream stream(VBK_HEADER_SIZE);
   toRaw(stream);
   return vblake(stream.data());
 }
@@ -58,6 +58,23 @@ void VbkPopTx::toVbkEncoding(WriteStream& stream) const {
   writeSingleByteLenValue(stream, publicKey);
 }
 
+size_t VbkPopTx::rawSize() const {
+  size_t size = networkByteSize(networkOrType) + address.serializedSize() +
+                publishedBlock.serializedSize() +
+                bitcoinTransaction.serializedSize() +
+                merklePath.serializedSize() + blockOfProof.serializedSize() +
+                singleBEValueSize((int64_t)blockOfProofContext.size());
+  for (const auto& block : blockOfProofContext) {
+    size += block.serializedSize();
+  }
+  return size;
+}
+
+size_t VbkPopTx::serializedSize() const {
+  return varLenValueSize(rawSize()) + singleByteLenValueSize(signature.size()) +
+         singleByteLenValueSize(publicKey.size());
+}
+
 uint256 VbkPopTx::getHash() const {
   WriteStream stream;
   toRaw(stream);
@@ -63,6 +63,22 @@ void VbkTx::toVbkEncoding(WriteStream& stream) const {
   writeSingleByteLenValue(stream, publicKey);
 }
 
+size_t VbkTx::rawSize() const {
+  size_t size = networkByteSize(networkOrType) +
+                sourceAddress.serializedSize() +
+                sourceAmount.serializedSize() + sizeof(uint8_t);
+  for (const auto& output : outputs) {
+    size += output.serializedSize();
+  }
+  return size + singleBEValueSize(signatureIndex) +
+         varLenValueSize(publicationData.rawSize());
+}
+
+size_t VbkTx::serializedSize() const {
+  return varLenValueSize(rawSize()) + singleByteLenValueSize(signature.size()) +
+         singleByteLenValueSize(publicKey.size());
+}
+
 uint256 VbkTx::getHash() const {
   WriteStream stream;
   toRaw(stream);
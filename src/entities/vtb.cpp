@@ -48,6 +48,13 @@ void VTB::toVbkEncoding(WriteStream& stream) const {
   }
 }
 
+size_t VTB::serializedSize() const {
+  VBK_ASSERT_MSG(
+      version == 1, "VTB serialization version=%d is not implemented", version);
+  return sizeof(version) + transaction.serializedSize() +
+         merklePath.serializedSize() + containingBlock.serializedSize();
+}
+
 std::vector<uint8_t> VTB::toVbkEncoding() const {
   WriteStream stream;
   toVbkEncoding(stream);
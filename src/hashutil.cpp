@@ -5,6 +5,10 @@
 
 #include "veriblock/hashutil.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "veriblock/assert.hpp"
 
 namespace altintegration {
@@ -38,6 +42,76 @@ uint256 sha256(Slice<const uint8_t> a, Slice<const uint8_t> b) {
   return ret;
 }
 
+uint256 hmacSha256(Slice<const uint8_t> key, Slice<const uint8_t> message) {
+  const size_t blockSize = 64;
+  uint8_t pad[blockSize] = {};
+  if (key.size() > blockSize) {
+    auto hashed = sha256(key);
+    std::copy(hashed.begin(), hashed.end(), pad);
+  } else {
+    std::copy(key.begin(), key.end(), pad);
+  }
+
+  for (auto& b : pad) {
+    b ^= 0x36;
+  }
+  auto inner = sha256(Slice<const uint8_t>(pad, blockSize), message);
+
+  for (auto& b : pad) {
+    b ^= 0x36 ^ 0x5c;
+  }
+  return sha256(Slice<const uint8_t>(pad, blockSize), inner);
+}
+
+namespace {
+
+// hashes `inputs` into `out`, which holds inputs.size() hashes
+void sha256Batch(Slice<const Slice<const uint8_t>> inputs, uint8_t* out) {
+  if (inputs.size() == 0) {
+    return;
+  }
+
+  const size_t size = inputs[0].size();
+  VBK_ASSERT(size <= (std::numeric_limits<uint32_t>::max)());
+  std::vector<const uint8_t*> in(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    VBK_ASSERT_MSG(inputs[i].size() == size,
+                   "batch inputs must have the same size");
+    in[i] = inputs[i].data();
+  }
+
+  sha256_batch(out, in.data(), in.size(), (uint32_t)size);
+}
+
+}  // namespace
+
+void sha256Batch(Slice<const Slice<const uint8_t>> inputs,
+                 Slice<uint256> outputs) {
+  VBK_ASSERT(inputs.size() == outputs.size());
+  // outputs may overlap inputs
+  std::vector<uint8_t> hashes(inputs.size() * SHA256_HASH_SIZE);
+  sha256Batch(inputs, hashes.data());
+  for (size_t i = 0; i < outputs.size(); i++) {
+    outputs[i] = Slice<const uint8_t>(hashes.data() + i * SHA256_HASH_SIZE,
+                                      SHA256_HASH_SIZE);
+  }
+}
+
+void sha256twiceBatch(Slice<const Slice<const uint8_t>> inputs,
+                      Slice<uint256> outputs) {
+  VBK_ASSERT(inputs.size() == outputs.size());
+  std::vector<uint8_t> firstShot(inputs.size() * SHA256_HASH_SIZE);
+  sha256Batch(inputs, firstShot.data());
+
+  std::vector<Slice<const uint8_t>> hashes;
+  hashes.reserve(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    hashes.emplace_back(firstShot.data() + i * SHA256_HASH_SIZE,
+                        SHA256_HASH_SIZE);
+  }
+  sha256Batch(hashes, outputs);
+}
+
 uint192 vblake(Slice<const uint8_t> data) {
   VBK_ASSERT(data.size() <= (std::numeric_limits<uint32_t>::max)());
   uint192 hash{};
@@ -45,4 +119,29 @@ uint192 vblake(Slice<const uint8_t> data) {
   return hash;
 }
 
+void vblakeBatch(Slice<const Slice<const uint8_t>> inputs,
+                 Slice<uint192> outputs) {
+  VBK_ASSERT(inputs.size() == outputs.size());
+  if (inputs.size() == 0) {
+    return;
+  }
+
+  const size_t size = inputs[0].size();
+  std::vector<const uint8_t*> in(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    VBK_ASSERT_MSG(inputs[i].size() == size,
+                   "batch inputs must have the same size");
+    in[i] = inputs[i].data();
+  }
+
+  // outputs may overlap inputs
+  std::vector<uint8_t> hashes(inputs.size() * VBLAKE_HASH_SIZE);
+  const int ret = vblake_batch(hashes.data(), in.data(), in.size(), size);
+  VBK_ASSERT_MSG(ret == 0, "vblake input must not exceed 64 bytes");
+  for (size_t i = 0; i < outputs.size(); i++) {
+    outputs[i] = Slice<const uint8_t>(hashes.data() + i * VBLAKE_HASH_SIZE,
+                                      VBLAKE_HASH_SIZE);
+  }
+}
+
 }  // namespace altintegration
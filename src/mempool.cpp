@@ -6,111 +6,454 @@
 #include <deque>
 #include <veriblock/reversed_range.hpp>
 
+#include "veriblock/algorithm.hpp"
+#include "veriblock/hashutil.hpp"
 #include "veriblock/mempool.hpp"
 #include "veriblock/stateless_validation.hpp"
+#include "veriblock/time.hpp"
 
 namespace altintegration {
 
 namespace {
 
-template <typename pop_t>
-bool process_cut_payloads(std::vector<pop_t>& payloads, size_t& current_size) {
-  if (!payloads.empty()) {
-    auto& p = payloads.back();
-    current_size -= p.toVbkEncoding().size();
-    payloads.pop_back();
-    return true;
+const uint32_t kMempoolSnapshotMagic = 0x56424d50;  // "VBMP"
+const uint32_t kMempoolSnapshotVersion = 1;
+
+}  // namespace
+
+PopData MemPool::getPop() {
+  if (!hasTemplate_ || !(templateState_ == getTreeState())) {
+    rebuildTemplate();
+  } else if (!addedBlocks_.empty() || !addedVtbs_.empty() ||
+             !addedAtvs_.empty()) {
+    if (templateTree_ != nullptr && selector_->isIncremental()) {
+      extendTemplate();
+    } else {
+      rebuildTemplate();
+    }
   }
 
-  return false;
+  return template_;
 }
 
-size_t cutPopData(PopData& popData, size_t current_size) {
-  // first remove vtb
-  if (process_cut_payloads(popData.vtbs, current_size)) {
-    return current_size;
+MemPool::TreeState MemPool::getTreeState() const {
+  TreeState state;
+  auto* alt = tree_->getBestChain().tip();
+  if (alt != nullptr) {
+    state.alt = alt->getHash();
   }
-  // second remove atv
-  if (process_cut_payloads(popData.atvs, current_size)) {
-    return current_size;
+  auto* vbk = tree_->vbk().getBestChain().tip();
+  if (vbk != nullptr) {
+    state.vbk = vbk->getHash();
   }
-  // third remove vbk blocks
-  if (process_cut_payloads(popData.context, current_size)) {
-    return current_size;
+  auto* btc = tree_->btc().getBestChain().tip();
+  if (btc != nullptr) {
+    state.btc = btc->getHash();
   }
+  // blocks may be removed from trees without changing their tips
+  state.blocks = tree_->getBlocks().size() + tree_->vbk().getBlocks().size() +
+                 tree_->btc().getBlocks().size();
+  return state;
+}
 
-  return current_size;
+void MemPool::invalidateTemplate() {
+  template_ = PopData();
+  templateSize_ = 0;
+  templateTree_.reset();
+  hasTemplate_ = false;
+  addedBlocks_.clear();
+  addedVtbs_.clear();
+  addedAtvs_.clear();
 }
 
-PopData generatePopData(
-    const std::vector<
-        std::pair<VbkBlock::id_t,
-                  std::shared_ptr<VbkPayloadsRelations>>>& blocks,
-    const AltChainParams& params) {
-  PopData ret;
-  // size in bytes of pop data added to
-  size_t popSize = 0;
+void MemPool::rebuildTemplate() {
+  invalidateTemplate();
 
-  for (const auto& block : blocks) {
-    PopData pop = block.second->toPopData();
-    size_t estimated = pop.estimateSize();
+  PopData ret = selector_->select(relationsIndex_, *tree_);
+  // cheap pass on overlays drops most invalid payloads, so that canonical
+  // check, which is authoritative, rarely has to undo them
+  std::unique_ptr<MemPoolBlockTree> temp(new MemPoolBlockTree(*tree_));
+  temp->filterInvalidPayloads(ret);
+  size_t speculative = ret.context.size() + ret.vtbs.size() + ret.atvs.size();
+  tree_->filterInvalidPayloads(ret);
+  if (ret.context.size() + ret.vtbs.size() + ret.atvs.size() != speculative) {
+    // overlays do not model VBK fork resolution and contain payloads which are
+    // not in template, so template can not be extended on top of them
+    temp.reset();
+  }
 
-    while (popSize + estimated > params.getMaxPopDataSize() && !pop.empty()) {
-      estimated = cutPopData(pop, estimated);
+  template_ = std::move(ret);
+  templateSize_ = template_.estimateSize();
+  templateTree_ = std::move(temp);
+  templateState_ = getTreeState();
+  hasTemplate_ = true;
+}
+
+void MemPool::extendTemplate() {
+  const size_t maxSize = tree_->getParams().getMaxPopDataSize();
+  const size_t templateSize = templateSize_;
+  ValidationState state;
+
+  // same order in which payloads are applied
+  for (const auto& block : addedBlocks_) {
+    extendTemplateContext(*block);
+  }
+
+  for (const auto& vtb : addedVtbs_) {
+    if (!extendTemplateContext(vtb->containingBlock)) {
+      continue;
     }
+    auto growth = templateGrowth(template_.vtbs.size(), vtb->serializedSize());
+    if (templateSize_ + growth <= maxSize &&
+        templateTree_->acceptVTB(*vtb, state)) {
+      template_.vtbs.push_back(*vtb);
+      templateSize_ += growth;
+    }
+  }
 
-    if (popSize + estimated > params.getMaxPopDataSize() || pop.empty()) {
+  for (const auto& atv : addedAtvs_) {
+    if (!extendTemplateContext(atv->blockOfProof)) {
       continue;
     }
+    auto growth = templateGrowth(template_.atvs.size(), atv->serializedSize());
+    if (templateSize_ + growth <= maxSize &&
+        templateTree_->acceptATV(*atv, state)) {
+      template_.atvs.push_back(*atv);
+      templateSize_ += growth;
+    }
+  }
 
-    popSize += estimated;
-    ret.mergeFrom(pop);
+  // payloads, which are not appended, wait for next rebuild
+  addedBlocks_.clear();
+  addedVtbs_.clear();
+  addedAtvs_.clear();
 
-    if (popSize > params.getMaxPopDataSize()) {
+  if (templateSize_ == templateSize) {
+    return;
+  }
+
+  // overlays are only a pre-filter, so extended template passes canonical
+  // check as well, or is built from scratch
+  size_t extended =
+      template_.context.size() + template_.vtbs.size() + template_.atvs.size();
+  tree_->filterInvalidPayloads(template_);
+  if (template_.context.size() + template_.vtbs.size() +
+          template_.atvs.size() !=
+      extended) {
+    rebuildTemplate();
+  }
+}
+
+bool MemPool::extendTemplateContext(const VbkBlock& block) {
+  auto& vbk = templateTree_->vbk();
+  std::vector<const VbkBlock*> missing;
+  const VbkBlock* current = &block;
+  while (vbk.getBlockIndex(current->getHash()) == nullptr) {
+    missing.push_back(current);
+    if (vbk.getBlockIndex(current->previousBlock) != nullptr) {
       break;
     }
+    auto it = relations_.find(current->previousBlock);
+    if (it == relations_.end()) {
+      return false;
+    }
+    current = it->second->header.get();
   }
 
-  return ret;
+  const size_t maxSize = tree_->getParams().getMaxPopDataSize();
+  const size_t contextSize = template_.context.size();
+  const size_t templateSize = templateSize_;
+  ValidationState state;
+  for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+    auto growth =
+        templateGrowth(template_.context.size(), (*it)->serializedSize());
+    if (templateSize_ + growth > maxSize ||
+        !templateTree_->acceptVbkBlock(**it, state)) {
+      // ancestors appended above are useless without `block`
+      for (size_t i = template_.context.size(); i > contextSize; i--) {
+        templateTree_->removeVbkBlock(template_.context[i - 1]);
+      }
+      template_.context.erase(template_.context.begin() + contextSize,
+                              template_.context.end());
+      templateSize_ = templateSize;
+      return false;
+    }
+    template_.context.push_back(**it);
+    templateSize_ += growth;
+  }
+  return true;
 }
 
-}  // namespace
+size_t MemPool::templateGrowth(size_t count, size_t size) {
+  return size + singleBEValueSize((int64_t)count + 1) -
+         singleBEValueSize((int64_t)count);
+}
 
-PopData MemPool::getPop() {
-  // sorted array of VBK blocks (ascending order)
-  using P = std::pair<VbkBlock::id_t, std::shared_ptr<VbkPayloadsRelations>>;
-  std::vector<P> blocks(relations_.begin(), relations_.end());
-  std::sort(blocks.begin(), blocks.end(), [](const P& a, const P& b) {
-    return a.second->header->height < b.second->header->height;
-  });
-
-  PopData ret = generatePopData(blocks, tree_->getParams());
-  tree_->filterInvalidPayloads(ret);
-  return ret;
+MemPool::relations_map_t::iterator MemPool::removeRelation(
+    relations_map_t::iterator it) {
+  // cascade removal of relation and stored payloads
+  auto& rel = *it->second;
+  if (!rel.orphan) {
+    // template may contain its payloads
+    invalidateTemplate();
+  }
+  relationsIndex_.erase({rel.header->height, rel.arrival});
+  evictionIndex_.erase(
+      std::make_tuple(rel.evictionClass, rel.header->height, rel.arrival));
+  usage_ -= rel.accountedUsage;
+  if (rel.orphan) {
+    orphans_.erase(rel.arrival);
+    auto range = orphansByPrev_.equal_range(rel.header->previousBlock);
+    for (auto o = range.first; o != range.second; ++o) {
+      if (o->second == &rel) {
+        orphansByPrev_.erase(o);
+        break;
+      }
+    }
+  }
+  vbkblocks_.erase(it->first);
+  for (auto& vtb : rel.vtbs) {
+    stored_vtbs_.erase(vtb->getId());
+  }
+  for (auto& atv : rel.atvs) {
+    stored_atvs_.erase(atv->getId());
+  }
+  return relations_.erase(it);
+}
+
+void MemPool::reindexRelation(VbkPayloadsRelations& rel) {
+  usage_ = usage_ - rel.accountedUsage + rel.memoryUsage();
+  rel.accountedUsage = rel.memoryUsage();
+
+  // orphans are evicted first, then blocks on VBK forks, then blocks without
+  // payloads
+  auto& vbk = tree_->vbk();
+  auto* index = vbk.getBlockIndex(rel.header->getHash());
+  int evictionClass = 3;
+  if (rel.orphan) {
+    evictionClass = 0;
+  } else if (index != nullptr && !vbk.getBestChain().contains(index)) {
+    evictionClass = 1;
+  } else if (rel.empty()) {
+    evictionClass = 2;
+  }
+  if (evictionClass == rel.evictionClass) {
+    return;
+  }
+
+  evictionIndex_.erase(
+      std::make_tuple(rel.evictionClass, rel.header->height, rel.arrival));
+  rel.evictionClass = evictionClass;
+  evictionIndex_.emplace(
+      std::make_tuple(rel.evictionClass, rel.header->height, rel.arrival),
+      &rel);
+}
+
+void MemPool::trimToSize() {
+  while (orphans_.size() > maxOrphans_) {
+    auto* rel = orphans_.begin()->second;
+    VBK_LOG_DEBUG("Evicting orphan %s, too many orphans",
+                  rel->header->toPrettyString());
+    removeRelation(relations_.find(rel->header->getId()));
+  }
+
+  while (usage_ > maxUsage_ && !evictionIndex_.empty()) {
+    auto* rel = evictionIndex_.begin()->second;
+    VBK_LOG_DEBUG("Evicting %s with %d VTBs and %d ATVs, mempool is full",
+                  rel->header->toPrettyString(),
+                  rel->vtbs.size(),
+                  rel->atvs.size());
+    removeRelation(relations_.find(rel->header->getId()));
+  }
+}
+
+void MemPool::setMaxMemoryUsage(size_t bytes) {
+  maxUsage_ = bytes;
+  trimToSize();
+}
+
+void MemPool::setOrphanLimits(size_t maxOrphans, uint32_t expiry) {
+  maxOrphans_ = maxOrphans;
+  orphanExpiry_ = expiry;
+  trimToSize();
+}
+
+bool MemPool::isConnected(const VbkBlock& block) const {
+  auto& vbk = tree_->vbk();
+  if (vbk.getBlockIndex(block.previousBlock) != nullptr ||
+      vbk.getBlockIndex(block.getHash()) != nullptr) {
+    return true;
+  }
+
+  auto it = relations_.find(block.previousBlock);
+  return it != relations_.end() && !it->second->orphan;
+}
+
+void MemPool::connectOrphans(std::vector<vbk_hash_t> arrived) {
+  while (!arrived.empty()) {
+    auto range = orphansByPrev_.equal_range(arrived.back());
+    arrived.pop_back();
+    std::vector<VbkPayloadsRelations*> dependents;
+    for (auto it = range.first; it != range.second; ++it) {
+      dependents.push_back(it->second);
+    }
+    orphansByPrev_.erase(range.first, range.second);
+
+    for (auto* rel : dependents) {
+      orphans_.erase(rel->arrival);
+      rel->orphan = false;
+      relationsIndex_.emplace(std::make_pair(rel->header->height, rel->arrival),
+                              rel);
+
+      // payloads have not been checked against chain they connect to
+      rel->removeVTBsIf([&](const VTB& vtb) {
+        ValidationState state;
+        if (!checkContextually(vtb, state)) {
+          stored_vtbs_.erase(vtb.getId());
+          return true;
+        }
+        return false;
+      });
+      rel->removeATVsIf([&](const ATV& atv) {
+        ValidationState state;
+        if (!checkContextually(atv, state)) {
+          stored_atvs_.erase(atv.getId());
+          return true;
+        }
+        return false;
+      });
+
+      reindexRelation(*rel);
+      if (hasTemplate_) {
+        addedBlocks_.push_back(rel->header);
+        addedVtbs_.insert(
+            addedVtbs_.end(), rel->vtbs.begin(), rel->vtbs.end());
+        addedAtvs_.insert(
+            addedAtvs_.end(), rel->atvs.begin(), rel->atvs.end());
+      }
+      // orphans of this block are connected now
+      arrived.push_back(rel->header->getId());
+    }
+  }
+}
+
+void MemPool::expireOrphans() {
+  auto now = currentTimestamp4();
+  // orphans are ordered by arrival, so oldest ones are in the beginning
+  while (!orphans_.empty()) {
+    auto* rel = orphans_.begin()->second;
+    if (now < rel->orphanTime || now - rel->orphanTime < orphanExpiry_) {
+      break;
+    }
+    removeRelation(relations_.find(rel->header->getId()));
+  }
+}
+
+bool MemPool::cleanupRelation(VbkPayloadsRelations& rel,
+                              const PopData& pop,
+                              const std::set<VbkBlock::id_t>& vbkblockids) {
+  auto* index = tree_->vbk().getBlockIndex(rel.header->getHash());
+  if (index != nullptr) {
+    // VBK tree knows about this VBK block
+    // does it know about stored VTBs?
+    auto& v = index->getPayloadIds<VTB>();
+    std::set<VTB::id_t> ids(v.begin(), v.end());
+    // include vtbs that have just been included into new block
+    std::transform(pop.vtbs.begin(),
+                   pop.vtbs.end(),
+                   std::inserter(ids, std::end(ids)),
+                   get_id<VTB>);
+
+    // mempool contains VBK block, which already exists in VBK tree, and
+    // we found a VTB which exists in that VBK block. we can remove VTB
+    // from mempool
+    rel.removeVTBsIf([&](const VTB& vtb) {
+      auto id = vtb.getId();
+      if (ids.count(id) > 0) {
+        stored_vtbs_.erase(id);
+        return true;
+      }
+      return false;
+    });
+
+    if (rel.empty()) {
+      return true;
+    }
+  }
+
+  // if header is recently added to new block or relation is empty, cleanup
+  return vbkblockids.count(rel.header->getId()) && rel.empty();
+}
+
+void MemPool::notifyAccepted() {
+  if (notifications_ == nullptr || accepted_.empty()) {
+    accepted_ = MemPoolNotificationQueue::Batch();
+    return;
+  }
+
+  MemPoolNotificationQueue::Batch batch;
+  std::swap(batch, accepted_);
+  notifications_->push(std::move(batch));
+}
+
+void MemPool::scheduleExpiry(const ATV& atv) {
+  auto endorsed_hash =
+      tree_->getParams().getHash(atv.transaction.publicationData.header);
+  auto* endorsed_index = tree_->getBlockIndex(endorsed_hash);
+  if (endorsed_index == nullptr) {
+    unresolvedAtvs_.insert(atv.getId());
+    return;
+  }
+
+  // see checkContextually<ATV>: ATV is expired when
+  // tip - endorsed + 1 > window
+  int32_t window = tree_->getParams().getEndorsementSettlementInterval();
+  atvExpiry_.emplace(endorsed_index->getHeight() + window, atv.getId());
+}
+
+bool MemPool::canVacuumIncrementally() const {
+  if (fullVacuum_) {
+    return false;
+  }
+
+  auto* tip = tree_->getBestChain().tip();
+  if (tip == nullptr || tip->pprev == nullptr ||
+      tip->pprev->getHash() != lastAltTip_) {
+    // ALT tip is not a direct successor of the last seen tip
+    return false;
+  }
+
+  auto& vbk = tree_->vbk();
+  auto* vbkTip = vbk.getBestChain().tip();
+  auto* lastVbkTip = vbk.getBlockIndex(lastVbkTip_);
+  // VBK chain may only be extended
+  return vbkTip != nullptr && lastVbkTip != nullptr &&
+         vbkTip->getAncestor(lastVbkTip->getHeight()) == lastVbkTip;
 }
 
 void MemPool::vacuum(const PopData& pop) {
+  invalidateTemplate();
+  expireOrphans();
+  if (canVacuumIncrementally()) {
+    vacuumIncremental(pop);
+  } else {
+    vacuumFull(pop);
+  }
+
+  fullVacuum_ = false;
+  auto* tip = tree_->getBestChain().tip();
+  lastAltTip_ = tip ? tip->getHash() : AltBlock::hash_t{};
+  auto* vbkTip = tree_->vbk().getBestChain().tip();
+  lastVbkTip_ = vbkTip ? vbkTip->getHash() : VbkBlock::hash_t{};
+}
+
+void MemPool::vacuumFull(const PopData& pop) {
   auto vbkblockids = make_idset(pop.context);
   auto vtbids = make_idset(pop.vtbs);
   auto atvids = make_idset(pop.atvs);
 
-  // cascade removal of relation and stored payloads
-  auto removeRelation = [&](decltype(relations_.begin()) it) {
-    auto& rel = *it->second;
-    vbkblocks_.erase(it->first);
-    for (auto& vtb : rel.vtbs) {
-      stored_vtbs_.erase(vtb->getId());
-    }
-    for (auto& atv : rel.atvs) {
-      stored_atvs_.erase(atv->getId());
-    }
-    return relations_.erase(it);
-  };
-
   for (auto it = relations_.begin(); it != relations_.end();) {
-    auto blockHash = it->second->header->getHash();
     auto& vbk = tree_->vbk();
-    auto* index = vbk.getBlockIndex(blockHash);
     auto* tip = vbk.getBestChain().tip();
     auto maxReorgBlocks = vbk.getParams().getMaxReorgBlocks();
     auto& rel = *it->second;
@@ -122,82 +465,201 @@ void MemPool::vacuum(const PopData& pop) {
       continue;
     }
 
+    if (rel.orphan) {
+      // nothing it depends on has changed
+      ++it;
+      continue;
+    }
+
     // cleanup stale VTBs
-    for (auto vtbit = rel.vtbs.begin(); vtbit != rel.vtbs.end();) {
-      auto& vtb = **vtbit;
+    rel.removeVTBsIf([&](const VTB& vtb) {
       ValidationState state;
       auto id = vtb.getId();
       if (vtbids.count(id) > 0 || !checkContextually(vtb, state)) {
         stored_vtbs_.erase(id);
-        vtbit = rel.vtbs.erase(vtbit);
-      } else {
-        ++vtbit;
+        return true;
       }
-    }
+      return false;
+    });
 
     // cleanup stale ATVs
-    for (auto atvit = rel.atvs.begin(); atvit != rel.atvs.end();) {
-      auto& atv = **atvit;
-      auto id = atv.getId();
+    rel.removeATVsIf([&](const ATV& atv) {
       ValidationState state;
+      auto id = atv.getId();
       if (atvids.count(id) > 0 || !checkContextually(atv, state)) {
         stored_atvs_.erase(id);
-        atvit = rel.atvs.erase(atvit);
-      } else {
-        ++atvit;
+        return true;
       }
+      return false;
+    });
+
+    if (cleanupRelation(rel, pop, vbkblockids)) {
+      it = removeRelation(it);
+      continue;
     }
 
-    if (index != nullptr) {
-      // VBK tree knows about this VBK block
-      // does it know about stored VTBs?
-      auto& v = index->getPayloadIds<VTB>();
-      std::set<VTB::id_t> ids(v.begin(), v.end());
-      // include vtbs that have just been included into new block
-      std::transform(pop.vtbs.begin(),
-                     pop.vtbs.end(),
-                     std::inserter(ids, std::end(ids)),
-                     get_id<VTB>);
-
-      for (auto vtbit = rel.vtbs.begin(); vtbit != rel.vtbs.end();) {
-        auto id = (*vtbit)->getId();
-        // mempool contains VBK block, which already exists in VBK tree, and
-        // we found a VTB which exists in that VBK block. we can remove VTB
-        // from mempool
-        vtbit = ids.count(id) ? rel.vtbs.erase(vtbit) : std::next(vtbit);
-      }
+    reindexRelation(rel);
+    ++it;
+  }
 
-      if (rel.empty()) {
-        it = removeRelation(it);
-        continue;
-      }
+  // orphans, which missing blocks have been added to VBK tree
+  std::vector<vbk_hash_t> arrived;
+  for (const auto& p : orphansByPrev_) {
+    if (tree_->vbk().getBlockIndex(p.first) != nullptr) {
+      arrived.push_back(p.first);
     }
+  }
+  connectOrphans(std::move(arrived));
+}
 
-    // if header is recently added to new block or relation is empty, cleanup
-    if (vbkblockids.count(rel.header->getId()) && rel.empty()) {
-      it = removeRelation(it);
+void MemPool::vacuumIncremental(const PopData& pop) {
+  // ALT chain has been extended by one block with `pop` and VBK chain has
+  // been extended by its context, so only payloads included into this block,
+  // payloads which expire at new heights and relations of those payloads and
+  // blocks need to be checked
+  auto vbkblockids = make_idset(pop.context);
+  std::set<VbkBlock::id_t> touched = vbkblockids;
+
+  auto removeVTB = [&](const VTB::id_t& id) {
+    auto it = stored_vtbs_.find(id);
+    if (it == stored_vtbs_.end()) {
+      return;
+    }
+    auto containing = it->second->containingBlock.getId();
+    auto rel = relations_.find(containing);
+    if (rel != relations_.end()) {
+      rel->second->removeVTB(id);
+    }
+    touched.insert(containing);
+    stored_vtbs_.erase(it);
+  };
+
+  auto removeATV = [&](const ATV::id_t& id) {
+    auto it = stored_atvs_.find(id);
+    if (it == stored_atvs_.end()) {
+      return;
+    }
+    auto blockOfProof = it->second->blockOfProof.getId();
+    auto rel = relations_.find(blockOfProof);
+    if (rel != relations_.end()) {
+      rel->second->removeATV(id);
+    }
+    touched.insert(blockOfProof);
+    stored_atvs_.erase(it);
+  };
+
+  // payloads included into new block are duplicates now
+  for (const auto& vtb : pop.vtbs) {
+    removeVTB(vtb.getId());
+  }
+  for (const auto& atv : pop.atvs) {
+    removeATV(atv.getId());
+  }
+
+  // ATVs, which endorsed blocks have become known, get their expiry height
+  std::set<ATV::id_t> unresolved;
+  unresolved.swap(unresolvedAtvs_);
+  for (const auto& id : unresolved) {
+    auto it = stored_atvs_.find(id);
+    if (it != stored_atvs_.end()) {
+      scheduleExpiry(*it->second);
+    }
+  }
+
+  // expire ATVs. Endorsed block may have been removed from the tree since
+  // expiry was scheduled, so ATV is re-checked the same way as full vacuum
+  // does, and is rescheduled if it is still valid
+  auto* tip = tree_->getBestChain().tip();
+  while (!atvExpiry_.empty() &&
+         atvExpiry_.begin()->first <= tip->getHeight()) {
+    auto id = atvExpiry_.begin()->second;
+    atvExpiry_.erase(atvExpiry_.begin());
+    auto it = stored_atvs_.find(id);
+    if (it == stored_atvs_.end()) {
+      continue;
+    }
+    ValidationState state;
+    if (checkContextually(*it->second, state)) {
+      scheduleExpiry(*it->second);
+    } else {
+      removeATV(id);
+    }
+  }
+
+  // relations are ordered by height, so too old relations are in the beginning
+  auto& vbk = tree_->vbk();
+  auto minHeight = vbk.getBestChain().tip()->getHeight() -
+                   vbk.getParams().getMaxReorgBlocks();
+  while (!relationsIndex_.empty() &&
+         relationsIndex_.begin()->first.first < minHeight) {
+    auto id = relationsIndex_.begin()->second->header->getId();
+    removeRelation(relations_.find(id));
+  }
+
+  for (const auto& id : touched) {
+    auto it = relations_.find(id);
+    if (it == relations_.end()) {
       continue;
     }
+    if (cleanupRelation(*it->second, pop, vbkblockids)) {
+      removeRelation(it);
+    } else {
+      reindexRelation(*it->second);
+    }
+  }
 
-    ++it;
+  // VBK blocks, which may have been added to VBK tree with this block
+  std::vector<vbk_hash_t> arrived;
+  for (const auto& b : pop.context) {
+    arrived.push_back(b.getId());
+  }
+  for (const auto& vtb : pop.vtbs) {
+    arrived.push_back(vtb.containingBlock.getId());
   }
+  for (const auto& atv : pop.atvs) {
+    arrived.push_back(atv.blockOfProof.getId());
+  }
+  connectOrphans(std::move(arrived));
 }
 
 void MemPool::removeAll(const PopData& pop) { vacuum(pop); }
 
-VbkPayloadsRelations& MemPool::touchVbkBlock(const VbkBlock& block,
-                                                      VbkBlock::id_t block_id) {
+VbkPayloadsRelations& MemPool::touchVbkBlock(
+    const VbkBlock& block,
+    VbkBlock::id_t block_id,
+    std::shared_ptr<VbkBlock> stored) {
   if (block_id == VbkBlock::id_t()) {
     block_id = block.getId();
   }
 
-  std::shared_ptr<VbkBlock> vbk_block = std::make_shared<VbkBlock>(block);
-
-  vbkblocks_[block_id] = vbk_block;
-
   auto& val = relations_[block_id];
   if (val == nullptr) {
+    std::shared_ptr<VbkBlock> vbk_block =
+        stored != nullptr ? std::move(stored)
+                          : std::make_shared<VbkBlock>(block);
+    vbkblocks_[block_id] = vbk_block;
+    shortIds_.add<VbkBlock>(shortIds_.context, block_id);
     val = std::make_shared<VbkPayloadsRelations>(vbk_block);
+    val->arrival = arrivals_++;
+    if (isConnected(block)) {
+      relationsIndex_.emplace(std::make_pair(block.height, val->arrival),
+                              val.get());
+      reindexRelation(*val);
+      if (hasTemplate_) {
+        addedBlocks_.push_back(vbk_block);
+      }
+      connectOrphans({block_id});
+    } else {
+      // wait for previous block
+      val->orphan = true;
+      val->orphanTime = currentTimestamp4();
+      orphans_.emplace(val->arrival, val.get());
+      orphansByPrev_.emplace(block.previousBlock, val.get());
+      reindexRelation(*val);
+    }
+    if (notifications_ != nullptr) {
+      accepted_.vbkblocks.push_back(block_id);
+    }
   }
 
   on_vbkblock_accepted.emit(block);
@@ -205,62 +667,475 @@ VbkPayloadsRelations& MemPool::touchVbkBlock(const VbkBlock& block,
   return *val;
 }
 
+template <typename Pop, typename Get, typename Take>
+void MemPool::submitMany(
+    size_t size,
+    const Get& get,
+    const Take& take,
+    std::vector<std::pair<typename Pop::id_t, ValidationState>>& results,
+    size_t threads) {
+  // signature and merkle path checks are expensive enough to split payloads
+  // into small chunks
+  const size_t minPayloadsPerThread = 8;
+  std::vector<ValidationState> states(size);
+  std::vector<char> valid(size, 0);
+  workers_.reserve(threads > 1 ? threads - 1 : 0);
+  parallel_for(
+      workers_,
+      size,
+      threads,
+      [&](size_t i) {
+        valid[i] = checkStateless(get(i), states[i]) ? 1 : 0;
+        return true;
+      },
+      minPayloadsPerThread);
+
+  results.reserve(results.size() + size);
+  for (size_t i = 0; i < size; i++) {
+    const Pop& payload = get(i);
+    auto id = payload.getId();
+    if (valid[i] != 0) {
+      submitChecked(payload, take(i), states[i], true);
+    }
+    results.emplace_back(id, std::move(states[i]));
+  }
+}
+
 namespace {
 
-template <typename pop_t>
-void process_submit(
-    MemPool& memPool,
-    const std::vector<pop_t>& payloads,
-    std::vector<std::pair<typename pop_t::id_t, ValidationState>>& res) {
-  for (const auto& p : payloads) {
-    ValidationState state;
-    memPool.submit<pop_t>(p, state);
-    res.emplace_back(p.getId(), state);
+template <typename Pop>
+std::vector<std::shared_ptr<Pop>> makeShared(std::vector<Pop>&& payloads) {
+  std::vector<std::shared_ptr<Pop>> ret;
+  ret.reserve(payloads.size());
+  for (auto& p : payloads) {
+    ret.push_back(std::make_shared<Pop>(std::move(p)));
   }
+  payloads.clear();
+  return ret;
 }
 
 }  // namespace
 
-MempoolResult MemPool::submitAll(const PopData& pop) {
+MempoolResult MemPool::submitAll(const PopData& pop, size_t threads) {
+  MempoolResult r;
+
+  // payloads are copied when stored
+  submitMany<VbkBlock>(
+      pop.context.size(),
+      [&](size_t i) -> const VbkBlock& { return pop.context[i]; },
+      [](size_t) { return std::shared_ptr<VbkBlock>(); },
+      r.context,
+      threads);
+  submitMany<VTB>(
+      pop.vtbs.size(),
+      [&](size_t i) -> const VTB& { return pop.vtbs[i]; },
+      [](size_t) { return std::shared_ptr<VTB>(); },
+      r.vtbs,
+      threads);
+  submitMany<ATV>(
+      pop.atvs.size(),
+      [&](size_t i) -> const ATV& { return pop.atvs[i]; },
+      [](size_t) { return std::shared_ptr<ATV>(); },
+      r.atvs,
+      threads);
+  notifyAccepted();
+
+  return r;
+}
+
+MempoolResult MemPool::submitAll(PopData&& pop, size_t threads) {
   MempoolResult r;
 
-  process_submit(*this, pop.context, r.context);
-  process_submit(*this, pop.vtbs, r.vtbs);
-  process_submit(*this, pop.atvs, r.atvs);
+  // payloads are moved to shared objects once, and these objects are stored
+  auto context = makeShared(std::move(pop.context));
+  auto vtbs = makeShared(std::move(pop.vtbs));
+  auto atvs = makeShared(std::move(pop.atvs));
+  submitMany<VbkBlock>(
+      context.size(),
+      [&](size_t i) -> const VbkBlock& { return *context[i]; },
+      [&](size_t i) { return std::move(context[i]); },
+      r.context,
+      threads);
+  submitMany<VTB>(
+      vtbs.size(),
+      [&](size_t i) -> const VTB& { return *vtbs[i]; },
+      [&](size_t i) { return std::move(vtbs[i]); },
+      r.vtbs,
+      threads);
+  submitMany<ATV>(
+      atvs.size(),
+      [&](size_t i) -> const ATV& { return *atvs[i]; },
+      [&](size_t i) { return std::move(atvs[i]); },
+      r.atvs,
+      threads);
+  notifyAccepted();
 
   return r;
 }
 
 void MemPool::clear() {
+  invalidateTemplate();
   relations_.clear();
+  relationsIndex_.clear();
+  evictionIndex_.clear();
+  orphans_.clear();
+  orphansByPrev_.clear();
+  usage_ = 0;
   vbkblocks_.clear();
   stored_vtbs_.clear();
   stored_atvs_.clear();
+  atvExpiry_.clear();
+  unresolvedAtvs_.clear();
+  shortIds_ = ShortIds();
+  fullVacuum_ = true;
+}
+
+void MemPool::saveSnapshot(WriteStream& stream) const {
+  // relations in order of arrival, so that relations index keeps its order
+  std::vector<const VbkPayloadsRelations*> sorted;
+  sorted.reserve(relations_.size());
+  for (const auto& p : relations_) {
+    sorted.push_back(p.second.get());
+  }
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const VbkPayloadsRelations* a, const VbkPayloadsRelations* b) {
+              return a->arrival < b->arrival;
+            });
+
+  WriteStream body;
+  body.writeBE<uint32_t>((uint32_t)sorted.size());
+  for (const auto* rel : sorted) {
+    rel->header->toVbkEncoding(body);
+    body.writeBE<uint32_t>((uint32_t)rel->vtbs.size());
+    for (const auto& vtb : rel->vtbs) {
+      vtb->toVbkEncoding(body);
+    }
+    body.writeBE<uint32_t>((uint32_t)rel->atvs.size());
+    for (const auto& atv : rel->atvs) {
+      atv->toVbkEncoding(body);
+    }
+  }
+
+  stream.writeBE<uint32_t>(kMempoolSnapshotMagic);
+  stream.writeBE<uint32_t>(kMempoolSnapshotVersion);
+  auto checksum = sha256(body.data());
+  stream.write(checksum);
+  stream.write(body.data());
+}
+
+bool MemPool::restoreSnapshot(Slice<const uint8_t> snapshot,
+                              ValidationState& state) {
+  auto invalid = [&state](const std::string& reason,
+                          const std::string& debug = "") {
+    state.Invalid(reason, debug);
+    return state.Invalid("restore-mempool-snapshot");
+  };
+
+  ReadStream stream(snapshot);
+  ValidationState dummy;
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  Slice<const uint8_t> checksum;
+  if (!stream.readBE<uint32_t>(magic, dummy) ||
+      !stream.readBE<uint32_t>(version, dummy) ||
+      !stream.readSlice(uint256::size(), checksum, dummy)) {
+    return invalid("bad-snapshot-header");
+  }
+  if (magic != kMempoolSnapshotMagic) {
+    return invalid("bad-snapshot-magic");
+  }
+  if (version != kMempoolSnapshotVersion) {
+    return invalid("bad-snapshot-version", fmt::format("version {}", version));
+  }
+
+  Slice<const uint8_t> body(snapshot.data() + stream.position(),
+                            stream.remaining());
+  if (sha256(body) != uint256(checksum)) {
+    return invalid("bad-snapshot-checksum");
+  }
+
+  // checksum matches, so payloads are the ones which have passed stateless
+  // checks before they were saved
+  try {
+    auto count = stream.readBE<uint32_t>();
+    VBK_LOG_WARN("Restoring %d VBK blocks to mempool from snapshot", count);
+    for (uint32_t i = 0; i < count; i++) {
+      ValidationState ignored;
+      auto block =
+          std::make_shared<VbkBlock>(VbkBlock::fromVbkEncoding(stream));
+      submitChecked(*block, block, ignored, false);
+
+      auto vtbs = stream.readBE<uint32_t>();
+      for (uint32_t j = 0; j < vtbs; j++) {
+        auto vtb = std::make_shared<VTB>(VTB::fromVbkEncoding(stream));
+        vtb->checked = true;
+        submitChecked(*vtb, vtb, ignored, false);
+      }
+
+      auto atvs = stream.readBE<uint32_t>();
+      for (uint32_t j = 0; j < atvs; j++) {
+        auto atv = std::make_shared<ATV>(ATV::fromVbkEncoding(stream));
+        atv->checked = true;
+        submitChecked(*atv, atv, ignored, false);
+      }
+    }
+  } catch (const std::exception& e) {
+    return invalid("bad-snapshot-payload", e.what());
+  }
+
+  // single contextual pass over all stored payloads
+  fullVacuum_ = true;
+  vacuum(PopData{});
+  notifyAccepted();
+  return true;
+}
+
+namespace {
+
+//! prefills payloads, which are not stored in mempool
+struct NotInMemPool {
+  const MemPool& mempool;
+
+  template <typename Pop>
+  bool operator()(const Pop& payload) const {
+    return mempool.get<Pop>(payload.getId()) == nullptr;
+  }
+};
+
+//! payload matching a short id, nullptr if there is none or more than one
+template <typename Pop>
+struct ShortIdMatch {
+  const Pop* payload = nullptr;
+  bool ambiguous = false;
+
+  void add(const Pop& p) {
+    if (payload == nullptr) {
+      payload = &p;
+    } else if (payload != &p && payload->getId() != p.getId()) {
+      ambiguous = true;
+    }
+  }
+
+  const Pop* get() const { return ambiguous ? nullptr : payload; }
+};
+
+//! adds short ids of all `stored` payloads to `out`
+template <typename Pop, typename Map>
+void fillShortIds(uint64_t salt,
+                  const MemPool::payload_map<Pop>& stored,
+                  Map& out) {
+  out.clear();
+  out.reserve(stored.size());
+  for (const auto& p : stored) {
+    out.emplace(CompactPopData::shortId(
+                    salt, Slice<const uint8_t>(p.first.data(), p.first.size())),
+                p.first);
+  }
+}
+
+/**
+ * Places payloads of `compact` into `slots`: prefilled ones and those, which
+ * are found among `stored` and `extra` by short id. Indexes of unresolved short
+ * ids are added to `missing`.
+ * @param shortIds ids of stored payloads by short id, may contain ids of
+ * removed payloads
+ * @return false if `compact` is malformed
+ */
+template <typename Pop, typename ShortIds>
+bool reconstructPayloads(const CompactPopData& c,
+                         const CompactPopData::Payloads<Pop>& compact,
+                         const MemPool::payload_map<Pop>& stored,
+                         const ShortIds& shortIds,
+                         const std::vector<Pop>& extra,
+                         std::vector<const Pop*>& slots,
+                         std::vector<uint32_t>& missing,
+                         ValidationState& state) {
+  slots.assign(compact.size(), nullptr);
+  for (const auto& p : compact.prefilled) {
+    if (p.first >= slots.size() || slots[p.first] != nullptr) {
+      return state.Invalid(
+          "compact-pop-bad-prefilled-index",
+          fmt::format("{} index={}", Pop::name(), p.first));
+    }
+    slots[p.first] = &p.second;
+  }
+
+  if (compact.shortIds.empty()) {
+    return true;
+  }
+
+  std::unordered_map<CompactPopData::short_id_t, ShortIdMatch<Pop>> matches;
+  matches.reserve(compact.shortIds.size());
+  for (const auto& id : compact.shortIds) {
+    matches[id];
+  }
+  for (auto& m : matches) {
+    auto range = shortIds.equal_range(m.first);
+    for (auto it = range.first; it != range.second; ++it) {
+      auto p = stored.find(it->second);
+      if (p != stored.end()) {
+        m.second.add(*p->second);
+      }
+    }
+  }
+  for (const auto& p : extra) {
+    auto it = matches.find(c.shortId(p.getId()));
+    if (it != matches.end()) {
+      it->second.add(p);
+    }
+  }
+
+  size_t next = 0;
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (slots[i] != nullptr) {
+      continue;
+    }
+    slots[i] = matches.at(compact.shortIds[next++]).get();
+    if (slots[i] == nullptr) {
+      missing.push_back((uint32_t)i);
+    }
+  }
+  return true;
+}
+
+template <typename Pop>
+std::vector<Pop> copyPayloads(const std::vector<const Pop*>& slots) {
+  std::vector<Pop> ret;
+  ret.reserve(slots.size());
+  for (const auto* p : slots) {
+    ret.push_back(*p);
+  }
+  return ret;
+}
+
+}  // namespace
+
+CompactPopData MemPool::compact(const PopData& pop, uint64_t salt) const {
+  return CompactPopData::fromPopData(pop, salt, NotInMemPool{*this});
+}
+
+bool MemPool::reconstruct(const CompactPopData& compact,
+                          PopData& out,
+                          CompactPopData::Missing& missing,
+                          ValidationState& state,
+                          const PopData& extra) const {
+  missing = CompactPopData::Missing{};
+  auto& ids = shortIds_;
+  // removed payloads stay in the map until it is rebuilt
+  const size_t stored =
+      vbkblocks_.size() + stored_vtbs_.size() + stored_atvs_.size();
+  if (!ids.built || ids.salt != compact.salt || ids.size() > 2 * stored) {
+    ids.built = true;
+    ids.salt = compact.salt;
+    fillShortIds(ids.salt, getMap<VbkBlock>(), ids.context);
+    fillShortIds(ids.salt, getMap<VTB>(), ids.vtbs);
+    fillShortIds(ids.salt, getMap<ATV>(), ids.atvs);
+  }
+
+  std::vector<const VbkBlock*> context;
+  std::vector<const VTB*> vtbs;
+  std::vector<const ATV*> atvs;
+  // clang-format off
+  if (!reconstructPayloads(compact, compact.context, getMap<VbkBlock>(), ids.context, extra.context, context, missing.context, state) ||
+      !reconstructPayloads(compact, compact.vtbs, getMap<VTB>(), ids.vtbs, extra.vtbs, vtbs, missing.vtbs, state) ||
+      !reconstructPayloads(compact, compact.atvs, getMap<ATV>(), ids.atvs, extra.atvs, atvs, missing.atvs, state)) {
+    return state.Invalid("pop-mempool-reconstruct");
+  }
+  // clang-format on
+
+  if (!missing.empty()) {
+    return state.Invalid(
+        "pop-mempool-reconstruct-missing-payloads",
+        fmt::format("VBK={} VTB={} ATV={}",
+                    missing.context.size(),
+                    missing.vtbs.size(),
+                    missing.atvs.size()));
+  }
+
+  out.version = compact.version;
+  out.context = copyPayloads(context);
+  out.vtbs = copyPayloads(vtbs);
+  out.atvs = copyPayloads(atvs);
+  return true;
 }
 
 template <>
 bool MemPool::submit(const ATV& atv,
                      ValidationState& state,
                      bool shouldDoContextualCheck) {
-  // stateless validation
+  bool valid = checkStateless(atv, state) &&
+               submitChecked(
+                   atv, std::shared_ptr<ATV>(), state, shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+bool MemPool::submit(std::shared_ptr<ATV> atv,
+                     ValidationState& state,
+                     bool shouldDoContextualCheck) {
+  VBK_ASSERT(atv != nullptr);
+  const ATV& ref = *atv;
+  bool valid =
+      checkStateless(ref, state) &&
+      submitChecked(ref, std::move(atv), state, shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+template <>
+bool MemPool::checkStateless(const ATV& atv, ValidationState& state) const {
   if (!checkATV(atv, state, tree_->getParams())) {
     return state.Invalid("pop-mempool-submit-atv-stateless");
   }
+  return true;
+}
 
+template <>
+bool MemPool::submitChecked(const ATV& atv,
+                            std::shared_ptr<ATV> stored,
+                            ValidationState& state,
+                            bool shouldDoContextualCheck) {
   // stateful validation
   if (shouldDoContextualCheck && !checkContextually(atv, state)) {
     return state.Invalid("pop-mempool-submit-atv-stateful");
   }
 
+  auto id = atv.getId();
+  if (stored_atvs_.count(id) > 0) {
+    // already stored
+    return true;
+  }
+
   auto& rel = touchVbkBlock(atv.blockOfProof);
-  auto atvptr = std::make_shared<ATV>(atv);
-  auto pair = std::make_pair(atv.getId(), atvptr);
-  rel.atvs.push_back(atvptr);
+  auto atvptr = stored != nullptr ? std::move(stored)
+                                  : std::make_shared<ATV>(atv);
+  auto pair = std::make_pair(id, atvptr);
+  rel.addATV(atvptr);
+  if (hasTemplate_ && !rel.orphan) {
+    addedAtvs_.push_back(atvptr);
+  }
 
   // store atv id in containing block index
   stored_atvs_.insert(pair);
+  shortIds_.add<ATV>(shortIds_.atvs, id);
+  scheduleExpiry(atv);
+  if (!shouldDoContextualCheck) {
+    // ATV may be already invalid, check it on next vacuum
+    fullVacuum_ = true;
+  }
+
+  reindexRelation(rel);
+  trimToSize();
+  if (stored_atvs_.count(id) == 0) {
+    return state.Invalid("pop-mempool-full",
+                         "ATV is evicted, because mempool is full");
+  }
 
   on_atv_accepted.emit(atv);
+  if (notifications_ != nullptr) {
+    accepted_.atvs.push_back(id);
+  }
 
   return true;
 }
@@ -269,25 +1144,76 @@ template <>
 bool MemPool::submit(const VTB& vtb,
                      ValidationState& state,
                      bool shouldDoContextualCheck) {
-  auto& vbk = tree_->vbk();
-  // stateless validation
-  if (!checkVTB(vtb, state, vbk.btc().getParams())) {
+  bool valid = checkStateless(vtb, state) &&
+               submitChecked(
+                   vtb, std::shared_ptr<VTB>(), state, shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+bool MemPool::submit(std::shared_ptr<VTB> vtb,
+                     ValidationState& state,
+                     bool shouldDoContextualCheck) {
+  VBK_ASSERT(vtb != nullptr);
+  const VTB& ref = *vtb;
+  bool valid =
+      checkStateless(ref, state) &&
+      submitChecked(ref, std::move(vtb), state, shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+template <>
+bool MemPool::checkStateless(const VTB& vtb, ValidationState& state) const {
+  if (!checkVTB(vtb, state, btcInterner_)) {
     return state.Invalid("pop-mempool-submit-vtb-stateless");
   }
+  return true;
+}
 
+template <>
+bool MemPool::submitChecked(const VTB& vtb,
+                            std::shared_ptr<VTB> stored,
+                            ValidationState& state,
+                            bool shouldDoContextualCheck) {
   // stateful validation
   if (shouldDoContextualCheck && !checkContextually(vtb, state)) {
     return state.Invalid("pop-mempool-submit-vtb-stateful");
   }
 
+  auto id = vtb.getId();
+  if (stored_vtbs_.count(id) > 0) {
+    // already stored
+    return true;
+  }
+
   auto& rel = touchVbkBlock(vtb.containingBlock);
-  auto vtbptr = std::make_shared<VTB>(vtb);
-  auto pair = std::make_pair(vtb.getId(), vtbptr);
-  rel.vtbs.push_back(vtbptr);
+  auto vtbptr = stored != nullptr ? std::move(stored)
+                                  : std::make_shared<VTB>(vtb);
+  auto pair = std::make_pair(id, vtbptr);
+  rel.addVTB(vtbptr);
+  if (hasTemplate_ && !rel.orphan) {
+    addedVtbs_.push_back(vtbptr);
+  }
 
   stored_vtbs_.insert(pair);
+  shortIds_.add<VTB>(shortIds_.vtbs, id);
+  if (!shouldDoContextualCheck) {
+    // VTB may be already invalid, check it on next vacuum
+    fullVacuum_ = true;
+  }
+
+  reindexRelation(rel);
+  trimToSize();
+  if (stored_vtbs_.count(id) == 0) {
+    return state.Invalid("pop-mempool-full",
+                         "VTB is evicted, because mempool is full");
+  }
 
   on_vtb_accepted.emit(vtb);
+  if (notifications_ != nullptr) {
+    accepted_.vtbs.push_back(id);
+  }
 
   return true;
 }
@@ -296,19 +1222,56 @@ template <>
 bool MemPool::submit(const VbkBlock& blk,
                      ValidationState& state,
                      bool shouldDoContextualCheck) {
-  // stateless validation
-  if (!checkBlock(blk, state, tree_->vbk().getParams())) {
+  bool valid = checkStateless(blk, state) &&
+               submitChecked(blk,
+                             std::shared_ptr<VbkBlock>(),
+                             state,
+                             shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+bool MemPool::submit(std::shared_ptr<VbkBlock> blk,
+                     ValidationState& state,
+                     bool shouldDoContextualCheck) {
+  VBK_ASSERT(blk != nullptr);
+  const VbkBlock& ref = *blk;
+  bool valid =
+      checkStateless(ref, state) &&
+      submitChecked(ref, std::move(blk), state, shouldDoContextualCheck);
+  notifyAccepted();
+  return valid;
+}
+
+template <>
+bool MemPool::checkStateless(const VbkBlock& blk,
+                             ValidationState& state) const {
+  if (!checkBlock(blk, state, vbkInterner_)) {
     return state.Invalid("pop-mempool-submit-vbkblock-stateless");
   }
+  return true;
+}
 
+template <>
+bool MemPool::submitChecked(const VbkBlock& blk,
+                            std::shared_ptr<VbkBlock> stored,
+                            ValidationState& state,
+                            bool shouldDoContextualCheck) {
   if (shouldDoContextualCheck && !checkContextually(blk, state)) {
     return state.Invalid("pop-mempool-submit-vbk-stateful");
   }
 
   // stateful validation
-  if (!shouldDoContextualCheck || !tree_->vbk().getBlockIndex(blk.getHash())) {
+  auto hash = vbkInterner_.intern(blk)->hash;
+  if (!shouldDoContextualCheck || !tree_->vbk().getBlockIndex(hash)) {
     // duplicate
-    touchVbkBlock(blk, blk.getId());
+    auto id = hash.trimLE<VbkBlock::id_t::size()>();
+    touchVbkBlock(blk, id, std::move(stored));
+    trimToSize();
+    if (vbkblocks_.count(id) == 0) {
+      return state.Invalid("pop-mempool-full",
+                           "VBK block is evicted, because mempool is full");
+    }
   }
 
   return true;
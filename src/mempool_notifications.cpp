@@ -0,0 +1,63 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "veriblock/mempool_notifications.hpp"
+
+#include "veriblock/finalizer.hpp"
+
+namespace altintegration {
+
+void MemPoolNotificationQueue::push(Batch batch) {
+  if (batch.empty()) {
+    return;
+  }
+
+  const size_t n = batch.size();
+  std::unique_lock<std::mutex> lock(mutex_);
+  notFull_.wait(lock, [&] { return size_ == 0 || size_ + n <= capacity_; });
+  size_ += n;
+  batches_.push_back(std::move(batch));
+  notEmpty_.notify_all();
+}
+
+size_t MemPoolNotificationQueue::drain(const callback_t& f) {
+  size_t count = 0;
+  while (true) {
+    Batch batch;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (batches_.empty()) {
+        return count;
+      }
+      batch = std::move(batches_.front());
+      batches_.pop_front();
+    }
+
+    // space is released even if `f` throws
+    Finalizer release([&] {
+      std::lock_guard<std::mutex> lock(mutex_);
+      size_ -= batch.size();
+      notFull_.notify_all();
+    });
+    f(batch);
+    ++count;
+  }
+}
+
+size_t MemPoolNotificationQueue::waitAndDrain(
+    const callback_t& f, std::chrono::milliseconds timeout) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait_for(lock, timeout, [&] { return !batches_.empty(); });
+  }
+  return drain(f);
+}
+
+size_t MemPoolNotificationQueue::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+}  // namespace altintegration
@@ -0,0 +1,302 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "veriblock/mempool_selector.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace altintegration {
+
+namespace {
+
+//! VBK encoding size of PopData version and payload counts
+size_t popDataOverhead(size_t context, size_t vtbs, size_t atvs) {
+  return sizeof(PopData::version) + singleBEValueSize((int64_t)context) +
+         singleBEValueSize((int64_t)vtbs) + singleBEValueSize((int64_t)atvs);
+}
+
+//! lowest height of VBK blocks on active VBK chain, which contain
+//! endorsements of `index`, see PopRewards::scoreFromEndorsements
+int32_t getBestPublication(const BlockIndex<AltBlock>& index,
+                           const VbkBlockTree& vbk) {
+  int32_t best = -1;
+  for (const auto* e : index.getEndorsedBy()) {
+    auto* b = vbk.getBlockIndex(e->blockOfProof);
+    if (b == nullptr || !vbk.getBestChain().contains(b)) {
+      continue;
+    }
+    if (best < 0 || b->getHeight() < best) {
+      best = b->getHeight();
+    }
+  }
+  return best;
+}
+
+//! ATVs endorsing `index` can be added to the next block on top of ALT tip,
+//! see checkContextually<ATV>
+bool isEndorsable(const BlockIndex<AltBlock>& index, const AltBlockTree& tree) {
+  if (!tree.getBestChain().contains(&index)) {
+    return false;
+  }
+  auto containingHeight = tree.getBestChain().tip()->getHeight() + 1;
+  auto window = tree.getParams().getEndorsementSettlementInterval();
+  return containingHeight - index.getHeight() <= window;
+}
+
+//! score of endorsement published `relative` VBK blocks after the best one
+double getScore(const AltBlockTree& tree, int32_t relative) {
+  const auto& scores =
+      tree.getParams().getRewardParams().relativeScoreLookupTable();
+  if (relative < 0) {
+    // endorsement becomes the best one
+    relative = 0;
+  }
+  return (size_t)relative < scores.size() ? scores[relative] : 0;
+}
+
+struct Candidate {
+  double density;
+  //! position of relation in relations index
+  size_t relation;
+  //! position of payload in `selected`
+  size_t payload;
+  size_t size;
+};
+
+}  // namespace
+
+PopData HeightOrderSelector::select(const relations_index_t& relations,
+                                    const AltBlockTree& tree) const {
+  PopData ret;
+  // size in bytes of pop data added to
+  size_t popSize = 0;
+  const size_t maxSize = tree.getParams().getMaxPopDataSize();
+
+  for (const auto& p : relations) {
+    const auto& rel = *p.second;
+    if (popSize + rel.estimateSize(0, 0) > maxSize) {
+      // VBK blocks have fixed size, so no other relation fits
+      break;
+    }
+
+    // first cut VTBs, then ATVs
+    size_t vtbs = rel.vtbs.size();
+    size_t atvs = rel.atvs.size();
+    size_t estimated = rel.estimateSize();
+    while (popSize + estimated > maxSize && vtbs > 0) {
+      estimated -= rel.vtbSizes[--vtbs];
+    }
+    while (popSize + estimated > maxSize && atvs > 0) {
+      estimated -= rel.atvSizes[--atvs];
+    }
+    if (popSize + estimated > maxSize) {
+      // only header fits
+      estimated = rel.estimateSize(0, 0);
+    }
+
+    popSize += estimated;
+    ret.context.push_back(*rel.header);
+    for (size_t i = 0; i < vtbs; i++) {
+      ret.vtbs.push_back(*rel.vtbs[i]);
+    }
+    for (size_t i = 0; i < atvs; i++) {
+      ret.atvs.push_back(*rel.atvs[i]);
+    }
+  }
+
+  return ret;
+}
+
+PopData ValueDensitySelector::select(const relations_index_t& relations,
+                                     const AltBlockTree& tree) const {
+  const auto& vbk = tree.vbk();
+
+  // ATVs endorse few distinct blocks, resolve every endorsed block once
+  std::unordered_map<const BlockIndex<AltBlock>*, Endorsed> byIndex;
+  auto resolve = [&](const BlockIndex<AltBlock>* index) -> const Endorsed& {
+    auto it = byIndex.find(index);
+    if (it == byIndex.end()) {
+      Endorsed e;
+      e.index = index;
+      if (index != nullptr) {
+        e.bestPublication = getBestPublication(*index, vbk);
+        e.endorsable = isEndorsable(*index, tree);
+      }
+      it = byIndex.emplace(index, e).first;
+    }
+    return it->second;
+  };
+  // endorsed blocks by sha256 of their headers, see
+  // VbkPayloadsRelations::atvEndorsed
+  std::unordered_map<uint256, const Endorsed*> byHeader;
+  const uint256* lastHeader = nullptr;
+  const Endorsed* lastEndorsed = nullptr;
+
+  // value of ATVs by their block of proof, VTBs publishing these blocks unlock
+  // them. ATVs, which are already added to active ALT chain, are valued first.
+  std::unordered_map<VbkBlock::id_t, double> unlocks;
+  unlocks.reserve(relations.size());
+  const auto window = tree.getParams().getEndorsementSettlementInterval();
+  const auto* block = tree.getBestChain().tip();
+  for (int32_t i = 0; i < window && block != nullptr; i++) {
+    for (const auto& p : block->getContainingEndorsements()) {
+      const auto& e = *p.second;
+      auto* proof = vbk.getBlockIndex(e.blockOfProof);
+      if (proof == nullptr) {
+        continue;
+      }
+      const auto& endorsed = resolve(tree.getBlockIndex(e.endorsedHash));
+      unlocks[e.blockOfProof.trimLE<VbkBlock::id_t::size()>()] +=
+          getScore(tree, proof->getHeight() - endorsed.bestPublication);
+    }
+    block = block->pprev;
+  }
+
+  std::vector<const VbkPayloadsRelations*> rels;
+  rels.reserve(relations.size());
+  // headers[i] is a total size of VBK blocks of first i relations
+  std::vector<size_t> headers{0};
+  headers.reserve(relations.size() + 1);
+  // offsets[i] is a position of first payload of i-th relation in `selected`
+  std::vector<size_t> offsets{0};
+  offsets.reserve(relations.size() + 1);
+  std::vector<Candidate> candidates;
+  candidates.reserve(relations.size() * 5);
+  size_t vtbsTotal = 0;
+  size_t atvsTotal = 0;
+  size_t minSize = (std::numeric_limits<size_t>::max)();
+
+  for (const auto& p : relations) {
+    const auto& rel = *p.second;
+    const size_t r = rels.size();
+    headers.push_back(headers.back() + rel.headerSize);
+    // payload requires VBK blocks of this and all preceding relations
+    auto add = [&](double value, size_t payload, size_t size) {
+      if (value > 0) {
+        candidates.push_back(
+            {value / (size + headers.back()), r, payload, size});
+        minSize = (std::min)(minSize, size);
+      }
+    };
+
+    // published blocks precede containing blocks, so their ATVs are already
+    // valued. Payloads are read only through keys cached in relation.
+    size_t payload = offsets.back();
+    for (size_t i = 0; i < rel.vtbs.size(); i++) {
+      auto it = unlocks.find(rel.vtbPublished[i]);
+      double unlocked = it == unlocks.end() ? 0 : it->second;
+      add(getValue(*rel.vtbs[i], unlocked, tree), payload++, rel.vtbSizes[i]);
+    }
+
+    double atvsValue = 0;
+    for (size_t i = 0; i < rel.atvs.size(); i++) {
+      const auto& key = rel.atvEndorsed[i];
+      if (lastHeader == nullptr || *lastHeader != key) {
+        auto it = byHeader.find(key);
+        if (it == byHeader.end()) {
+          const auto& header = rel.atvs[i]->transaction.publicationData.header;
+          auto* index = tree.getBlockIndex(tree.getParams().getHash(header));
+          it = byHeader.emplace(key, &resolve(index)).first;
+        }
+        lastHeader = &it->first;
+        lastEndorsed = it->second;
+      }
+      double value = getValue(*rel.atvs[i], *rel.header, *lastEndorsed, tree);
+      atvsValue += value;
+      add(value, payload++, rel.atvSizes[i]);
+    }
+    if (atvsValue > 0) {
+      unlocks[rel.id] += atvsValue;
+    }
+
+    vtbsTotal += rel.vtbs.size();
+    atvsTotal += rel.atvs.size();
+    rels.push_back(&rel);
+    offsets.push_back(payload);
+  }
+
+  // payloads of equal density are taken in dependency order. Only a small
+  // part of candidates fits, so they are popped from a heap instead of being
+  // sorted.
+  auto worse = [](const Candidate& a, const Candidate& b) {
+    return a.density < b.density ||
+           (a.density == b.density && a.payload > b.payload);
+  };
+  std::make_heap(candidates.begin(), candidates.end(), worse);
+
+  const size_t maxSize = tree.getParams().getMaxPopDataSize();
+  // counts are not known in advance, reserve space for the largest ones
+  size_t popSize = popDataOverhead(rels.size(), vtbsTotal, atvsTotal);
+  // number of relations which VBK blocks are selected
+  size_t included = 0;
+  std::vector<char> selected(offsets.back(), 0);
+  for (auto end = candidates.end();
+       end != candidates.begin() && popSize < maxSize &&
+       maxSize - popSize >= minSize;
+       --end) {
+    std::pop_heap(candidates.begin(), end, worse);
+    const auto& c = *(end - 1);
+    size_t context =
+        c.relation < included ? 0 : headers[c.relation + 1] - headers[included];
+    if (popSize + context + c.size > maxSize) {
+      continue;
+    }
+
+    popSize += context + c.size;
+    included = (std::max)(included, c.relation + 1);
+    selected[c.payload] = 1;
+  }
+
+  // remaining space is filled with VBK blocks, they advance VBK tip
+  while (included < rels.size() &&
+         popSize + rels[included]->headerSize <= maxSize) {
+    popSize += rels[included++]->headerSize;
+  }
+
+  PopData ret;
+  for (size_t r = 0; r < included; r++) {
+    const auto& rel = *rels[r];
+    ret.context.push_back(*rel.header);
+    size_t payload = offsets[r];
+    for (const auto& vtb : rel.vtbs) {
+      if (selected[payload++] != 0) {
+        ret.vtbs.push_back(*vtb);
+      }
+    }
+    for (const auto& atv : rel.atvs) {
+      if (selected[payload++] != 0) {
+        ret.atvs.push_back(*atv);
+      }
+    }
+  }
+
+  return ret;
+}
+
+double ValueDensitySelector::getValue(const ATV& atv,
+                                      const VbkBlock& blockOfProof,
+                                      const Endorsed& endorsed,
+                                      const AltBlockTree& tree) const {
+  (void)atv;
+  if (!endorsed.endorsable) {
+    return 0;
+  }
+
+  auto height = blockOfProof.height;
+  auto best = endorsed.bestPublication < 0 ? height : endorsed.bestPublication;
+  return getScore(tree, height - best);
+}
+
+double ValueDensitySelector::getValue(const VTB& vtb,
+                                      double unlocked,
+                                      const AltBlockTree& tree) const {
+  (void)vtb;
+  (void)tree;
+  return unlocked;
+}
+
+}  // namespace altintegration
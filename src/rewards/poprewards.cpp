@@ -14,7 +14,7 @@ namespace altintegration {
 static int getBestPublicationHeight(const BlockIndex<AltBlock>& endorsedBlock,
                                     const VbkBlockTree& vbk_tree) {
   int bestPublication = -1;
-  for (const auto* e : endorsedBlock.endorsedBy) {
+  for (const auto* e : endorsedBlock.getEndorsedBy()) {
     auto* b = vbk_tree.getBlockIndex(e->blockOfProof);
     if (!vbk_tree.getBestChain().contains(b)) continue;
     if (b->getHeight() < bestPublication || bestPublication < 0)
@@ -31,7 +31,7 @@ PopRewardsBigDecimal PopRewards::scoreFromEndorsements(
   int bestPublication = getBestPublicationHeight(endorsedBlock, vbk_tree);
   if (bestPublication < 0) return totalScore;
 
-  for (const auto* e : endorsedBlock.endorsedBy) {
+  for (const auto* e : endorsedBlock.getEndorsedBy()) {
     auto* b = vbk_tree.getBlockIndex(e->blockOfProof);
     if (!vbk_tree.getBestChain().contains(b)) continue;
     int relativeHeight = b->getHeight() - bestPublication;
@@ -80,7 +80,7 @@ std::map<std::vector<uint8_t>, int64_t> PopRewards::calculatePayouts(
       endorsedBlock.getHeight(), blockScore, popDifficulty);
 
   // pay reward for each of the endorsements
-  for (const auto* e : endorsedBlock.endorsedBy) {
+  for (const auto* e : endorsedBlock.getEndorsedBy()) {
     auto* b = vbk_tree.getBlockIndex(e->blockOfProof);
     if (!vbk_tree.getBestChain().contains(b)) continue;
 
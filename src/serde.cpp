@@ -84,11 +84,40 @@ void writeSingleBEValue(WriteStream& stream, int64_t value) {
   stream.write(dataBytes);
 }
 
+size_t singleBEValueSize(int64_t value) {
+  // same trimming as in trimmedArray
+  size_t x = sizeof(int64_t);
+  while (x > 1 && (value >> ((x - 1) * 8)) == 0) {
+    x--;
+  }
+  return 1 + x;
+}
+
 void writeVarLenValue(WriteStream& stream, Slice<const uint8_t> value) {
   writeSingleBEValue(stream, value.size());
   stream.write(value);
 }
 
+void writeVarInt(WriteStream& stream, uint64_t value) {
+  while (value >= 0x80) {
+    stream.writeBE<uint8_t>((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  stream.writeBE<uint8_t>((uint8_t)value);
+}
+
+uint64_t readVarInt(ReadStream& stream) {
+  uint64_t value = 0;
+  for (size_t shift = 0; shift < 64; shift += 7) {
+    auto byte = stream.readBE<uint8_t>();
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::out_of_range("readVarInt(): value is too large");
+}
+
 NetworkBytePair readNetworkByte(ReadStream& stream, TxType type) {
   NetworkBytePair ret;
   auto networkOrType = stream.readBE<uint8_t>();
@@ -11,6 +11,7 @@
 
 #include "veriblock/arith_uint256.hpp"
 #include "veriblock/blob.hpp"
+#include "veriblock/block_interner.hpp"
 #include "veriblock/consts.hpp"
 #include "veriblock/stateless_validation.hpp"
 #include "veriblock/strutil.hpp"
@@ -157,20 +158,152 @@ bool checkBitcoinTransactionForPoPData(const VbkPopTx& tx,
   return true;
 }
 
-bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlock,
-                    ValidationState& state,
-                    const BtcChainParams& params) {
+namespace {
+
+bool checkProofOfWork(const BtcBlock& block,
+                      const uint256& hash,
+                      const BtcChainParams& param) {
+  ArithUint256 blockHash = ArithUint256::fromLEBytes(hash);
+  auto powLimit = ArithUint256(param.getPowLimit());
+  bool negative = false;
+  bool overflow = false;
+  auto target =
+      ArithUint256::fromBits(block.getDifficulty(), &negative, &overflow);
+
+  if (negative || overflow || target == 0 || target > powLimit) {
+    return false;
+  }
+
+  return !(blockHash > target);
+}
+
+bool checkProofOfWork(const VbkBlock& block,
+                      const VbkBlock::hash_t& hash,
+                      const VbkChainParams& param) {
+  static const auto max = ArithUint256::fromHex(VBK_MAXIMUM_DIFFICULTY);
+  auto blockHash = ArithUint256::fromLEBytes(hash);
+  auto minDiff = ArithUint256(param.getMinimumDifficulty());
+  bool negative = false;
+  bool overflow = false;
+  auto target =
+      ArithUint256::fromBits(block.getDifficulty(), &negative, &overflow);
+
+  if (negative || overflow || target == 0 || target < minDiff) {
+    return false;
+  }
+
+  target = max / target;
+
+  return !(blockHash > target);
+}
+
+bool checkBlock(const VbkBlock& block,
+                const VbkBlock::hash_t& hash,
+                ValidationState& state,
+                const VbkChainParams& params) {
+  if (!checkProofOfWork(block, hash, params)) {
+    return state.Invalid("vbk-bad-pow", "Invalid Block proof of work");
+  }
+
+  return true;
+}
+
+//! hashes of VBK headers, computed in one batch
+std::vector<VbkBlock::hash_t> getHashes(const std::vector<VbkBlock>& blocks) {
+  WriteStream stream(blocks.size() * VBK_HEADER_SIZE);
+  for (const auto& block : blocks) {
+    block.toRaw(stream);
+  }
+  VBK_ASSERT(stream.data().size() == blocks.size() * VBK_HEADER_SIZE);
+
+  std::vector<Slice<const uint8_t>> raw;
+  raw.reserve(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    raw.emplace_back(stream.data().data() + i * VBK_HEADER_SIZE,
+                     VBK_HEADER_SIZE);
+  }
+  std::vector<VbkBlock::hash_t> hashes(blocks.size());
+  vblakeBatch(raw, hashes);
+  return hashes;
+}
+
+//! checks BTC headers, hashes of which are computed in one batch
+struct BtcHeaderCheck {
+  explicit BtcHeaderCheck(const BtcChainParams& params) : params(params) {}
+
+  void prepare(const std::vector<BtcBlock>& blocks) {
+    WriteStream stream(blocks.size() * BTC_HEADER_SIZE);
+    for (const auto& block : blocks) {
+      block.toRaw(stream);
+    }
+    VBK_ASSERT(stream.data().size() == blocks.size() * BTC_HEADER_SIZE);
+
+    std::vector<Slice<const uint8_t>> raw;
+    raw.reserve(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+      raw.emplace_back(stream.data().data() + i * BTC_HEADER_SIZE,
+                       BTC_HEADER_SIZE);
+    }
+    hashes.resize(blocks.size());
+    sha256twiceBatch(raw, hashes);
+    for (auto& hash : hashes) {
+      hash = hash.reverse();
+    }
+  }
+
+  bool operator()(const std::vector<BtcBlock>& blocks,
+                  size_t i,
+                  uint256& hash,
+                  ValidationState& state) const {
+    hash = hashes[i];
+    if (!checkProofOfWork(blocks[i], hash, params)) {
+      return state.Invalid("btc-bad-pow", "Invalid Block proof of work");
+    }
+    return true;
+  }
+
+ private:
+  const BtcChainParams& params;
+  std::vector<uint256> hashes;
+};
+
+//! takes hash and proof of work check result of BTC header from interner
+struct InternedBtcHeaderCheck {
+  BtcBlockInterner& interner;
+
+  void prepare(const std::vector<BtcBlock>&) {}
+
+  bool operator()(const std::vector<BtcBlock>& blocks,
+                  size_t i,
+                  uint256& hash,
+                  ValidationState& state) const {
+    auto interned = interner.intern(blocks[i]);
+    if (!interned->validPow) {
+      return state.Invalid("btc-bad-pow", "Invalid Block proof of work");
+    }
+    hash = interned->hash;
+    return true;
+  }
+};
+
+template <typename HeaderCheck>
+bool checkBtcBlocksImpl(const std::vector<BtcBlock>& btcBlock,
+                        ValidationState& state,
+                        HeaderCheck check) {
   if (btcBlock.empty()) {
     return true;
   }
 
-  if (!checkBlock(btcBlock[0], state, params)) {
+  check.prepare(btcBlock);
+
+  uint256 lastHash;
+  if (!check(btcBlock, 0, lastHash, state)) {
     return state.Invalid("vbk-check-block");
   }
 
-  uint256 lastHash = btcBlock[0].getHash();
   for (size_t i = 1; i < btcBlock.size(); ++i) {
-    if (!checkBlock(btcBlock[i], state, params)) {
+    uint256 hash;
+    if (!check(btcBlock, i, hash, state)) {
       return state.Invalid("btc-check-block");
     }
 
@@ -178,11 +311,76 @@ bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlock,
     if (btcBlock[i].previousBlock != lastHash) {
       return state.Invalid("invalid-btc-block", "Blocks are not contiguous");
     }
-    lastHash = btcBlock[i].getHash();
+    lastHash = hash;
   }
   return true;
 }
 
+template <typename HeaderCheck>
+bool checkVbkPopTxImpl(const VbkPopTx& tx,
+                       ValidationState& state,
+                       const HeaderCheck& check) {
+  if (!checkSignature(tx, state)) {
+    return state.Invalid("vbk-check-signature");
+  }
+
+  if (!checkBitcoinTransactionForPoPData(tx, state)) {
+    return state.Invalid("vbk-check-btc-tx-for-pop");
+  }
+
+  if (!checkMerklePath(tx.merklePath,
+                       tx.bitcoinTransaction.getHash(),
+                       tx.blockOfProof.merkleRoot.reverse(),
+                       state)) {
+    return state.Invalid("vbk-check-merkle-path");
+  }
+
+  if (!checkBtcBlocksImpl(tx.blockOfProofContext, state, check)) {
+    return state.Invalid("vbk-check-btc-blocks");
+  }
+
+  return true;
+}
+
+template <typename HeaderCheck>
+bool checkVTBImpl(const VTB& vtb,
+                  ValidationState& state,
+                  const HeaderCheck& check) {
+  if (vtb.checked) {
+    // we've already checked that VTB
+    return true;
+  }
+
+  if (!checkVbkPopTxImpl(vtb.transaction, state, check)) {
+    return state.Invalid("vbk-check-pop-tx");
+  }
+
+  if (!checkMerklePath(vtb.merklePath,
+                       vtb.transaction.getHash(),
+                       vtb.containingBlock.merkleRoot,
+                       state)) {
+    return state.Invalid("vbk-check-merkle-path");
+  }
+
+  vtb.checked = true;
+
+  return true;
+}
+
+}  // namespace
+
+bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlock,
+                    ValidationState& state,
+                    const BtcChainParams& params) {
+  return checkBtcBlocksImpl(btcBlock, state, BtcHeaderCheck{params});
+}
+
+bool checkBtcBlocks(const std::vector<BtcBlock>& btcBlock,
+                    ValidationState& state,
+                    BtcBlockInterner& interner) {
+  return checkBtcBlocksImpl(btcBlock, state, InternedBtcHeaderCheck{interner});
+}
+
 bool checkVbkBlocks(const std::vector<VbkBlock>& vbkBlocks,
                     ValidationState& state,
                     const VbkChainParams& params) {
@@ -190,85 +388,43 @@ bool checkVbkBlocks(const std::vector<VbkBlock>& vbkBlocks,
     return true;
   }
 
-  if (!checkBlock(vbkBlocks[0], state, params)) {
+  const auto hashes = getHashes(vbkBlocks);
+  if (!checkBlock(vbkBlocks[0], hashes[0], state, params)) {
     return state.Invalid("vbk-check-block");
   }
 
-  int32_t lastHeight = vbkBlocks[0].height;
-  auto lastHash = vbkBlocks[0].getHash();
-
   for (size_t i = 1; i < vbkBlocks.size(); ++i) {
-    if (!checkBlock(vbkBlocks[i], state, params)) {
+    if (!checkBlock(vbkBlocks[i], hashes[i], state, params)) {
       return state.Invalid("vbk-check-block");
     }
 
-    if (vbkBlocks[i].height != lastHeight + 1 ||
+    if (vbkBlocks[i].height != vbkBlocks[i - 1].height + 1 ||
         vbkBlocks[i].previousBlock !=
-            lastHash.template trimLE<VBLAKE_PREVIOUS_BLOCK_HASH_SIZE>()) {
+            hashes[i - 1].template trimLE<VBLAKE_PREVIOUS_BLOCK_HASH_SIZE>()) {
       return state.Invalid("invalid-vbk-block", "Blocks are not contiguous");
     }
-    lastHeight = vbkBlocks[i].height;
-    lastHash = vbkBlocks[i].getHash();
   }
   return true;
 }
 
 bool checkProofOfWork(const BtcBlock& block, const BtcChainParams& param) {
-  ArithUint256 blockHash = ArithUint256::fromLEBytes(block.getHash());
-  auto powLimit = ArithUint256(param.getPowLimit());
-  bool negative = false;
-  bool overflow = false;
-  auto target =
-      ArithUint256::fromBits(block.getDifficulty(), &negative, &overflow);
-
-  if (negative || overflow || target == 0 || target > powLimit) {
-    return false;
-  }
-
-  return !(blockHash > target);
+  return checkProofOfWork(block, block.getHash(), param);
 }
 
 bool checkProofOfWork(const VbkBlock& block, const VbkChainParams& param) {
-  static const auto max = ArithUint256::fromHex(VBK_MAXIMUM_DIFFICULTY);
-  auto blockHash = ArithUint256::fromLEBytes(block.getHash());
-  auto minDiff = ArithUint256(param.getMinimumDifficulty());
-  bool negative = false;
-  bool overflow = false;
-  auto target =
-      ArithUint256::fromBits(block.getDifficulty(), &negative, &overflow);
-
-  if (negative || overflow || target == 0 || target < minDiff) {
-    return false;
-  }
-
-  target = max / target;
-
-  return !(blockHash > target);
+  return checkProofOfWork(block, block.getHash(), param);
 }
 
 bool checkVbkPopTx(const VbkPopTx& tx,
                    ValidationState& state,
                    const BtcChainParams& btc) {
-  if (!checkSignature(tx, state)) {
-    return state.Invalid("vbk-check-signature");
-  }
-
-  if (!checkBitcoinTransactionForPoPData(tx, state)) {
-    return state.Invalid("vbk-check-btc-tx-for-pop");
-  }
-
-  if (!checkMerklePath(tx.merklePath,
-                       tx.bitcoinTransaction.getHash(),
-                       tx.blockOfProof.merkleRoot.reverse(),
-                       state)) {
-    return state.Invalid("vbk-check-merkle-path");
-  }
-
-  if (!checkBtcBlocks(tx.blockOfProofContext, state, btc)) {
-    return state.Invalid("vbk-check-btc-blocks");
-  }
+  return checkVbkPopTxImpl(tx, state, BtcHeaderCheck{btc});
+}
 
-  return true;
+bool checkVbkPopTx(const VbkPopTx& tx,
+                   ValidationState& state,
+                   BtcBlockInterner& interner) {
+  return checkVbkPopTxImpl(tx, state, InternedBtcHeaderCheck{interner});
 }
 
 bool checkVbkTx(const VbkTx& tx, ValidationState& state) {
@@ -341,31 +497,29 @@ bool checkATV(const ATV& atv,
 bool checkVTB(const VTB& vtb,
               ValidationState& state,
               const BtcChainParams& btc) {
-  if (vtb.checked) {
-    // we've already checked that VTB
-    return true;
-  }
+  return checkVTBImpl(vtb, state, BtcHeaderCheck{btc});
+}
 
-  if (!checkVbkPopTx(vtb.transaction, state, btc)) {
-    return state.Invalid("vbk-check-pop-tx");
-  }
+bool checkVTB(const VTB& vtb,
+              ValidationState& state,
+              BtcBlockInterner& interner) {
+  return checkVTBImpl(vtb, state, InternedBtcHeaderCheck{interner});
+}
 
-  if (!checkMerklePath(vtb.merklePath,
-                       vtb.transaction.getHash(),
-                       vtb.containingBlock.merkleRoot,
-                       state)) {
-    return state.Invalid("vbk-check-merkle-path");
+bool checkBlock(const VbkBlock& block,
+                ValidationState& state,
+                const VbkChainParams& params) {
+  if (!checkProofOfWork(block, params)) {
+    return state.Invalid("vbk-bad-pow", "Invalid Block proof of work");
   }
 
-  vtb.checked = true;
-
   return true;
 }
 
 bool checkBlock(const VbkBlock& block,
                 ValidationState& state,
-                const VbkChainParams& params) {
-  if (!checkProofOfWork(block, params)) {
+                VbkBlockInterner& interner) {
+  if (!interner.intern(block)->validPow) {
     return state.Invalid("vbk-bad-pow", "Invalid Block proof of work");
   }
 
@@ -0,0 +1,128 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <veriblock/assert.hpp>
+#include <veriblock/storage/append_only_file.hpp>
+
+namespace altintegration {
+
+namespace {
+
+bool ioError(ValidationState& state,
+             const std::string& reason,
+             const std::string& path) {
+  return state.Invalid(reason, path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+AppendOnlyFile::AppendOnlyFile(std::string path) : path_(std::move(path)) {}
+
+AppendOnlyFile::~AppendOnlyFile() {
+  unmap();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool AppendOnlyFile::open(ValidationState& state) {
+  VBK_ASSERT_MSG(fd_ < 0, "%s is already opened", path_);
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd_ < 0) {
+    return ioError(state, "file-open", path_);
+  }
+
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0) {
+    return ioError(state, "file-stat", path_);
+  }
+  size_ = (uint64_t)st.st_size;
+  return map(state);
+}
+
+bool AppendOnlyFile::append(Slice<const uint8_t> bytes,
+                            ValidationState& state) {
+  VBK_ASSERT(isOpen());
+  const uint8_t* ptr = bytes.data();
+  size_t left = bytes.size();
+  while (left > 0) {
+    auto written = ::write(fd_, ptr, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ioError(state, "file-write", path_);
+    }
+    ptr += written;
+    left -= (size_t)written;
+    size_ += (uint64_t)written;
+  }
+  return map(state);
+}
+
+bool AppendOnlyFile::sync(ValidationState& state) {
+  VBK_ASSERT(isOpen());
+#if defined(__linux__)
+  int ret = ::fdatasync(fd_);
+#else
+  int ret = ::fsync(fd_);
+#endif
+  if (ret != 0) {
+    return ioError(state, "file-sync", path_);
+  }
+  return true;
+}
+
+bool AppendOnlyFile::truncate(uint64_t size, ValidationState& state) {
+  VBK_ASSERT(isOpen());
+  VBK_ASSERT(size <= size_);
+  unmap();
+  if (::ftruncate(fd_, (off_t)size) != 0) {
+    ioError(state, "file-truncate", path_);
+    // keep the old contents readable
+    ValidationState dummy;
+    map(dummy);
+    return false;
+  }
+  size_ = size;
+  return map(state);
+}
+
+bool AppendOnlyFile::map(ValidationState& state) {
+  if (mapSize_ == size_) {
+    return true;
+  }
+
+  if (size_ == 0) {
+    unmap();
+    return true;
+  }
+
+  auto* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (ptr == MAP_FAILED) {
+    return ioError(state, "file-mmap", path_);
+  }
+  unmap();
+  map_ = ptr;
+  mapSize_ = size_;
+  return true;
+}
+
+void AppendOnlyFile::unmap() {
+  if (map_ != nullptr) {
+    ::munmap(map_, mapSize_);
+    map_ = nullptr;
+    mapSize_ = 0;
+  }
+}
+
+}  // namespace altintegration
@@ -0,0 +1,263 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veriblock/logger.hpp>
+#include <veriblock/storage/file_block_storage.hpp>
+
+namespace altintegration {
+
+namespace {
+
+enum BlockRecordType : uint8_t {
+  RECORD_BTC_BLOCK = 1,
+  RECORD_VBK_BLOCK = 2,
+  RECORD_ALT_BLOCK = 3,
+  RECORD_BTC_TIP = 0x11,
+  RECORD_VBK_TIP = 0x12,
+  RECORD_ALT_TIP = 0x13,
+  RECORD_BTC_REMOVED = 0x21,
+  RECORD_VBK_REMOVED = 0x22,
+  RECORD_ALT_REMOVED = 0x23,
+  RECORD_BTC_COMMITMENT = 0x31,
+  RECORD_VBK_COMMITMENT = 0x32,
+  RECORD_ALT_COMMITMENT = 0x33,
+};
+
+bool isValidHashSize(uint8_t type, size_t size) {
+  switch (type) {
+    case RECORD_BTC_BLOCK:
+    case RECORD_BTC_TIP:
+    case RECORD_BTC_REMOVED:
+    case RECORD_BTC_COMMITMENT:
+      return size == BtcBlock::hash_t::size();
+    case RECORD_VBK_BLOCK:
+    case RECORD_VBK_TIP:
+    case RECORD_VBK_REMOVED:
+    case RECORD_VBK_COMMITMENT:
+      return size == VbkBlock::hash_t::size();
+    case RECORD_ALT_BLOCK:
+    case RECORD_ALT_TIP:
+    case RECORD_ALT_REMOVED:
+    case RECORD_ALT_COMMITMENT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool FileBlockStorage::open(ValidationState& state) {
+  if (!file_.open(state)) {
+    return false;
+  }
+
+  auto valid = scan(0);
+  committed_ = valid;
+  if (valid != file_.size()) {
+    VBK_LOG_WARN("Block log %s has %llu bytes of incomplete records, dropping",
+                 file_.path(),
+                 file_.size() - valid);
+    return file_.truncate(valid, state);
+  }
+
+  return true;
+}
+
+bool FileBlockStorage::commit(Slice<const uint8_t> records,
+                              ValidationState& state) {
+  if (records.size() == 0) {
+    return true;
+  }
+
+  // records are indexed as if they start at `committed_`, so cut off
+  // leftovers of a previously failed commit first
+  if (file_.size() != committed_ && !file_.truncate(committed_, state)) {
+    return state.Invalid("blocks-commit");
+  }
+
+  if (!file_.append(records, state) || !file_.sync(state)) {
+    ValidationState dummy;
+    if (file_.size() != committed_) {
+      file_.truncate(committed_, dummy);
+    }
+    return state.Invalid("blocks-commit");
+  }
+
+  auto end = scan(committed_);
+  VBK_ASSERT_MSG(end == file_.size(),
+                 "committed block records are malformed at offset %llu",
+                 end);
+  committed_ = end;
+  return true;
+}
+
+uint64_t FileBlockStorage::scan(uint64_t from) {
+  ReadStream stream(file_.data());
+  stream.setPosition((size_t)from);
+
+  uint64_t valid = from;
+  while (stream.remaining() > 0) {
+    ValidationState dummy;
+    uint8_t type = 0;
+    uint8_t hashSize = 0;
+    Slice<const uint8_t> hash;
+    uint32_t rawSize = 0;
+    Slice<const uint8_t> raw;
+    if (!stream.readBE<uint8_t>(type, dummy) ||
+        !stream.readBE<uint8_t>(hashSize, dummy) ||
+        !isValidHashSize(type, hashSize) ||
+        !stream.readSlice(hashSize, hash, dummy) ||
+        !stream.readBE<uint32_t>(rawSize, dummy) ||
+        !stream.readSlice(rawSize, raw, dummy)) {
+      break;
+    }
+    if (type >= RECORD_BTC_COMMITMENT && raw.size() != uint256::size()) {
+      break;
+    }
+
+    switch (type) {
+      case RECORD_BTC_BLOCK:
+        btc_[BtcBlock::hash_t(hash)] = valid;
+        break;
+      case RECORD_VBK_BLOCK:
+        vbk_[VbkBlock::hash_t(hash)] = valid;
+        break;
+      case RECORD_ALT_BLOCK:
+        alt_[hash.asVector()] = valid;
+        break;
+      case RECORD_BTC_TIP:
+        btcTip_ = hash;
+        break;
+      case RECORD_VBK_TIP:
+        vbkTip_ = hash;
+        break;
+      case RECORD_ALT_TIP:
+        altTip_ = hash.asVector();
+        break;
+      case RECORD_BTC_REMOVED:
+        btc_.erase(BtcBlock::hash_t(hash));
+        break;
+      case RECORD_VBK_REMOVED:
+        vbk_.erase(VbkBlock::hash_t(hash));
+        break;
+      case RECORD_ALT_REMOVED:
+        alt_.erase(hash.asVector());
+        break;
+      case RECORD_BTC_COMMITMENT:
+        btcCommitment_.tip = BtcBlock::hash_t(hash);
+        btcCommitment_.value = raw;
+        break;
+      case RECORD_VBK_COMMITMENT:
+        vbkCommitment_.tip = VbkBlock::hash_t(hash);
+        vbkCommitment_.value = raw;
+        break;
+      case RECORD_ALT_COMMITMENT:
+        altCommitment_.tip = hash.asVector();
+        altCommitment_.value = raw;
+        break;
+    }
+    valid = stream.position();
+  }
+
+  return valid;
+}
+
+Slice<const uint8_t> FileBlockStorage::getRecord(uint64_t offset) {
+  ReadStream stream(file_.data());
+  stream.setPosition((size_t)offset + 1);
+  auto hashSize = stream.readBE<uint8_t>();
+  stream.setPosition(stream.position() + hashSize);
+  auto rawSize = stream.readBE<uint32_t>();
+  return stream.readSlice(rawSize);
+}
+
+bool FileBlockBatch::append(uint8_t type,
+                            Slice<const uint8_t> hash,
+                            const std::vector<uint8_t>& raw) {
+  VBK_ASSERT(hash.size() <= 0xff);
+  WriteStream stream;
+  stream.writeBE<uint8_t>(type);
+  stream.writeBE<uint8_t>((uint8_t)hash.size());
+  stream.write(hash);
+  stream.writeBE<uint32_t>((uint32_t)raw.size());
+  stream.write(raw);
+  pending_.insert(pending_.end(), stream.data().begin(), stream.data().end());
+
+  if (pending_.size() >= maxBatchSize_) {
+    return commit(state_);
+  }
+  return true;
+}
+
+bool FileBlockBatch::commit(ValidationState& state) {
+  if (!storage_.commit(pending_, state)) {
+    return false;
+  }
+  pending_.clear();
+  return true;
+}
+
+bool FileBlockBatch::writeBlock(const BlockIndex<BtcBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_BTC_BLOCK, hash, value.toRaw());
+}
+
+bool FileBlockBatch::writeBlock(const BlockIndex<VbkBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_VBK_BLOCK, hash, value.toRaw());
+}
+
+bool FileBlockBatch::writeBlock(const BlockIndex<AltBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_ALT_BLOCK, hash, value.toRaw());
+}
+
+bool FileBlockBatch::writeTip(const BlockIndex<BtcBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_BTC_TIP, hash, {});
+}
+
+bool FileBlockBatch::writeTip(const BlockIndex<VbkBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_VBK_TIP, hash, {});
+}
+
+bool FileBlockBatch::writeTip(const BlockIndex<AltBlock>& value) {
+  auto hash = value.getHash();
+  return append(RECORD_ALT_TIP, hash, {});
+}
+
+bool FileBlockBatch::removeBlock(const BtcBlock::hash_t& hash) {
+  return append(RECORD_BTC_REMOVED, hash, {});
+}
+
+bool FileBlockBatch::removeBlock(const VbkBlock::hash_t& hash) {
+  return append(RECORD_VBK_REMOVED, hash, {});
+}
+
+bool FileBlockBatch::removeBlock(const AltBlock::hash_t& hash) {
+  return append(RECORD_ALT_REMOVED, hash, {});
+}
+
+bool FileBlockBatch::writeCommitment(const BlockIndex<BtcBlock>& tip,
+                                     const uint256& commitment) {
+  auto hash = tip.getHash();
+  return append(RECORD_BTC_COMMITMENT, hash, commitment.asVector());
+}
+
+bool FileBlockBatch::writeCommitment(const BlockIndex<VbkBlock>& tip,
+                                     const uint256& commitment) {
+  auto hash = tip.getHash();
+  return append(RECORD_VBK_COMMITMENT, hash, commitment.asVector());
+}
+
+bool FileBlockBatch::writeCommitment(const BlockIndex<AltBlock>& tip,
+                                     const uint256& commitment) {
+  auto hash = tip.getHash();
+  return append(RECORD_ALT_COMMITMENT, hash, commitment.asVector());
+}
+
+}  // namespace altintegration
@@ -0,0 +1,228 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veriblock/logger.hpp>
+#include <veriblock/storage/mmap_payloads_provider.hpp>
+
+namespace altintegration {
+
+namespace {
+
+template <typename T>
+struct PayloadRecord;
+
+template <>
+struct PayloadRecord<VbkBlock> {
+  static const uint8_t type = 1;
+};
+
+template <>
+struct PayloadRecord<VTB> {
+  static const uint8_t type = 2;
+};
+
+template <>
+struct PayloadRecord<ATV> {
+  static const uint8_t type = 3;
+};
+
+template <typename T>
+size_t idSize() {
+  return typename T::id_t().size();
+}
+
+}  // namespace
+
+template <>
+MmapPayloadsProvider::index_t<ATV>& MmapPayloadsProvider::getIndex<ATV>() {
+  return atvs_;
+}
+template <>
+MmapPayloadsProvider::index_t<VTB>& MmapPayloadsProvider::getIndex<VTB>() {
+  return vtbs_;
+}
+template <>
+MmapPayloadsProvider::index_t<VbkBlock>&
+MmapPayloadsProvider::getIndex<VbkBlock>() {
+  return vbkblocks_;
+}
+
+template <typename T>
+void MmapPayloadsProvider::append(const T& payload) {
+  auto id = payload.getId();
+  auto& index = getIndex<T>();
+  if (index.count(id) > 0) {
+    return;
+  }
+
+  WriteStream stream;
+  stream.writeBE<uint8_t>(PayloadRecord<T>::type);
+  stream.write(id);
+  auto encoded = payload.toVbkEncoding();
+  stream.writeBE<uint32_t>((uint32_t)encoded.size());
+  stream.write(encoded);
+
+  index[id] = size();
+  pending_.insert(pending_.end(), stream.data().begin(), stream.data().end());
+}
+
+void MmapPayloadsProvider::write(const ATV& atv) {
+  append(atv);
+  append(atv.blockOfProof);
+}
+
+void MmapPayloadsProvider::write(const VTB& vtb) {
+  append(vtb);
+  append(vtb.containingBlock);
+}
+
+void MmapPayloadsProvider::write(const VbkBlock& block) { append(block); }
+
+bool MmapPayloadsProvider::open(ValidationState& state) {
+  if (!file_.open(state)) {
+    return false;
+  }
+
+  ReadStream stream(file_.data());
+  uint64_t valid = 0;
+  while (stream.remaining() > 0) {
+    ValidationState dummy;
+    uint8_t type = 0;
+    if (!stream.readBE<uint8_t>(type, dummy)) {
+      break;
+    }
+
+    size_t size = 0;
+    switch (type) {
+      case PayloadRecord<VbkBlock>::type:
+        size = idSize<VbkBlock>();
+        break;
+      case PayloadRecord<VTB>::type:
+        size = idSize<VTB>();
+        break;
+      case PayloadRecord<ATV>::type:
+        size = idSize<ATV>();
+        break;
+      default:
+        break;
+    }
+
+    Slice<const uint8_t> id;
+    uint32_t payloadSize = 0;
+    Slice<const uint8_t> payload;
+    if (size == 0 || !stream.readSlice(size, id, dummy) ||
+        !stream.readBE<uint32_t>(payloadSize, dummy) ||
+        !stream.readSlice(payloadSize, payload, dummy)) {
+      break;
+    }
+
+    switch (type) {
+      case PayloadRecord<VbkBlock>::type:
+        vbkblocks_.insert({VbkBlock::id_t(id), valid});
+        break;
+      case PayloadRecord<VTB>::type:
+        vtbs_.insert({VTB::id_t(id), valid});
+        break;
+      case PayloadRecord<ATV>::type:
+        atvs_.insert({ATV::id_t(id), valid});
+        break;
+    }
+    valid = stream.position();
+  }
+
+  if (valid != file_.size()) {
+    VBK_LOG_WARN("Payload log %s has %llu bytes of incomplete records, dropping",
+                 file_.path(),
+                 file_.size() - valid);
+    if (!file_.truncate(valid, state)) {
+      return false;
+    }
+  }
+
+  committed_ = valid;
+  return true;
+}
+
+bool MmapPayloadsProvider::flush(ValidationState& state) {
+  if (pending_.empty()) {
+    return true;
+  }
+
+  // buffered records are indexed as if they start at `committed_`, so cut off
+  // leftovers of a previously failed flush first
+  if (file_.size() != committed_ && !file_.truncate(committed_, state)) {
+    return state.Invalid("payloads-flush");
+  }
+
+  if (!file_.append(pending_, state) || !file_.sync(state)) {
+    ValidationState dummy;
+    if (file_.size() != committed_) {
+      file_.truncate(committed_, dummy);
+    }
+    return state.Invalid("payloads-flush");
+  }
+
+  committed_ = file_.size();
+  pending_.clear();
+  return true;
+}
+
+Slice<const uint8_t> MmapPayloadsProvider::getRecord(uint64_t offset,
+                                                     size_t idSize) {
+  Slice<const uint8_t> data;
+  if (offset < committed_) {
+    data = file_.data();
+  } else {
+    data = pending_;
+    offset -= committed_;
+  }
+
+  ReadStream stream(data);
+  stream.setPosition((size_t)offset + 1 + idSize);
+  auto payloadSize = stream.readBE<uint32_t>();
+  return stream.readSlice(payloadSize);
+}
+
+template <typename T, typename View>
+bool MmapPayloadsProvider::getViews(const std::vector<typename T::id_t>& ids,
+                                    std::vector<View>& out,
+                                    ValidationState& state) {
+  auto& index = getIndex<T>();
+  std::vector<View> ret(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    auto it = index.find(ids[i]);
+    if (it == index.end()) {
+      return state.Invalid(T::name() + "-not-found", HexStr(ids[i]));
+    }
+
+    ReadStream stream(getRecord(it->second, idSize<T>()));
+    if (!Deserialize(stream, ret[i], state)) {
+      return state.Invalid(T::name() + "-bad-record", HexStr(ids[i]));
+    }
+  }
+
+  out = std::move(ret);
+  return true;
+}
+
+bool MmapPayloadsProvider::getATVViews(const std::vector<ATV::id_t>& ids,
+                                       std::vector<ATVView>& out,
+                                       ValidationState& state) {
+  return getViews<ATV>(ids, out, state);
+}
+
+bool MmapPayloadsProvider::getVTBViews(const std::vector<VTB::id_t>& ids,
+                                       std::vector<VTBView>& out,
+                                       ValidationState& state) {
+  return getViews<VTB>(ids, out, state);
+}
+
+bool MmapPayloadsProvider::getVBKs(const std::vector<VbkBlock::id_t>& ids,
+                                   std::vector<VbkBlock>& out,
+                                   ValidationState& state) {
+  return getViews<VbkBlock>(ids, out, state);
+}
+
+}  // namespace altintegration
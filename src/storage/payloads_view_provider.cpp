@@ -0,0 +1,98 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <veriblock/blockchain/alt_block_tree.hpp>
+#include <veriblock/storage/payloads_view_provider.hpp>
+
+namespace altintegration {
+
+namespace {
+
+template <typename T, typename View>
+bool materializeAll(const std::vector<View>& views,
+                    std::vector<T>& out,
+                    ValidationState& state) {
+  std::vector<T> ret(views.size());
+  for (size_t i = 0; i < views.size(); i++) {
+    if (!views[i].materialize(ret[i], state)) {
+      return state.Invalid("payloads-bad-view", i);
+    }
+  }
+  out = std::move(ret);
+  return true;
+}
+
+}  // namespace
+
+bool PayloadsViewProvider::getATVs(const std::vector<ATV::id_t>& ids,
+                                   std::vector<ATV>& out,
+                                   ValidationState& state) {
+  std::vector<ATVView> views;
+  if (!getATVViews(ids, views, state)) {
+    return false;
+  }
+  return materializeAll(views, out, state);
+}
+
+bool PayloadsViewProvider::getVTBs(const std::vector<VTB::id_t>& ids,
+                                   std::vector<VTB>& out,
+                                   ValidationState& state) {
+  std::vector<VTBView> views;
+  if (!getVTBViews(ids, views, state)) {
+    return false;
+  }
+  return materializeAll(views, out, state);
+}
+
+bool PayloadsViewProvider::getCommands(AltBlockTree& tree,
+                                       const BlockIndex<AltBlock>& block,
+                                       std::vector<CommandGroup>& out,
+                                       ValidationState& state) {
+  std::vector<ATVView> atvs;
+  atvs.reserve(block.getPayloadIds<ATV>().size());
+  std::vector<VTBView> vtbs;
+  vtbs.reserve(block.getPayloadIds<VTB>().size());
+  std::vector<VbkBlock> vbks;
+  vbks.reserve(block.getPayloadIds<VbkBlock>().size());
+
+  if (!getVBKs(block.getPayloadIds<VbkBlock>(), vbks, state)) {
+    return false;
+  }
+  if (!getVTBViews(block.getPayloadIds<VTB>(), vtbs, state)) {
+    return false;
+  }
+  if (!getATVViews(block.getPayloadIds<ATV>(), atvs, state)) {
+    return false;
+  }
+
+  auto containingHash = block.getHash();
+  vectorPopToCommandGroup<AltBlockTree, VbkBlock>(
+      tree, vbks, containingHash, out);
+  vectorPopToCommandGroup<AltBlockTree, VTBView>(
+      tree, vtbs, containingHash, out);
+  vectorPopToCommandGroup<AltBlockTree, ATVView>(
+      tree, atvs, containingHash, out);
+
+  return true;
+}
+
+bool PayloadsViewProvider::getCommands(VbkBlockTree& tree,
+                                       const BlockIndex<VbkBlock>& block,
+                                       std::vector<CommandGroup>& out,
+                                       ValidationState& state) {
+  std::vector<VTBView> vtbs;
+  vtbs.reserve(block.getPayloadIds<VTB>().size());
+
+  if (!getVTBViews(block.getPayloadIds<VTB>(), vtbs, state)) {
+    return false;
+  }
+
+  auto containingHash = block.getHash().asVector();
+  vectorPopToCommandGroup<VbkBlockTree, VTBView>(
+      tree, vtbs, containingHash, out);
+
+  return true;
+}
+
+}  // namespace altintegration
@@ -2,6 +2,7 @@
 // https://www.veriblock.org
 // Distributed under the MIT software license, see the accompanying
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <future>
 #include <veriblock/blockchain/alt_block_tree.hpp>
 #include <veriblock/storage/util.hpp>
 
@@ -13,4 +14,137 @@ void SaveAllTrees(AltBlockTree& tree, BlockBatchAdaptor& batch) {
   SaveTree(tree, batch);
 }
 
-}  // namespace altintegration
\ No newline at end of file
+void SaveAllTreesCommitments(const AltBlockTree& tree,
+                             BlockBatchAdaptor& batch,
+                             Slice<const uint8_t> key) {
+  SaveTreeCommitment(tree.btc(), batch, key);
+  SaveTreeCommitment(tree.vbk(), batch, key);
+  SaveTreeCommitment(tree, batch, key);
+}
+
+namespace {
+
+//! decoded blocks of a single tree
+template <typename BlockTreeT>
+struct DecodedTree {
+  std::vector<typename BlockTreeT::index_t> blocks;
+  std::vector<bool> trusted;
+};
+
+//! connects `decoded` blocks to `tree`, while `next` tree blocks are being
+//! decoded
+template <typename TreeA, typename TreeB>
+bool linkAndDecodeNext(
+    TreeA& tree,
+    const DecodedTree<TreeA>& decoded,
+    const typename TreeA::hash_t& tip,
+    const TreeB& next,
+    BlockCursor& nextCursor,
+    const TreeCommitment<typename TreeB::block_t>& nextCommitment,
+    Slice<const uint8_t> key,
+    DecodedTree<TreeB>& nextDecoded,
+    ValidationState& state,
+    size_t threads) {
+  ValidationState nextState;
+  auto decoding = std::async(std::launch::async, [&]() {
+    return DecodeLoadedBlocks(next,
+                              nextCursor,
+                              nextCommitment,
+                              key,
+                              nextDecoded.blocks,
+                              nextDecoded.trusted,
+                              nextState,
+                              threads);
+  });
+
+  bool linked =
+      LinkLoadedBlocks(tree, decoded.blocks, tip, state, decoded.trusted);
+  // always wait for decoding, as it references local variables
+  bool isNextDecoded = decoding.get();
+  if (!linked) {
+    return false;
+  }
+  if (!isNextDecoded) {
+    state = nextState;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool LoadAllTrees(AltBlockTree& tree,
+                  BlockCursor& btc,
+                  BlockCursor& vbk,
+                  BlockCursor& alt,
+                  const BtcBlock::hash_t& btcTip,
+                  const VbkBlock::hash_t& vbkTip,
+                  const AltBlock::hash_t& altTip,
+                  ValidationState& state,
+                  size_t threads) {
+  // without a key no blocks are trusted, so all blocks are validated
+  return LoadAllTrees(tree,
+                      btc,
+                      vbk,
+                      alt,
+                      btcTip,
+                      vbkTip,
+                      altTip,
+                      TreeCommitment<BtcBlock>(),
+                      TreeCommitment<VbkBlock>(),
+                      TreeCommitment<AltBlock>(),
+                      {},
+                      state,
+                      threads);
+}
+
+bool LoadAllTrees(AltBlockTree& tree,
+                  BlockCursor& btc,
+                  BlockCursor& vbk,
+                  BlockCursor& alt,
+                  const BtcBlock::hash_t& btcTip,
+                  const VbkBlock::hash_t& vbkTip,
+                  const AltBlock::hash_t& altTip,
+                  const TreeCommitment<BtcBlock>& btcCommitment,
+                  const TreeCommitment<VbkBlock>& vbkCommitment,
+                  const TreeCommitment<AltBlock>& altCommitment,
+                  Slice<const uint8_t> key,
+                  ValidationState& state,
+                  size_t threads) {
+  DecodedTree<VbkBlockTree::BtcTree> btcblocks;
+  DecodedTree<VbkBlockTree> vbkblocks;
+  DecodedTree<AltBlockTree> altblocks;
+
+  return DecodeLoadedBlocks(tree.btc(),
+                            btc,
+                            btcCommitment,
+                            key,
+                            btcblocks.blocks,
+                            btcblocks.trusted,
+                            state,
+                            threads) &&
+         linkAndDecodeNext(tree.btc(),
+                           btcblocks,
+                           btcTip,
+                           tree.vbk(),
+                           vbk,
+                           vbkCommitment,
+                           key,
+                           vbkblocks,
+                           state,
+                           threads) &&
+         linkAndDecodeNext(tree.vbk(),
+                           vbkblocks,
+                           vbkTip,
+                           static_cast<const AltBlockTree&>(tree),
+                           alt,
+                           altCommitment,
+                           key,
+                           altblocks,
+                           state,
+                           threads) &&
+         LinkLoadedBlocks(
+             tree, altblocks.blocks, altTip, state, altblocks.trusted);
+}
+
+}  // namespace altintegration
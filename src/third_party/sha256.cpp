@@ -33,6 +33,18 @@
 #include <string.h>
 #include <veriblock/third_party/sha256.h>
 
+#include <atomic>
+
+#include "cpu_features.hpp"
+#include "sha256_backends.hpp"
+
+#if defined(VBK_SHA256_ARMV8) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#endif
+
 /*
  * 32-bit integer manipulation macros (big endian)
  */
@@ -75,7 +87,20 @@ void sha256_init(sha256_context *ctx) {
   ctx->state[7] = 0x5BE0CD19;
 }
 
-static void sha2_process(sha256_context *ctx, const unsigned char data[64]) {
+const uint32_t sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1,
+    0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786,
+    0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147,
+    0x06CA6351, 0x14292967, 0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B,
+    0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A,
+    0x5B9CCA4F, 0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
+
+static void sha2_process(uint32_t state[8], const unsigned char data[64]) {
   unsigned long temp1, temp2, W[64];
   unsigned long A, B, C, D, E, F, G, H;
 
@@ -118,14 +143,14 @@ static void sha2_process(sha256_context *ctx, const unsigned char data[64]) {
     h = temp1 + temp2;                       \
   }
 
-  A = ctx->state[0];
-  B = ctx->state[1];
-  C = ctx->state[2];
-  D = ctx->state[3];
-  E = ctx->state[4];
-  F = ctx->state[5];
-  G = ctx->state[6];
-  H = ctx->state[7];
+  A = state[0];
+  B = state[1];
+  C = state[2];
+  D = state[3];
+  E = state[4];
+  F = state[5];
+  G = state[6];
+  H = state[7];
 
   P(A, B, C, D, E, F, G, H, W[0], 0x428A2F98);
   P(H, A, B, C, D, E, F, G, W[1], 0x71374491);
@@ -192,14 +217,107 @@ static void sha2_process(sha256_context *ctx, const unsigned char data[64]) {
   P(C, D, E, F, G, H, A, B, R(62), 0xBEF9A3F7);
   P(B, C, D, E, F, G, H, A, R(63), 0xC67178F2);
 
-  ctx->state[0] += A;
-  ctx->state[1] += B;
-  ctx->state[2] += C;
-  ctx->state[3] += D;
-  ctx->state[4] += E;
-  ctx->state[5] += F;
-  ctx->state[6] += G;
-  ctx->state[7] += H;
+  state[0] += A;
+  state[1] += B;
+  state[2] += C;
+  state[3] += D;
+  state[4] += E;
+  state[5] += F;
+  state[6] += G;
+  state[7] += H;
+}
+
+static void sha256_transform_portable(uint32_t state[8],
+                                      const uint8_t *data,
+                                      size_t blocks) {
+  for (; blocks > 0; --blocks, data += 64) {
+    sha2_process(state, data);
+  }
+}
+
+static sha256_transform_t sha256_transform_of(sha256_backend backend) {
+  switch (backend) {
+#ifdef VBK_SHA256_SHANI
+    case SHA256_BACKEND_SHANI:
+      return sha256_transform_shani;
+#endif
+#ifdef VBK_SHA256_ARMV8
+    case SHA256_BACKEND_ARMV8:
+      return sha256_transform_armv8;
+#endif
+    default:
+      return sha256_transform_portable;
+  }
+}
+
+int sha256_backend_supported(sha256_backend backend) {
+  switch (backend) {
+    case SHA256_BACKEND_PORTABLE:
+      return 1;
+#ifdef VBK_SHA256_SHANI
+    case SHA256_BACKEND_SHANI:
+      return cpuHasShaNi() ? 1 : 0;
+#endif
+#ifdef VBK_SHA256_ARMV8
+    case SHA256_BACKEND_ARMV8:
+#if defined(__APPLE__)
+      return 1;
+#elif defined(__linux__)
+      return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0 ? 1 : 0;
+#else
+      return 0;
+#endif
+#endif
+    default:
+      return 0;
+  }
+}
+
+const char *sha256_backend_name(sha256_backend backend) {
+  switch (backend) {
+    case SHA256_BACKEND_PORTABLE:
+      return "portable";
+    case SHA256_BACKEND_SHANI:
+      return "shani";
+    case SHA256_BACKEND_ARMV8:
+      return "armv8";
+  }
+  return "unknown";
+}
+
+static sha256_backend sha256_detect_backend() {
+  if (sha256_backend_supported(SHA256_BACKEND_SHANI)) {
+    return SHA256_BACKEND_SHANI;
+  }
+  if (sha256_backend_supported(SHA256_BACKEND_ARMV8)) {
+    return SHA256_BACKEND_ARMV8;
+  }
+  return SHA256_BACKEND_PORTABLE;
+}
+
+// selected on first use, so hashing during static initialization works
+static std::atomic<sha256_backend> &sha256_current_backend() {
+  static std::atomic<sha256_backend> backend{sha256_detect_backend()};
+  return backend;
+}
+
+static std::atomic<sha256_transform_t> &sha256_current_transform() {
+  static std::atomic<sha256_transform_t> transform{
+      sha256_transform_of(sha256_current_backend().load())};
+  return transform;
+}
+
+sha256_backend sha256_get_backend(void) {
+  return sha256_current_backend().load();
+}
+
+int sha256_set_backend(sha256_backend backend) {
+  if (!sha256_backend_supported(backend)) {
+    return 0;
+  }
+  sha256_current_backend().store(backend);
+  sha256_current_transform().store(sha256_transform_of(backend));
+  return 1;
 }
 
 /*
@@ -221,18 +339,21 @@ void sha256_update(sha256_context *ctx,
 
   if (ctx->total[0] < (unsigned long)ilen) ctx->total[1]++;
 
+  const sha256_transform_t transform = sha256_current_transform().load();
+
   if (left && ilen >= fill) {
     memcpy((void *)(ctx->buffer + left), (void *)input, fill);
-    sha2_process(ctx, ctx->buffer);
+    transform(ctx->state, ctx->buffer, 1);
     input += fill;
     ilen -= fill;
     left = 0;
   }
 
-  while (ilen >= 64) {
-    sha2_process(ctx, input);
-    input += 64;
-    ilen -= 64;
+  if (ilen >= 64) {
+    const uint32_t blocks = ilen / 64;
+    transform(ctx->state, input, blocks);
+    input += 64 * blocks;
+    ilen -= 64 * blocks;
   }
 
   if (ilen > 0) {
@@ -290,4 +411,127 @@ void sha256(unsigned char output[32],
   memset(&ctx, 0, sizeof(sha256_context));
 }
 
+static sha256_batch_t sha256_batch_of(sha256_batch_backend backend) {
+  switch (backend) {
+#ifdef VBK_SHA256_SSE2
+    case SHA256_BATCH_SSE2:
+      return sha256_batch_sse2;
+#endif
+#ifdef VBK_SHA256_AVX2
+    case SHA256_BATCH_AVX2:
+      return sha256_batch_avx2;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+static size_t sha256_batch_lanes(sha256_batch_backend backend) {
+  switch (backend) {
+    case SHA256_BATCH_SSE2:
+      return 4;
+    case SHA256_BATCH_AVX2:
+      return 8;
+    default:
+      return 1;
+  }
+}
+
+int sha256_batch_backend_supported(sha256_batch_backend backend) {
+  switch (backend) {
+    case SHA256_BATCH_SINGLE:
+      return 1;
+#ifdef VBK_SHA256_SSE2
+    case SHA256_BATCH_SSE2:
+      // part of x86-64
+      return 1;
+#endif
+#ifdef VBK_SHA256_AVX2
+    case SHA256_BATCH_AVX2:
+      return cpuHasAvx2() ? 1 : 0;
+#endif
+    default:
+      return 0;
+  }
+}
+
+const char *sha256_batch_backend_name(sha256_batch_backend backend) {
+  switch (backend) {
+    case SHA256_BATCH_SINGLE:
+      return "single";
+    case SHA256_BATCH_SSE2:
+      return "sse2";
+    case SHA256_BATCH_AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+static sha256_batch_backend sha256_detect_batch_backend() {
+  // hardware SHA-256 of a single message is faster than SIMD lanes
+  if (sha256_get_backend() != SHA256_BACKEND_PORTABLE) {
+    return SHA256_BATCH_SINGLE;
+  }
+  if (sha256_batch_backend_supported(SHA256_BATCH_AVX2)) {
+    return SHA256_BATCH_AVX2;
+  }
+  if (sha256_batch_backend_supported(SHA256_BATCH_SSE2)) {
+    return SHA256_BATCH_SSE2;
+  }
+  return SHA256_BATCH_SINGLE;
+}
+
+static std::atomic<sha256_batch_backend> &sha256_current_batch_backend() {
+  static std::atomic<sha256_batch_backend> backend{
+      sha256_detect_batch_backend()};
+  return backend;
+}
+
+sha256_batch_backend sha256_get_batch_backend(void) {
+  return sha256_current_batch_backend().load();
+}
+
+int sha256_set_batch_backend(sha256_batch_backend backend) {
+  if (!sha256_batch_backend_supported(backend)) {
+    return 0;
+  }
+  sha256_current_batch_backend().store(backend);
+  return 1;
+}
+
+/*
+ * output[i] = SHA-256( input[i] )
+ */
+void sha256_batch(uint8_t *out,
+                  const uint8_t *const *in,
+                  size_t n,
+                  uint32_t ilen) {
+  const sha256_batch_backend backend = sha256_get_batch_backend();
+  const sha256_batch_t batch = sha256_batch_of(backend);
+  const size_t lanes = sha256_batch_lanes(backend);
+
+  size_t i = 0;
+  if (batch != nullptr) {
+    for (; i + lanes <= n; i += lanes) {
+      batch(out + 32 * i, in + i, ilen);
+    }
+
+    // fill unused lanes of the last batch with copies of the first message
+    if (n - i > 1) {
+      const uint8_t *last[8];
+      uint8_t hashes[8 * 32];
+      for (size_t l = 0; l < lanes; l++) {
+        last[l] = i + l < n ? in[i + l] : in[i];
+      }
+      batch(hashes, last, ilen);
+      memcpy(out + 32 * i, hashes, 32 * (n - i));
+      i = n;
+    }
+  }
+
+  for (; i < n; i++) {
+    sha256(out + 32 * i, in[i], ilen);
+  }
+}
+
 }  // namespace altintegration
@@ -0,0 +1,56 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// SHA-256 block compression with ARMv8 crypto extensions. This file is
+// compiled with -march=armv8-a+crypto, and is called only when CPU supports
+// SHA2 instructions.
+
+#include <arm_neon.h>
+
+#include "sha256_backends.hpp"
+
+namespace altintegration {
+
+void sha256_transform_armv8(uint32_t state[8],
+                            const uint8_t* data,
+                            size_t blocks) {
+  uint32x4_t state0 = vld1q_u32(&state[0]);
+  uint32x4_t state1 = vld1q_u32(&state[4]);
+
+  for (; blocks > 0; --blocks, data += 64) {
+    const uint32x4_t abcd = state0;
+    const uint32x4_t efgh = state1;
+
+    // big endian words
+    uint32x4_t m[4];
+    for (size_t i = 0; i < 4; i++) {
+      m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+    }
+
+    // rounds 4g..4g+3, message words of group g+4 are computed in place of
+    // words of group g
+    for (size_t g = 0; g < 16; g++) {
+      uint32x4_t& w = m[g % 4];
+      const uint32x4_t k = vaddq_u32(w, vld1q_u32(&sha256_k[4 * g]));
+      if (g < 12) {
+        w = vsha256su0q_u32(w, m[(g + 1) % 4]);
+      }
+      const uint32x4_t s = state0;
+      state0 = vsha256hq_u32(state0, state1, k);
+      state1 = vsha256h2q_u32(state1, s, k);
+      if (g < 12) {
+        w = vsha256su1q_u32(w, m[(g + 2) % 4], m[(g + 3) % 4]);
+      }
+    }
+
+    state0 = vaddq_u32(state0, abcd);
+    state1 = vaddq_u32(state1, efgh);
+  }
+
+  vst1q_u32(&state[0], state0);
+  vst1q_u32(&state[4], state1);
+}
+
+}  // namespace altintegration
@@ -0,0 +1,50 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// 8-way SHA-256 with AVX2. This file is compiled with -mavx2, and is called
+// only when CPU and OS support AVX2.
+
+#include <immintrin.h>
+
+#include "sha256_multiway.hpp"
+
+namespace altintegration {
+
+namespace {
+
+struct Avx2 {
+  using vec = __m256i;
+  static const size_t lanes = 8;
+
+  static vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+  static vec bxor(vec a, vec b) { return _mm256_xor_si256(a, b); }
+  static vec band(vec a, vec b) { return _mm256_and_si256(a, b); }
+  static vec bor(vec a, vec b) { return _mm256_or_si256(a, b); }
+  template <int n>
+  static vec srl(vec a) {
+    return _mm256_srli_epi32(a, n);
+  }
+  template <int n>
+  static vec sll(vec a) {
+    return _mm256_slli_epi32(a, n);
+  }
+  static vec set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+  static vec load(const uint32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void store(uint32_t* p, vec a) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+  }
+};
+
+}  // namespace
+
+void sha256_batch_avx2(uint8_t* out,
+                       const uint8_t* const* in,
+                       uint32_t ilen) {
+  Sha256Multiway<Avx2>::hash(out, in, ilen);
+}
+
+}  // namespace altintegration
@@ -0,0 +1,53 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_BACKENDS_HPP
+#define ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_BACKENDS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace altintegration {
+
+//! SHA-256 round constants
+extern const uint32_t sha256_k[64];
+
+//! compresses `blocks` consecutive 64-byte blocks of `data` into `state`
+typedef void (*sha256_transform_t)(uint32_t state[8],
+                                   const uint8_t *data,
+                                   size_t blocks);
+
+#ifdef VBK_SHA256_SHANI
+//! x86-64 SHA extensions, requires SSE4.1 and SHA CPU features
+void sha256_transform_shani(uint32_t state[8],
+                            const uint8_t *data,
+                            size_t blocks);
+#endif
+
+#ifdef VBK_SHA256_ARMV8
+//! ARMv8 crypto extensions, requires SHA2 CPU feature
+void sha256_transform_armv8(uint32_t state[8],
+                            const uint8_t *data,
+                            size_t blocks);
+#endif
+
+//! hashes a fixed number of messages of `ilen` bytes each into `out`
+typedef void (*sha256_batch_t)(uint8_t *out,
+                               const uint8_t *const *in,
+                               uint32_t ilen);
+
+#ifdef VBK_SHA256_SSE2
+//! 4 messages, x86-64 SSE2
+void sha256_batch_sse2(uint8_t *out, const uint8_t *const *in, uint32_t ilen);
+#endif
+
+#ifdef VBK_SHA256_AVX2
+//! 8 messages, x86-64 AVX2, requires AVX2 CPU feature and OS support of AVX
+void sha256_batch_avx2(uint8_t *out, const uint8_t *const *in, uint32_t ilen);
+#endif
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_BACKENDS_HPP
@@ -0,0 +1,167 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_MULTIWAY_HPP
+#define ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_MULTIWAY_HPP
+
+#include <string.h>
+
+#include "sha256_backends.hpp"
+
+namespace altintegration {
+
+// Included only by translation units, which are compiled with flags of their
+// SIMD instruction set, so everything here has internal linkage.
+namespace {
+
+/**
+ * SHA-256 of `V::lanes` independent messages of the same size, one message
+ * per SIMD lane.
+ *
+ * `V` provides vector type `vec` of `lanes` 32-bit words and operations on
+ * it: add, bxor, band, bor, srl<n>, sll<n>, set1, load and store.
+ */
+template <typename V>
+struct Sha256Multiway {
+  using vec = typename V::vec;
+  static const size_t lanes = V::lanes;
+
+  static void hash(uint8_t *out, const uint8_t *const *in, uint32_t ilen) {
+    // every message has the same padding, so tails of all messages occupy
+    // the same number of blocks
+    const size_t full = ilen / 64;
+    const size_t tail = ilen % 64;
+    const size_t tailBlocks = tail < 56 ? 1 : 2;
+    uint8_t tails[lanes][128];
+    for (size_t l = 0; l < lanes; l++) {
+      memset(tails[l], 0, sizeof(tails[l]));
+      memcpy(tails[l], in[l] + 64 * full, tail);
+      tails[l][tail] = 0x80;
+      const uint64_t bits = (uint64_t)ilen * 8;
+      uint8_t *len = tails[l] + 64 * tailBlocks - 8;
+      for (size_t i = 0; i < 8; i++) {
+        len[i] = (uint8_t)(bits >> (56 - 8 * i));
+      }
+    }
+
+    vec state[8];
+    static const uint32_t init[8] = {0x6A09E667,
+                                     0xBB67AE85,
+                                     0x3C6EF372,
+                                     0xA54FF53A,
+                                     0x510E527F,
+                                     0x9B05688C,
+                                     0x1F83D9AB,
+                                     0x5BE0CD19};
+    for (size_t i = 0; i < 8; i++) {
+      state[i] = V::set1(init[i]);
+    }
+
+    const uint8_t *blocks[lanes];
+    for (size_t b = 0; b < full + tailBlocks; b++) {
+      for (size_t l = 0; l < lanes; l++) {
+        blocks[l] = b < full ? in[l] + 64 * b : tails[l] + 64 * (b - full);
+      }
+      transform(state, blocks);
+    }
+
+    uint32_t words[lanes];
+    for (size_t i = 0; i < 8; i++) {
+      V::store(words, state[i]);
+      for (size_t l = 0; l < lanes; l++) {
+        uint8_t *o = out + 32 * l + 4 * i;
+        o[0] = (uint8_t)(words[l] >> 24);
+        o[1] = (uint8_t)(words[l] >> 16);
+        o[2] = (uint8_t)(words[l] >> 8);
+        o[3] = (uint8_t)words[l];
+      }
+    }
+  }
+
+ private:
+  template <int n>
+  static vec rotr(vec x) {
+    return V::bor(V::template srl<n>(x), V::template sll<32 - n>(x));
+  }
+
+  static vec ch(vec x, vec y, vec z) {
+    return V::bxor(z, V::band(x, V::bxor(y, z)));
+  }
+
+  static vec maj(vec x, vec y, vec z) {
+    return V::bor(V::band(x, y), V::band(z, V::bor(x, y)));
+  }
+
+  static vec bigSigma0(vec x) {
+    return V::bxor(V::bxor(rotr<2>(x), rotr<13>(x)), rotr<22>(x));
+  }
+
+  static vec bigSigma1(vec x) {
+    return V::bxor(V::bxor(rotr<6>(x), rotr<11>(x)), rotr<25>(x));
+  }
+
+  static vec sigma0(vec x) {
+    return V::bxor(V::bxor(rotr<7>(x), rotr<18>(x)), V::template srl<3>(x));
+  }
+
+  static vec sigma1(vec x) {
+    return V::bxor(V::bxor(rotr<17>(x), rotr<19>(x)),
+                   V::template srl<10>(x));
+  }
+
+  // big endian word `i` of every lane's block
+  static vec word(const uint8_t *const *blocks, size_t i) {
+    uint32_t words[lanes];
+    for (size_t l = 0; l < lanes; l++) {
+      const uint8_t *p = blocks[l] + 4 * i;
+      words[l] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                 ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+    return V::load(words);
+  }
+
+  static void transform(vec state[8], const uint8_t *const *blocks) {
+    vec w[16];
+    for (size_t i = 0; i < 16; i++) {
+      w[i] = word(blocks, i);
+    }
+
+    vec a = state[0], b = state[1], c = state[2], d = state[3];
+    vec e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t t = 0; t < 64; t++) {
+      if (t >= 16) {
+        w[t % 16] = V::add(V::add(sigma1(w[(t - 2) % 16]), w[(t - 7) % 16]),
+                           V::add(sigma0(w[(t - 15) % 16]), w[t % 16]));
+      }
+      vec t1 = V::add(V::add(h, bigSigma1(e)),
+                      V::add(ch(e, f, g),
+                             V::add(V::set1(sha256_k[t]), w[t % 16])));
+      vec t2 = V::add(bigSigma0(a), maj(a, b, c));
+      h = g;
+      g = f;
+      f = e;
+      e = V::add(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = V::add(t1, t2);
+    }
+
+    state[0] = V::add(state[0], a);
+    state[1] = V::add(state[1], b);
+    state[2] = V::add(state[2], c);
+    state[3] = V::add(state[3], d);
+    state[4] = V::add(state[4], e);
+    state[5] = V::add(state[5], f);
+    state[6] = V::add(state[6], g);
+    state[7] = V::add(state[7], h);
+  }
+};
+
+}  // namespace
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_SRC_THIRD_PARTY_SHA256_MULTIWAY_HPP
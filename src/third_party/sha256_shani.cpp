@@ -0,0 +1,114 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// SHA-256 block compression with x86-64 SHA extensions. This file is compiled
+// with -msse4.1 -msha, and is called only when CPU supports these features.
+
+#include <immintrin.h>
+
+#include "sha256_backends.hpp"
+
+namespace altintegration {
+
+namespace {
+
+//! rounds 4g..4g+3 with message words `m`
+inline void quadRound(__m128i& state0,
+                      __m128i& state1,
+                      __m128i m,
+                      size_t g) {
+  __m128i msg = _mm_add_epi32(
+      m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&sha256_k[4 * g])));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0E);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+}
+
+//! finishes message words of next group: `next` is already passed through
+//! sha256msg1, `m` and `prev` are words of current and previous groups
+inline __m128i schedule(__m128i next, __m128i m, __m128i prev) {
+  return _mm_sha256msg2_epu32(
+      _mm_add_epi32(next, _mm_alignr_epi8(m, prev, 4)), m);
+}
+
+inline __m128i load(const uint8_t* data, __m128i mask) {
+  return _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), mask);
+}
+
+}  // namespace
+
+void sha256_transform_shani(uint32_t state[8],
+                            const uint8_t* data,
+                            size_t blocks) {
+  // big endian words
+  const __m128i mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // state is kept as ABEF and CDGH
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+  __m128i state1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);
+  state1 = _mm_shuffle_epi32(state1, 0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  for (; blocks > 0; --blocks, data += 64) {
+    const __m128i abef = state0;
+    const __m128i cdgh = state1;
+
+    __m128i m0 = load(data, mask);
+    __m128i m1 = load(data + 16, mask);
+    __m128i m2 = load(data + 32, mask);
+    __m128i m3 = load(data + 48, mask);
+
+    quadRound(state0, state1, m0, 0);
+    quadRound(state0, state1, m1, 1);
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+    quadRound(state0, state1, m2, 2);
+    m1 = _mm_sha256msg1_epu32(m1, m2);
+    quadRound(state0, state1, m3, 3);
+    m0 = schedule(m0, m3, m2);
+    m2 = _mm_sha256msg1_epu32(m2, m3);
+
+    for (size_t g = 4; g < 12; g += 4) {
+      quadRound(state0, state1, m0, g);
+      m1 = schedule(m1, m0, m3);
+      m3 = _mm_sha256msg1_epu32(m3, m0);
+      quadRound(state0, state1, m1, g + 1);
+      m2 = schedule(m2, m1, m0);
+      m0 = _mm_sha256msg1_epu32(m0, m1);
+      quadRound(state0, state1, m2, g + 2);
+      m3 = schedule(m3, m2, m1);
+      m1 = _mm_sha256msg1_epu32(m1, m2);
+      quadRound(state0, state1, m3, g + 3);
+      m0 = schedule(m0, m3, m2);
+      m2 = _mm_sha256msg1_epu32(m2, m3);
+    }
+
+    quadRound(state0, state1, m0, 12);
+    m1 = schedule(m1, m0, m3);
+    m3 = _mm_sha256msg1_epu32(m3, m0);
+    quadRound(state0, state1, m1, 13);
+    m2 = schedule(m2, m1, m0);
+    quadRound(state0, state1, m2, 14);
+    m3 = schedule(m3, m2, m1);
+    quadRound(state0, state1, m3, 15);
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  // back to ABCD and EFGH
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+}  // namespace altintegration
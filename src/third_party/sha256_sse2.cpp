@@ -0,0 +1,49 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// 4-way SHA-256 with SSE2, which every x86-64 CPU supports.
+
+#include <emmintrin.h>
+
+#include "sha256_multiway.hpp"
+
+namespace altintegration {
+
+namespace {
+
+struct Sse2 {
+  using vec = __m128i;
+  static const size_t lanes = 4;
+
+  static vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+  static vec bxor(vec a, vec b) { return _mm_xor_si128(a, b); }
+  static vec band(vec a, vec b) { return _mm_and_si128(a, b); }
+  static vec bor(vec a, vec b) { return _mm_or_si128(a, b); }
+  template <int n>
+  static vec srl(vec a) {
+    return _mm_srli_epi32(a, n);
+  }
+  template <int n>
+  static vec sll(vec a) {
+    return _mm_slli_epi32(a, n);
+  }
+  static vec set1(uint32_t x) { return _mm_set1_epi32((int)x); }
+  static vec load(const uint32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  static void store(uint32_t* p, vec a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+  }
+};
+
+}  // namespace
+
+void sha256_batch_sse2(uint8_t* out,
+                       const uint8_t* const* in,
+                       uint32_t ilen) {
+  Sha256Multiway<Sse2>::hash(out, in, ilen);
+}
+
+}  // namespace altintegration
@@ -0,0 +1,87 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "veriblock/thread_pool.hpp"
+
+namespace altintegration {
+
+ThreadPool::ThreadPool(size_t workers) { reserve(workers); }
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    hasTasks_.notify_all();
+  }
+  for (auto& w : workers_) {
+    w.join();
+  }
+}
+
+void ThreadPool::reserve(size_t workers) {
+  std::lock_guard<std::mutex> serial(runMutex_);
+  while (workers_.size() < workers) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+void ThreadPool::run(size_t tasks, const std::function<void(size_t)>& task) {
+  std::lock_guard<std::mutex> serial(runMutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  tasks_ = tasks;
+  next_ = 0;
+  hasTasks_.notify_all();
+
+  while (runNext(lock)) {
+  }
+  finished_.wait(lock, [&] { return running_ == 0; });
+  task_ = nullptr;
+
+  if (error_ != nullptr) {
+    std::exception_ptr error;
+    std::swap(error, error_);
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    if (!runNext(lock)) {
+      hasTasks_.wait(lock);
+    }
+  }
+}
+
+bool ThreadPool::runNext(std::unique_lock<std::mutex>& lock) {
+  if (task_ == nullptr || next_ >= tasks_) {
+    return false;
+  }
+
+  // `run` waits for running tasks, so `task` outlives this call
+  const auto& task = *task_;
+  const size_t i = next_++;
+  ++running_;
+  lock.unlock();
+
+  std::exception_ptr error;
+  try {
+    task(i);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  lock.lock();
+  if (error != nullptr && error_ == nullptr) {
+    error_ = error;
+  }
+  if (--running_ == 0) {
+    finished_.notify_all();
+  }
+  return true;
+}
+
+}  // namespace altintegration
@@ -3,33 +3,32 @@
 // Distributed under the MIT software license, see the accompanying
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 
-// A simple vblake Reference Implementation.
+// vBlake: 16 rounds of Blake2b G function with VeriBlock constants over a
+// single 64-byte block.
 
 #include <veriblock/vblake.h>
 
-#include <cstdio>
+#include <atomic>
 #include <cstring>
 
-#ifndef _countof
-#define _countof(x) (sizeof(x) / sizeof((x)[0]))
-#endif
+#include "cpu_features.hpp"
+#include "vblake_backends.hpp"
 
 namespace altintegration {
 //==========================================================================================
 //                      CONSTS
 //==========================================================================================
 
-static const uint64_t cnt_vblake_iv = 8;
-static const uint64_t vblake_iv[cnt_vblake_iv] = {0x4BBF42C1F006AD9DL,
-                                                  0x5D11A8C3B5AEB12EL,
-                                                  0xA64AB78DC2774652L,
-                                                  0xC67595724658F253L,
-                                                  0xB8864E79CB891E56L,
-                                                  0x12ED593E29FB41A1L,
-                                                  0xB1DA3AB63C60BAA8L,
-                                                  0x6D20E50C1F954DEDL};
-
-static const uint8_t sigma[16][16] = {
+const uint64_t vblake_iv[8] = {0x4BBF42C1F006AD9DL,
+                               0x5D11A8C3B5AEB12EL,
+                               0xA64AB78DC2774652L,
+                               0xC67595724658F253L,
+                               0xB8864E79CB891E56L,
+                               0x12ED593E29FB41A1L,
+                               0xB1DA3AB63C60BAA8L,
+                               0x6D20E50C1F954DEDL};
+
+const uint8_t vblake_sigma[16][16] = {
     {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
     {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
     {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
@@ -47,22 +46,22 @@ static const uint8_t sigma[16][16] = {
     {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
     {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9}};
 
-static const uint64_t vblake_c[] = {0xA51B6A89D489E800L,
-                                    0xD35B2E0E0B723800L,
-                                    0xA47B39A2AE9F9000L,
-                                    0x0C0EFA33E77E6488L,
-                                    0x4F452FEC309911EBL,
-                                    0x3CFCC66F74E1022CL,
-                                    0x4606AD364DC879DDL,
-                                    0xBBA055B53D47C800L,
-                                    0x531655D90C59EB1BL,
-                                    0xD1A00BA6DAE5B800L,
-                                    0x2FE452DA9632463EL,
-                                    0x98A7B5496226F800L,
-                                    0xBAFCD004F92CA000L,
-                                    0x64A39957839525E7L,
-                                    0xD859E6F081AAE000L,
-                                    0x63D980597B560E6BL};
+const uint64_t vblake_c[16] = {0xA51B6A89D489E800L,
+                               0xD35B2E0E0B723800L,
+                               0xA47B39A2AE9F9000L,
+                               0x0C0EFA33E77E6488L,
+                               0x4F452FEC309911EBL,
+                               0x3CFCC66F74E1022CL,
+                               0x4606AD364DC879DDL,
+                               0xBBA055B53D47C800L,
+                               0x531655D90C59EB1BL,
+                               0xD1A00BA6DAE5B800L,
+                               0x2FE452DA9632463EL,
+                               0x98A7B5496226F800L,
+                               0xBAFCD004F92CA000L,
+                               0x64A39957839525E7L,
+                               0xD859E6F081AAE000L,
+                               0x63D980597B560E6BL};
 
 //==========================================================================================
 //                                  TOOLS
@@ -71,190 +70,136 @@ static const uint64_t vblake_c[] = {0xA51B6A89D489E800L,
 /**
  * Rotate x, a 64-bit long, to the right by y places
  */
-static inline uint64_t vblake_ROTR64(uint64_t x, uint64_t y) {
-  return (((x) >> (y)) ^ ((x) << (64 - (y))));
+static inline uint64_t vblake_ROTR64(uint64_t x, unsigned y) {
+  return (x >> y) | (x << (64 - y));
+}
+
+static inline uint64_t vblake_load64(const uint8_t *p) {
+  return ((uint64_t)p[0] << 0u) | ((uint64_t)p[1] << 8u) |
+         ((uint64_t)p[2] << 16u) | ((uint64_t)p[3] << 24u) |
+         ((uint64_t)p[4] << 32u) | ((uint64_t)p[5] << 40u) |
+         ((uint64_t)p[6] << 48u) | ((uint64_t)p[7] << 56u);
 }
 
 //
-// The G Mixing function from the Blake2 specification.
+// The G Mixing function from the Blake2 specification. x and y are message
+// words xored with their constants.
 //
-static void vblake_B2B_G(uint64_t *v,
-                         uint32_t a,
-                         uint32_t b,
-                         uint32_t c,
-                         uint32_t d,
-                         uint64_t x,
-                         uint64_t y,
-                         uint64_t c1,
-                         uint64_t c2) {
-  v[a] = v[a] + v[b] + (x ^ c1);
-  v[d] ^= v[a];
-  v[d] = vblake_ROTR64(v[d], 60);
-  v[c] = v[c] + v[d];
-  v[b] = vblake_ROTR64(v[b] ^ v[c], 43);
-  v[a] = v[a] + v[b] + (y ^ c2);
-  v[d] = vblake_ROTR64(v[d] ^ v[a], 5);
-  v[c] = v[c] + v[d];
-  v[b] = vblake_ROTR64(v[b] ^ v[c], 18);
-
-  // X'Y'Z' + X'YZ + XY'Z + XYZ'    LUT: 10010110
-  v[d] ^= (~v[a] & ~v[b] & ~v[c]) | (~v[a] & v[b] & v[c]) |
-          (v[a] & ~v[b] & v[c]) | (v[a] & v[b] & ~v[c]);
-
-  // X'Y'Z + X'YZ' + XY'Z' + XYZ    LUT: 01101001
-  v[d] ^= (~v[a] & ~v[b] & v[c]) | (~v[a] & v[b] & ~v[c]) |
-          (v[a] & ~v[b] & ~v[c]) | (v[a] & v[b] & v[c]);
-}
+// Reference implementation ends G with
+//   v[d] ^= (~v[a] & ~v[b] & ~v[c]) | (~v[a] & v[b] & v[c]) |
+//           (v[a] & ~v[b] & v[c]) | (v[a] & v[b] & ~v[c]);
+//   v[d] ^= (~v[a] & ~v[b] & v[c]) | (~v[a] & v[b] & ~v[c]) |
+//           (v[a] & ~v[b] & ~v[c]) | (v[a] & v[b] & v[c]);
+// First function is ~(a ^ b ^ c), second is a ^ b ^ c, so together they
+// flip all bits of v[d].
+//
+#define VBLAKE_G(a, b, c, d, x, y) \
+  do {                             \
+    a = a + b + (x);               \
+    d = vblake_ROTR64(d ^ a, 60);  \
+    c = c + d;                     \
+    b = vblake_ROTR64(b ^ c, 43);  \
+    a = a + b + (y);               \
+    d = vblake_ROTR64(d ^ a, 5);   \
+    c = c + d;                     \
+    b = vblake_ROTR64(b ^ c, 18);  \
+    d = ~d;                        \
+  } while (0)
+
+// message word of round r, xored with its constant
+#define VBLAKE_M(r, i) mc[vblake_sigma[r][i]]
+
+#define VBLAKE_ROUND(r)                                           \
+  do {                                                            \
+    VBLAKE_G(v0, v4, v8, v12, VBLAKE_M(r, 1), VBLAKE_M(r, 0));    \
+    VBLAKE_G(v1, v5, v9, v13, VBLAKE_M(r, 3), VBLAKE_M(r, 2));    \
+    VBLAKE_G(v2, v6, v10, v14, VBLAKE_M(r, 5), VBLAKE_M(r, 4));   \
+    VBLAKE_G(v3, v7, v11, v15, VBLAKE_M(r, 7), VBLAKE_M(r, 6));   \
+    VBLAKE_G(v0, v5, v10, v15, VBLAKE_M(r, 9), VBLAKE_M(r, 8));   \
+    VBLAKE_G(v1, v6, v11, v12, VBLAKE_M(r, 11), VBLAKE_M(r, 10)); \
+    VBLAKE_G(v2, v7, v8, v13, VBLAKE_M(r, 13), VBLAKE_M(r, 12));  \
+    VBLAKE_G(v3, v4, v9, v14, VBLAKE_M(r, 15), VBLAKE_M(r, 14));  \
+  } while (0)
 
 //==========================================================================================
 //                       WORK UNITS
 //==========================================================================================
 
 //
-// Compression function. "last" flag indicates last block.
+// Compression function of the only, last block.
 //
-static void vblake_compress(vblake_ctx *ctx) {
-  uint64_t i;
-  static const uint64_t kNumOfRounds = 16;
-  uint64_t v[kNumOfRounds] = {};
-  uint64_t m[kNumOfRounds] = {};
-
-  // init work variables
-  for (i = 0; i < 8; i++) {
-    v[i] = ctx->h[i];
-    v[i + 8] = vblake_iv[i];
+static void vblake_compress(uint64_t h[8], const uint8_t b[64]) {
+  uint64_t mc[16];
+  for (int i = 0; i < 8; i++) {
+    mc[i] = vblake_load64(b + 8 * i) ^ vblake_c[i];
   }
-
-  v[12] ^= 64;          // Input count low
-  v[13] ^= 0;           // Input count high (no overflow, therefore 0)
-  v[14] ^= (long)(-1);  // f[0] = 0xFF..FF
-  v[15] ^= 0;           // f[1] = 0x00..00
-
-  for (i = 0; i < 8; i++) {
-    m[i] = ((uint64_t)(ctx->b[i * 8u + 7u] & 0xFFu) << 56u) ^
-           ((uint64_t)(ctx->b[i * 8u + 6u] & 0xFFu) << 48u) ^
-           ((uint64_t)(ctx->b[i * 8u + 5u] & 0xFFu) << 40u) ^
-           ((uint64_t)(ctx->b[i * 8u + 4u] & 0xFFu) << 32u) ^
-           ((uint64_t)(ctx->b[i * 8u + 3u] & 0xFFu) << 24u) ^
-           ((uint64_t)(ctx->b[i * 8u + 2u] & 0xFFu) << 16u) ^
-           ((uint64_t)(ctx->b[i * 8u + 1u] & 0xFFu) << 8u) ^
-           ((uint64_t)(ctx->b[i * 8u + 0u] & 0xFFu) << 0u);
+  for (int i = 8; i < 16; i++) {
+    // message words 8..15 are always zero
+    mc[i] = vblake_c[i];
   }
 
+  uint64_t v0 = h[0], v1 = h[1], v2 = h[2], v3 = h[3];
+  uint64_t v4 = h[4], v5 = h[5], v6 = h[6], v7 = h[7];
+  uint64_t v8 = vblake_iv[0], v9 = vblake_iv[1], v10 = vblake_iv[2],
+           v11 = vblake_iv[3];
+  uint64_t v12 = vblake_iv[4] ^ 64;  // Input count low
+  uint64_t v13 = vblake_iv[5];       // Input count high (no overflow)
+  uint64_t v14 = ~vblake_iv[6];      // f[0] = 0xFF..FF
+  uint64_t v15 = vblake_iv[7];       // f[1] = 0x00..00
+
   // Using 16 rounds of the Blake2 G function, drawing on the additional 4 rows
   // of sigma from reference BLAKE implementation
-
-  for (i = 0; i < kNumOfRounds; i++) {
-    vblake_B2B_G(v,
-                 0,
-                 4,
-                 8,
-                 12,
-                 m[sigma[i][1]],
-                 m[sigma[i][0]],
-                 vblake_c[sigma[i][1]],
-                 vblake_c[sigma[i][0]]);
-    vblake_B2B_G(v,
-                 1,
-                 5,
-                 9,
-                 13,
-                 m[sigma[i][3]],
-                 m[sigma[i][2]],
-                 vblake_c[sigma[i][3]],
-                 vblake_c[sigma[i][2]]);
-    vblake_B2B_G(v,
-                 2,
-                 6,
-                 10,
-                 14,
-                 m[sigma[i][5]],
-                 m[sigma[i][4]],
-                 vblake_c[sigma[i][5]],
-                 vblake_c[sigma[i][4]]);
-    vblake_B2B_G(v,
-                 3,
-                 7,
-                 11,
-                 15,
-                 m[sigma[i][7]],
-                 m[sigma[i][6]],
-                 vblake_c[sigma[i][7]],
-                 vblake_c[sigma[i][6]]);
-    vblake_B2B_G(v,
-                 0,
-                 5,
-                 10,
-                 15,
-                 m[sigma[i][9]],
-                 m[sigma[i][8]],
-                 vblake_c[sigma[i][9]],
-                 vblake_c[sigma[i][8]]);
-    vblake_B2B_G(v,
-                 1,
-                 6,
-                 11,
-                 12,
-                 m[sigma[i][11]],
-                 m[sigma[i][10]],
-                 vblake_c[sigma[i][11]],
-                 vblake_c[sigma[i][10]]);
-    vblake_B2B_G(v,
-                 2,
-                 7,
-                 8,
-                 13,
-                 m[sigma[i][13]],
-                 m[sigma[i][12]],
-                 vblake_c[sigma[i][13]],
-                 vblake_c[sigma[i][12]]);
-    vblake_B2B_G(v,
-                 3,
-                 4,
-                 9,
-                 14,
-                 m[sigma[i][15]],
-                 m[sigma[i][14]],
-                 vblake_c[sigma[i][15]],
-                 vblake_c[sigma[i][14]]);
-  }
+  VBLAKE_ROUND(0);
+  VBLAKE_ROUND(1);
+  VBLAKE_ROUND(2);
+  VBLAKE_ROUND(3);
+  VBLAKE_ROUND(4);
+  VBLAKE_ROUND(5);
+  VBLAKE_ROUND(6);
+  VBLAKE_ROUND(7);
+  VBLAKE_ROUND(8);
+  VBLAKE_ROUND(9);
+  VBLAKE_ROUND(10);
+  VBLAKE_ROUND(11);
+  VBLAKE_ROUND(12);
+  VBLAKE_ROUND(13);
+  VBLAKE_ROUND(14);
+  VBLAKE_ROUND(15);
 
   // Update h[0 .. 7]
-  for (i = 0; i < 8; ++i) {
-    ctx->h[i] ^= v[i] ^ v[i + 8];
-  }
-
-  ctx->h[0] ^= ctx->h[3] ^ ctx->h[6];
-  ctx->h[1] ^= ctx->h[4] ^ ctx->h[7];
-  ctx->h[2] ^= ctx->h[5];
+  h[0] ^= v0 ^ v8;
+  h[1] ^= v1 ^ v9;
+  h[2] ^= v2 ^ v10;
+  h[3] ^= v3 ^ v11;
+  h[4] ^= v4 ^ v12;
+  h[5] ^= v5 ^ v13;
+  h[6] ^= v6 ^ v14;
+  h[7] ^= v7 ^ v15;
+
+  h[0] ^= h[3] ^ h[6];
+  h[1] ^= h[4] ^ h[7];
+  h[2] ^= h[5];
 }
 
-static inline void vblake_create_ctx(vblake_ctx *ctx) {
-  uint64_t i = 0;
-
+static void vblake_init_h(uint64_t h[8]) {
   // state, "param block"
-  for (i = 0; i < _countof(ctx->h); i++) {
-    ctx->h[i] = vblake_iv[i];
-  }
-  ctx->h[0] ^= 0x01010000u ^ VBLAKE_HASH_SIZE;
-
-  // zero input block
-  for (i = 0; i < _countof(ctx->b); i++) {
-    ctx->b[i] = 0;
+  for (int i = 0; i < 8; i++) {
+    h[i] = vblake_iv[i];
   }
+  h[0] ^= 0x01010000u ^ VBLAKE_HASH_SIZE;
 }
 
-static void vblake_recombineB2Bh(vblake_ctx *ctx, void *out) {
+static void vblake_recombineB2Bh(const uint64_t h[8], void *out) {
   auto *output = (uint8_t *)out;
   for (int i = 0; i < 3; i++) {
-    output[i * 8u + 0u] = (ctx->h[i] >> 0u) & 0xFFu;
-    output[i * 8u + 1u] = (ctx->h[i] >> 8u) & 0xFFu;
-    output[i * 8u + 2u] = (ctx->h[i] >> 16u) & 0xFFu;
-    output[i * 8u + 3u] = (ctx->h[i] >> 24u) & 0xFFu;
-    output[i * 8u + 4u] = (ctx->h[i] >> 32u) & 0xFFu;
-    output[i * 8u + 5u] = (ctx->h[i] >> 40u) & 0xFFu;
-    output[i * 8u + 6u] = (ctx->h[i] >> 48u) & 0xFFu;
-    output[i * 8u + 7u] = (ctx->h[i] >> 56u) & 0xFFu;
+    output[i * 8u + 0u] = (h[i] >> 0u) & 0xFFu;
+    output[i * 8u + 1u] = (h[i] >> 8u) & 0xFFu;
+    output[i * 8u + 2u] = (h[i] >> 16u) & 0xFFu;
+    output[i * 8u + 3u] = (h[i] >> 24u) & 0xFFu;
+    output[i * 8u + 4u] = (h[i] >> 32u) & 0xFFu;
+    output[i * 8u + 5u] = (h[i] >> 40u) & 0xFFu;
+    output[i * 8u + 6u] = (h[i] >> 48u) & 0xFFu;
+    output[i * 8u + 7u] = (h[i] >> 56u) & 0xFFu;
   }
 }
 
@@ -264,7 +209,11 @@ static void vblake_recombineB2Bh(vblake_ctx *ctx, void *out) {
 //
 // Initialize the hashing context "ctx"
 //
-void vblake_init(vblake_ctx *ctx) { vblake_create_ctx(ctx); }
+void vblake_init(vblake_ctx *ctx) {
+  vblake_init_h(ctx->h);
+  // zero input block
+  memset(ctx->b, 0, sizeof(ctx->b));
+}
 
 //
 // Add "inlen" bytes from "in" into the hash.
@@ -275,11 +224,10 @@ int vblake_update(vblake_ctx *ctx, const void *in, size_t inlen)  // data bytes
     return -1;
   }
 
-  auto *input = (uint8_t *)in;
-  for (size_t i = 0; i < inlen; ++i) {
-    ctx->b[i] = input[i];
+  if (inlen > 0) {
+    memcpy(ctx->b, in, inlen);
   }
-  vblake_compress(ctx);
+  vblake_compress(ctx->h, ctx->b);
   return 0;
 }
 
@@ -288,19 +236,126 @@ int vblake_update(vblake_ctx *ctx, const void *in, size_t inlen)  // data bytes
 //      Result placed in "out".
 //
 void vblake_final(vblake_ctx *ctx, void *out) {
-  vblake_recombineB2Bh(ctx, out);
+  vblake_recombineB2Bh(ctx->h, out);
 }
 
 //
 // Convenience function for all-in-one computation.
 //
 int vblake(void *out, const void *in, size_t inlen) {
-  vblake_ctx ctx;
-  vblake_init(&ctx);
-  if (-1 == vblake_update(&ctx, in, inlen)) {
+  if (inlen > 64) {
+    return -1;
+  }
+
+  uint8_t b[64] = {};
+  if (inlen > 0) {
+    memcpy(b, in, inlen);
+  }
+  uint64_t h[8];
+  vblake_init_h(h);
+  vblake_compress(h, b);
+  vblake_recombineB2Bh(h, out);
+  return 0;
+}
+
+//==========================================================================================
+//                      BATCH
+//==========================================================================================
+
+static vblake_batch_t vblake_batch_of(vblake_batch_backend backend) {
+  switch (backend) {
+#ifdef VBK_VBLAKE_AVX2
+    case VBLAKE_BATCH_AVX2:
+      return vblake_batch_avx2;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+int vblake_batch_backend_supported(vblake_batch_backend backend) {
+  switch (backend) {
+    case VBLAKE_BATCH_SINGLE:
+      return 1;
+#ifdef VBK_VBLAKE_AVX2
+    case VBLAKE_BATCH_AVX2:
+      return cpuHasAvx2() ? 1 : 0;
+#endif
+    default:
+      return 0;
+  }
+}
+
+const char *vblake_batch_backend_name(vblake_batch_backend backend) {
+  switch (backend) {
+    case VBLAKE_BATCH_SINGLE:
+      return "single";
+    case VBLAKE_BATCH_AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+static vblake_batch_backend vblake_detect_batch_backend() {
+  if (vblake_batch_backend_supported(VBLAKE_BATCH_AVX2)) {
+    return VBLAKE_BATCH_AVX2;
+  }
+  return VBLAKE_BATCH_SINGLE;
+}
+
+// selected on first use, so hashing during static initialization works
+static std::atomic<vblake_batch_backend> &vblake_current_batch_backend() {
+  static std::atomic<vblake_batch_backend> backend{
+      vblake_detect_batch_backend()};
+  return backend;
+}
+
+vblake_batch_backend vblake_get_batch_backend(void) {
+  return vblake_current_batch_backend().load();
+}
+
+int vblake_set_batch_backend(vblake_batch_backend backend) {
+  if (!vblake_batch_backend_supported(backend)) {
+    return 0;
+  }
+  vblake_current_batch_backend().store(backend);
+  return 1;
+}
+
+int vblake_batch(void *out,
+                 const uint8_t *const *in,
+                 size_t n,
+                 size_t inlen) {
+  if (inlen > 64) {
     return -1;
   }
-  vblake_final(&ctx, out);
+
+  auto *output = (uint8_t *)out;
+  const vblake_batch_t batch = vblake_batch_of(vblake_get_batch_backend());
+  const size_t lanes = 4;
+
+  size_t i = 0;
+  if (batch != nullptr) {
+    for (; i + lanes <= n; i += lanes) {
+      batch(output + VBLAKE_HASH_SIZE * i, in + i, inlen);
+    }
+
+    // fill unused lanes of the last batch with copies of the first message
+    if (n - i > 1) {
+      const uint8_t *last[lanes];
+      uint8_t hashes[lanes * VBLAKE_HASH_SIZE];
+      for (size_t l = 0; l < lanes; l++) {
+        last[l] = i + l < n ? in[i + l] : in[i];
+      }
+      batch(hashes, last, inlen);
+      memcpy(output + VBLAKE_HASH_SIZE * i, hashes, VBLAKE_HASH_SIZE * (n - i));
+      i = n;
+    }
+  }
+
+  for (; i < n; i++) {
+    vblake(output + VBLAKE_HASH_SIZE * i, in[i], inlen);
+  }
   return 0;
 }
 
@@ -0,0 +1,132 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// 4-way vBlake with AVX2, one message per 64-bit lane. This file is compiled
+// with -mavx2, and is called only when CPU and OS support AVX2.
+
+#include <immintrin.h>
+#include <string.h>
+#include <veriblock/vblake.h>
+
+#include "vblake_backends.hpp"
+
+namespace altintegration {
+
+namespace {
+
+template <int n>
+inline __m256i rotr(__m256i x) {
+  return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n));
+}
+
+inline __m256i add(__m256i a, __m256i b) { return _mm256_add_epi64(a, b); }
+
+inline __m256i bxor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+
+inline __m256i set1(uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+
+inline uint64_t load64(const uint8_t* p) {
+  uint64_t x = 0;
+  for (int i = 7; i >= 0; i--) {
+    x = (x << 8) | p[i];
+  }
+  return x;
+}
+
+// same as scalar vBlake G, see vblake.cpp
+inline void g(__m256i& a,
+              __m256i& b,
+              __m256i& c,
+              __m256i& d,
+              __m256i x,
+              __m256i y) {
+  const __m256i ones = _mm256_set1_epi64x(-1);
+  a = add(add(a, b), x);
+  d = rotr<60>(bxor(d, a));
+  c = add(c, d);
+  b = rotr<43>(bxor(b, c));
+  a = add(add(a, b), y);
+  d = rotr<5>(bxor(d, a));
+  c = add(c, d);
+  b = rotr<18>(bxor(b, c));
+  d = bxor(d, ones);
+}
+
+}  // namespace
+
+void vblake_batch_avx2(uint8_t* out,
+                       const uint8_t* const* in,
+                       size_t inlen) {
+  // zero padded blocks
+  uint8_t blocks[4][64];
+  for (size_t l = 0; l < 4; l++) {
+    memset(blocks[l], 0, sizeof(blocks[l]));
+    if (inlen > 0) {
+      memcpy(blocks[l], in[l], inlen);
+    }
+  }
+
+  __m256i mc[16];
+  for (int i = 0; i < 8; i++) {
+    mc[i] = bxor(_mm256_set_epi64x((long long)load64(blocks[3] + 8 * i),
+                                   (long long)load64(blocks[2] + 8 * i),
+                                   (long long)load64(blocks[1] + 8 * i),
+                                   (long long)load64(blocks[0] + 8 * i)),
+                 set1(vblake_c[i]));
+  }
+  for (int i = 8; i < 16; i++) {
+    // message words 8..15 are always zero
+    mc[i] = set1(vblake_c[i]);
+  }
+
+  uint64_t h0[8];
+  for (int i = 0; i < 8; i++) {
+    h0[i] = vblake_iv[i];
+  }
+  h0[0] ^= 0x01010000u ^ VBLAKE_HASH_SIZE;
+
+  __m256i v[16];
+  for (int i = 0; i < 8; i++) {
+    v[i] = set1(h0[i]);
+    v[i + 8] = set1(vblake_iv[i]);
+  }
+  v[12] = set1(vblake_iv[4] ^ 64);  // Input count low
+  v[14] = set1(~vblake_iv[6]);      // f[0] = 0xFF..FF
+
+  for (int r = 0; r < 16; r++) {
+    const uint8_t* s = vblake_sigma[r];
+    g(v[0], v[4], v[8], v[12], mc[s[1]], mc[s[0]]);
+    g(v[1], v[5], v[9], v[13], mc[s[3]], mc[s[2]]);
+    g(v[2], v[6], v[10], v[14], mc[s[5]], mc[s[4]]);
+    g(v[3], v[7], v[11], v[15], mc[s[7]], mc[s[6]]);
+    g(v[0], v[5], v[10], v[15], mc[s[9]], mc[s[8]]);
+    g(v[1], v[6], v[11], v[12], mc[s[11]], mc[s[10]]);
+    g(v[2], v[7], v[8], v[13], mc[s[13]], mc[s[12]]);
+    g(v[3], v[4], v[9], v[14], mc[s[15]], mc[s[14]]);
+  }
+
+  // only h[0..2] are part of the hash
+  __m256i h[3];
+  for (int i = 0; i < 3; i++) {
+    const __m256i hi = bxor(set1(h0[i]), bxor(v[i], v[i + 8]));
+    const __m256i hj = bxor(set1(h0[i + 3]), bxor(v[i + 3], v[i + 11]));
+    h[i] = bxor(hi, hj);
+    if (i < 2) {
+      h[i] = bxor(h[i], bxor(set1(h0[i + 6]), bxor(v[i + 6], v[i + 14])));
+    }
+  }
+
+  uint64_t words[4];
+  for (int i = 0; i < 3; i++) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), h[i]);
+    for (size_t l = 0; l < 4; l++) {
+      for (int j = 0; j < 8; j++) {
+        out[VBLAKE_HASH_SIZE * l + 8 * i + j] = (uint8_t)(words[l] >> (8 * j));
+      }
+    }
+  }
+}
+
+}  // namespace altintegration
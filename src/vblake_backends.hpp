@@ -0,0 +1,33 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef ALT_INTEGRATION_SRC_VBLAKE_BACKENDS_HPP
+#define ALT_INTEGRATION_SRC_VBLAKE_BACKENDS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace altintegration {
+
+//! vBlake initialization vector
+extern const uint64_t vblake_iv[8];
+//! vBlake message word permutations of every round
+extern const uint8_t vblake_sigma[16][16];
+//! vBlake constants, which are xored with message words
+extern const uint64_t vblake_c[16];
+
+//! hashes a fixed number of messages of `inlen` (at most 64) bytes into `out`
+typedef void (*vblake_batch_t)(uint8_t *out,
+                               const uint8_t *const *in,
+                               size_t inlen);
+
+#ifdef VBK_VBLAKE_AVX2
+//! 4 messages, x86-64 AVX2, requires AVX2 CPU feature and OS support of AVX
+void vblake_batch_avx2(uint8_t *out, const uint8_t *const *in, size_t inlen);
+#endif
+
+}  // namespace altintegration
+
+#endif  // ALT_INTEGRATION_SRC_VBLAKE_BACKENDS_HPP
@@ -142,7 +142,38 @@ TYPED_TEST_P(TempBlockTreeTest, scenario_2) {
   EXPECT_FALSE(areOnSameChain(*fork2, *fork1, this->temp_block_tree));
 }
 
-REGISTER_TYPED_TEST_SUITE_P(TempBlockTreeTest, scenario_1, scenario_2);
+TYPED_TEST_P(TempBlockTreeTest, scenario_3) {
+  using block_t = typename TypeParam::block_t;
+
+  auto block1 = mineBlock<block_t>(*this->popminer);
+  auto block2 = mineBlock<block_t>(*this->popminer);
+
+  // block2 does not connect until block1 is accepted
+  EXPECT_FALSE(this->temp_block_tree.acceptBlock(block2, this->state));
+  EXPECT_EQ(this->state.GetPath(), block_t::name() + "-bad-prev-block");
+  this->state = ValidationState();
+
+  EXPECT_TRUE(this->temp_block_tree.acceptBlock(block1, this->state));
+  EXPECT_TRUE(this->temp_block_tree.acceptBlock(block2, this->state));
+  // duplicates are accepted
+  EXPECT_TRUE(this->temp_block_tree.acceptBlock(block2, this->state));
+  EXPECT_EQ(this->temp_block_tree.size(), 2);
+  EXPECT_EQ(this->temp_block_tree.getBlockIndex(block2->getHash())->pprev,
+            this->temp_block_tree.getBlockIndex(block1->getHash()));
+
+  // overlay is discarded, stable tree is untouched
+  this->temp_block_tree.clear();
+  EXPECT_EQ(this->temp_block_tree.size(), 0);
+  EXPECT_EQ(this->temp_block_tree.getBlockIndex(block1->getHash()), nullptr);
+  EXPECT_EQ(
+      this->temp_block_tree.getStableTree().getBlockIndex(block1->getHash()),
+      nullptr);
+}
+
+REGISTER_TYPED_TEST_SUITE_P(TempBlockTreeTest,
+                            scenario_1,
+                            scenario_2,
+                            scenario_3);
 
 // clang-format off
 typedef ::testing::Types<
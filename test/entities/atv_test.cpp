@@ -7,6 +7,7 @@
 
 #include "util/test_utils.hpp"
 #include "veriblock/entities/atv.hpp"
+#include "veriblock/entities/payloads_view.hpp"
 #include "veriblock/literals.hpp"
 
 using namespace altintegration;
@@ -113,3 +114,29 @@ TEST(ATV, getId_test) {
   EXPECT_EQ(atv.getId().toHex(),
             "50483f2dd2238329158e8d4241ec1fb74809b0ddc594efa8658e4047f105e35d");
 }
+
+TEST(ATV, View) {
+  auto atvBytes = ParseHex(defaultAtvEncoded);
+  ATVView view;
+  ValidationState state;
+  ASSERT_TRUE(Deserialize(atvBytes, view, state)) << state.toString();
+  EXPECT_EQ(view.getId(), defaultAtv.getId());
+  EXPECT_EQ(view.getBlockOfProofHash(), defaultAtv.blockOfProof.getHash());
+
+  PublicationData pub;
+  ASSERT_TRUE(view.getPublicationData(pub, state));
+  EXPECT_EQ(pub.header, publicationData.header);
+  EXPECT_EQ(pub.payoutInfo, publicationData.payoutInfo);
+
+  ATV decoded;
+  ASSERT_TRUE(view.materialize(decoded, state)) << state.toString();
+  EXPECT_EQ(decoded.toHex(), defaultAtvEncoded);
+}
+
+TEST(ATV, ViewTruncated) {
+  auto atvBytes = ParseHex(defaultAtvEncoded);
+  atvBytes.pop_back();
+  ATVView view;
+  ValidationState state;
+  ASSERT_FALSE(Deserialize(atvBytes, view, state));
+}
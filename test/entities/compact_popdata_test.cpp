@@ -0,0 +1,71 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <veriblock/entities/compact_popdata.hpp>
+
+#include "util/test_utils.hpp"
+
+using namespace altintegration;
+
+static PopData defaultPopData() {
+  auto atvBytes = ParseHex(defaultAtvEncoded);
+  ReadStream atvStream(atvBytes);
+  auto vtbBytes = ParseHex(defaultVtbEncoded);
+  ReadStream vtbStream(vtbBytes);
+  VTB vtb = VTB::fromVbkEncoding(vtbStream);
+  PopData pop;
+  pop.context = {vtb.containingBlock, vtb.transaction.publishedBlock};
+  pop.vtbs = {vtb};
+  pop.atvs = {ATV::fromVbkEncoding(atvStream)};
+  return pop;
+}
+
+TEST(CompactPopData, RoundTrip) {
+  auto pop = defaultPopData();
+  // VTB is sent in full, everything else as short ids
+  auto compact = CompactPopData::fromPopData(pop, 42, [](const auto& p) {
+    return std::is_same<typename std::decay<decltype(p)>::type, VTB>::value;
+  });
+  ASSERT_EQ(compact.salt, 42);
+  ASSERT_EQ(compact.context.shortIds.size(), 2);
+  ASSERT_TRUE(compact.context.prefilled.empty());
+  ASSERT_TRUE(compact.vtbs.shortIds.empty());
+  ASSERT_EQ(compact.vtbs.prefilled.size(), 1);
+  ASSERT_EQ(compact.vtbs.prefilled[0].first, 0);
+  ASSERT_EQ(compact.vtbs.prefilled[0].second, pop.vtbs[0]);
+  ASSERT_EQ(compact.atvs.shortIds.size(), 1);
+  ASSERT_EQ(compact.atvs.shortIds[0], compact.shortId(pop.atvs[0].getId()));
+
+  auto bytes = compact.toVbkEncoding();
+  ASSERT_LT(bytes.size(), pop.toVbkEncoding().size());
+  ReadStream stream(bytes);
+  CompactPopData decoded;
+  ValidationState state;
+  ASSERT_TRUE(Deserialize(stream, decoded, state)) << state.toString();
+  ASSERT_EQ(decoded, compact);
+  ASSERT_EQ(stream.remaining(), 0);
+}
+
+TEST(CompactPopData, ShortIdDependsOnSalt) {
+  auto id = defaultPopData().atvs[0].getId();
+  ASSERT_EQ(CompactPopData::shortId(1, id), CompactPopData::shortId(1, id));
+  ASSERT_NE(CompactPopData::shortId(1, id), CompactPopData::shortId(2, id));
+}
+
+TEST(CompactPopData, BadPrefilledIndex) {
+  auto pop = defaultPopData();
+  auto compact = CompactPopData::fromPopData(
+      pop, 1, [](const auto&) { return true; });
+  // index is out of range
+  compact.atvs.prefilled[0].first = 1;
+  auto bytes = compact.toVbkEncoding();
+  ReadStream stream(bytes);
+  CompactPopData decoded;
+  ValidationState state;
+  ASSERT_FALSE(Deserialize(stream, decoded, state));
+  ASSERT_EQ(state.GetPath(), "compact-pop-bad-encoding");
+}
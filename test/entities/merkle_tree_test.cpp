@@ -104,3 +104,28 @@ TEST(MerklePath, RegressionWhenNormalTx) {
   EXPECT_EQ(expected.trim<VBK_MERKLE_ROOT_HASH_SIZE>(),
             path.calculateMerkleRoot());
 }
+
+TEST(MerkleTree, SameRootWithEveryBatchBackend) {
+  const auto previous = sha256_get_batch_backend();
+  for (size_t n = 1; n < 40; n++) {
+    std::vector<uint256> txes;
+    for (size_t i = 0; i < n; i++) {
+      txes.push_back(ArithUint256(i * 7919 + 1));
+    }
+
+    ASSERT_TRUE(sha256_set_batch_backend(SHA256_BATCH_SINGLE));
+    auto vbkRoot = VbkMerkleTree(txes, 0).getMerkleRoot();
+    auto btcRoot = BtcMerkleTree(txes).getMerkleRoot();
+
+    for (auto backend : {SHA256_BATCH_SSE2, SHA256_BATCH_AVX2}) {
+      if (!sha256_set_batch_backend(backend)) {
+        continue;
+      }
+      EXPECT_EQ(VbkMerkleTree(txes, 0).getMerkleRoot(), vbkRoot)
+          << sha256_batch_backend_name(backend) << " n=" << n;
+      EXPECT_EQ(BtcMerkleTree(txes).getMerkleRoot(), btcRoot)
+          << sha256_batch_backend_name(backend) << " n=" << n;
+    }
+  }
+  sha256_set_batch_backend(previous);
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <veriblock/entities/popdata.hpp>
+
+#include "util/test_utils.hpp"
+
+using namespace altintegration;
+
+template <typename T>
+static void checkSize(const T& entity) {
+  WriteStream stream;
+  entity.toVbkEncoding(stream);
+  ASSERT_EQ(entity.serializedSize(), stream.data().size());
+}
+
+static int64_t randomValue() {
+  // mix small, large and negative values
+  switch (rand() % 3) {
+    case 0:
+      return rand() % 256;
+    case 1:
+      return ((int64_t)rand() << 31) | rand();
+    default:
+      return -(int64_t)rand();
+  }
+}
+
+static std::vector<uint256> randomLayers() {
+  std::vector<uint256> layers(rand() % 20);
+  for (auto& layer : layers) {
+    generateRandomBytes(layer.begin(), layer.end());
+  }
+  return layers;
+}
+
+static Address randomAddress() {
+  auto publicKey = generateRandomBytesVector(32);
+  return Address::fromPublicKey(publicKey);
+}
+
+static void mutate(VbkTx& tx) {
+  tx.networkOrType.hasNetworkByte = rand() % 2 != 0;
+  tx.sourceAddress = randomAddress();
+  tx.sourceAmount = Coin(randomValue());
+  tx.outputs.resize(rand() % 5);
+  for (auto& output : tx.outputs) {
+    output = Output(randomAddress(), Coin(randomValue()));
+  }
+  tx.signatureIndex = randomValue();
+  tx.publicationData.identifier = randomValue();
+  tx.publicationData.header = generateRandomBytesVector(rand() % 300);
+  tx.publicationData.contextInfo = generateRandomBytesVector(rand() % 300);
+  tx.publicationData.payoutInfo = generateRandomBytesVector(rand() % 300);
+  tx.signature = generateRandomBytesVector(rand() % 80);
+  tx.publicKey = generateRandomBytesVector(rand() % 100);
+}
+
+static void mutate(VbkPopTx& tx) {
+  tx.networkOrType.hasNetworkByte = rand() % 2 != 0;
+  tx.address = randomAddress();
+  tx.bitcoinTransaction.tx = generateRandomBytesVector(rand() % 1000);
+  tx.merklePath.layers = randomLayers();
+  tx.blockOfProofContext.resize(rand() % 10);
+  tx.signature = generateRandomBytesVector(rand() % 80);
+  tx.publicKey = generateRandomBytesVector(rand() % 100);
+}
+
+TEST(SerializedSize, DefaultEntities) {
+  auto atv = ATV::fromHex(defaultAtvEncoded);
+  auto vtb = VTB::fromHex(defaultVtbEncoded);
+
+  checkSize(atv);
+  checkSize(atv.transaction);
+  checkSize(atv.merklePath);
+  checkSize(atv.blockOfProof);
+  checkSize(vtb);
+  checkSize(vtb.transaction);
+  checkSize(vtb.transaction.merklePath);
+  checkSize(vtb.transaction.bitcoinTransaction);
+  checkSize(vtb.transaction.blockOfProof);
+
+  PopData pd;
+  checkSize(pd);
+  pd.context = {atv.blockOfProof, vtb.containingBlock};
+  pd.vtbs = {vtb};
+  pd.atvs = {atv, atv};
+  checkSize(pd);
+}
+
+TEST(SerializedSize, RandomEntities) {
+  srand(0);
+  auto atv = ATV::fromHex(defaultAtvEncoded);
+  auto vtb = VTB::fromHex(defaultVtbEncoded);
+
+  PopData pd;
+  for (int i = 0; i < 200; i++) {
+    mutate(atv.transaction);
+    atv.merklePath.layers = randomLayers();
+    mutate(vtb.transaction);
+    vtb.merklePath.layers = randomLayers();
+
+    checkSize(atv.transaction);
+    checkSize(atv.merklePath);
+    checkSize(atv);
+    checkSize(vtb.transaction);
+    checkSize(vtb.transaction.merklePath);
+    checkSize(vtb.transaction.bitcoinTransaction);
+    checkSize(vtb);
+
+    pd.atvs.push_back(atv);
+    pd.vtbs.push_back(vtb);
+    pd.context.push_back(vtb.containingBlock);
+    checkSize(pd);
+  }
+}
+
+TEST(SerializedSize, Addresses) {
+  for (const char* text :
+       {"VFFDWUMLJwLRuNzH4NX8Rm32E59n6d", "V23Cuyc34u5rdk9psJ86aFcwhB1md0"}) {
+    // size is computed on first call
+    auto address = Address::fromString(text);
+    checkSize(address);
+    checkSize(address);
+
+    // size is known after decoding
+    WriteStream stream;
+    address.toVbkEncoding(stream);
+    ReadStream rs(stream.data());
+    checkSize(Address::fromVbkEncoding(rs));
+
+    Address decoded;
+    ValidationState state;
+    ReadStream rs2(stream.data());
+    ASSERT_TRUE(Deserialize(rs2, decoded, state)) << state.toString();
+    checkSize(decoded);
+  }
+}
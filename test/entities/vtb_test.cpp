@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "util/test_utils.hpp"
+#include "veriblock/entities/payloads_view.hpp"
 #include "veriblock/entities/vtb.hpp"
 #include "veriblock/literals.hpp"
 
@@ -222,3 +223,34 @@ TEST(VTB, getId_test) {
   EXPECT_EQ(vtb.getId().toHex(),
             "e3d7f971cf23efadc50c4ff9d1b971346f7f7851f4dad89bfa8408be0b1a70e7");
 }
+
+TEST(VTB, View) {
+  auto vtbBytes = ParseHex(defaultVtbEncoded);
+  VTBView view;
+  ValidationState state;
+  ASSERT_TRUE(Deserialize(vtbBytes, view, state)) << state.toString();
+  EXPECT_EQ(view.getId(), defaultVtb.getId());
+  EXPECT_EQ(view.getContainingBlockHash(),
+            defaultVtb.containingBlock.getHash());
+  EXPECT_EQ(view.transaction.getHash(), defaultVtb.transaction.getHash());
+  EXPECT_EQ(view.transaction.getBlockOfProofHash(),
+            defaultVtb.transaction.blockOfProof.getHash());
+  EXPECT_EQ(view.transaction.getPublishedBlockHash(),
+            defaultVtb.transaction.publishedBlock.getHash());
+
+  std::vector<BtcBlock> context;
+  ASSERT_TRUE(view.transaction.getBlockOfProofContext(context, state));
+  EXPECT_EQ(context, defaultVtb.transaction.blockOfProofContext);
+
+  VTB decoded;
+  ASSERT_TRUE(view.materialize(decoded, state)) << state.toString();
+  EXPECT_EQ(decoded.toHex(), defaultVtbEncoded);
+}
+
+TEST(VTB, ViewTruncated) {
+  auto vtbBytes = ParseHex(defaultVtbEncoded);
+  vtbBytes.pop_back();
+  VTBView view;
+  ValidationState state;
+  ASSERT_FALSE(Deserialize(vtbBytes, view, state));
+}
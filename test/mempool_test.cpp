@@ -7,11 +7,15 @@
 
 #include <gtest/gtest.h>
 
+#include <future>
+#include <set>
+#include <thread>
 #include <vector>
 
 #include "util/pop_test_fixture.hpp"
 #include "util/test_utils.hpp"
 #include "veriblock/hashutil.hpp"
+#include "veriblock/literals.hpp"
 
 using namespace altintegration;
 
@@ -1323,3 +1327,752 @@ TEST_F(MemPoolFixture, getPop_scenario_13) {
 
   applyInNextBlock(popData);
 }
+
+TEST_F(MemPoolFixture, getPop_ordered_by_height) {
+  Miner<VbkBlock, VbkChainParams> vbk_miner(popminer->vbk().getParams());
+
+  std::vector<VbkBlock> vbk_blocks;
+  for (size_t i = 0; i < 10; ++i) {
+    VbkBlock block =
+        vbk_miner.createNextBlock(*popminer->vbk().getBestChain().tip());
+    ASSERT_TRUE(popminer->vbk().acceptBlock(block, state));
+    vbk_blocks.push_back(block);
+  }
+
+  // submit in reverse order, as if received from p2p
+  for (auto it = vbk_blocks.rbegin(); it != vbk_blocks.rend(); ++it) {
+    payloadsProvider.write(*it);
+    ASSERT_TRUE(mempool->submit<VbkBlock>(*it, state, false));
+  }
+
+  PopData popData = checkedGetPop();
+  ASSERT_EQ(popData.context, vbk_blocks);
+}
+
+TEST_F(MemPoolFixture, vacuum_expires_atvs) {
+  mineAltBlocks(10, chain);
+  AltBlock endorsedBlock = chain[5];
+
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(endorsedBlock));
+  ATV atv = popminer->applyATV(tx, state);
+  payloadsProvider.write(atv);
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+
+  // ATV expires when tip - endorsed + 1 > window
+  auto expiry =
+      endorsedBlock.height + altparam.getEndorsementSettlementInterval();
+  while (chain.back().height + 1 < expiry) {
+    applyInNextBlock({});
+    mempool->removeAll({});
+    ASSERT_NE(mempool->get<ATV>(atv.getId()), nullptr) << chain.back().height;
+  }
+
+  applyInNextBlock({});
+  mempool->removeAll({});
+  ASSERT_EQ(mempool->get<ATV>(atv.getId()), nullptr);
+}
+
+template <typename T>
+std::set<typename T::id_t> storedIds(const MemPool& mempool) {
+  std::set<typename T::id_t> ids;
+  for (const auto& p : mempool.getMap<T>()) {
+    ids.insert(p.first);
+  }
+  return ids;
+}
+
+TEST_F(MemPoolFixture, vacuum_incremental_matches_full) {
+  auto* vbkTip = popminer->mineVbkBlocks(65);
+  generatePopTx(vbkTip->getAncestor(vbkTip->getHeight() - 10)->getHeader());
+  vbkTip = popminer->mineVbkBlocks(1);
+  auto vtbs = popminer->vbkPayloads[vbkTip->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+
+  mineAltBlocks(10, chain);
+  auto endorse = [&](const AltBlock& block) {
+    VbkTx tx =
+        popminer->createVbkTxEndorsingAltBlock(generatePublicationData(block));
+    ATV atv = popminer->applyATV(tx, state);
+    payloadsProvider.write(atv);
+    ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  };
+
+  std::vector<VbkBlock> context;
+  fillVbkContext(
+      context, vbkparam.getGenesisBlock().getHash(), popminer->vbk());
+  for (const auto& b : context) {
+    ASSERT_TRUE(mempool->submit(b, state)) << state.toString();
+  }
+  for (const auto& vtb : vtbs) {
+    ASSERT_TRUE(mempool->submit(vtb, state)) << state.toString();
+  }
+  endorse(chain[1]);
+  endorse(chain[5]);
+  endorse(chain[9]);
+  mempool->removeAll({});
+
+  // every step mempool is vacuumed incrementally, unless ALT chain is
+  // reorganized, and compared with a mempool restored from the snapshot taken
+  // before the step, which does a full vacuum over the same payloads
+  const auto window = altparam.getEndorsementSettlementInterval();
+  PopData included;
+  for (int step = 0; chain.back().height < window + 20; step++) {
+    if (step == 4) {
+      // endorsed block and block with payloads from previous step are
+      // reorganized out, payloads of disconnected block are returned back
+      endorse(chain.back());
+      removeLastAltBlock();
+      mempool->submitAll(included);
+      applyInNextBlock({});
+    }
+    if (step == 20) {
+      endorse(chain.back());
+    }
+
+    WriteStream snapshot;
+    mempool->saveSnapshot(snapshot);
+
+    PopData pop;
+    if (step == 3 || step == 30) {
+      pop = checkedGetPop();
+      ASSERT_FALSE(pop.atvs.empty()) << step;
+      pop.atvs.resize(1);
+      included = pop;
+    }
+    applyInNextBlock(pop);
+    mempool->removeAll(pop);
+
+    MemPool full(alttree);
+    auto data = snapshot.data();
+    ASSERT_TRUE(full.restoreSnapshot(data, state)) << state.toString();
+    ASSERT_EQ(storedIds<ATV>(*mempool), storedIds<ATV>(full)) << step;
+    ASSERT_EQ(storedIds<VTB>(*mempool), storedIds<VTB>(full)) << step;
+    ASSERT_EQ(storedIds<VbkBlock>(*mempool), storedIds<VbkBlock>(full))
+        << step;
+  }
+}
+
+TEST_F(MemPoolFixture, speculative_filter) {
+  auto* vbkTip = popminer->mineVbkBlocks(65);
+  generatePopTx(vbkTip->getAncestor(vbkTip->getHeight() - 10)->getHeader());
+  vbkTip = popminer->mineVbkBlocks(1);
+  auto vtbs = popminer->vbkPayloads[vbkTip->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+
+  mineAltBlocks(10, chain);
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+
+  PopData pop;
+  fillVbkContext(
+      pop.context, vbkparam.getGenesisBlock().getHash(), popminer->vbk());
+  pop.vtbs = vtbs;
+  pop.atvs = {atv};
+
+  // valid payloads are kept, nothing is added to stable trees
+  auto before = alttree.toPrettyString();
+  MemPoolBlockTree temp(alttree);
+  PopData valid = pop;
+  temp.filterInvalidPayloads(valid);
+  ASSERT_EQ(valid, pop);
+  ASSERT_GT(temp.vbk().size(), 0);
+  ASSERT_EQ(alttree.vbk().getBlockIndex(vbkTip->getHash()), nullptr);
+  ASSERT_EQ(alttree.toPrettyString(), before);
+
+  // duplicates and stale endorsements are removed
+  PopData invalid = pop;
+  invalid.atvs.push_back(atv);
+  invalid.vtbs.push_back(vtbs[0]);
+  ATV unknown = atv;
+  unknown.transaction.publicationData.header =
+      generateNextBlock(chain.back()).toVbkEncoding();
+  invalid.atvs.push_back(unknown);
+  temp.filterInvalidPayloads(invalid);
+  ASSERT_EQ(invalid, pop);
+
+  // payloads without VBK context are removed
+  PopData nocontext = pop;
+  nocontext.context.clear();
+  temp.filterInvalidPayloads(nocontext);
+  ASSERT_TRUE(nocontext.empty());
+  ASSERT_EQ(temp.vbk().size(), 0);
+
+  // rejected VBK block is accepted once its previous block is known
+  temp.clear();
+  ValidationState s;
+  ASSERT_FALSE(temp.acceptVbkBlock(pop.context.at(1), s));
+  ASSERT_TRUE(temp.acceptVbkBlock(pop.context.at(0), s)) << s.toString();
+  ASSERT_TRUE(temp.acceptVbkBlock(pop.context.at(1), s)) << s.toString();
+
+  // rejected VTB leaves no BTC blocks in the overlay
+  temp.clear();
+  for (const auto& b : pop.context) {
+    ASSERT_TRUE(temp.acceptVbkBlock(b, s)) << s.toString();
+  }
+  VTB stale = vtbs[0];
+  stale.transaction.publishedBlock.nonce++;
+  ASSERT_FALSE(temp.acceptVTB(stale, s));
+  ASSERT_EQ(temp.btc().size(), 0);
+
+  // VTB with invalid block of proof leaves no BTC context blocks
+  VTB badProof = vtbs[0];
+  auto& poptx = badProof.transaction;
+  ASSERT_TRUE(poptx.blockOfProofContext.empty());
+  poptx.blockOfProofContext.push_back(poptx.blockOfProof);
+  poptx.blockOfProof.previousBlock = uint256();
+  s = ValidationState();
+  ASSERT_FALSE(temp.acceptVTB(badProof, s));
+  ASSERT_EQ(s.GetPath().rfind("vtb-btc-block-of-proof+", 0), 0) << s.GetPath();
+  ASSERT_EQ(temp.btc().size(), 0);
+  s = ValidationState();
+  ASSERT_TRUE(temp.acceptVTB(vtbs[0], s)) << s.toString();
+  ASSERT_GT(temp.btc().size(), 0);
+
+  // payloads already added to active chain are duplicates
+  applyInNextBlock(pop);
+  PopData applied = pop;
+  temp.filterInvalidPayloads(applied);
+  ASSERT_TRUE(applied.empty());
+}
+
+TEST_F(MemPoolFixture, value_density_selector) {
+  mineAltBlocks(10, chain);
+  auto endorse = [&](const AltBlock& block) {
+    VbkTx tx =
+        popminer->createVbkTxEndorsingAltBlock(generatePublicationData(block));
+    return popminer->applyATV(tx, state);
+  };
+
+  PopData pop;
+  pop.atvs.push_back(endorse(chain[5]));
+  fillVbkContext(
+      pop.context, vbkparam.getGenesisBlock().getHash(), popminer->vbk());
+  applyInNextBlock(pop);
+
+  // chain[5] is already endorsed and late endorsement scores less, chain[6] is
+  // not endorsed, and unknown block can not be endorsed
+  auto* empty = popminer->mineVbkBlocks(12);
+  ATV again = endorse(chain[5]);
+  ATV fresh = endorse(chain[6]);
+  ATV unknown = endorse(generateNextBlock(chain.back()));
+  VbkPayloadsRelations rel1(again.blockOfProof);
+  rel1.addATV(std::make_shared<ATV>(again));
+  rel1.addATV(std::make_shared<ATV>(unknown));
+  VbkPayloadsRelations rel2(fresh.blockOfProof);
+  rel2.addATV(std::make_shared<ATV>(fresh));
+  MemPoolSelector::relations_index_t relations{
+      {{rel1.header->height, 0}, &rel1}, {{rel2.header->height, 1}, &rel2}};
+
+  // size limit is taken from params of the tree
+  struct SelectorParams : public AltChainParamsRegTest {
+    void setMaxPopDataSize(uint32_t size) { mMaxPopDataSize = size; }
+  } params;
+  AltBlockTree tree(params, vbkparam, btcparam, payloadsProvider);
+  ASSERT_TRUE(tree.btc().bootstrapWithGenesis(state));
+  ASSERT_TRUE(tree.vbk().bootstrapWithGenesis(state));
+  ASSERT_TRUE(tree.bootstrap(state));
+  WriteStream snapshot;
+  auto key = "node secret"_v;
+  alttree.saveSnapshot(snapshot, key);
+  auto data = snapshot.data();
+  ASSERT_TRUE(tree.restoreSnapshot(data, key, state)) << state.toString();
+
+  // there is space for only one ATV
+  PopData expected;
+  expected.context = {*rel1.header, *rel2.header};
+  expected.atvs = {fresh};
+  params.setMaxPopDataSize((uint32_t)expected.serializedSize());
+
+  PopData selected = ValueDensitySelector().select(relations, tree);
+  ASSERT_EQ(selected, expected);
+  ASSERT_EQ(HeightOrderSelector().select(relations, tree).atvs,
+            std::vector<ATV>{again});
+
+  // everything with value fits, VBK blocks are kept in order
+  params.setMaxPopDataSize(1024 * 1024);
+  selected = ValueDensitySelector().select(relations, tree);
+  ASSERT_EQ(selected.context, expected.context);
+  ASSERT_EQ(selected.atvs, (std::vector<ATV>{again, fresh}));
+
+  // VTBs publishing blocks of proof of stored and applied ATVs unlock them,
+  // VTB publishing block without ATVs is worth nothing
+  generatePopTx(fresh.blockOfProof);
+  generatePopTx(pop.atvs[0].blockOfProof);
+  generatePopTx(empty->getHeader());
+  auto* containing = popminer->mineVbkBlocks(1);
+  auto vtbs = popminer->vbkPayloads[containing->getHash()];
+  ASSERT_EQ(vtbs.size(), 3);
+  VbkPayloadsRelations rel3(containing->getHeader());
+  for (const auto& vtb : vtbs) {
+    rel3.addVTB(std::make_shared<VTB>(vtb));
+  }
+  relations[{rel3.header->height, 2}] = &rel3;
+
+  selected = ValueDensitySelector().select(relations, tree);
+  ASSERT_EQ(selected.context.size(), 3);
+  ASSERT_EQ(selected.atvs, (std::vector<ATV>{again, fresh}));
+  ASSERT_EQ(selected.vtbs.size(), 2);
+  for (const auto& vtb : selected.vtbs) {
+    ASSERT_NE(vtb.transaction.publishedBlock, empty->getHeader());
+  }
+}
+
+TEST_F(MemPoolFixture, submitAll_parallel) {
+  mineAltBlocks(10, chain);
+  std::vector<VbkTx> txs;
+  for (size_t i = 0; i < 5; i++) {
+    for (const auto& block : chain) {
+      auto pub = generatePublicationData(block);
+      pub.contextInfo.push_back((uint8_t)i);
+      txs.push_back(popminer->createVbkTxEndorsingAltBlock(pub));
+    }
+  }
+
+  PopData pop;
+  pop.atvs = popminer->applyATVs(txs, state);
+  fillVbkContext(
+      pop.context, vbkparam.getGenesisBlock().getHash(), popminer->vbk());
+  // statelessly invalid ATV in the middle
+  pop.atvs[pop.atvs.size() / 2].transaction.signature[0] ^= 1;
+
+  // payloads are marked as checked, so every mempool gets its own copy
+  PopData copy = pop;
+  MemPool sequential(alttree);
+  auto expected = sequential.submitAll(copy);
+  copy = pop;
+  auto actual = mempool->submitAll(copy, 4);
+
+  auto check = [](const std::vector<std::pair<ATV::id_t, ValidationState>>& a,
+                  const std::vector<std::pair<ATV::id_t, ValidationState>>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+      ASSERT_EQ(a[i].first, b[i].first);
+      ASSERT_EQ(a[i].second.GetPath(), b[i].second.GetPath());
+    }
+  };
+  check(actual.atvs, expected.atvs);
+  ASSERT_EQ(actual.context.size(), expected.context.size());
+  ASSERT_EQ(actual.atvs.size(), pop.atvs.size());
+  ASSERT_EQ(actual.atvs[pop.atvs.size() / 2].second.GetPath(),
+            "pop-mempool-submit-atv-stateless+vbk-check-tx+vbk-check-signature+"
+            "invalid-vbk-tx");
+  ASSERT_EQ(mempool->getMap<ATV>().size(), pop.atvs.size() - 1);
+  ASSERT_EQ(sequential.getPop(), mempool->getPop());
+}
+
+TEST_F(MemPoolFixture, eviction) {
+  mineAltBlocks(10, chain);
+
+  // VBK fork block known to VBK tree
+  auto* genesis = popminer->vbk().getBestChain().tip();
+  auto* active = popminer->mineVbkBlocks(1);
+  auto* fork = popminer->mineVbkBlocks(*genesis, 1);
+  ASSERT_TRUE(alttree.vbk().acceptBlock(active->getHeader(), state));
+  ASSERT_TRUE(alttree.vbk().acceptBlock(fork->getHeader(), state));
+  ASSERT_FALSE(alttree.vbk().getBestChain().contains(
+      alttree.vbk().getBlockIndex(fork->getHash())));
+
+  // ATV in the oldest unknown VBK block, and VBK block without payloads
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+  auto* unreferenced = popminer->mineVbkBlocks(1);
+
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  ASSERT_TRUE(mempool->submit(unreferenced->getHeader(), state))
+      << state.toString();
+  ASSERT_TRUE(mempool->submit(fork->getHeader(), state, false))
+      << state.toString();
+  ASSERT_EQ(mempool->getMap<VbkBlock>().size(), 3);
+
+  // duplicates are not accounted twice
+  auto before = mempool->getMemoryUsage();
+  ASSERT_GT(before, atv.serializedSize());
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  ASSERT_EQ(mempool->getMemoryUsage(), before);
+
+  // fork block goes first, then unreferenced block, then block with ATV
+  mempool->setMaxMemoryUsage(mempool->getMemoryUsage() - 1);
+  ASSERT_EQ(mempool->get<VbkBlock>(fork->getHeader().getId()), nullptr);
+  ASSERT_EQ(mempool->getMap<VbkBlock>().size(), 2);
+  mempool->setMaxMemoryUsage(mempool->getMemoryUsage() - 1);
+  ASSERT_EQ(mempool->get<VbkBlock>(unreferenced->getHeader().getId()),
+            nullptr);
+  ASSERT_NE(mempool->get<ATV>(atv.getId()), nullptr);
+  ASSERT_LE(mempool->getMemoryUsage(), before);
+
+  // payload, which does not fit, is not accepted
+  mempool->setMaxMemoryUsage(0);
+  ASSERT_EQ(mempool->getMemoryUsage(), 0);
+  ASSERT_TRUE(mempool->getMap<ATV>().empty());
+  ASSERT_FALSE(mempool->submit(atv, state));
+  ASSERT_EQ(state.GetPath(), "pop-mempool-full");
+  ASSERT_EQ(mempool->getMemoryUsage(), 0);
+}
+
+TEST_F(MemPoolFixture, orphans) {
+  mineAltBlocks(10, chain);
+
+  // ATV in VBK block, which previous block is unknown
+  auto* first = popminer->mineVbkBlocks(1);
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  ASSERT_EQ(mempool->getOrphansCount(), 1);
+  ASSERT_NE(mempool->get<ATV>(atv.getId()), nullptr);
+  ASSERT_TRUE(checkedGetPop().atvs.empty());
+
+  // missing block arrives to mempool
+  ASSERT_TRUE(mempool->submit(first->getHeader(), state)) << state.toString();
+  ASSERT_EQ(mempool->getOrphansCount(), 0);
+  auto pop = checkedGetPop();
+  ASSERT_EQ(pop.context.size(), 2);
+  ASSERT_EQ(pop.atvs.size(), 1);
+
+  // orphans wait for each other, and missing block arrives to VBK tree
+  auto* third = popminer->mineVbkBlocks(1);
+  auto* fourth = popminer->mineVbkBlocks(1);
+  auto* fifth = popminer->mineVbkBlocks(1);
+  ASSERT_TRUE(mempool->submit(fifth->getHeader(), state, false));
+  ASSERT_TRUE(mempool->submit(fourth->getHeader(), state, false));
+  ASSERT_EQ(mempool->getOrphansCount(), 2);
+  pop.context.push_back(third->getHeader());
+  applyInNextBlock(pop);
+  mempool->removeAll(pop);
+  ASSERT_EQ(mempool->getOrphansCount(), 0);
+  pop = checkedGetPop();
+  ASSERT_EQ(pop.context.size(), 2);
+  ASSERT_EQ(pop.context.back(), fifth->getHeader());
+
+  // oldest orphans are evicted, and expire
+  mempool->setOrphanLimits(1, 60);
+  // sixth block is missing
+  popminer->mineVbkBlocks(1);
+  auto* seventh = popminer->mineVbkBlocks(1);
+  auto* eighth = popminer->mineVbkBlocks(1);
+  auto now = getMockTime();
+  ASSERT_TRUE(mempool->submit(eighth->getHeader(), state, false));
+  setMockTime(now + 10);
+  ASSERT_TRUE(mempool->submit(seventh->getHeader(), state, false));
+  ASSERT_EQ(mempool->getOrphansCount(), 1);
+  ASSERT_EQ(mempool->get<VbkBlock>(eighth->getHeader().getId()), nullptr);
+  setMockTime(now + 60);
+  mempool->removeAll({});
+  ASSERT_EQ(mempool->getOrphansCount(), 1);
+  setMockTime(now + 70);
+  mempool->removeAll({});
+  ASSERT_EQ(mempool->getOrphansCount(), 0);
+  ASSERT_EQ(mempool->get<VbkBlock>(seventh->getHeader().getId()), nullptr);
+  ASSERT_EQ(mempool->getMap<VbkBlock>().size(), 2);
+}
+
+TEST(VbkPayloadsRelations, estimateSize) {
+  auto vtb = VTB::fromHex(defaultVtbEncoded);
+  auto atv = ATV::fromHex(defaultAtvEncoded);
+  VbkPayloadsRelations rel(vtb.containingBlock);
+  ASSERT_EQ(rel.estimateSize(), rel.toPopData().estimateSize());
+
+  rel.addVTB(std::make_shared<VTB>(vtb));
+  rel.addVTB(std::make_shared<VTB>(vtb));
+  rel.addATV(std::make_shared<ATV>(atv));
+  ASSERT_EQ(rel.estimateSize(), rel.toPopData().estimateSize());
+
+  rel.removeVTB(vtb.getId());
+  ASSERT_EQ(rel.estimateSize(), rel.toPopData().estimateSize());
+  rel.removeATVsIf([](const ATV&) { return true; });
+  ASSERT_EQ(rel.estimateSize(), rel.toPopData().estimateSize());
+}
+
+TEST_F(MemPoolFixture, snapshot) {
+  mineAltBlocks(10, chain);
+
+  // VTB, ATV, their VBK blocks, and an orphan VBK block
+  auto* endorsed = popminer->mineVbkBlocks(1);
+  generatePopTx(endorsed->getHeader());
+  auto* containing = popminer->mineVbkBlocks(1);
+  auto& vtbs = popminer->vbkPayloads[containing->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+  popminer->mineVbkBlocks(1);
+  auto* orphan = popminer->mineVbkBlocks(1);
+
+  ASSERT_TRUE(mempool->submit(endorsed->getHeader(), state));
+  ASSERT_TRUE(mempool->submit(vtbs[0], state)) << state.toString();
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  ASSERT_TRUE(mempool->submit(orphan->getHeader(), state, false));
+  auto expected = checkedGetPop();
+  ASSERT_EQ(expected.context.size(), 3);
+  ASSERT_EQ(expected.vtbs.size(), 1);
+  ASSERT_EQ(expected.atvs.size(), 1);
+
+  WriteStream stream;
+  mempool->saveSnapshot(stream);
+
+  MemPool restored(alttree);
+  ASSERT_TRUE(restored.restoreSnapshot(stream.data(), state))
+      << state.toString();
+  ASSERT_EQ(restored.getMap<VbkBlock>().size(), 4);
+  ASSERT_EQ(restored.getMap<VTB>().size(), 1);
+  ASSERT_EQ(restored.getMap<ATV>().size(), 1);
+  ASSERT_EQ(restored.getOrphansCount(), 1);
+  ASSERT_EQ(restored.getPop(), expected);
+
+  // payloads, which have been added to ALT tree, are removed on restore
+  applyInNextBlock(expected);
+  MemPool outdated(alttree);
+  ASSERT_TRUE(outdated.restoreSnapshot(stream.data(), state))
+      << state.toString();
+  ASSERT_TRUE(outdated.getMap<VTB>().empty());
+  ASSERT_TRUE(outdated.getMap<ATV>().empty());
+  ASSERT_EQ(outdated.getMap<VbkBlock>().size(), 1);
+  ASSERT_EQ(outdated.getOrphansCount(), 1);
+
+  // corrupted snapshot is rejected
+  auto bytes = stream.data();
+  bytes.back() ^= 1;
+  MemPool corrupted(alttree);
+  ASSERT_FALSE(corrupted.restoreSnapshot(bytes, state));
+  ASSERT_EQ(state.GetPath(),
+            "restore-mempool-snapshot+bad-snapshot-checksum");
+  ASSERT_TRUE(corrupted.getMap<VbkBlock>().empty());
+}
+
+TEST_F(MemPoolFixture, notification_queue) {
+  auto queue = std::make_shared<MemPoolNotificationQueue>(2);
+  mempool->setNotificationQueue(queue);
+  std::vector<MemPoolNotificationQueue::Batch> batches;
+  auto collect = [&](const MemPoolNotificationQueue::Batch& b) {
+    batches.push_back(b);
+  };
+
+  // submitAll is coalesced into a single batch
+  PopData pop;
+  auto* tip = popminer->mineVbkBlocks(3);
+  pop.context.push_back(tip->pprev->pprev->getHeader());
+  pop.context.push_back(tip->pprev->getHeader());
+  mempool->submitAll(pop);
+  ASSERT_EQ(queue->size(), 2);
+  ASSERT_EQ(queue->drain(collect), 1);
+  ASSERT_EQ(batches.at(0).vbkblocks.size(), 2);
+  ASSERT_EQ(batches.at(0).vbkblocks.at(1), pop.context.at(1).getId());
+  ASSERT_EQ(queue->size(), 0);
+
+  // full queue blocks submit until it is drained
+  auto* next = popminer->mineVbkBlocks(2);
+  ASSERT_TRUE(mempool->submit(tip->getHeader(), state));
+  ASSERT_TRUE(mempool->submit(next->pprev->getHeader(), state));
+  ASSERT_EQ(queue->size(), 2);
+  std::promise<void> submitted;
+  auto done = submitted.get_future();
+  std::thread producer([&] {
+    ValidationState s;
+    EXPECT_TRUE(mempool->submit(next->getHeader(), s));
+    submitted.set_value();
+  });
+  // space taken by the first batch is released after callback returns, so
+  // producer can not finish before that
+  batches.clear();
+  size_t drained = queue->waitAndDrain(
+      [&](const MemPoolNotificationQueue::Batch& b) {
+        if (batches.empty()) {
+          EXPECT_EQ(done.wait_for(std::chrono::milliseconds(0)),
+                    std::future_status::timeout);
+        }
+        collect(b);
+      },
+      std::chrono::milliseconds(0));
+  producer.join();
+  ASSERT_EQ(done.wait_for(std::chrono::milliseconds(0)),
+            std::future_status::ready);
+  drained += queue->drain(collect);
+  ASSERT_EQ(drained, 3);
+  ASSERT_EQ(batches.back().vbkblocks.at(0), next->getHeader().getId());
+  ASSERT_EQ(queue->size(), 0);
+
+  // space is released if callback throws
+  next = popminer->mineVbkBlocks(1);
+  ASSERT_TRUE(mempool->submit(next->getHeader(), state));
+  ASSERT_EQ(queue->size(), 1);
+  auto fail = [](const MemPoolNotificationQueue::Batch&) {
+    throw std::runtime_error("callback failed");
+  };
+  ASSERT_THROW(queue->drain(fail), std::runtime_error);
+  ASSERT_EQ(queue->size(), 0);
+
+  // known VBK block is not notified again
+  ASSERT_TRUE(mempool->submit(next->getHeader(), state));
+  ASSERT_EQ(queue->size(), 0);
+}
+
+TEST_F(MemPoolFixture, pop_template) {
+  mineAltBlocks(10, chain);
+
+  auto endorse = [&](const AltBlock& block) {
+    auto tx =
+        popminer->createVbkTxEndorsingAltBlock(generatePublicationData(block));
+    return popminer->applyATV(tx, state);
+  };
+
+  ATV atv1 = endorse(chain[5]);
+  ASSERT_TRUE(mempool->submit(atv1, state)) << state.toString();
+  auto pop = checkedGetPop();
+  ASSERT_EQ(pop.context.size(), 1);
+  ASSERT_EQ(pop.atvs.size(), 1);
+  // stable tip and mempool
+  ASSERT_EQ(checkedGetPop(), pop);
+
+  // VTB in orphan block, which is promoted by ATV in its previous block
+  ATV atv2 = endorse(chain[6]);
+  generatePopTx(atv1.blockOfProof);
+  auto* containing = popminer->mineVbkBlocks(1);
+  auto& vtbs = popminer->vbkPayloads[containing->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+  ASSERT_TRUE(mempool->submit(vtbs[0], state)) << state.toString();
+  ASSERT_TRUE(mempool->submit(atv2, state)) << state.toString();
+
+  // new payloads are appended to template
+  auto extended = checkedGetPop();
+  ASSERT_EQ(extended.context.size(), 3);
+  ASSERT_EQ(extended.context.at(0), pop.context.at(0));
+  ASSERT_EQ(extended.context.at(2), containing->getHeader());
+  ASSERT_EQ(extended.vtbs.size(), 1);
+  ASSERT_EQ(extended.atvs.size(), 2);
+  ASSERT_EQ(extended.atvs.at(0), atv1);
+  auto filtered = extended;
+  alttree.filterInvalidPayloads(filtered);
+  ASSERT_EQ(filtered, extended);
+
+  // template is rebuilt when tip changes
+  applyInNextBlock(extended);
+  mempool->removeAll(extended);
+  ASSERT_TRUE(checkedGetPop().empty());
+
+  // non-incremental selector rebuilds template for new payloads
+  mempool->setSelector(std::make_shared<ValueDensitySelector>());
+  ASSERT_TRUE(checkedGetPop().empty());
+  ATV atv3 = endorse(chain[7]);
+  ASSERT_TRUE(mempool->submit(atv3, state)) << state.toString();
+  pop = checkedGetPop();
+  ASSERT_EQ(pop.atvs.size(), 1);
+  ASSERT_EQ(pop.atvs.at(0), atv3);
+}
+
+TEST_F(MemPoolFixture, submit_move) {
+  mineAltBlocks(10, chain);
+
+  auto* endorsed = popminer->mineVbkBlocks(1);
+  generatePopTx(endorsed->getHeader());
+  auto* containing = popminer->mineVbkBlocks(1);
+  auto& vtbs = popminer->vbkPayloads[containing->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+
+  // shared payload is stored as is
+  auto vtb = std::make_shared<VTB>(vtbs[0]);
+  ASSERT_TRUE(mempool->submit(
+      std::make_shared<VbkBlock>(endorsed->getHeader()), state));
+  ASSERT_TRUE(mempool->submit(vtb, state)) << state.toString();
+  ASSERT_EQ(mempool->get<VTB>(vtb->getId()), vtb.get());
+
+  // moved payload is stored
+  auto atvId = atv.getId();
+  ATV copy = atv;
+  ASSERT_TRUE(mempool->submit(std::move(copy), state)) << state.toString();
+  ASSERT_NE(mempool->get<ATV>(atvId), nullptr);
+  ASSERT_EQ(*mempool->get<ATV>(atvId), atv);
+
+  // moved PopData gives the same result as copied one
+  auto expected = checkedGetPop();
+  ASSERT_EQ(expected.vtbs.size(), 1);
+  ASSERT_EQ(expected.atvs.size(), 1);
+  MemPool copied(alttree);
+  MemPool moved(alttree);
+  auto r1 = copied.submitAll(expected);
+  auto pop = expected;
+  auto r2 = moved.submitAll(std::move(pop));
+  ASSERT_EQ(r1.context.size(), r2.context.size());
+  ASSERT_EQ(r1.vtbs.at(0).first, r2.vtbs.at(0).first);
+  ASSERT_EQ(r1.atvs.at(0).first, r2.atvs.at(0).first);
+  ASSERT_TRUE(r2.vtbs.at(0).second.IsValid());
+  ASSERT_TRUE(r2.atvs.at(0).second.IsValid());
+  ASSERT_EQ(copied.getPop(), expected);
+  ASSERT_EQ(moved.getPop(), expected);
+}
+
+TEST_F(MemPoolFixture, compact_relay) {
+  mineAltBlocks(10, chain);
+
+  auto* endorsed = popminer->mineVbkBlocks(1);
+  generatePopTx(endorsed->getHeader());
+  auto* containing = popminer->mineVbkBlocks(1);
+  auto& vtbs = popminer->vbkPayloads[containing->getHash()];
+  ASSERT_EQ(vtbs.size(), 1);
+  VbkTx tx = popminer->createVbkTxEndorsingAltBlock(
+      generatePublicationData(chain[5]));
+  ATV atv = popminer->applyATV(tx, state);
+
+  // sender has every payload, receiver has everything but ATV
+  ASSERT_TRUE(mempool->submit(endorsed->getHeader(), state));
+  ASSERT_TRUE(mempool->submit(vtbs[0], state)) << state.toString();
+  ASSERT_TRUE(mempool->submit(atv, state)) << state.toString();
+  auto pop = checkedGetPop();
+  ASSERT_EQ(pop.vtbs.size(), 1);
+  ASSERT_EQ(pop.atvs.size(), 1);
+  MemPool receiver(alttree);
+  ASSERT_TRUE(receiver.submit(endorsed->getHeader(), state));
+  ASSERT_TRUE(receiver.submit(vtbs[0], state)) << state.toString();
+
+  auto compact = mempool->compact(pop, 7);
+  ASSERT_TRUE(compact.context.prefilled.empty());
+  ASSERT_TRUE(compact.vtbs.prefilled.empty());
+  ASSERT_TRUE(compact.atvs.prefilled.empty());
+  ASSERT_LT(compact.toVbkEncoding().size(), pop.toVbkEncoding().size());
+
+  PopData out;
+  CompactPopData::Missing missing;
+  ASSERT_FALSE(receiver.reconstruct(compact, out, missing, state));
+  ASSERT_EQ(state.GetPath(), "pop-mempool-reconstruct-missing-payloads");
+  // ATV and its block of proof
+  ASSERT_EQ(missing.context.size(), 1);
+  ASSERT_EQ(pop.context.at(missing.context[0]), atv.blockOfProof);
+  ASSERT_TRUE(missing.vtbs.empty());
+  ASSERT_EQ(missing.atvs, std::vector<uint32_t>{0});
+
+  // missing payloads are received from peer
+  state = ValidationState();
+  PopData extra;
+  extra.context = {pop.context[missing.context[0]]};
+  extra.atvs = {pop.atvs[missing.atvs[0]]};
+  ASSERT_TRUE(receiver.reconstruct(compact, out, missing, state, extra))
+      << state.toString();
+  ASSERT_TRUE(missing.empty());
+  ASSERT_EQ(out, pop);
+
+  // short ids are kept for the same salt, payloads stored later are matched
+  ASSERT_TRUE(receiver.submit(atv.blockOfProof, state)) << state.toString();
+  ASSERT_TRUE(receiver.submit(atv, state)) << state.toString();
+  ASSERT_TRUE(receiver.reconstruct(compact, out, missing, state))
+      << state.toString();
+  ASSERT_EQ(out, pop);
+
+  // removed payloads are not matched
+  receiver.removeAll(pop);
+  ASSERT_FALSE(receiver.reconstruct(compact, out, missing, state));
+  ASSERT_EQ(missing.atvs, std::vector<uint32_t>{0});
+  state = ValidationState();
+
+  // payloads, which sender does not have, are prefilled
+  MemPool empty(alttree);
+  compact = empty.compact(pop, 7);
+  ASSERT_EQ(compact.atvs.prefilled.size(), 1);
+  ASSERT_TRUE(empty.reconstruct(compact, out, missing, state))
+      << state.toString();
+  ASSERT_EQ(out, pop);
+}
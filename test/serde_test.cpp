@@ -26,4 +26,46 @@ TEST(Serde, ToFromArrayRoundTrip) {
   });
 
   ASSERT_EQ(v, actual);
-}
\ No newline at end of file
+}
+
+TEST(Serde, VarIntRoundTrip) {
+  std::vector<uint64_t> v{0, 1, 127, 128, 300, 0xffffffff, UINT64_MAX};
+  std::vector<size_t> sizes{1, 1, 1, 2, 2, 5, 10};
+
+  for (size_t i = 0; i < v.size(); i++) {
+    WriteStream w;
+    writeVarInt(w, v[i]);
+    ASSERT_EQ(w.data().size(), sizes[i]);
+
+    ReadStream r(w.data());
+    ASSERT_EQ(readVarInt(r), v[i]);
+    ASSERT_EQ(r.remaining(), 0);
+  }
+
+  // truncated
+  std::vector<uint8_t> bytes{0x80, 0x80};
+  ReadStream r(bytes);
+  ASSERT_THROW(readVarInt(r), std::out_of_range);
+}
+
+TEST(Serde, CompactArrayRoundTrip) {
+  std::vector<uint256> v{uint256::fromHex("01"), uint256::fromHex("02")};
+
+  WriteStream w;
+  writeCompactArrayOf<uint256>(w, v);
+  ASSERT_EQ(w.data().size(), 1 + 2 * uint256::size());
+
+  ReadStream r(w.data());
+  ASSERT_EQ(readCompactArrayOf<uint256>(r), v);
+}
+
+TEST(Serde, SingleBEValueSize) {
+  std::vector<int64_t> v{
+      0, 1, 255, 256, 0xffffff, 0x1000000, INT64_MAX, -1, INT64_MIN};
+
+  for (auto value : v) {
+    WriteStream w;
+    writeSingleBEValue(w, value);
+    ASSERT_EQ(singleBEValueSize(value), w.data().size()) << value;
+  }
+}
@@ -9,6 +9,7 @@
 #include "util/test_utils.hpp"
 #include "veriblock/blockchain/btc_chain_params.hpp"
 #include "veriblock/blockchain/vbk_chain_params.hpp"
+#include "veriblock/block_interner.hpp"
 #include "veriblock/literals.hpp"
 #include "veriblock/stateless_validation.hpp"
 
@@ -284,6 +285,42 @@ TEST_F(StatelessValidationTest, checkBitcoinBlocks_when_not_contiguous) {
   ASSERT_FALSE(checkBtcBlocks(tx.blockOfProofContext, state, btc));
 }
 
+TEST_F(StatelessValidationTest, interned_headers) {
+  BtcBlockInterner btcInterner(btc);
+  VTB vtb = validVTB;
+  vtb.checked = false;
+  ASSERT_TRUE(checkVTB(vtb, state, btcInterner)) << state.toString();
+  auto& context = vtb.transaction.blockOfProofContext;
+  ASSERT_EQ(btcInterner.size(), context.size());
+
+  // the same headers are interned once
+  VTB copy = validVTB;
+  copy.checked = false;
+  ASSERT_TRUE(checkVTB(copy, state, btcInterner)) << state.toString();
+  ASSERT_EQ(btcInterner.size(), context.size());
+  auto interned = btcInterner.intern(context[0]);
+  ASSERT_EQ(interned, btcInterner.intern(context[0]));
+  ASSERT_EQ(interned->hash, context[0].getHash());
+  ASSERT_TRUE(interned->validPow);
+
+  // result is the same as without interner
+  VbkPopTx tx = validPopTx;
+  tx.blockOfProofContext.erase(tx.blockOfProofContext.begin() + 1);
+  ValidationState expected;
+  ASSERT_FALSE(checkBtcBlocks(tx.blockOfProofContext, expected, btc));
+  ASSERT_FALSE(checkBtcBlocks(tx.blockOfProofContext, state, btcInterner));
+  ASSERT_EQ(state.GetPath(), expected.GetPath());
+
+  state = ValidationState();
+  VbkBlockInterner vbkInterner(vbk);
+  ASSERT_TRUE(checkBlock(validVbkBlock, state, vbkInterner));
+  VbkBlock block = validVbkBlock;
+  block.nonce = 1;
+  ASSERT_FALSE(checkBlock(block, state, vbkInterner));
+  ASSERT_EQ(state.GetPath(), "vbk-bad-pow");
+  ASSERT_EQ(vbkInterner.size(), 2);
+}
+
 TEST_F(StatelessValidationTest, checkVbkTx_valid) {
   ASSERT_TRUE(checkVbkTx(validVbkTx, state));
 }
@@ -0,0 +1,325 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <util/pop_test_fixture.hpp>
+#include <veriblock/literals.hpp>
+#include <veriblock/storage/append_only_file.hpp>
+#include <veriblock/storage/file_block_storage.hpp>
+#include <veriblock/storage/mmap_payloads_provider.hpp>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+using namespace altintegration;
+
+#if defined(__linux__)
+namespace {
+
+// IO failures injected into AppendOnlyFile by overriding libc calls
+struct FileFaults {
+  bool enabled = false;
+  // bytes, which are written before writes fail with ENOSPC
+  size_t writeLimit = 0;
+  bool failTruncate = false;
+} faults;
+
+}  // namespace
+
+extern "C" ssize_t write(int fd, const void* buf, size_t count) {
+  if (faults.enabled) {
+    if (faults.writeLimit == 0) {
+      errno = ENOSPC;
+      return -1;
+    }
+    count = std::min(count, faults.writeLimit);
+    faults.writeLimit -= count;
+  }
+  return ::syscall(SYS_write, fd, buf, count);
+}
+
+extern "C" int ftruncate(int fd, off_t length) noexcept {
+  if (faults.enabled && faults.failTruncate) {
+    errno = EIO;
+    return -1;
+  }
+  return (int)::syscall(SYS_ftruncate, fd, length);
+}
+#endif
+
+struct MmapStorageTest : public PopTestFixture, public testing::Test {
+  std::string payloadsPath = testing::TempDir() + "mmap_storage_payloads.log";
+  std::string blocksPath = testing::TempDir() + "mmap_storage_blocks.log";
+  std::string snapshotPath = testing::TempDir() + "mmap_storage_snapshot";
+
+  MmapStorageTest() {
+    std::remove(payloadsPath.c_str());
+    std::remove(blocksPath.c_str());
+    std::remove(snapshotPath.c_str());
+  }
+
+  ~MmapStorageTest() override {
+#if defined(__linux__)
+    faults = FileFaults();
+#endif
+    std::remove(payloadsPath.c_str());
+    std::remove(blocksPath.c_str());
+    std::remove(snapshotPath.c_str());
+  }
+
+  template <typename T>
+  void copyPayloads(MmapPayloadsProvider& provider) {
+    for (auto& p : payloadsProvider.getMap<T>()) {
+      provider.write(*p.second);
+    }
+  }
+
+  void copyPayloads(MmapPayloadsProvider& provider) {
+    copyPayloads<VbkBlock>(provider);
+    copyPayloads<VTB>(provider);
+    copyPayloads<ATV>(provider);
+  }
+
+  void appendGarbage(const std::string& path) {
+    std::ofstream f(path, std::ios::binary | std::ios::app);
+    f << "\x03\x01\x02";
+  }
+};
+
+TEST_F(MmapStorageTest, PayloadsRoundTrip) {
+  createEndorsedAltChain(5, 2);
+  auto& atvs = payloadsProvider.getMap<ATV>();
+  auto& vtbs = payloadsProvider.getMap<VTB>();
+  ASSERT_FALSE(atvs.empty());
+  ASSERT_FALSE(vtbs.empty());
+
+  std::vector<ATV::id_t> atvids;
+  for (auto& p : atvs) {
+    atvids.push_back(p.first);
+  }
+  std::vector<VTB::id_t> vtbids;
+  for (auto& p : vtbs) {
+    vtbids.push_back(p.first);
+  }
+
+  {
+    MmapPayloadsProvider provider(payloadsPath);
+    ASSERT_TRUE(provider.open(state)) << state.toString();
+    copyPayloads(provider);
+
+    // pending records are visible before flush
+    std::vector<ATV> out;
+    ASSERT_TRUE(provider.getATVs(atvids, out, state)) << state.toString();
+    ASSERT_EQ(out.size(), atvids.size());
+    ASSERT_TRUE(provider.flush(state)) << state.toString();
+    ASSERT_EQ(provider.pendingSize(), 0);
+  }
+
+  appendGarbage(payloadsPath);
+
+  MmapPayloadsProvider provider(payloadsPath);
+  ASSERT_TRUE(provider.open(state)) << state.toString();
+
+  std::vector<ATV> outatvs;
+  ASSERT_TRUE(provider.getATVs(atvids, outatvs, state)) << state.toString();
+  for (size_t i = 0; i < atvids.size(); i++) {
+    EXPECT_EQ(outatvs[i], *atvs.at(atvids[i]));
+  }
+
+  std::vector<VTBView> views;
+  ASSERT_TRUE(provider.getVTBViews(vtbids, views, state)) << state.toString();
+  for (size_t i = 0; i < vtbids.size(); i++) {
+    EXPECT_EQ(views[i].getId(), vtbids[i]);
+  }
+
+  std::vector<VbkBlock> blocks;
+  ASSERT_TRUE(provider.getVBKs({outatvs[0].blockOfProof.getId()}, blocks, state))
+      << state.toString();
+  EXPECT_EQ(blocks.at(0), outatvs[0].blockOfProof);
+
+  std::vector<ATV> missing;
+  ASSERT_FALSE(provider.getATVs({uint256()}, missing, state));
+  EXPECT_EQ(state.GetPath(), "ATV-not-found");
+}
+
+TEST_F(MmapStorageTest, FailedFlushKeepsPendingRecords) {
+  createEndorsedAltChain(2, 1);
+  auto& atvs = payloadsProvider.getMap<ATV>();
+  ASSERT_FALSE(atvs.empty());
+  std::vector<ATV::id_t> atvids;
+  for (auto& p : atvs) {
+    atvids.push_back(p.first);
+  }
+
+  // every write to /dev/full fails with ENOSPC
+  MmapPayloadsProvider provider("/dev/full");
+  ASSERT_TRUE(provider.open(state)) << state.toString();
+  copyPayloads(provider);
+  auto pending = provider.pendingSize();
+
+  ASSERT_FALSE(provider.flush(state));
+  EXPECT_EQ(state.GetPath(), "payloads-flush+file-write");
+  EXPECT_EQ(provider.pendingSize(), pending);
+  EXPECT_EQ(provider.size(), pending);
+
+  ValidationState state2;
+  std::vector<ATV> out;
+  ASSERT_TRUE(provider.getATVs(atvids, out, state2)) << state2.toString();
+  for (size_t i = 0; i < atvids.size(); i++) {
+    EXPECT_EQ(out[i], *atvs.at(atvids[i]));
+  }
+}
+
+TEST_F(MmapStorageTest, SaveLoadTrees) {
+  createEndorsedAltChain(10, 2);
+  auto key = "node secret"_v;
+
+  {
+    FileBlockStorage storage(blocksPath);
+    ASSERT_TRUE(storage.open(state)) << state.toString();
+    FileBlockBatch batch(storage);
+    SaveAllTrees(alttree, batch);
+    SaveAllTreesCommitments(alttree, batch, key);
+    // nothing is written until commit
+    ASSERT_EQ(storage.size(), 0);
+    ASSERT_TRUE(batch.commit(state)) << state.toString();
+    ASSERT_GT(storage.size(), 0);
+  }
+
+  appendGarbage(blocksPath);
+
+  MmapPayloadsProvider provider(payloadsPath);
+  ASSERT_TRUE(provider.open(state)) << state.toString();
+  copyPayloads(provider);
+  ASSERT_TRUE(provider.flush(state)) << state.toString();
+
+  FileBlockStorage storage(blocksPath);
+  ASSERT_TRUE(storage.open(state)) << state.toString();
+
+  AltBlockTree alttree2(altparam, vbkparam, btcparam, provider);
+  ASSERT_TRUE(alttree2.btc().bootstrapWithGenesis(state));
+  ASSERT_TRUE(alttree2.vbk().bootstrapWithGenesis(state));
+  ASSERT_TRUE(alttree2.bootstrap(state));
+
+  ASSERT_TRUE(LoadAllTrees(alttree2,
+                           *storage.getCursor<BtcBlock>(),
+                           *storage.getCursor<VbkBlock>(),
+                           *storage.getCursor<AltBlock>(),
+                           storage.getTip<BtcBlock>(),
+                           storage.getTip<VbkBlock>(),
+                           storage.getTip<AltBlock>(),
+                           storage.getCommitment<BtcBlock>(),
+                           storage.getCommitment<VbkBlock>(),
+                           storage.getCommitment<AltBlock>(),
+                           key,
+                           state))
+      << state.toString();
+  ASSERT_TRUE(cmp(alttree, alttree2));
+  EXPECT_EQ(storage.getCommitment<VbkBlock>().tip,
+            alttree2.vbk().getBestChain().tip()->getHash());
+  EXPECT_EQ(GetTreeCommitment(alttree2.vbk(), key),
+            storage.getCommitment<VbkBlock>().value);
+
+  // commands are built from views over mapped log
+  auto to = alttree.getBestChain().first()->getHash();
+  ASSERT_TRUE(alttree.setState(to, state)) << state.toString();
+  ASSERT_TRUE(alttree2.setState(to, state)) << state.toString();
+  ASSERT_TRUE(cmp(alttree, alttree2));
+}
+
+TEST_F(MmapStorageTest, GroupCommit) {
+  createEndorsedAltChain(3, 1);
+  FileBlockStorage storage(blocksPath);
+  ASSERT_TRUE(storage.open(state)) << state.toString();
+
+  // every record exceeds batch size, so it is committed immediately
+  FileBlockBatch batch(storage, 1);
+  auto* tip = alttree.getBestChain().tip();
+  ASSERT_TRUE(batch.writeBlock(*tip));
+  ASSERT_EQ(batch.pendingSize(), 0);
+  ASSERT_EQ(storage.getIndex<AltBlock>().size(), 1);
+
+  // rewriting a block replaces previous version
+  ASSERT_TRUE(batch.writeBlock(*tip));
+  ASSERT_TRUE(batch.writeTip(*tip));
+  ASSERT_EQ(storage.getIndex<AltBlock>().size(), 1);
+  ASSERT_EQ(storage.getTip<AltBlock>(), tip->getHash());
+  ASSERT_EQ(storage.load<AltBlock>().at(0).getHash(), tip->getHash());
+}
+
+#if defined(__linux__)
+TEST_F(MmapStorageTest, FailedCommitRollback) {
+  createEndorsedAltChain(3, 1);
+  auto* tip = alttree.getBestChain().tip();
+  FileBlockStorage storage(blocksPath);
+  ASSERT_TRUE(storage.open(state)) << state.toString();
+  FileBlockBatch batch(storage);
+  ASSERT_TRUE(batch.writeBlock(*tip->pprev->pprev));
+  ASSERT_TRUE(batch.commit(state)) << state.toString();
+  auto committed = storage.size();
+
+  // commit is torn, and torn record can not be cut off
+  faults.enabled = true;
+  faults.writeLimit = 10;
+  faults.failTruncate = true;
+  ASSERT_TRUE(batch.writeBlock(*tip->pprev));
+  ASSERT_FALSE(batch.commit(state));
+  EXPECT_EQ(state.GetPath(), "blocks-commit+file-write");
+  EXPECT_EQ(storage.size(), committed + 10);
+
+  // next commit is not written after torn record
+  faults.writeLimit = (size_t)-1;
+  ValidationState state2;
+  ASSERT_FALSE(batch.commit(state2));
+  EXPECT_EQ(state2.GetPath(), "blocks-commit+file-truncate");
+  EXPECT_EQ(storage.size(), committed + 10);
+
+  faults = FileFaults();
+  ValidationState state3;
+  ASSERT_TRUE(batch.commit(state3)) << state3.toString();
+  ASSERT_TRUE(batch.writeBlock(*tip));
+  ASSERT_TRUE(batch.commit(state3)) << state3.toString();
+  ASSERT_EQ(storage.getIndex<AltBlock>().size(), 3);
+
+  // every good commit survives reopen
+  FileBlockStorage reopened(blocksPath);
+  ASSERT_TRUE(reopened.open(state3)) << state3.toString();
+  EXPECT_EQ(reopened.size(), storage.size());
+  EXPECT_EQ(reopened.getIndex<AltBlock>().size(), 3);
+  EXPECT_EQ(reopened.load<AltBlock>().size(), 3);
+}
+#endif
+
+TEST_F(MmapStorageTest, RestoreMappedSnapshot) {
+  createEndorsedAltChain(10, 2);
+  auto key = "node secret"_v;
+
+  {
+    WriteStream stream;
+    alttree.saveSnapshot(stream, key);
+    AppendOnlyFile file(snapshotPath);
+    ASSERT_TRUE(file.open(state)) << state.toString();
+    ASSERT_TRUE(file.append(stream.data(), state)) << state.toString();
+    ASSERT_TRUE(file.sync(state)) << state.toString();
+  }
+
+  AppendOnlyFile file(snapshotPath);
+  ASSERT_TRUE(file.open(state)) << state.toString();
+
+  AltBlockTree alttree2(altparam, vbkparam, btcparam, payloadsProvider);
+  ASSERT_TRUE(alttree2.btc().bootstrapWithGenesis(state));
+  ASSERT_TRUE(alttree2.vbk().bootstrapWithGenesis(state));
+  ASSERT_TRUE(alttree2.bootstrap(state));
+  ASSERT_TRUE(alttree2.restoreSnapshot(file.data(), key, state))
+      << state.toString();
+  ASSERT_TRUE(cmp(alttree, alttree2));
+}
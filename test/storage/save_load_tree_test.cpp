@@ -5,7 +5,9 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
 #include <util/pop_test_fixture.hpp>
+#include <veriblock/literals.hpp>
 
 using namespace altintegration;
 
@@ -20,6 +22,8 @@ struct SaveLoadTreeTest : public PopTestFixture, public testing::Test {
   }
 
   std::vector<AltBlock> chain;
+  //! node-local secret, which authenticates tree commitments
+  std::vector<uint8_t> key = "node secret"_v;
 
   AltBlockTree alttree2 =
       AltBlockTree(altparam, vbkparam, btcparam, payloadsProvider);
@@ -29,6 +33,29 @@ struct SaveLoadTreeTest : public PopTestFixture, public testing::Test {
     SaveAllTrees(alttree, adaptor);
   }
 
+  void saveCommitments() {
+    auto adaptor = InmemBlockBatch(blockStorage);
+    SaveAllTreesCommitments(alttree, adaptor, key);
+  }
+
+  template <typename Block>
+  std::vector<std::vector<uint8_t>> loadRaw() {
+    std::vector<std::vector<uint8_t>> ret;
+    for (auto& b : blockStorage.load<Block>()) ret.push_back(b.toRaw());
+    return ret;
+  }
+
+  template <typename Block>
+  std::vector<std::vector<uint8_t>> loadRawV1() {
+    std::vector<std::vector<uint8_t>> ret;
+    for (auto& b : blockStorage.load<Block>()) {
+      WriteStream stream;
+      b.toRawV1(stream);
+      ret.push_back(stream.data());
+    }
+    return ret;
+  }
+
   bool load() {
     return LoadTreeWrapper(alttree2.btc()) && LoadTreeWrapper(alttree2.vbk()) &&
            LoadTreeWrapper(alttree2);
@@ -177,4 +204,379 @@ TEST_F(SaveLoadTreeTest, ReloadWithoutDuplicates_test3) {
   EXPECT_FALSE(load());
   EXPECT_FALSE(state.IsValid());
   EXPECT_EQ(state.GetPath(), "load-tree+ATV-duplicate");
-}
\ No newline at end of file
+}
+
+TEST_F(SaveLoadTreeTest, SaveOnlyChangedBlocks_test) {
+  save();
+  EXPECT_TRUE(alttree.getDirtyBlocks().empty());
+  EXPECT_TRUE(alttree.vbk().getDirtyBlocks().empty());
+  EXPECT_TRUE(alttree.btc().getDirtyBlocks().empty());
+  for (auto& block : alttree.getBlocks()) {
+    EXPECT_FALSE(block.second->isDirty());
+  }
+
+  auto* tip = alttree.getBestChain().tip();
+  tip->setFlag(BLOCK_FAILED_POP);
+  EXPECT_EQ(alttree.getDirtyBlocks().size(), 1);
+  EXPECT_EQ(*alttree.getDirtyBlocks().begin(), tip);
+  tip->unsetFlag(BLOCK_FAILED_POP);
+  EXPECT_EQ(alttree.getDirtyBlocks().size(), 1);
+
+  save();
+  EXPECT_TRUE(alttree.getDirtyBlocks().empty());
+  EXPECT_FALSE(tip->isDirty());
+}
+
+TEST_F(SaveLoadTreeTest, ReportRemovedBlocks_test) {
+  save();
+  auto size = blockStorage.alt.size();
+
+  // fork from the tip's parent, then remove the fork
+  auto* tip = alttree.getBestChain().tip();
+  auto fork = generateNextBlock(tip->pprev->getHeader());
+  ASSERT_TRUE(alttree.acceptBlockHeader(fork, state));
+  EXPECT_EQ(alttree.getDirtyBlocks().size(), 1);
+  save();
+  EXPECT_EQ(blockStorage.alt.size(), size + 1);
+
+  alttree.removeSubtree(fork.getHash());
+  EXPECT_EQ(alttree.getRemovedBlocks().size(), 1);
+  EXPECT_EQ(alttree.getRemovedBlocks().count(fork.getHash()), 1);
+  // removed blocks are not written
+  for (auto* index : alttree.getDirtyBlocks()) {
+    EXPECT_NE(index->getHash(), fork.getHash());
+  }
+
+  save();
+  EXPECT_TRUE(alttree.getRemovedBlocks().empty());
+  EXPECT_EQ(blockStorage.alt.size(), size);
+  EXPECT_EQ(blockStorage.alt.count(fork.getHash()), 0);
+  ASSERT_TRUE(load()) << state.toString();
+  assertTreesEqual();
+}
+
+TEST_F(SaveLoadTreeTest, LoadAllTreesFromCursors_test) {
+  save();
+
+  auto btc = loadRaw<BtcBlock>();
+  auto vbk = loadRaw<VbkBlock>();
+  auto alt = loadRaw<AltBlock>();
+
+  VectorBlockCursor btcCursor(btc);
+  VectorBlockCursor vbkCursor(vbk);
+  VectorBlockCursor altCursor(alt);
+  ASSERT_TRUE(LoadAllTrees(alttree2,
+                           btcCursor,
+                           vbkCursor,
+                           altCursor,
+                           blockStorage.btcTip,
+                           blockStorage.vbkTip,
+                           blockStorage.altTip,
+                           state,
+                           4))
+      << state.toString();
+  assertTreesEqual();
+}
+
+TEST_F(SaveLoadTreeTest, LoadTreeBadPow_test) {
+  save();
+
+  auto blocks = blockStorage.load<VbkBlock>();
+  // zero target is never satisfied
+  auto& victim = blocks.at(blocks.size() / 2);
+  auto header = victim.getHeader();
+  header.difficulty = 0;
+  victim.setHeader(header);
+
+  std::vector<std::vector<uint8_t>> raw;
+  for (auto& b : blocks) raw.push_back(b.toRaw());
+  VectorBlockCursor cursor(raw);
+
+  ASSERT_TRUE(LoadTreeWrapper(alttree2.btc()));
+  ASSERT_FALSE(
+      LoadTree(alttree2.vbk(), cursor, blockStorage.vbkTip, state, 4));
+  EXPECT_EQ(state.GetPath(), "load-tree+bad-header+vbk-bad-pow");
+}
+
+TEST_F(SaveLoadTreeTest, TrustedReload_test) {
+  save();
+  saveCommitments();
+
+  auto btc = loadRaw<BtcBlock>();
+  auto vbk = loadRaw<VbkBlock>();
+  auto alt = loadRaw<AltBlock>();
+  VectorBlockCursor btcCursor(btc);
+  VectorBlockCursor vbkCursor(vbk);
+  VectorBlockCursor altCursor(alt);
+  ASSERT_TRUE(LoadAllTrees(alttree2,
+                           btcCursor,
+                           vbkCursor,
+                           altCursor,
+                           blockStorage.btcTip,
+                           blockStorage.vbkTip,
+                           blockStorage.altTip,
+                           blockStorage.btcCommitment,
+                           blockStorage.vbkCommitment,
+                           blockStorage.altCommitment,
+                           key,
+                           state))
+      << state.toString();
+  assertTreesEqual();
+
+  // reloaded trees commit to the same state
+  EXPECT_EQ(GetTreeCommitment(alttree2.btc(), key),
+            blockStorage.btcCommitment.value);
+  EXPECT_EQ(GetTreeCommitment(alttree2.vbk(), key),
+            blockStorage.vbkCommitment.value);
+  EXPECT_EQ(GetTreeCommitment(alttree2, key),
+            blockStorage.altCommitment.value);
+}
+
+TEST_F(SaveLoadTreeTest, TrustedReloadFallback_test) {
+  save();
+  saveCommitments();
+
+  auto raw = loadRaw<VbkBlock>();
+  std::vector<BlockIndex<VbkBlock>> blocks;
+  std::vector<bool> trusted;
+  {
+    VectorBlockCursor cursor(raw);
+    ASSERT_TRUE(DecodeLoadedBlocks(alttree2.vbk(),
+                                   cursor,
+                                   blockStorage.vbkCommitment,
+                                   key,
+                                   blocks,
+                                   trusted,
+                                   state));
+    EXPECT_EQ(std::count(trusted.begin(), trusted.end(), true),
+              alttree.vbk().getBestChain().blocksCount());
+  }
+
+  // commitment is authenticated by the key
+  {
+    auto wrongKey = "other node"_v;
+    VectorBlockCursor cursor(raw);
+    ASSERT_TRUE(DecodeLoadedBlocks(alttree2.vbk(),
+                                   cursor,
+                                   blockStorage.vbkCommitment,
+                                   wrongKey,
+                                   blocks,
+                                   trusted,
+                                   state));
+    EXPECT_EQ(std::count(trusted.begin(), trusted.end(), true), 0);
+  }
+
+  // modified blocks are validated
+  auto victim = blockStorage.load<VbkBlock>().at(raw.size() / 2);
+  auto header = victim.getHeader();
+  header.difficulty = 0;
+  victim.setHeader(header);
+  raw.at(raw.size() / 2) = victim.toRaw();
+
+  VectorBlockCursor cursor(raw);
+  ASSERT_FALSE(DecodeLoadedBlocks(alttree2.vbk(),
+                                  cursor,
+                                  blockStorage.vbkCommitment,
+                                  key,
+                                  blocks,
+                                  trusted,
+                                  state));
+  EXPECT_EQ(state.GetPath(), "load-tree+bad-header+vbk-bad-pow");
+}
+
+TEST_F(SaveLoadTreeTest, TrustedReloadPerBlock_test) {
+  save();
+  saveCommitments();
+  auto committed = alttree.getBestChain().blocksCount();
+
+  // blocks saved after commitment: new tip and a fork
+  auto* tip = alttree.getBestChain().tip();
+  mineAltBlocks(*tip->pprev, 1);
+  mineAltBlocks(*tip, 3);
+  save();
+
+  auto raw = loadRaw<AltBlock>();
+  std::vector<BlockIndex<AltBlock>> blocks;
+  std::vector<bool> trusted;
+  VectorBlockCursor cursor(raw);
+  ASSERT_TRUE(DecodeLoadedBlocks(static_cast<const AltBlockTree&>(alttree2),
+                                 cursor,
+                                 blockStorage.altCommitment,
+                                 key,
+                                 blocks,
+                                 trusted,
+                                 state))
+      << state.toString();
+  ASSERT_EQ(blocks.size(), committed + 4);
+  // only the committed chain is trusted
+  EXPECT_EQ(std::count(trusted.begin(), trusted.end(), true), committed);
+  for (size_t i = 0; i < blocks.size(); i++) {
+    auto* index = alttree.getBlockIndex(blocks[i].getHash());
+    ASSERT_NE(index, nullptr);
+    bool onCommittedChain =
+        index->getHeight() <= tip->getHeight() &&
+        tip->getAncestor(index->getHeight()) == index;
+    EXPECT_EQ(trusted[i], onCommittedChain) << index->toPrettyString();
+  }
+
+  auto btc = loadRaw<BtcBlock>();
+  auto vbk = loadRaw<VbkBlock>();
+  VectorBlockCursor btcCursor(btc);
+  VectorBlockCursor vbkCursor(vbk);
+  VectorBlockCursor altCursor(raw);
+  ASSERT_TRUE(LoadAllTrees(alttree2,
+                           btcCursor,
+                           vbkCursor,
+                           altCursor,
+                           blockStorage.btcTip,
+                           blockStorage.vbkTip,
+                           blockStorage.altTip,
+                           blockStorage.btcCommitment,
+                           blockStorage.vbkCommitment,
+                           blockStorage.altCommitment,
+                           key,
+                           state))
+      << state.toString();
+  assertTreesEqual();
+}
+
+TEST_F(SaveLoadTreeTest, LoadLegacyEncoding_test) {
+  save();
+
+  auto btc = loadRawV1<BtcBlock>();
+  auto vbk = loadRawV1<VbkBlock>();
+  auto alt = loadRawV1<AltBlock>();
+  VectorBlockCursor btcCursor(btc);
+  VectorBlockCursor vbkCursor(vbk);
+  VectorBlockCursor altCursor(alt);
+  ASSERT_TRUE(LoadAllTrees(alttree2,
+                           btcCursor,
+                           vbkCursor,
+                           altCursor,
+                           blockStorage.btcTip,
+                           blockStorage.vbkTip,
+                           blockStorage.altTip,
+                           state))
+      << state.toString();
+  assertTreesEqual();
+}
+
+TEST_F(SaveLoadTreeTest, CompactEncoding_test) {
+  size_t v1 = 0;
+  size_t v2 = 0;
+  size_t endorsements = 0;
+  for (auto& p : alttree.getBlocks()) {
+    auto& index = *p.second;
+    WriteStream legacy;
+    index.toRawV1(legacy);
+    auto raw = index.toRaw();
+    v1 += legacy.data().size();
+    v2 += raw.size();
+    endorsements += index.getContainingEndorsements().size();
+
+    auto decoded = BlockIndex<AltBlock>::fromRaw(raw);
+    ASSERT_EQ(decoded.getHeight(), index.getHeight());
+    ASSERT_EQ(decoded.getStatus(), index.getStatus());
+    ASSERT_EQ(decoded.toRaw(), raw);
+
+    // v1 encoding is still readable
+    auto decodedV1 = BlockIndex<AltBlock>::fromRaw(legacy.data());
+    ASSERT_EQ(decodedV1.toRaw(), raw);
+  }
+
+  ASSERT_GT(endorsements, 0);
+  EXPECT_LT(v2, v1);
+}
+
+TEST_F(SaveLoadTreeTest, CompactEncodingDeduplicatesEndorsements_test) {
+  BlockIndex<AltBlock> index;
+  index.setHeight(1);
+  index.setHeader(chain.back());
+
+  // several ATVs in a block endorse the same block with the same block of
+  // proof and payout info
+  AltEndorsement e;
+  e.endorsedHash = chain.at(0).getHash();
+  e.containingHash = "0102"_unhex;
+  e.blockOfProof = VbkBlock::hash_t::fromHex("0a0b");
+  e.payoutInfo = "payout"_v;
+
+  std::vector<size_t> sizes;
+  for (uint8_t i = 0; i < 3; i++) {
+    sizes.push_back(index.toRaw().size());
+    e.id = uint256::fromHex(HexStr(std::vector<uint8_t>{(uint8_t)(i + 1)}));
+    index.insertContainingEndorsement(std::make_shared<AltEndorsement>(e));
+  }
+  auto raw = index.toRaw();
+  sizes.push_back(raw.size());
+
+  // first endorsement writes its values, next ones only reference them
+  EXPECT_LT(sizes[3] - sizes[2], sizes[1] - sizes[0]);
+  EXPECT_EQ(sizes[3] - sizes[2], sizes[2] - sizes[1]);
+
+  auto decoded = BlockIndex<AltBlock>::fromRaw(raw);
+  auto& expected = index.getContainingEndorsements();
+  auto& actual = decoded.getContainingEndorsements();
+  ASSERT_EQ(actual.size(), expected.size());
+  for (auto a = actual.begin(), b = expected.begin(); a != actual.end();
+       ++a, ++b) {
+    EXPECT_EQ(a->second->toVbkEncoding(), b->second->toVbkEncoding());
+  }
+}
+
+TEST_F(SaveLoadTreeTest, LazyEndorsedBy_test) {
+  save();
+  ASSERT_TRUE(load()) << state.toString();
+
+  size_t endorsed = 0;
+  for (auto& p : alttree.getBlocks()) {
+    auto& expected = p.second->getEndorsedBy();
+    if (expected.empty()) {
+      continue;
+    }
+    ++endorsed;
+
+    auto* index = alttree2.getBlockIndex(p.first);
+    ASSERT_TRUE(index);
+    // back-references are not materialized by load
+    ASSERT_FALSE(index->isEndorsedByResolved());
+    ASSERT_EQ(index->getEndorsedBy().size(), expected.size());
+    ASSERT_TRUE(index->isEndorsedByResolved());
+  }
+  ASSERT_GT(endorsed, 0);
+
+  // unapply and apply endorsements to resolved and not resolved blocks
+  assertTreesEqual();
+}
+
+TEST_F(SaveLoadTreeTest, ConcurrentEndorsedBy_test) {
+  save();
+  ASSERT_TRUE(load()) << state.toString();
+
+  std::vector<const BlockIndex<AltBlock>*> blocks;
+  for (auto& p : alttree2.getBlocks()) {
+    blocks.push_back(p.second.get());
+  }
+
+  // every thread resolves all blocks, as parallel validation does
+  std::vector<std::vector<size_t>> sizes(4);
+  std::vector<std::thread> threads;
+  for (auto& out : sizes) {
+    threads.emplace_back([&blocks, &out]() {
+      for (const auto* index : blocks) {
+        out.push_back(index->getEndorsedBy().size());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (size_t i = 0; i < blocks.size(); i++) {
+    auto& expected =
+        alttree.getBlockIndex(blocks[i]->getHash())->getEndorsedBy();
+    for (auto& out : sizes) {
+      ASSERT_EQ(out.at(i), expected.size());
+    }
+  }
+}
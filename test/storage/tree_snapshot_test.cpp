@@ -0,0 +1,100 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <util/pop_test_fixture.hpp>
+#include <veriblock/literals.hpp>
+#include <veriblock/storage/tree_snapshot.hpp>
+
+using namespace altintegration;
+
+struct TreeSnapshotTest : public PopTestFixture, public testing::Test {
+  TreeSnapshotTest() {
+    alttree2.btc().bootstrapWithGenesis(state);
+    alttree2.vbk().bootstrapWithGenesis(state);
+    alttree2.bootstrap(state);
+
+    createEndorsedAltChain(20, 3);
+  }
+
+  std::vector<uint8_t> snapshot() {
+    WriteStream stream;
+    alttree.saveSnapshot(stream, key);
+    return stream.data();
+  }
+
+  std::vector<uint8_t> key = "node secret"_v;
+  AltBlockTree alttree2 =
+      AltBlockTree(altparam, vbkparam, btcparam, payloadsProvider);
+};
+
+TEST_F(TreeSnapshotTest, SaveRestore) {
+  auto bytes = snapshot();
+  ASSERT_TRUE(alttree2.restoreSnapshot(bytes, key, state)) << state.toString();
+  ASSERT_TRUE(cmp(alttree, alttree2));
+
+  auto to = alttree.getBestChain().first()->getHash();
+  ASSERT_TRUE(alttree.setState(to, state));
+  ASSERT_TRUE(alttree2.setState(to, state));
+  ASSERT_TRUE(cmp(alttree, alttree2));
+}
+
+TEST_F(TreeSnapshotTest, BadChecksum) {
+  auto bytes = snapshot();
+  bytes.back() ^= 1;
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, key, state));
+  EXPECT_EQ(state.GetPath(), "restore-snapshot+bad-snapshot-checksum");
+}
+
+TEST_F(TreeSnapshotTest, WrongKey) {
+  auto bytes = snapshot();
+  auto other = "other secret"_v;
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, other, state));
+  EXPECT_EQ(state.GetPath(), "restore-snapshot+bad-snapshot-checksum");
+
+  // snapshot, which checksum is recomputed without key, is rejected
+  Slice<const uint8_t> body(bytes.data() + kSnapshotHeaderSize,
+                            bytes.size() - kSnapshotHeaderSize);
+  auto checksum = sha256(body);
+  std::copy(checksum.begin(), checksum.end(), bytes.begin() + 8);
+  ValidationState state2;
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, key, state2));
+  EXPECT_EQ(state2.GetPath(), "restore-snapshot+bad-snapshot-checksum");
+
+  ValidationState state3;
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, {}, state3));
+  EXPECT_EQ(state3.GetPath(), "restore-snapshot+bad-snapshot-key");
+}
+
+TEST_F(TreeSnapshotTest, BadVersion) {
+  auto bytes = snapshot();
+  bytes.at(7) = 0xff;
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, key, state));
+  EXPECT_EQ(state.GetPath(), "restore-snapshot+bad-snapshot-version");
+}
+
+TEST_F(TreeSnapshotTest, BadParent) {
+  auto bytes = snapshot();
+  // parent of the third BTC record is either 0 or 1, point it to another one
+  auto pos = kSnapshotHeaderSize + 2 * sizeof(uint32_t) +
+             2 * 3 * sizeof(uint32_t) + 3;
+  bytes.at(pos) ^= 1;
+  Slice<const uint8_t> body(bytes.data() + kSnapshotHeaderSize,
+                            bytes.size() - kSnapshotHeaderSize);
+  auto checksum = hmacSha256(key, body);
+  std::copy(checksum.begin(), checksum.end(), bytes.begin() + 8);
+
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, key, state));
+  EXPECT_EQ(state.GetPath(),
+            "restore-snapshot+" + BtcBlock::name() + "-bad-snapshot-parent");
+}
+
+TEST_F(TreeSnapshotTest, Truncated) {
+  auto bytes = snapshot();
+  bytes.resize(kSnapshotHeaderSize - 1);
+  ASSERT_FALSE(alttree2.restoreSnapshot(bytes, key, state));
+  EXPECT_EQ(state.GetPath(), "restore-snapshot+bad-snapshot-header");
+}
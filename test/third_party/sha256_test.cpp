@@ -5,7 +5,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "veriblock/hashutil.hpp"
@@ -72,3 +74,150 @@ TEST_P(Sha256Test1, IUF) {
 INSTANTIATE_TEST_SUITE_P(Sha256Regression,
                          Sha256Test1,
                          testing::ValuesIn(sha256_cases));
+
+class Sha256BackendTest : public testing::TestWithParam<sha256_backend> {
+ protected:
+  sha256_backend previous_ = sha256_get_backend();
+
+  void SetUp() override {
+    if (!sha256_backend_supported(GetParam())) {
+      GTEST_SKIP() << sha256_backend_name(GetParam()) << " is not supported";
+    }
+    ASSERT_TRUE(sha256_set_backend(GetParam()));
+    ASSERT_EQ(sha256_get_backend(), GetParam());
+  }
+
+  void TearDown() override { sha256_set_backend(previous_); }
+};
+
+TEST_P(Sha256BackendTest, KnownAnswers) {
+  for (const auto& tc : sha256_cases) {
+    EXPECT_EQ(altintegration::sha256(tc.data), tc.hashBytes);
+    EXPECT_EQ(altintegration::sha256twice(tc.data), tc.hashTwiceBytes);
+  }
+
+  // million 'a', hashed in chunks of different sizes
+  std::vector<uint8_t> a(1000, 'a');
+  altintegration::sha256_context ctx{};
+  altintegration::sha256_init(&ctx);
+  for (size_t i = 0, size = 1; i < 1000000; i += size, size = size % 997 + 1) {
+    size = std::min(size, 1000000 - i);
+    altintegration::sha256_update(&ctx, a.data(), (uint32_t)size);
+  }
+  uint256 result;
+  altintegration::sha256_finish(&ctx, result.data());
+  EXPECT_EQ(
+      result,
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"_unhex);
+}
+
+TEST_P(Sha256BackendTest, MatchesPortable) {
+  std::vector<uint8_t> data(600);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i * 131 + 7);
+  }
+
+  for (size_t size = 0; size <= data.size(); size += 7) {
+    Slice<const uint8_t> slice(data.data(), size);
+    ASSERT_TRUE(sha256_set_backend(SHA256_BACKEND_PORTABLE));
+    auto expected = altintegration::sha256(slice);
+    ASSERT_TRUE(sha256_set_backend(GetParam()));
+    ASSERT_EQ(altintegration::sha256(slice), expected) << "size=" << size;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends,
+                         Sha256BackendTest,
+                         testing::Values(SHA256_BACKEND_PORTABLE,
+                                         SHA256_BACKEND_SHANI,
+                                         SHA256_BACKEND_ARMV8),
+                         [](const testing::TestParamInfo<sha256_backend>& i) {
+                           return std::string(sha256_backend_name(i.param));
+                         });
+
+class Sha256BatchTest : public testing::TestWithParam<sha256_batch_backend> {
+ protected:
+  sha256_batch_backend previous_ = sha256_get_batch_backend();
+
+  void SetUp() override {
+    if (!sha256_batch_backend_supported(GetParam())) {
+      GTEST_SKIP() << sha256_batch_backend_name(GetParam())
+                   << " is not supported";
+    }
+    ASSERT_TRUE(sha256_set_batch_backend(GetParam()));
+    ASSERT_EQ(sha256_get_batch_backend(), GetParam());
+  }
+
+  void TearDown() override { sha256_set_batch_backend(previous_); }
+};
+
+TEST_P(Sha256BatchTest, KnownAnswers) {
+  for (const auto& tc : sha256_cases) {
+    // every batch size up to two full batches of the widest backend
+    for (size_t n = 1; n <= 17; n++) {
+      std::vector<Slice<const uint8_t>> inputs(n, tc.data);
+      std::vector<uint256> hashes(n);
+      std::vector<uint256> hashesTwice(n);
+      sha256Batch(inputs, hashes);
+      sha256twiceBatch(inputs, hashesTwice);
+      for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(hashes[i], tc.hashBytes) << "n=" << n << " i=" << i;
+        ASSERT_EQ(hashesTwice[i], tc.hashTwiceBytes) << "n=" << n << " i=" << i;
+      }
+    }
+  }
+}
+
+TEST_P(Sha256BatchTest, MatchesSingle) {
+  const size_t n = 11;
+  std::vector<uint8_t> data(n * 200);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i * 131 + 7);
+  }
+
+  // every padding layout: tail of 0..63 bytes in one or two blocks
+  for (size_t size = 0; size <= 200; size++) {
+    std::vector<Slice<const uint8_t>> inputs;
+    for (size_t i = 0; i < n; i++) {
+      inputs.emplace_back(data.data() + i * 200, size);
+    }
+    std::vector<uint256> hashes(n);
+    sha256Batch(inputs, hashes);
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(hashes[i], altintegration::sha256(inputs[i]))
+          << "size=" << size << " i=" << i;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Backends,
+    Sha256BatchTest,
+    testing::Values(SHA256_BATCH_SINGLE, SHA256_BATCH_SSE2, SHA256_BATCH_AVX2),
+    [](const testing::TestParamInfo<sha256_batch_backend>& i) {
+      return std::string(sha256_batch_backend_name(i.param));
+    });
+
+TEST(HmacSha256, Rfc4231) {
+  std::vector<uint8_t> key(20, 0x0b);
+  auto message = "Hi There"_v;
+  EXPECT_EQ(
+      hmacSha256(key, message),
+      uint256(
+          "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"_unhex));
+
+  key = "Jefe"_v;
+  message = "what do ya want for nothing?"_v;
+  EXPECT_EQ(
+      hmacSha256(key, message),
+      uint256(
+          "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"_unhex));
+
+  // key is longer than block size
+  key = std::vector<uint8_t>(131, 0xaa);
+  message = "Test Using Larger Than Block-Size Key - Hash Key First"_v;
+  EXPECT_EQ(
+      hmacSha256(key, message),
+      uint256(
+          "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"_unhex));
+}
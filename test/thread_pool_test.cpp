@@ -0,0 +1,93 @@
+// Copyright (c) 2019-2020 Xenios SEZC
+// https://www.veriblock.org
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <veriblock/algorithm.hpp>
+#include <veriblock/thread_pool.hpp>
+
+using namespace altintegration;
+
+TEST(ThreadPool, RunsEveryTask) {
+  ThreadPool pool(3);
+  ASSERT_EQ(pool.size(), 3);
+
+  std::vector<std::atomic<int>> calls(100);
+  for (int run = 0; run < 10; run++) {
+    pool.run(calls.size(), [&](size_t i) { calls[i]++; });
+  }
+  for (auto& c : calls) {
+    EXPECT_EQ(c.load(), 10);
+  }
+
+  // no workers, tasks run on caller thread
+  ThreadPool empty;
+  size_t sum = 0;
+  empty.run(10, [&](size_t i) { sum += i; });
+  EXPECT_EQ(sum, 45);
+}
+
+TEST(ThreadPool, ReusesWorkers) {
+  ThreadPool pool(2);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  for (int run = 0; run < 20; run++) {
+    pool.run(8, [&](size_t) {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+  }
+  // two workers and caller thread
+  EXPECT_LE(threads.size(), 3);
+
+  pool.reserve(1);
+  EXPECT_EQ(pool.size(), 2);
+  pool.reserve(4);
+  EXPECT_EQ(pool.size(), 4);
+}
+
+TEST(ThreadPool, RethrowsFirstException) {
+  ThreadPool pool(2);
+  std::atomic<int> calls{0};
+  EXPECT_THROW(pool.run(16,
+                        [&](size_t i) {
+                          calls++;
+                          if (i % 4 == 0) {
+                            throw std::runtime_error("task failed");
+                          }
+                        }),
+               std::runtime_error);
+  EXPECT_EQ(calls.load(), 16);
+
+  // pool is still usable
+  calls = 0;
+  pool.run(4, [&](size_t) { calls++; });
+  EXPECT_EQ(calls.load(), 4);
+}
+
+TEST(ThreadPool, ParallelFor) {
+  ThreadPool pool(3);
+  std::vector<int> items(1000, 0);
+  auto ret = parallel_for(
+      pool,
+      items.size(),
+      4,
+      [&](size_t i) {
+        items[i] = 1;
+        return true;
+      },
+      10);
+  EXPECT_EQ(ret, items.size());
+  EXPECT_EQ(std::count(items.begin(), items.end(), 1), 1000);
+
+  // smallest failed index is returned
+  ret = parallel_for(
+      pool, items.size(), 4, [](size_t i) { return i % 300 != 299; }, 10);
+  EXPECT_EQ(ret, 299);
+}
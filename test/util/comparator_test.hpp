@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -188,6 +189,7 @@ struct TestComparator {
     const base& A = a;
     const base& B = b;
     VBK_EXPECT_TRUE(this->operator()(A, B, suppress), suppress);
+    VBK_EXPECT_TRUE(compareEndorsedBy(a, b, suppress), suppress);
 
     VBK_EXPECT_EQ(a.getStatus(), b.getStatus(), suppress);
     return true;
@@ -284,9 +286,31 @@ struct TestComparator {
                                      b.getContainingEndorsements(),
                                      suppress),
                     suppress);
-    VBK_EXPECT_TRUE(
-        this->operator()(a.getEndorsedBy(), b.getEndorsedBy(), suppress),
-        suppress);
+    return true;
+  }
+
+  // order of endorsedBy is not specified
+  template <typename Block>
+  bool compareEndorsedBy(const BlockIndex<Block>& a,
+                         const BlockIndex<Block>& b,
+                         bool suppress = false) {
+    using E = typename Block::addon_t::endorsement_t;
+    auto sorted = [](const std::vector<E*>& v) {
+      std::vector<E> ret;
+      for (const auto* e : v) {
+        ret.push_back(*e);
+      }
+      std::sort(ret.begin(), ret.end());
+      return ret;
+    };
+    VBK_EXPECT_EQ(
+        sorted(a.getEndorsedBy()), sorted(b.getEndorsedBy()), suppress);
+    return true;
+  }
+
+  bool compareEndorsedBy(const BlockIndex<BtcBlock>&,
+                         const BlockIndex<BtcBlock>&,
+                         bool = false) {
     return true;
   }
 
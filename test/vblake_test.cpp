@@ -6,8 +6,10 @@
 #include <gtest/gtest.h>
 #include <veriblock/vblake.h>
 
+#include <string>
 #include <vector>
 
+#include "veriblock/hashutil.hpp"
 #include "veriblock/literals.hpp"
 
 using namespace altintegration;
@@ -35,6 +37,30 @@ static std::vector<TestCase> cases = {
 
     {"00001388000294E7DC3E3BE21A96ECCF0FBDF5F62A3331DC995C36B0935637860679DDD5DB0F135312B2C27867C9A83EF1B99B985C9B949307023AD672BAFD77"_unhex,
      "000000000000480D8196D5B0B41861D032377F5165BB4452"_unhex},
+
+    {"092E53789DC2E70C31"_unhex,
+     "742A6AAD5F2712315BF757B097EC1C0F7FE98F9EE827CD7A"_unhex},
+
+    {"183D6287ACD1F61B40658AAFD4F91E43688DB2D7FC21466B"_unhex,
+     "8FBA92CAF4FE20C3D4C3D60632C3D3D18142C2894D012B7D"_unhex},
+
+    {"20456A8FB4D9FE23486D92B7DC01264B7095BADF04294E7398BDE2072C51769B"_unhex,
+     "F9A0C13B9C9F24E9930AD7D49A3304AA0B45B068D7C16637"_unhex},
+
+    {"21466B90B5DAFF24496E93B8DD02274C7196BBE0052A4F7499BEE3082D52779CC1"_unhex,
+     "57DD1F19AD91FA37BAEAAD9344CC5531462140F9D837D75C"_unhex},
+
+    {"385D82A7CCF1163B6085AACFF4193E6388ADD2F71C41668BB0D5FA1F44698EB3D8FD2247"
+     "6C91B6DB00254A6F94B9DE03284D7297BCE1062B"_unhex,
+     "8BD6953A9690B3A466DB6274AFD01F240FBFC3C5F650ABB7"_unhex},
+
+    {"3F6489AED3F81D42678CB1D6FB20456A8FB4D9FE23486D92B7DC01264B7095BADF04294E"
+     "7398BDE2072C51769BC0E50A2F54799EC3E80D32577CA1C6EB1035"_unhex,
+     "708A2097B9D6ED3C44B7D19CCE2384D38151E27E82895ABD"_unhex},
+
+    {"40658AAFD4F91E43688DB2D7FC21466B90B5DAFF24496E93B8DD02274C7196BBE0052A4F"
+     "7499BEE3082D52779CC1E60B30557A9FC4E90E33587DA2C7EC11365B"_unhex,
+     "99061ED67968D0CC6951AEE8D9EB900957AB4874A2BB5B7B"_unhex},
 };
 
 class VBlakeTest : public testing::TestWithParam<TestCase> {};
@@ -54,3 +80,70 @@ TEST_P(VBlakeTest, Regression) {
 INSTANTIATE_TEST_SUITE_P(VBlakeRegression,
                          VBlakeTest,
                          testing::ValuesIn(cases));
+
+TEST(VBlake, TooLongInput) {
+  std::vector<uint8_t> message(65);
+  std::vector<uint8_t> actual(VBLAKE_HASH_SIZE, 0);
+  const uint8_t* in = message.data();
+  EXPECT_EQ(altintegration::vblake(actual.data(), in, message.size()), -1);
+  EXPECT_EQ(vblake_batch(actual.data(), &in, 1, message.size()), -1);
+}
+
+class VBlakeBatchTest : public testing::TestWithParam<vblake_batch_backend> {
+ protected:
+  vblake_batch_backend previous_ = vblake_get_batch_backend();
+
+  void SetUp() override {
+    if (!vblake_batch_backend_supported(GetParam())) {
+      GTEST_SKIP() << vblake_batch_backend_name(GetParam())
+                   << " is not supported";
+    }
+    ASSERT_TRUE(vblake_set_batch_backend(GetParam()));
+    ASSERT_EQ(vblake_get_batch_backend(), GetParam());
+  }
+
+  void TearDown() override { vblake_set_batch_backend(previous_); }
+};
+
+TEST_P(VBlakeBatchTest, KnownAnswers) {
+  for (const auto& tc : cases) {
+    // every batch size up to two full batches of the widest backend
+    for (size_t n = 1; n <= 9; n++) {
+      std::vector<Slice<const uint8_t>> inputs(n, tc.message);
+      std::vector<uint192> hashes(n);
+      vblakeBatch(inputs, hashes);
+      for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(hashes[i], tc.hash) << "n=" << n << " i=" << i;
+      }
+    }
+  }
+}
+
+TEST_P(VBlakeBatchTest, MatchesSingle) {
+  const size_t n = 7;
+  std::vector<uint8_t> data(n * 64);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i * 131 + 7);
+  }
+
+  for (size_t size = 0; size <= 64; size++) {
+    std::vector<Slice<const uint8_t>> inputs;
+    for (size_t i = 0; i < n; i++) {
+      inputs.emplace_back(data.data() + i * 64, size);
+    }
+    std::vector<uint192> hashes(n);
+    vblakeBatch(inputs, hashes);
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(hashes[i], altintegration::vblake(inputs[i]))
+          << "size=" << size << " i=" << i;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Backends,
+    VBlakeBatchTest,
+    testing::Values(VBLAKE_BATCH_SINGLE, VBLAKE_BATCH_AVX2),
+    [](const testing::TestParamInfo<vblake_batch_backend>& i) {
+      return std::string(vblake_batch_backend_name(i.param));
+    });